@@ -21,11 +21,11 @@ extension RLYANCSNotification
     }
 
     /**
-     Returns `true` if the notification's signature is contained in the array of signatures.
+     Returns `true` if the notification's signature is contained in the signature cache.
 
      - parameter signatures: The notification signatures to check.
      */
-    func alreadySent(_ signatures: [String]) -> Bool
+    func alreadySent(_ signatures: NotificationSignatureCache) -> Bool
     {
         return signatures.contains(ANCSV1Signature)
     }
@@ -40,11 +40,10 @@ extension RLYANCSNotification
 
      - parameter applicationsService: The applications service to use.
      */
-    func applicationsTest(configurations: [ApplicationConfiguration])
+    func applicationsTest(configurations: ApplicationConfigurationIndex)
         -> Result<ApplicationConfiguration, ANCSV1RejectionReason>
     {
-        if let configuration = configurations
-            .configurationMatching(applicationIdentifier: applicationIdentifier, trimLengthToMatch: true)
+        if let configuration = configurations.configuration(matching: applicationIdentifier, trimLengthToMatch: true)
         {
             if configuration.activated
             {
@@ -79,12 +78,12 @@ extension RLYANCSNotification
 
      - parameter contactsService: The contacts service to request contacts from.
      */
-    fileprivate func contactConfigurationIn(_ configurations: [ContactConfiguration])
+    fileprivate func contactConfigurationIn(_ configurations: ContactConfigurationIndex)
         -> ContactConfiguration?
     {
         if supportsInnerRing
         {
-            return configurations.contactConfiguration(title, trimLengthToMatch: true)
+            return configurations.configuration(matching: title, trimLengthToMatch: true)
         }
         else
         {
@@ -101,7 +100,7 @@ extension RLYANCSNotification
      - returns: A result. A successful value is an optional contact configuration - if the value is `nil`, the
                 notification passed the test, but does not have a contact configuration associated with it.
      */
-    func contactsTest(configurations: [ContactConfiguration], innerRingEnabled: Bool)
+    func contactsTest(configurations: ContactConfigurationIndex, innerRingEnabled: Bool)
         -> Result<ContactConfiguration?, ANCSV1RejectionReason>
     {
         if let configuration = contactConfigurationIn(configurations)
@@ -171,8 +170,8 @@ extension RLYANCSNotification
      - parameter applicationsService: The applications service to use.
      - parameter contactsService:     The contacts service to use.
      */
-    fileprivate func configurationsTest(applicationConfigurations: [ApplicationConfiguration],
-                                        contactConfigurations: [ContactConfiguration],
+    fileprivate func configurationsTest(applicationConfigurations: ApplicationConfigurationIndex,
+                                        contactConfigurations: ContactConfigurationIndex,
                                         innerRingEnabled: Bool)
         -> Result<ANCSV1Configurations, ANCSV1RejectionReason>
     {
@@ -185,16 +184,16 @@ extension RLYANCSNotification
     /**
      Performs all tests on the notification.
 
-     - parameter sentSignatures:      The current list of already sent notification signatures.
+     - parameter sentSignatures:      The signatures of already sent notifications.
      - parameter applicationsService: The applications service to use.
      - parameter contactsService:     The contacts service to use.
 
      - returns: A result. If the value is successful, the notification should be sent to the peripheral as a
                 notification.
      */
-    func ANCSV1TestResult(sentSignatures: [String],
-                          applicationConfigurations: [ApplicationConfiguration],
-                          contactConfigurations: [ContactConfiguration],
+    func ANCSV1TestResult(sentSignatures: NotificationSignatureCache,
+                          applicationConfigurations: ApplicationConfigurationIndex,
+                          contactConfigurations: ContactConfigurationIndex,
                           innerRingEnabled: Bool)
         -> ANCSV1Result
     {
@@ -0,0 +1,428 @@
+import ReactiveSwift
+import RinglyExtensions
+import RinglyKit
+
+// MARK: - Settings
+
+/// A single application or contact setting, as written to an ANCS v2 peripheral by a settings command.
+struct ANCSV2Setting
+{
+    // MARK: - Properties
+
+    /// The application identifier or contact name.
+    let key: String
+
+    /// The color of the setting.
+    let color: RLYColor
+
+    /// The vibration of the setting. Contact settings always use `.none`.
+    let vibration: RLYVibration
+}
+
+extension ANCSV2Setting: Equatable {}
+func ==(lhs: ANCSV2Setting, rhs: ANCSV2Setting) -> Bool
+{
+    return lhs.key == rhs.key && RLYColorEqualToColor(lhs.color, rhs.color) && lhs.vibration == rhs.vibration
+}
+
+extension ANCSV2Setting
+{
+    // MARK: - Commands
+
+    /**
+     Returns an application settings command for the setting.
+
+     - parameter mode: The command mode to use.
+     */
+    func applicationCommand(for mode: RLYSettingsCommandMode) -> RLYCommand
+    {
+        return RLYApplicationSettingsCommand(mode: mode, applicationIdentifier: key, color: color, vibration: vibration)
+    }
+
+    /**
+     Returns a contact settings command for the setting.
+
+     - parameter mode: The command mode to use.
+     */
+    func contactCommand(for mode: RLYSettingsCommandMode) -> RLYCommand
+    {
+        return RLYContactSettingsCommand(mode: mode, contactName: key, color: color)
+    }
+}
+
+extension ANCSV2Setting
+{
+    // MARK: - Creating Settings from Configurations
+
+    /**
+     Returns a dictionary of settings, keyed by application identifier or contact name.
+
+     If multiple settings share a key, the peripheral's behavior is ambiguous, so `nil` is returned, and the settings
+     must be written in full.
+
+     - parameter settings: The settings.
+     */
+    static func keyed<S: Sequence>(_ settings: S) -> [String:ANCSV2Setting]? where S.Iterator.Element == ANCSV2Setting
+    {
+        var keyed = [String:ANCSV2Setting]()
+
+        for setting in settings
+        {
+            guard keyed.updateValue(setting, forKey: setting.key) == nil else { return nil }
+        }
+
+        return keyed
+    }
+}
+
+extension ApplicationConfiguration
+{
+    /// The settings written to a peripheral for this configuration, one for each of the application's identifiers.
+    var ANCSV2Settings: [ANCSV2Setting]
+    {
+        let color = DefaultColorToLEDColor(self.color)
+
+        return application.identifiers.map({ identifier in
+            ANCSV2Setting(key: identifier, color: color, vibration: vibration)
+        })
+    }
+}
+
+extension ContactConfiguration
+{
+    /// The settings written to a peripheral for this configuration, one for each of the contact's names.
+    var ANCSV2Settings: [ANCSV2Setting]
+    {
+        let color = DefaultColorToLEDColor(self.color)
+
+        return names.map({ name in ANCSV2Setting(key: name, color: color, vibration: .none) })
+    }
+}
+
+// MARK: - Applied Settings
+
+/// The settings most recently written to a peripheral for one half of its configuration hash, and that half's hash.
+///
+/// These settings are only valid while the peripheral reports the same hash - since the hash is written after the
+/// settings commands, a peripheral that reports the hash has received the settings.
+struct ANCSV2AppliedSettings
+{
+    // MARK: - Properties
+
+    /// The hash of the configurations that produced the settings.
+    let hash: UInt32
+
+    /// The settings, keyed by application identifier or contact name.
+    let settings: [String:ANCSV2Setting]
+}
+
+extension ANCSV2AppliedSettings
+{
+    // MARK: - Delta Commands
+
+    /**
+     Returns the commands necessary to change the peripheral's settings from these settings to `target`.
+
+     Settings that are removed or changed are deleted first, then settings that are new or changed are added. Commands
+     are sorted by key, so that the output is deterministic.
+
+     - parameter target:  The settings to change to.
+     - parameter command: A function to create a command for a setting.
+     */
+    func commands(toMatch target: [String:ANCSV2Setting],
+                  command: (ANCSV2Setting, RLYSettingsCommandMode) -> RLYCommand)
+        -> [RLYCommand]
+    {
+        let deletes = settings.values
+            .filter({ setting in target[setting.key] != setting })
+            .sorted(by: { $0.key < $1.key })
+            .map({ setting in command(setting, .delete) })
+
+        let adds = target.values
+            .filter({ setting in settings[setting.key] != setting })
+            .sorted(by: { $0.key < $1.key })
+            .map({ setting in command(setting, .add) })
+
+        return deletes + adds
+    }
+}
+
+/// The applied settings for both halves of a peripheral's configuration hash.
+struct ANCSV2AppliedConfiguration
+{
+    // MARK: - Properties
+
+    /// The applied application settings, or `nil` if they are unknown.
+    let applications: ANCSV2AppliedSettings?
+
+    /// The applied contact settings, or `nil` if they are unknown.
+    let contacts: ANCSV2AppliedSettings?
+}
+
+// MARK: - Snapshots
+extension ANCSV2ConfigurationSnapshot
+{
+    /// The packed hash of the snapshot's configurations.
+    var hash: ANCSV2PackedHash
+    {
+        return ANCSV2PackedHash(applications: applications, contacts: contacts)
+    }
+
+    /// The applied configuration that writing the snapshot to a peripheral will produce. A half is `nil` if its
+    /// settings contain duplicate keys.
+    var appliedConfiguration: ANCSV2AppliedConfiguration
+    {
+        let hash = self.hash
+
+        return ANCSV2AppliedConfiguration(
+            applications: ANCSV2Setting.keyed(applications.lazy.flatMap({ $0.ANCSV2Settings })).map({ settings in
+                ANCSV2AppliedSettings(hash: hash.first, settings: settings)
+            }),
+            contacts: ANCSV2Setting.keyed(contacts.lazy.flatMap({ $0.ANCSV2Settings })).map({ settings in
+                ANCSV2AppliedSettings(hash: hash.second, settings: settings)
+            })
+        )
+    }
+
+    /**
+     Returns the commands necessary to change a peripheral's configuration to match the snapshot.
+
+     For each half of the hash that does not match, if the settings that produced the peripheral's current hash are
+     known, only the differences are written. Otherwise, the peripheral's settings are cleared and written in full.
+
+     - parameter currentHash: The peripheral's current hash.
+     - parameter applied:     The configuration most recently applied to the peripheral, if known.
+     */
+    func commands(toChange currentHash: ANCSV2PackedHash, applied: ANCSV2AppliedConfiguration?) -> [RLYCommand]
+    {
+        let correctHash = hash
+        let target = appliedConfiguration
+        var commands = [RLYCommand]()
+
+        // make sure that the current application settings are correct
+        if currentHash.first != correctHash.first
+        {
+            if let current = applied?.applications, current.hash == currentHash.first,
+               let settings = target.applications?.settings
+            {
+                commands += current.commands(toMatch: settings, command: { $0.applicationCommand(for: $1) })
+            }
+            else
+            {
+                commands.append(RLYClearApplicationSettingsCommand())
+
+                commands += applications.flatMap({ configuration in
+                    configuration.commands(for: .add) as [RLYCommand]
+                })
+            }
+        }
+
+        // make sure that the current contact settings are correct
+        if currentHash.second != correctHash.second
+        {
+            if let current = applied?.contacts, current.hash == currentHash.second,
+               let settings = target.contacts?.settings
+            {
+                commands += current.commands(toMatch: settings, command: { $0.contactCommand(for: $1) })
+            }
+            else
+            {
+                commands.append(RLYClearContactSettingsCommand())
+
+                commands += contacts.flatMap({ configuration -> [RLYCommand] in
+                    configuration.commands(for: .add)
+                })
+            }
+        }
+
+        return commands
+    }
+}
+
+// MARK: - Coding
+extension ANCSV2Setting
+{
+    /// A property list representation of the setting, excluding its key.
+    var encoded: [Int]
+    {
+        return [Int(color.red), Int(color.green), Int(color.blue), vibration.rawValue]
+    }
+
+    /**
+     Decodes a setting from a property list representation.
+
+     - parameter key:     The setting's key.
+     - parameter encoded: The property list representation.
+     */
+    init?(key: String, encoded: Any)
+    {
+        guard let values = encoded as? [Int], values.count == 4,
+              values[0..<3].all({ component in component >= 0 && component <= Int(UInt8.max) }),
+              let vibration = RLYVibration(rawValue: values[3])
+        else { return nil }
+
+        self.init(
+            key: key,
+            color: RLYColorMake(UInt8(values[0]), UInt8(values[1]), UInt8(values[2])),
+            vibration: vibration
+        )
+    }
+}
+
+extension ANCSV2AppliedSettings
+{
+    fileprivate static let hashKey = "hash"
+    fileprivate static let settingsKey = "settings"
+
+    /// A property list representation of the applied settings.
+    var encoded: [String:Any]
+    {
+        var encodedSettings = [String:Any]()
+
+        for (key, setting) in settings
+        {
+            encodedSettings[key] = setting.encoded
+        }
+
+        return [
+            ANCSV2AppliedSettings.hashKey: NSNumber(value: hash),
+            ANCSV2AppliedSettings.settingsKey: encodedSettings
+        ]
+    }
+
+    /**
+     Decodes applied settings from a property list representation.
+
+     - parameter encoded: The property list representation.
+     */
+    init?(encoded: Any?)
+    {
+        guard let dictionary = encoded as? [String:Any],
+              let hash = (dictionary[ANCSV2AppliedSettings.hashKey] as? NSNumber)?.uint32Value,
+              let encodedSettings = dictionary[ANCSV2AppliedSettings.settingsKey] as? [String:Any]
+        else { return nil }
+
+        var settings = [String:ANCSV2Setting]()
+
+        for (key, encodedSetting) in encodedSettings
+        {
+            guard let setting = ANCSV2Setting(key: key, encoded: encodedSetting) else { return nil }
+            settings[key] = setting
+        }
+
+        self.init(hash: hash, settings: settings)
+    }
+}
+
+extension ANCSV2AppliedConfiguration
+{
+    fileprivate static let applicationsKey = "applications"
+    fileprivate static let contactsKey = "contacts"
+
+    /// A property list representation of the applied configuration.
+    var encoded: [String:Any]
+    {
+        var encoded = [String:Any]()
+        encoded[ANCSV2AppliedConfiguration.applicationsKey] = applications?.encoded
+        encoded[ANCSV2AppliedConfiguration.contactsKey] = contacts?.encoded
+        return encoded
+    }
+
+    /**
+     Decodes an applied configuration from a property list representation.
+
+     - parameter encoded: The property list representation.
+     */
+    init(encoded: [String:Any])
+    {
+        self.init(
+            applications: ANCSV2AppliedSettings(encoded: encoded[ANCSV2AppliedConfiguration.applicationsKey]),
+            contacts: ANCSV2AppliedSettings(encoded: encoded[ANCSV2AppliedConfiguration.contactsKey])
+        )
+    }
+}
+
+// MARK: - Store
+
+/// Stores the applied configuration of each ANCS v2 peripheral, keyed by peripheral identifier, in a property list file.
+final class ANCSV2AppliedConfigurationStore
+{
+    // MARK: - Initialization
+
+    /**
+     Initializes a store.
+
+     - parameter filePath:    The file to read from and write to. If `nil`, the store is not persisted.
+     - parameter logFunction: A function to log errors to.
+     */
+    init(filePath: String?, loggingTo logFunction: @escaping (String) -> ())
+    {
+        self.filePath = filePath
+        self.logFunction = logFunction
+
+        if let path = filePath, FileManager.default.fileExists(atPath: path)
+        {
+            if let dictionary = NSDictionary(contentsOfFile: path) as? [String:[String:Any]]
+            {
+                encoded = dictionary
+            }
+            else
+            {
+                logFunction("Could not load ANCS v2 applied configurations from property list file at “\(path)”")
+            }
+        }
+    }
+
+    // MARK: - Properties
+
+    /// The file to read from and write to.
+    fileprivate let filePath: String?
+
+    /// A function to log errors to.
+    fileprivate let logFunction: (String) -> ()
+
+    /// The property list representation of each peripheral's applied configuration.
+    fileprivate var encoded = [String:[String:Any]]()
+
+    /// The scheduler on which the store is written to disk.
+    fileprivate let scheduler = QueueScheduler(qos: .userInitiated, name: "Writing ANCS v2 Applied Configurations")
+
+    // MARK: - Applied Configurations
+
+    /// The applied configuration for a peripheral.
+    ///
+    /// - parameter identifier: The peripheral's identifier.
+    subscript(identifier: UUID) -> ANCSV2AppliedConfiguration?
+    {
+        get
+        {
+            return encoded[identifier.uuidString].map(ANCSV2AppliedConfiguration.init)
+        }
+        set
+        {
+            encoded[identifier.uuidString] = newValue?.encoded
+            write()
+        }
+    }
+
+    /// Writes the store to disk, asynchronously.
+    fileprivate func write()
+    {
+        guard let path = filePath else { return }
+
+        let snapshot = encoded
+        let logFunction = self.logFunction
+
+        scheduler.schedule({
+            do
+            {
+                let data = try PropertyListSerialization.data(fromPropertyList: snapshot, format: .binary, options: 0)
+                try data.write(to: URL(fileURLWithPath: path), options: .atomicWrite)
+            }
+            catch let error as NSError
+            {
+                logFunction("Error writing ANCS v2 applied configurations to “\(path)”: \(error)")
+            }
+        })
+    }
+}
@@ -85,10 +85,7 @@ final class ActivityDayViewController: ServicesViewController
     {
         super.viewDidLoad()
 
-        let cache = ActivityCache(
-            fileURL: FileManager.default.rly_cachesURL
-                .appendingPathComponent("activity-day.realm")
-        )
+        let cache = services.activityCache
     
 
         // enable collection view
@@ -113,10 +110,12 @@ final class ActivityDayViewController: ServicesViewController
 
         hoursDataController <~ hourBoundaryDates.producer
             .mapOptionalFlat({ boundaryDates in
+                // the hours of a day are loaded with a single query
                 let controller = BoundaryDatesDataController(
                     dataSource: activityTracking,
                     cache: cache,
-                    boundaryDates: boundaryDates
+                    boundaryDates: boundaryDates,
+                    maximumDatesPerQuery: boundaryDates.count
                 )
 
                 controller.queriesEnabled.value = true
@@ -3,12 +3,28 @@ import RinglyActivityTracking
 import ReactiveSwift
 import Result
 
+/// The stores that can provide steps data when HealthKit is unavailable.
+enum ActivityTrackingStepsStore
+{
+    /// Steps data is read from the Realm database.
+    case realm
+
+    /// Steps data is read from a columnar store. Updates are also written to the Realm database, which queues them for
+    /// HealthKit.
+    case columnar
+}
+
 extension ActivityTrackingService
 {
     // MARK: - Creating Services
 
     /// Creates an activity tracking service, using HealthKit if available.
-    static func with(healthKitIfAvailable: Bool) -> ActivityTrackingService
+    ///
+    /// - Parameters:
+    ///   - healthKitIfAvailable: Whether or not to use HealthKit, if it is available.
+    ///   - stepsStore: The store to read steps data from when HealthKit is unavailable.
+    static func with(healthKitIfAvailable: Bool, stepsStore: ActivityTrackingStepsStore = .realm)
+        -> ActivityTrackingService
     {
         let healthKitServiceResult: Result<(HKHealthStore, HealthKitService), HealthKitServiceCreateError>?
 
@@ -36,10 +52,24 @@ extension ActivityTrackingService
         let realmURL = NSURL(fileURLWithPath: fm.rly_documentsFile(withName: "ActivityTrackingData-1.realm"))
         let realmService = RealmService(fileURL: realmURL as URL, logFunction: SLogActivityTracking)
 
+        // select the store for steps data
+        let stepsDataSource: StepsDataSource & SourcedStepsDataSource
+
+        switch stepsStore
+        {
+        case .realm:
+            stepsDataSource = realmService
+        case .columnar:
+            stepsDataSource = ColumnarStepsStore(
+                directoryURL: URL(fileURLWithPath: fm.rly_documentsFile(withName: "ActivityTrackingData-Columnar")),
+                logFunction: SLogActivityTracking
+            )
+        }
+
         // create the activity tracking service
         let activityTrackingService = ActivityTrackingService(
             healthKitService: healthKitServiceResult?.value?.1,
-            backupStepsDataSource: realmService,
+            backupStepsDataSource: stepsDataSource,
             backupMindfulMinuteDataSource: realmService,
             retryBoundaryDateErrorsProducer: SignalProducer(
                 NotificationCenter.default.reactive.notifications(
@@ -131,10 +131,7 @@ final class ActivityWeekViewController: ServicesViewController
         let services = self.services
         let scheduler = UIScheduler()
         
-        let cache = ActivityCache(
-            fileURL: FileManager.default.rly_cachesURL
-                .appendingPathComponent("activity-week.realm")
-        )
+        let cache = services.activityCache
         
         // create a week data controller for the current week
         let viewHasAppearedProducer = viewHasAppeared.producer
@@ -161,6 +158,30 @@ final class ActivityWeekViewController: ServicesViewController
             return controller
         })
         
+        // load the selected day first, then the days outward from it - once the user scrolls away from this week, only
+        // the selected day continues to load, and the other days keep their cached values
+        let scrolledAwayProducer = viewHasAppearedProducer.combinePrevious(false).map({ previous, appeared in
+            previous && !appeared
+        })
+
+        dataController.producer.combineLatest(with: bottomViewController.selectedColumnIndexProducer)
+            .map(unwrap)
+            .skipNil()
+            .combineLatest(with: scrolledAwayProducer)
+            .take(until: reactive.lifetime.ended)
+            .startWithValues({ selection, scrolledAway in
+                let (controller, column) = selection
+
+                if scrolledAway
+                {
+                    controller.cancelQueries(outside: column..<(column + 1))
+                }
+                else
+                {
+                    controller.prioritize(visibleIndices: column..<(column + 1))
+                }
+            })
+
         selectedBoundaryDates <~ dataController.producer.mapOptional({ $0.boundaryDates })
             .combineLatest(with: bottomViewController.selectedColumnIndexProducer)
             .map(unwrap)
@@ -0,0 +1,226 @@
+import Foundation
+
+/// An append-only journal of analytics events, stored in a file.
+///
+/// Each event is appended to the end of the file as a record: the date it was added, as the bit pattern of its time
+/// interval since the reference date, then the length of its JSON representation, then the JSON. Integers are
+/// little-endian. Adding an event writes only that event's record. When events are acknowledged, the file is compacted
+/// by rewriting only the records that remain.
+///
+/// A journal is not thread-safe, and must only be used from a single serial queue.
+final class AnalyticsEventJournal
+{
+    // MARK: - Initialization
+
+    /**
+     Initializes an event journal, loading any events already stored in the file. An incomplete record at the end of the
+     file, which may have been left by an interrupted write, is truncated.
+
+     - parameter fileURL: The URL of the journal file. The file is created when the first event is added.
+     */
+    init(fileURL: URL)
+    {
+        self.fileURL = fileURL
+
+        guard let data = try? Data(contentsOf: fileURL, options: .alwaysMapped) else { return }
+
+        let validSize = AnalyticsEventJournal.enumerateRecords(in: data, { date, json in
+            records.append(Record(date: date, length: json.count))
+            byteCount += json.count
+            return true
+        })
+
+        if validSize < data.count, let handle = FileHandle(forWritingAtPath: fileURL.path)
+        {
+            handle.truncateFile(atOffset: UInt64(validSize))
+            handle.closeFile()
+        }
+    }
+
+    // MARK: - File
+
+    /// The URL of the journal file.
+    let fileURL: URL
+
+    /// The size of the fields of a record that precede its JSON.
+    fileprivate static let recordHeaderSize = 12
+
+    // MARK: - Events
+
+    /// A record in the journal file.
+    fileprivate struct Record
+    {
+        /// The date that the event was added.
+        let date: Date
+
+        /// The length of the event's JSON representation.
+        let length: Int
+    }
+
+    /// The records in the journal file, oldest first.
+    fileprivate var records = [Record]()
+
+    /// The number of events in the journal.
+    var count: Int
+    {
+        return records.count
+    }
+
+    /// The total size of the JSON representations of the events in the journal, in bytes.
+    fileprivate(set) var byteCount = 0
+
+    /// The date that the oldest event in the journal was added.
+    var oldestDate: Date?
+    {
+        return records.first?.date
+    }
+
+    // MARK: - Adding Events
+
+    /**
+     Appends an event to the journal.
+
+     - parameter event: The event, which must be representable as JSON.
+     - parameter date:  The date that the event was added.
+
+     - throws: An error if the event could not be encoded or written.
+     */
+    func append(_ event: [String:Any], date: Date) throws
+    {
+        let json = try JSONSerialization.data(withJSONObject: event, options: [])
+        let interval = date.timeIntervalSinceReferenceDate.bitPattern
+
+        var bytes = [UInt8]()
+        bytes.reserveCapacity(AnalyticsEventJournal.recordHeaderSize)
+        bytes.append(contentsOf: (0..<8).map({ byte in UInt8(truncatingBitPattern: interval >> UInt64(8 * byte)) }))
+        bytes.append(contentsOf: (0..<4).map({ byte in UInt8(truncatingBitPattern: json.count >> (8 * byte)) }))
+
+        var record = Data(bytes: bytes)
+        record.append(json)
+
+        let fileManager = FileManager.default
+
+        if !fileManager.fileExists(atPath: fileURL.path)
+        {
+            fileManager.createFile(atPath: fileURL.path, contents: nil, attributes: nil)
+        }
+
+        guard let handle = FileHandle(forWritingAtPath: fileURL.path) else {
+            throw NSError(domain: NSCocoaErrorDomain, code: NSFileWriteUnknownError, userInfo: [
+                NSFilePathErrorKey: fileURL.path
+            ])
+        }
+
+        handle.seekToEndOfFile()
+        handle.write(record)
+        handle.closeFile()
+
+        records.append(Record(date: date, length: json.count))
+        byteCount += json.count
+    }
+
+    // MARK: - Reading Events
+
+    /**
+     Reads a batch of the oldest events in the journal. The batch always includes the oldest event, even if it alone is
+     larger than `maximumBytes`.
+
+     - parameter maximumCount: The maximum number of events to read.
+     - parameter maximumBytes: The maximum total size of the events' JSON representations.
+
+     - returns: The events, and the number of records read, which should be passed to `acknowledge` once the events have
+                been handled. Records that can no longer be decoded are counted, but not included in `events`.
+     */
+    func oldestEvents(maximumCount: Int, maximumBytes: Int) -> (events: [[String:Any]], recordCount: Int)
+    {
+        guard let data = try? Data(contentsOf: fileURL, options: .alwaysMapped) else { return ([], 0) }
+
+        var events = [[String:Any]]()
+        var recordCount = 0, bytes = 0
+
+        AnalyticsEventJournal.enumerateRecords(in: data, { _, json in
+            guard recordCount < maximumCount && (recordCount == 0 || bytes + json.count <= maximumBytes) else {
+                return false
+            }
+
+            if let event = (try? JSONSerialization.jsonObject(with: json, options: [])) as? [String:Any]
+            {
+                events.append(event)
+            }
+
+            recordCount += 1
+            bytes += json.count
+            return true
+        })
+
+        return (events, recordCount)
+    }
+
+    // MARK: - Acknowledging Events
+
+    /**
+     Removes the oldest events from the journal, compacting the journal file.
+
+     - parameter count: The number of events to remove.
+
+     - throws: An error if the journal file could not be rewritten.
+     */
+    func acknowledge(_ count: Int) throws
+    {
+        let count = min(count, records.count)
+        guard count > 0 else { return }
+
+        let recordSize = { (record: Record) in AnalyticsEventJournal.recordHeaderSize + record.length }
+        let acknowledgedSize = records.prefix(count).reduce(0, { $0 + recordSize($1) })
+        let totalSize = records.reduce(0, { $0 + recordSize($1) })
+
+        if count == records.count
+        {
+            try FileManager.default.removeItem(at: fileURL)
+        }
+        else
+        {
+            let data = try Data(contentsOf: fileURL, options: .alwaysMapped)
+            try data.subdata(in: acknowledgedSize..<totalSize).write(to: fileURL, options: .atomic)
+        }
+
+        byteCount -= records.prefix(count).reduce(0, { $0 + $1.length })
+        records.removeFirst(count)
+    }
+
+    // MARK: - Decoding
+
+    /**
+     Enumerates the complete records in journal data.
+
+     - parameter data: The journal data.
+     - parameter body: A function called with the date and JSON of each record, in order. Returning `false` stops
+                       enumeration.
+
+     - returns: The size of the enumerated records, in bytes.
+     */
+    @discardableResult
+    fileprivate static func enumerateRecords(in data: Data, _ body: (Date, Data) -> Bool) -> Int
+    {
+        return data.withUnsafeBytes({ (bytes: UnsafePointer<UInt8>) -> Int in
+            var offset = 0
+
+            while offset + recordHeaderSize <= data.count
+            {
+                let record = bytes + offset
+                let date = (0..<8).reduce(UInt64(0), { date, byte in date | UInt64(record[byte]) << UInt64(8 * byte) })
+                let length = (0..<4).reduce(0, { length, byte in length | Int(record[8 + byte]) << (8 * byte) })
+
+                let jsonOffset = offset + recordHeaderSize
+                guard jsonOffset + length <= data.count else { break }
+
+                let json = Data(bytes: bytes + jsonOffset, count: length)
+                guard body(Date(timeIntervalSinceReferenceDate: TimeInterval(bitPattern: date)), json) else { break }
+
+                offset = jsonOffset + length
+            }
+
+            return offset
+        })
+    }
+}
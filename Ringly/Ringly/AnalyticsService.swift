@@ -19,6 +19,9 @@ final class AnalyticsService: NSObject
     /// Used to track notified events.
     fileprivate let notifiedStore: AnalyticsNotifiedStore
 
+    /// Stores notified events until they have been uploaded.
+    fileprivate let notifiedJournal: AnalyticsEventJournal
+
     /// Used to store super property values.
     fileprivate let superPropertyStore: AnalyticsSuperPropertyStore
 
@@ -32,17 +35,20 @@ final class AnalyticsService: NSObject
     ///   - eventStore: The store to track events with.
     ///   - identityStore: The store to track user identity with.
     ///   - notifiedStore: The store to track notified events with.
+    ///   - notifiedJournal: The journal to store notified events in until they have been uploaded.
     ///   - superPropertyStore: The store to track super properties with.
     init(authenticationProducer: SignalProducer<Authentication, NoError>,
          dateScheduler: DateSchedulerProtocol,
          eventStore: AnalyticsEventStore,
          identityStore: AnalyticsIdentityStore,
          notifiedStore: AnalyticsNotifiedStore,
+         notifiedJournal: AnalyticsEventJournal,
          superPropertyStore: AnalyticsSuperPropertyStore)
     {
         self.dateScheduler = dateScheduler
         self.eventStore = eventStore
         self.notifiedStore = notifiedStore
+        self.notifiedJournal = notifiedJournal
         self.superPropertyStore = superPropertyStore
 
         super.init()
@@ -53,6 +59,9 @@ final class AnalyticsService: NSObject
             .map(AnalyticsIdentifyAction.actions)
             .take(until: reactive.lifetime.ended)
             .startWithValues({ actions in actions.forEach({ $0.apply(to: identityStore) }) })
+
+        // upload or schedule an upload for any events stored by a previous launch
+        flushNotifiedEventsIfNeeded()
     }
 
     convenience init(APIService: RinglyAPI.APIService, mixpanel: Mixpanel)
@@ -63,6 +72,7 @@ final class AnalyticsService: NSObject
             eventStore: mixpanel,
             identityStore: mixpanel,
             notifiedStore: APIService,
+            notifiedJournal: AnalyticsService.makeNotifiedJournal(),
             superPropertyStore: mixpanel
         )
     }
@@ -151,9 +161,31 @@ final class AnalyticsService: NSObject
 
     // MARK: - Notified Events
 
-    /// The number of notified events required to flush `notifiedQueue`.
+    /// The number of notified events that triggers a flush.
     fileprivate static let notifiedEventsPerFlush = 5
 
+    /// The total size of notified events, in bytes, that triggers a flush.
+    fileprivate static let notifiedBytesPerFlush = 16 * 1024
+
+    /// The age of the oldest notified event that triggers a flush.
+    fileprivate static let notifiedMaximumAge: TimeInterval = 15 * 60
+
+    /// The maximum number of notified events uploaded in each request.
+    fileprivate static let notifiedEventsPerRequest = 50
+
+    /// The maximum total size of notified events uploaded in each request, in bytes.
+    fileprivate static let notifiedBytesPerRequest = 64 * 1024
+
+    /// The delay before the first retry of a failed upload. The delay doubles for each consecutive failure.
+    fileprivate static let notifiedInitialRetryDelay: TimeInterval = 30
+
+    /// The maximum delay before retrying a failed upload.
+    fileprivate static let notifiedMaximumRetryDelay: TimeInterval = 60 * 60
+
+    /// The HTTP status codes for which an upload will not succeed on retry, so the batch is dropped. Other client
+    /// errors, such as 401, 408, and 429, are retried.
+    fileprivate static let notifiedRejectedStatusCodes: Set<Int> = [400, 403, 404, 413, 422]
+
     /// The randomly generated UUID string sent with each request. This is stored in user defaults, so it will be the
     /// same unless the user reinstalls the application.
     fileprivate static let notifiedUUIDString: String = { () -> String in
@@ -169,62 +201,165 @@ final class AnalyticsService: NSObject
         }
     }()
 
-    /// The file path where queued notified events are stored.
-    fileprivate static let notifiedFile = FileManager.default.rly_documentsFile(withName: "notified-events.plist")
-
-    /// The current queue of notified events, waiting to go out.
-    fileprivate var notifiedQueue = (NSArray(contentsOfFile: AnalyticsService.notifiedFile) as? [[String:AnyObject]]) ?? []
+    /// Creates the journal for notified events in the documents directory, moving in any events queued by previous
+    /// versions of the app, which stored the entire queue in a property list.
+    fileprivate static func makeNotifiedJournal() -> AnalyticsEventJournal
     {
-        didSet
+        let fileManager = FileManager.default
+        let journal = AnalyticsEventJournal(
+            fileURL: URL(fileURLWithPath: fileManager.rly_documentsFile(withName: "notified-events.journal"))
+        )
+
+        let legacyFile = fileManager.rly_documentsFile(withName: "notified-events.plist")
+
+        if let legacyEvents = NSArray(contentsOfFile: legacyFile) as? [[String:Any]]
         {
-            let safe = notifiedQueue.map({ dictionary in
-                (dictionary as NSDictionary).rly_dictionaryByRemovingNSNull()
+            legacyEvents.forEach({ event in
+                do
+                {
+                    try journal.append(event, date: Date())
+                }
+                catch let error as NSError
+                {
+                    SLogAnalytics("Failed to move notified event to journal: \(error)")
+                }
             })
 
-            if !(safe as NSArray).write(toFile: AnalyticsService.notifiedFile, atomically: true)
-            {
-                SLogAnalytics("Failed to write notified events to file “\(AnalyticsService.notifiedFile)”")
-            }
+            try? fileManager.removeItem(atPath: legacyFile)
         }
+
+        return journal
     }
 
+    /// The upload of notified events in progress, if any.
     fileprivate var notifiedDisposable = Disposable?.none
 
+    /// A scheduled flush of notified events, either for the age of the oldest event, or to retry a failed upload.
+    fileprivate var notifiedScheduledFlushDisposable = Disposable?.none
+
+    /// The delay before retrying the most recent failed upload, or `nil` if the most recent upload did not fail.
+    fileprivate var notifiedRetryDelay = TimeInterval?.none
+
+    /// Flushes notified events if a count, size, or age threshold has been reached. Otherwise, schedules a flush for
+    /// when the oldest event reaches the maximum age. While an upload is in progress, or while waiting to retry a
+    /// failed upload, this function does nothing.
+    fileprivate func flushNotifiedEventsIfNeeded()
+    {
+        guard notifiedDisposable == nil && notifiedRetryDelay == nil else { return }
+        guard let oldestDate = notifiedJournal.oldestDate else { return }
+
+        let flushDate = oldestDate.addingTimeInterval(AnalyticsService.notifiedMaximumAge)
+
+        if notifiedJournal.count >= AnalyticsService.notifiedEventsPerFlush
+            || notifiedJournal.byteCount >= AnalyticsService.notifiedBytesPerFlush
+            || flushDate <= dateScheduler.currentDate
+        {
+            flushNotifiedEvents()
+        }
+        else if notifiedScheduledFlushDisposable == nil
+        {
+            scheduleNotifiedFlush(at: flushDate)
+        }
+    }
+
+    /**
+     Schedules a flush of notified events, replacing any previously scheduled flush.
+
+     - parameter date: The date at which to flush.
+     */
+    fileprivate func scheduleNotifiedFlush(at date: Date)
+    {
+        notifiedScheduledFlushDisposable?.dispose()
+        notifiedScheduledFlushDisposable = dateScheduler.schedule(after: date, action: { [weak self] in
+            self?.notifiedScheduledFlushDisposable = nil
+            self?.flushNotifiedEvents()
+        })
+    }
+
+    /// Uploads a batch of the oldest notified events. Once the batch has been acknowledged, it is removed from the
+    /// journal, and further batches are flushed if necessary.
     fileprivate func flushNotifiedEvents()
     {
         // do not proceed if we already have a disposable!
         guard notifiedDisposable == nil else { return }
 
+        notifiedScheduledFlushDisposable?.dispose()
+        notifiedScheduledFlushDisposable = nil
+
+        let batch = notifiedJournal.oldestEvents(
+            maximumCount: AnalyticsService.notifiedEventsPerRequest,
+            maximumBytes: AnalyticsService.notifiedBytesPerRequest
+        )
+
+        guard batch.recordCount > 0 else { return }
+
         // build the JSON body that we will send
         let mobileVersion = Bundle.main.infoDictionary?[kCFBundleVersionKey as String] as? String
-        let events = notifiedQueue
 
         let dictionary: [String:AnyObject] = [
             "name": 0 as AnyObject,
             "operating_system": 0 as AnyObject,
             "person_id": AnalyticsService.notifiedUUIDString as AnyObject,
             "mobile_version": mobileVersion as AnyObject? ?? NSNull(),
-            "events": events as AnyObject
+            "events": batch.events as AnyObject
         ]
 
         notifiedDisposable = notifiedStore.trackNotifiedProducer(parameters: dictionary)
             .observe(on: QueueScheduler.main)
-            .on(failed: { error in
-                // TODO: keep events for errors that aren't bad?
-                SLogAnalytics("Failed to upload notified events: \(error)")
-            }, completed: {
-                SLogAnalytics("Successfully uploaded \(events.count) notified events")
-            }, terminated: { [weak self] in
-                // update the notified queue
-                guard let strongSelf = self else { return }
-                strongSelf.notifiedQueue = Array(strongSelf.notifiedQueue.dropFirst(events.count))
-
-                // remove the disposable, so that we can run this again
-                strongSelf.notifiedDisposable = nil
+            .on(failed: { [weak self] error in
+                // rejected uploads will not succeed on retry, so the batch is dropped
+                if error.domain == APIService.httpErrorDomain
+                    && AnalyticsService.notifiedRejectedStatusCodes.contains(error.code)
+                {
+                    SLogAnalytics("Dropping \(batch.recordCount) notified events, upload was rejected: \(error)")
+                    self?.completeNotifiedUpload(acknowledging: batch.recordCount)
+                }
+                else
+                {
+                    SLogAnalytics("Failed to upload notified events: \(error)")
+                    self?.retryNotifiedUpload()
+                }
+            }, completed: { [weak self] in
+                SLogAnalytics("Successfully uploaded \(batch.recordCount) notified events")
+                self?.completeNotifiedUpload(acknowledging: batch.recordCount)
             })
             .start()
     }
 
+    /**
+     Removes uploaded events from the journal, then flushes again if necessary.
+
+     - parameter count: The number of events to remove.
+     */
+    fileprivate func completeNotifiedUpload(acknowledging count: Int)
+    {
+        notifiedDisposable = nil
+        notifiedRetryDelay = nil
+
+        do
+        {
+            try notifiedJournal.acknowledge(count)
+        }
+        catch let error as NSError
+        {
+            SLogAnalytics("Failed to remove uploaded notified events from journal: \(error)")
+        }
+
+        flushNotifiedEventsIfNeeded()
+    }
+
+    /// Schedules a retry of a failed upload, after an exponentially increasing delay.
+    fileprivate func retryNotifiedUpload()
+    {
+        notifiedDisposable = nil
+
+        let delay = notifiedRetryDelay.map({ min($0 * 2, AnalyticsService.notifiedMaximumRetryDelay) })
+            ?? AnalyticsService.notifiedInitialRetryDelay
+
+        notifiedRetryDelay = delay
+        scheduleNotifiedFlush(at: dateScheduler.currentDate.addingTimeInterval(delay))
+    }
+
     /// The date formatter for notified events.
     fileprivate let notifiedFormatter: DateFormatter = { () -> DateFormatter in
         let formatter = DateFormatter()
@@ -263,13 +398,18 @@ extension AnalyticsService: AnalyticsNotifiedEventSink
             "created": notifiedFormatter.string(from: Date()) as AnyObject? ?? NSNull()
         ]
 
-        SLogAnalytics("Adding notified event to queue: \(event)")
-        notifiedQueue.append(event)
+        SLogAnalytics("Adding notified event to journal: \(event)")
 
-        if notifiedQueue.count > AnalyticsService.notifiedEventsPerFlush
+        do
         {
-            flushNotifiedEvents()
+            try notifiedJournal.append(event, date: dateScheduler.currentDate)
+        }
+        catch let error as NSError
+        {
+            SLogAnalytics("Failed to add notified event to journal: \(error)")
         }
+
+        flushNotifiedEventsIfNeeded()
     }
 }
 
@@ -0,0 +1,38 @@
+import ReactiveSwift
+
+/// An index of application configurations by application identifier.
+///
+/// Lookups have the same results as `configurationMatching(applicationIdentifier:trimLengthToMatch:)` on the
+/// configurations array: identifiers are compared case-insensitively, and if multiple configurations match, the first is
+/// returned.
+typealias ApplicationConfigurationIndex = ConfigurationIndex<ApplicationConfiguration>
+
+extension ApplicationConfiguration: KeyedConfigurable
+{
+    // MARK: - Keys
+
+    /// Application configurations are matched by their application's identifiers.
+    var indexKeys: [String]
+    {
+        return application.identifiers
+    }
+
+    /// Folds the case of an identifier, for case-insensitive comparison.
+    static func normalizedKey(_ key: String) -> String
+    {
+        return key.folding(options: .caseInsensitive, locale: nil)
+    }
+}
+
+// MARK: - Producers
+extension SignalProducerProtocol where Value == [ApplicationConfiguration]
+{
+    /// Indexes each array of configurations, reusing the previous index's lookup tables when application identifiers
+    /// have not changed.
+    func indexed() -> SignalProducer<ApplicationConfigurationIndex, Error>
+    {
+        return scan(ApplicationConfigurationIndex?.none, { index, configurations in
+            index?.updated(with: configurations) ?? ApplicationConfigurationIndex(configurations)
+        }).skipNil()
+    }
+}
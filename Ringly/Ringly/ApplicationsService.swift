@@ -73,6 +73,9 @@ extension Sequence where Iterator.Element == ApplicationConfiguration
      Returns the configuration for the specified application identifier, if one exists. This uses the `configurations`
      value, so the configuration will not necessarily be installed or activated.
 
+     This performs a linear search - when matching repeatedly against the same configurations, as for ANCS
+     notifications, use `ApplicationConfigurationIndex`.
+
      - parameter applicationIdentifier: The application identifier to look up.
      - parameter trimLengthToMatch:     If `true`, the application identifier will be used as a prefix for comparison.
      */
@@ -101,9 +104,11 @@ extension Sequence where Iterator.Element == String
      */
     func containsCaseInsensitive(_ string: String, trimLengthToMatch: Bool = false) -> Bool
     {
-        return reduce(false, { current, element in
-            let trimmed = trimLengthToMatch ? element.trimmedTo(length: string.characters.count) : element
-            return current || string.caseInsensitiveCompare(trimmed) == .orderedSame
+        let length = string.characters.count
+
+        return contains(where: { element in
+            let trimmed = trimLengthToMatch ? element.trimmedTo(length: length) : element
+            return string.caseInsensitiveCompare(trimmed) == .orderedSame
         })
     }
 }
@@ -0,0 +1,119 @@
+import Foundation
+
+/// Writes comma-separated values to a file handle, one field at a time. Output is buffered in a fixed-size chunk, so
+/// that tables of any size are written with constant memory.
+final class CommaSeparatedValueWriter
+{
+    // MARK: - Initialization
+
+    /**
+     Initializes a comma-separated value writer.
+
+     - parameter fileHandle: The file handle to write to.
+     - parameter chunkSize:  The number of bytes to buffer before writing to `fileHandle`.
+     */
+    init(fileHandle: FileHandle, chunkSize: Int = 64 * 1024)
+    {
+        self.fileHandle = fileHandle
+        self.chunkSize = max(chunkSize, 1)
+        chunk.reserveCapacity(self.chunkSize)
+    }
+
+    // MARK: - Output
+
+    /// The file handle to write to.
+    let fileHandle: FileHandle
+
+    /// The number of bytes to buffer before writing to `fileHandle`.
+    let chunkSize: Int
+
+    /// The bytes that have not yet been written to `fileHandle`.
+    fileprivate var chunk = [UInt8]()
+
+    /// `true` if a field has been appended to the current row.
+    fileprivate var rowStarted = false
+
+    // MARK: - Writing
+
+    /**
+     Appends an escaped field to the current row.
+
+     - parameter bytes: The UTF-8 bytes of the field.
+     */
+    func append<Bytes: Sequence>(field bytes: Bytes) where Bytes.Iterator.Element == UInt8
+    {
+        if rowStarted
+        {
+            chunk.append(CommaSeparatedValueWriter.comma)
+        }
+
+        rowStarted = true
+        chunk.append(CommaSeparatedValueWriter.quote)
+
+        for byte in bytes
+        {
+            // quotes are escaped by doubling them
+            if byte == CommaSeparatedValueWriter.quote
+            {
+                chunk.append(byte)
+            }
+
+            chunk.append(byte)
+        }
+
+        chunk.append(CommaSeparatedValueWriter.quote)
+    }
+
+    /**
+     Appends an escaped field to the current row.
+
+     - parameter field: The field.
+     */
+    func append(field: String)
+    {
+        append(field: field.utf8)
+    }
+
+    /// Ends the current row, writing the buffered output if the chunk is full.
+    func endRow()
+    {
+        chunk.append(CommaSeparatedValueWriter.newline)
+        rowStarted = false
+
+        if chunk.count >= chunkSize
+        {
+            writeChunk()
+        }
+    }
+
+    /**
+     Appends a complete row.
+
+     - parameter fields: The fields of the row.
+     */
+    func append(row fields: [String])
+    {
+        fields.forEach({ append(field: $0) })
+        endRow()
+    }
+
+    /// Writes all buffered output to the file handle.
+    func finish()
+    {
+        writeChunk()
+    }
+
+    /// Writes the buffered chunk to the file handle, and empties it.
+    fileprivate func writeChunk()
+    {
+        guard !chunk.isEmpty else { return }
+
+        fileHandle.write(Data(bytes: chunk))
+        chunk.removeAll(keepingCapacity: true)
+    }
+
+    // MARK: - Bytes
+    fileprivate static let comma = UInt8(ascii: ",")
+    fileprivate static let quote = UInt8(ascii: "\"")
+    fileprivate static let newline = UInt8(ascii: "\n")
+}
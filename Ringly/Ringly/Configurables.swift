@@ -23,6 +23,20 @@ protocol IdentifierConfigurable
     var identifier: String { get }
 }
 
+/// A protocol for configuration types that are matched by strings, and can be indexed by `ConfigurationIndex`.
+protocol KeyedConfigurable
+{
+    /// The strings that the configuration is matched by.
+    var indexKeys: [String] { get }
+
+    /**
+     Normalizes a key or a string to match, so that equivalent strings compare exactly.
+
+     - parameter key: The key or string to match.
+     */
+    static func normalizedKey(_ key: String) -> String
+}
+
 /// A protocol for configuration types that have a vibration pattern associated with them.
 protocol VibrationConfigurable
 {
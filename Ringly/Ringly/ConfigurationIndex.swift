@@ -0,0 +1,107 @@
+import RinglyExtensions
+
+/// An index of configurations by their normalized keys, for matching ANCS notifications without scanning every
+/// configuration.
+///
+/// Keys are compared after normalization with `Configuration.normalizedKey`, and if multiple configurations match, the
+/// first is returned, so lookups have the same results as a linear search of the configurations array.
+struct ConfigurationIndex<Configuration: KeyedConfigurable>
+{
+    // MARK: - Initialization
+
+    /**
+     Initializes an index.
+
+     - parameter configurations: The configurations to index.
+     */
+    init(_ configurations: [Configuration])
+    {
+        let keys = configurations.map({ configuration in configuration.indexKeys.map(Configuration.normalizedKey) })
+
+        var exact = [String:Int]()
+        var trie = PrefixTrie()
+
+        for (index, normalized) in keys.enumerated()
+        {
+            for key in normalized
+            {
+                if exact[key] == nil
+                {
+                    exact[key] = index
+                }
+
+                trie.insert(key, index: index)
+            }
+        }
+
+        self.configurations = configurations
+        self.keys = keys
+        self.exact = exact
+        self.trie = trie
+    }
+
+    // MARK: - Properties
+
+    /// The indexed configurations.
+    let configurations: [Configuration]
+
+    /// The normalized keys of each configuration, used to determine whether the index can be reused.
+    fileprivate let keys: [[String]]
+
+    /// The index of the first configuration for each normalized key.
+    fileprivate let exact: [String:Int]
+
+    /// A prefix trie of normalized keys, for matching strings truncated by ANCS.
+    fileprivate let trie: PrefixTrie
+
+    // MARK: - Updating
+
+    /**
+     Returns an index for new configurations, reusing the receiver's lookup tables if the configurations' keys have not
+     changed - for example, if only colors, vibrations, or activation have changed.
+
+     - parameter configurations: The new configurations.
+     */
+    func updated(with configurations: [Configuration]) -> ConfigurationIndex
+    {
+        let unchanged = configurations.count == keys.count
+            && zip(configurations, keys).all({ configuration, normalized in
+                configuration.indexKeys.map(Configuration.normalizedKey) == normalized
+            })
+
+        return unchanged
+            ? ConfigurationIndex(configurations: configurations, reusing: self)
+            : ConfigurationIndex(configurations)
+    }
+
+    /**
+     Initializes an index with new configurations, reusing the lookup tables of an existing index.
+
+     - parameter configurations: The new configurations.
+     - parameter index:          The index to reuse.
+     */
+    private init(configurations: [Configuration], reusing index: ConfigurationIndex)
+    {
+        self.configurations = configurations
+        self.keys = index.keys
+        self.exact = index.exact
+        self.trie = index.trie
+    }
+
+    // MARK: - Matching
+
+    /**
+     Returns the first configuration matching a string, if one exists.
+
+     - parameter string:            The string to match.
+     - parameter trimLengthToMatch: If `true`, the string will be used as a prefix for comparison. This is used to match
+                                    strings received from ANCS, which have a length limit.
+     */
+    func configuration(matching string: String, trimLengthToMatch: Bool = false) -> Configuration?
+    {
+        let normalized = Configuration.normalizedKey(string)
+        let index = trimLengthToMatch ? trie.firstIndex(withPrefix: normalized) : exact[normalized]
+
+        return index.map({ configurations[$0] })
+    }
+}
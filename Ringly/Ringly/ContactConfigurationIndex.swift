@@ -0,0 +1,41 @@
+import ReactiveSwift
+
+/// An index of contact configurations by name.
+///
+/// Lookups have the same results as `contactConfiguration(_:trimLengthToMatch:)` on the configurations array: names are
+/// compared case-insensitively, and if multiple configurations match, the first is returned. Names are also normalized
+/// to their precomposed form, so that titles and contact names using different Unicode representations of the same
+/// characters will match.
+typealias ContactConfigurationIndex = ConfigurationIndex<ContactConfiguration>
+
+extension ContactConfiguration: KeyedConfigurable
+{
+    // MARK: - Keys
+
+    /// Contact configurations are matched by their contact's names.
+    var indexKeys: [String]
+    {
+        return names
+    }
+
+    /// Folds the case of a name and normalizes its Unicode representation, for comparison.
+    static func normalizedKey(_ key: String) -> String
+    {
+        return key.folding(options: .caseInsensitive, locale: nil).precomposedStringWithCanonicalMapping
+    }
+}
+
+// MARK: - Producers
+extension SignalProducerProtocol where Value == [ContactConfiguration]
+{
+    /// Indexes each array of configurations, reusing the previous index's lookup tables when names have not changed.
+    ///
+    /// Since `ContactsService.automaticContactUpdateProducer` updates the service's configurations when the contact
+    /// store changes, indexing the service's configurations producer keeps the index in sync with the contact store.
+    func indexed() -> SignalProducer<ContactConfigurationIndex, Error>
+    {
+        return scan(ContactConfigurationIndex?.none, { index, configurations in
+            index?.updated(with: configurations) ?? ContactConfigurationIndex(configurations)
+        }).skipNil()
+    }
+}
@@ -134,6 +134,9 @@ extension Sequence where Iterator.Element == ContactConfiguration
     /**
      Finds a contact configuration matching the given name, if possible.
 
+     This performs a linear search - when matching repeatedly against the same configurations, as for ANCS
+     notifications, use `ContactConfigurationIndex`.
+
      - parameter name:              The name to match.
      - parameter trimLengthToMatch: If the configuration's name should be trimmed to the same length as the given name.
                                     This is used to match names received from ANCS, which have a length limit.
@@ -0,0 +1,103 @@
+import Foundation
+
+/// A fixed-capacity ring buffer of log messages, which may be appended to from any thread.
+///
+/// Appending only stores the message and advances an index, so the lock is held for a constant, very short time. If the
+/// buffer is full, the oldest message is overwritten, and counted in the next drain's `dropped` count.
+final class LoggingBuffer
+{
+    // MARK: - Initialization
+
+    /**
+     Initializes a logging buffer.
+
+     - parameter capacity: The maximum number of messages that the buffer will hold before overwriting older messages.
+     */
+    init(capacity: Int)
+    {
+        self.capacity = max(capacity, 1)
+        self.messages = Array(repeating: nil, count: self.capacity)
+    }
+
+    // MARK: - Storage
+
+    /// The maximum number of messages that the buffer will hold.
+    let capacity: Int
+
+    /// The storage for messages. Only accessed while holding `lock`.
+    fileprivate var messages: [LoggingMessage?]
+
+    /// The index in `messages` of the oldest message. Only accessed while holding `lock`.
+    fileprivate var head = 0
+
+    /// The number of messages currently stored. Only accessed while holding `lock`.
+    fileprivate var count = 0
+
+    /// The number of messages overwritten since the last drain. Only accessed while holding `lock`.
+    fileprivate var dropped = 0
+
+    /// Protects the buffer's state.
+    fileprivate let lock = NSLock()
+
+    // MARK: - Appending
+
+    /**
+     Appends a message to the buffer.
+
+     - parameter message: The message to append.
+
+     - returns: The number of messages in the buffer, including the new message.
+     */
+    @discardableResult
+    func append(_ message: LoggingMessage) -> Int
+    {
+        lock.lock()
+        defer { lock.unlock() }
+
+        if count == capacity
+        {
+            // overwrite the oldest message
+            messages[head] = message
+            head = (head + 1) % capacity
+            dropped += 1
+        }
+        else
+        {
+            messages[(head + count) % capacity] = message
+            count += 1
+        }
+
+        return count
+    }
+
+    // MARK: - Draining
+
+    /**
+     Removes all messages from the buffer.
+
+     - returns: The messages, oldest first, and the number of messages that were overwritten since the last drain.
+     */
+    func drain() -> (messages: [LoggingMessage], dropped: Int)
+    {
+        lock.lock()
+
+        var drained = [LoggingMessage]()
+        drained.reserveCapacity(count)
+
+        for offset in 0..<count
+        {
+            let index = (head + offset) % capacity
+            drained.append(messages[index]!)
+            messages[index] = nil
+        }
+
+        let drainedDropped = dropped
+        head = 0
+        count = 0
+        dropped = 0
+
+        lock.unlock()
+
+        return (messages: drained, dropped: drainedDropped)
+    }
+}
@@ -1,56 +1,39 @@
-import RealmSwift
+import Foundation
 
-final class LoggingMessage: Object
+/// A message recorded by the logging service.
+struct LoggingMessage
 {
-    // MARK: - Initialization
-
-    /// Initializes a logging message with all properties.
-    ///
-    /// - Parameters:
-    ///   - text: The text of the log message.
-    ///   - type: The type of log message.
-    ///   - date: The date that the log message was recorded.
-    convenience init(text: String, type: RLogType, date: Date)
-    {
-        self.init()
-        self.text = text
-        self.type = type
-        self.date = date
-    }
-
     // MARK: - Properties
 
     /// The text of the log message.
-    dynamic var text: String?
-
-    /// A backing property for `type`.
-    dynamic fileprivate var _type: Int = 0
+    let text: String
 
     /// The type of log message.
-    var type: RLogType?
-    {
-        get { return RLogType(rawValue: _type) }
-        set { _type = newValue?.rawValue ?? 0 }
-    }
+    let type: RLogType
 
     /// The date that the log message was recorded.
-    dynamic var date: Date?
+    let date: Date
+}
 
-    // MARK: - Equality
+// MARK: - Equality
+extension LoggingMessage: Equatable {}
 
-    /// Log messages are equal if their `text`, `type`, and `date` properties are equal.
-    ///
-    /// - Parameter object: The other object.
-    /// - Returns: `true` if the objects are equal, otherwise `false`.
-    override func isEqual(_ object: Any?) -> Bool
-    {
-        guard let other = object as? LoggingMessage else { return false }
-        return text == other.text && _type == other._type && date == other.date
-    }
+/// Log messages are equal if their `text`, `type`, and `date` properties are equal.
+///
+/// - Parameters:
+///   - lhs: The first message.
+///   - rhs: The second message.
+/// - Returns: `true` if the messages are equal, otherwise `false`.
+func ==(lhs: LoggingMessage, rhs: LoggingMessage) -> Bool
+{
+    return lhs.text == rhs.text && lhs.type == rhs.type && lhs.date == rhs.date
 }
 
 extension LoggingMessage: CommaSeparatedValueRepresentable
 {
+    /// The formatter used for the date field of comma-separated log messages.
+    static let commaSeparatedDateFormatter = DateFormatter(format: "yyyy-MM-dd HH:mm:ss.SSS")
+
     static var commaSeparatedHeaders: [String]
     {
         return ["Date", "Type", "Message"]
@@ -58,13 +41,10 @@ extension LoggingMessage: CommaSeparatedValueRepresentable
 
     var commaSeparatedFields: [String]
     {
-        let formatter = DateFormatter(format: "yyyy-MM-dd HH:mm:ss.SSS")
-
         return [
-            formatter.string(from: date!),
-            RLogTypeToString(type!),
-            text!
+            LoggingMessage.commaSeparatedDateFormatter.string(from: date),
+            RLogTypeToString(type),
+            text
         ]
     }
 }
-
@@ -0,0 +1,93 @@
+import Foundation
+
+/// The binary format of the logging service's segment files.
+///
+/// A segment begins with a four-byte header, followed by a record for each message. A record is the message's date,
+/// as the bit pattern of its time interval since the reference date, then its type, then the length of its text, then
+/// its UTF-8 text. Integers are little-endian.
+enum LoggingSegment
+{
+    // MARK: - Format
+
+    /// The bytes that begin every segment file.
+    static let header: [UInt8] = Array("RLG1".utf8)
+
+    /// The size of the fields of a record that precede its text.
+    static let recordHeaderSize = 16
+
+    // MARK: - Encoding
+
+    /**
+     Appends the record for a message to segment data.
+
+     - parameter message: The message.
+     - parameter data:    The segment data.
+     */
+    static func append(_ message: LoggingMessage, to data: inout Data)
+    {
+        let text = Array(message.text.utf8)
+        let date = message.date.timeIntervalSinceReferenceDate.bitPattern
+
+        var bytes = [UInt8]()
+        bytes.reserveCapacity(recordHeaderSize + text.count)
+        bytes.append(contentsOf: (0..<8).map({ byte in UInt8(truncatingBitPattern: date >> UInt64(8 * byte)) }))
+        bytes.append(contentsOf: littleEndianBytes(of: message.type.rawValue))
+        bytes.append(contentsOf: littleEndianBytes(of: text.count))
+        bytes.append(contentsOf: text)
+
+        data.append(bytes, count: bytes.count)
+    }
+
+    /// The four little-endian bytes of an integer.
+    fileprivate static func littleEndianBytes(of value: Int) -> [UInt8]
+    {
+        return (0..<4).map({ byte in UInt8(truncatingBitPattern: value >> (8 * byte)) })
+    }
+
+    // MARK: - Decoding
+
+    /**
+     Enumerates the records in segment data. Enumeration stops at the first incomplete record, which may have been left
+     by an interrupted write. If the data does not begin with `header`, no records are enumerated.
+
+     - parameter data: The segment data.
+     - parameter body: A function called with the date, type, and UTF-8 text of each record, in order. The text buffer
+                       is only valid for the duration of the call.
+     */
+    static func enumerateRecords(in data: Data,
+                                 _ body: (Date, RLogType, UnsafeBufferPointer<UInt8>) throws -> ()) rethrows
+    {
+        guard data.count >= header.count else { return }
+
+        try data.withUnsafeBytes({ (bytes: UnsafePointer<UInt8>) -> () in
+            guard Array(UnsafeBufferPointer(start: bytes, count: header.count)) == header else { return }
+
+            var offset = header.count
+
+            while offset + recordHeaderSize <= data.count
+            {
+                let record = bytes + offset
+                let date = (0..<8).reduce(UInt64(0), { date, byte in date | UInt64(record[byte]) << UInt64(8 * byte) })
+                let type = littleEndianInteger(at: record + 8)
+                let length = littleEndianInteger(at: record + 12)
+
+                let textOffset = offset + recordHeaderSize
+                guard textOffset + length <= data.count else { return }
+
+                try body(
+                    Date(timeIntervalSinceReferenceDate: TimeInterval(bitPattern: date)),
+                    RLogType(rawValue: type),
+                    UnsafeBufferPointer(start: bytes + textOffset, count: length)
+                )
+
+                offset = textOffset + length
+            }
+        })
+    }
+
+    /// The integer encoded by the four little-endian bytes at a pointer.
+    fileprivate static func littleEndianInteger(at pointer: UnsafePointer<UInt8>) -> Int
+    {
+        return (0..<4).reduce(0, { value, byte in value | Int(pointer[byte]) << (8 * byte) })
+    }
+}
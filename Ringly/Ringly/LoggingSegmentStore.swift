@@ -0,0 +1,269 @@
+import Foundation
+
+/// Stores log messages in a directory of size-capped segment files, named with increasing sequence numbers. Messages
+/// are appended to the newest segment, until appending would exceed the maximum segment size. Segments are deleted
+/// whole, once all of their messages have expired.
+///
+/// A segment store is not thread-safe, and must only be used from a single serial queue. Segment files may be read on
+/// any queue.
+final class LoggingSegmentStore
+{
+    // MARK: - Initialization
+
+    /**
+     Initializes a segment store. The directory is not read until the store is first used.
+
+     - parameter directoryURL:       The directory to store segment files in. This directory must exist.
+     - parameter maximumSegmentSize: The size, in bytes, at which a new segment is started.
+     */
+    init(directoryURL: URL, maximumSegmentSize: Int)
+    {
+        self.directoryURL = directoryURL
+        self.maximumSegmentSize = maximumSegmentSize
+    }
+
+    // MARK: - Configuration
+
+    /// The directory in which segment files are stored.
+    let directoryURL: URL
+
+    /// The size, in bytes, at which a new segment is started.
+    let maximumSegmentSize: Int
+
+    /// The path extension of segment files.
+    fileprivate static let pathExtension = "rlog"
+
+    // MARK: - Segments
+
+    /// A segment file in the store.
+    fileprivate struct Segment
+    {
+        /// The segment's sequence number.
+        let sequence: Int
+
+        /// The segment's file URL.
+        let url: URL
+
+        /// The date of the segment's first message.
+        let firstDate: Date
+    }
+
+    /// The segments in the store, oldest first. Only valid once `loaded` is `true`.
+    fileprivate var segments = [Segment]()
+
+    /// The date of the newest message in the newest segment.
+    fileprivate var newestDate: Date?
+
+    /// The size, in bytes, of the newest segment.
+    fileprivate var newestSize = 0
+
+    /// Whether or not the store's segments have been loaded from the directory.
+    fileprivate var loaded = false
+
+    /// The URLs of the store's segment files, oldest first.
+    var segmentURLs: [URL]
+    {
+        loadIfNeeded()
+        return segments.map({ $0.url })
+    }
+
+    /// Loads the segments in the directory, if they have not yet been loaded. Segments without any complete messages
+    /// are deleted, and an incomplete message at the end of the newest segment is truncated, so that it is not
+    /// followed by further messages.
+    fileprivate func loadIfNeeded()
+    {
+        guard !loaded else { return }
+        loaded = true
+
+        let fileManager = FileManager.default
+
+        for (sequence, url) in LoggingSegmentStore.numberedSegmentFiles(in: directoryURL)
+        {
+            var firstDate: Date?, lastDate: Date?
+            var validSize = LoggingSegment.header.count
+
+            if let data = try? Data(contentsOf: url, options: .alwaysMapped)
+            {
+                LoggingSegment.enumerateRecords(in: data, { date, _, text in
+                    firstDate = firstDate ?? date
+                    lastDate = date
+                    validSize += LoggingSegment.recordHeaderSize + text.count
+                })
+            }
+
+            guard let date = firstDate else {
+                try? fileManager.removeItem(at: url)
+                continue
+            }
+
+            segments.append(Segment(sequence: sequence, url: url, firstDate: date))
+            newestDate = lastDate
+            newestSize = validSize
+        }
+
+        if let newest = segments.last, let handle = FileHandle(forWritingAtPath: newest.url.path)
+        {
+            handle.truncateFile(atOffset: UInt64(newestSize))
+            handle.closeFile()
+        }
+    }
+
+    /**
+     Finds the segment files in a directory.
+
+     - parameter directoryURL: The directory.
+
+     - returns: The sequence number and URL of each segment file, oldest first.
+     */
+    fileprivate static func numberedSegmentFiles(in directoryURL: URL) -> [(sequence: Int, url: URL)]
+    {
+        let fileManager = FileManager.default
+        let contents = (try? fileManager.contentsOfDirectory(at: directoryURL, includingPropertiesForKeys: nil)) ?? []
+
+        return contents
+            .flatMap({ url -> (sequence: Int, url: URL)? in
+                guard url.pathExtension == LoggingSegmentStore.pathExtension else { return nil }
+                return Int(url.deletingPathExtension().lastPathComponent).map({ (sequence: $0, url: url) })
+            })
+            .sorted(by: { $0.sequence < $1.sequence })
+    }
+
+    /**
+     Finds the segment files in a directory, without loading or modifying them. Unlike `segmentURLs`, this may be
+     called on any queue.
+
+     - parameter directoryURL: The directory.
+
+     - returns: The segment file URLs, oldest first.
+     */
+    static func segmentURLs(in directoryURL: URL) -> [URL]
+    {
+        return numberedSegmentFiles(in: directoryURL).map({ $0.url })
+    }
+
+    // MARK: - Appending
+
+    /**
+     Appends messages to the store, in a single write.
+
+     - parameter messages: The messages to append, oldest first.
+
+     - throws: An error if the messages could not be written.
+     */
+    func append(_ messages: [LoggingMessage]) throws
+    {
+        guard let first = messages.first, let last = messages.last else { return }
+
+        loadIfNeeded()
+
+        var data = Data()
+        messages.forEach({ LoggingSegment.append($0, to: &data) })
+
+        if segments.isEmpty || newestSize + data.count > maximumSegmentSize
+        {
+            try startSegment(firstDate: first.date)
+        }
+
+        guard let newest = segments.last, let handle = FileHandle(forWritingAtPath: newest.url.path) else {
+            throw NSError(domain: NSCocoaErrorDomain, code: NSFileWriteUnknownError, userInfo: [
+                NSFilePathErrorKey: segments.last?.url.path ?? directoryURL.path
+            ])
+        }
+
+        handle.seekToEndOfFile()
+        handle.write(data)
+        handle.closeFile()
+
+        newestSize += data.count
+        newestDate = last.date
+    }
+
+    /**
+     Starts a new, empty segment.
+
+     - parameter firstDate: The date of the first message that will be written to the segment.
+     */
+    fileprivate func startSegment(firstDate: Date) throws
+    {
+        let sequence = (segments.last?.sequence ?? 0) + 1
+        let url = directoryURL
+            .appendingPathComponent(String(sequence))
+            .appendingPathExtension(LoggingSegmentStore.pathExtension)
+
+        try Data(bytes: LoggingSegment.header).write(to: url, options: .atomic)
+
+        segments.append(Segment(sequence: sequence, url: url, firstDate: firstDate))
+        newestSize = LoggingSegment.header.count
+        newestDate = nil
+    }
+
+    // MARK: - Pruning
+
+    /**
+     Deletes every segment that contains only messages recorded before a date. A segment's messages are no newer than
+     the first message of the following segment.
+
+     - parameter date: The cutoff date.
+     */
+    func prune(before date: Date)
+    {
+        loadIfNeeded()
+
+        var expired = 0
+
+        while expired < segments.count
+        {
+            let newest = expired + 1 < segments.count ? segments[expired + 1].firstDate : newestDate
+            guard let newestInSegment = newest, newestInSegment < date else { break }
+            expired += 1
+        }
+
+        segments.prefix(expired).forEach({ try? FileManager.default.removeItem(at: $0.url) })
+        segments.removeFirst(expired)
+
+        if segments.isEmpty
+        {
+            newestDate = nil
+            newestSize = 0
+        }
+    }
+
+    // MARK: - Reading
+
+    /**
+     Enumerates the records in a segment file. Mapping the file means that only the records being read are resident in
+     memory. If the file cannot be read, for example because it has been pruned, no records are enumerated.
+
+     - parameter url:  The segment file URL.
+     - parameter body: A function called with the date, type, and UTF-8 text of each record, in order. The text buffer
+                       is only valid for the duration of the call.
+     */
+    static func enumerateRecords(inSegmentAt url: URL,
+                                 _ body: (Date, RLogType, UnsafeBufferPointer<UInt8>) throws -> ()) rethrows
+    {
+        guard let data = try? Data(contentsOf: url, options: .alwaysMapped) else { return }
+        try LoggingSegment.enumerateRecords(in: data, body)
+    }
+
+    /**
+     Reads the messages in segment files.
+
+     - parameter urls: The segment file URLs, oldest first.
+
+     - returns: The messages, in the order they were written.
+     */
+    static func messages(inSegmentsAt urls: [URL]) -> [LoggingMessage]
+    {
+        var messages = [LoggingMessage]()
+
+        for url in urls
+        {
+            enumerateRecords(inSegmentAt: url, { date, type, text in
+                let message = String(bytes: text, encoding: .utf8) ?? ""
+                messages.append(LoggingMessage(text: message, type: type, date: date))
+            })
+        }
+
+        return messages
+    }
+}
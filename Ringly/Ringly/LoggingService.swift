@@ -1,30 +1,70 @@
 import Foundation
+import ReactiveCocoa
 import ReactiveSwift
-import RealmSwift
 import Result
-import RinglyActivityTracking
+import RinglyExtensions
+import UIKit
 import class DFULibrary.ZipArchive
 
 final class LoggingService: NSObject
 {
     // MARK: - Singleton
-    static let sharedLoggingService = try? LoggingService(
-        storeURL: LoggingService.directoryURL.appendingPathComponent("l.realm"),
-        cutoff: 604800,
-        dateScheduler: QueueScheduler.main
-    )
+    static let sharedLoggingService: LoggingService? = {
+        LoggingService.removeLegacyStore()
+
+        return try? LoggingService(
+            directoryURL: LoggingService.directoryURL.appendingPathComponent("segments"),
+            cutoff: 604800,
+            dateScheduler: QueueScheduler.main
+        )
+    }()
 
     fileprivate static var directoryURL: URL
     {
         return FileManager.default.rly_documentsURL.appendingPathComponent("l")
     }
 
+    /// Removes the Realm database that previous versions of the app stored messages in.
+    fileprivate static func removeLegacyStore()
+    {
+        let fileManager = FileManager.default
+
+        for name in ["l.realm", "l.realm.lock", "l.realm.note", "l.realm.management"]
+        {
+            let url = directoryURL.appendingPathComponent(name)
+
+            if fileManager.fileExists(atPath: url.path)
+            {
+                try? fileManager.removeItem(at: url)
+            }
+        }
+    }
+
     // MARK: - Initialization
-    init(storeURL: URL, cutoff: TimeInterval, dateScheduler: DateSchedulerProtocol) throws
+
+    /**
+     Initializes a logging service.
+
+     - parameter directoryURL:       The directory to store message segment files in.
+     - parameter cutoff:             The age after which messages are deleted.
+     - parameter dateScheduler:      A scheduler to date messages with, and to run pruning on.
+     - parameter bufferCapacity:     The number of messages to buffer before overwriting the oldest unwritten messages.
+     - parameter writeInterval:      The delay between the first buffered message and writing the buffer to the store.
+     - parameter pruneInterval:      The interval at which segments containing only messages older than `cutoff` are
+                                     deleted.
+     - parameter maximumSegmentSize: The size, in bytes, at which a new segment file is started.
+     */
+    init(directoryURL: URL,
+         cutoff: TimeInterval,
+         dateScheduler: DateSchedulerProtocol,
+         bufferCapacity: Int = 4096,
+         writeInterval: DispatchTimeInterval = .seconds(1),
+         pruneInterval: DispatchTimeInterval = .seconds(3600),
+         maximumSegmentSize: Int = 256 * 1024) throws
     {
         // create logs path if necessary
         let fm = FileManager.default
-        let path = storeURL.deletingLastPathComponent().path
+        let path = directoryURL.path
 
         if !fm.rly_directoryExists(atPath: path)
         {
@@ -33,18 +73,55 @@ final class LoggingService: NSObject
 
         // assign properties
         self.cutoff = cutoff
-        self.configuration = Realm.Configuration(fileURL: storeURL, objectTypes: [LoggingMessage.self])
+        self.store = LoggingSegmentStore(directoryURL: directoryURL, maximumSegmentSize: maximumSegmentSize)
         self.dateScheduler = dateScheduler
+        self.buffer = LoggingBuffer(capacity: bufferCapacity)
+        self.writeInterval = writeInterval
+
+        let (messagesWritten, messagesWrittenObserver) = Signal<[LoggingMessage], NoError>.pipe()
+        self.messagesWritten = messagesWritten
+        self.messagesWrittenObserver = messagesWrittenObserver
 
         super.init()
+
+        // prune expired messages at launch, then periodically, instead of with each message
+        prune(before: dateScheduler.currentDate.addingTimeInterval(-cutoff))
+
+        disposable += timer(interval: pruneInterval, on: dateScheduler).startWithValues({ [weak self] date in
+            guard let strong = self else { return }
+            strong.prune(before: date.addingTimeInterval(-strong.cutoff))
+        })
+
+        // write any buffered messages before the app is suspended
+        let center = NotificationCenter.default
+
+        disposable += Signal.merge(
+            center.reactive.notifications(forName: .UIApplicationDidEnterBackground, object: nil),
+            center.reactive.notifications(forName: .UIApplicationWillTerminate, object: nil)
+        ).observeValues({ [weak self] _ in self?.flush() })
     }
 
+    deinit
+    {
+        disposable.dispose()
+        flush()
+        messagesWrittenObserver.sendCompleted()
+    }
+
+    fileprivate let disposable = CompositeDisposable()
+
     // MARK: - Logging
     var NSLogTypes: RLogType = []
     fileprivate let cutoff: TimeInterval
-    let configuration: Realm.Configuration
     fileprivate let dateScheduler: DateSchedulerProtocol
 
+    /**
+     Records a log message. The message is buffered in memory, and written to the store in a batch on a background
+     queue, so this function does not block on disk access.
+
+     - parameter string: The text of the log message.
+     - parameter type:   The type of log message.
+     */
     func log(_ string: String, type: RLogType)
     {
         let date = dateScheduler.currentDate
@@ -54,63 +131,144 @@ final class LoggingService: NSObject
             print("\(RLogTypeToString(type)): \(string)")
         }
 
-        do
+        let count = buffer.append(LoggingMessage(text: string, type: type, date: date))
+
+        if count == 1
+        {
+            // the buffer was empty, so no write is scheduled - wait to collect a batch of messages
+            writeQueue.asyncAfter(deadline: .now() + writeInterval, execute: { [weak self] in self?.writeBuffer() })
+        }
+        else if count == buffer.capacity / 2
         {
-            let realm = try Realm(configuration: configuration)
+            // write a busy buffer early, so that messages are not overwritten before the scheduled write
+            writeQueue.async(execute: { [weak self] in self?.writeBuffer() })
+        }
+    }
 
-            try realm.write {
-                // delete anything before the cutoff date
-                let cutoffDate = NSDate(timeIntervalSinceNow: -cutoff)
-                realm.delete(realm.objects(LoggingMessage.self).filter(NSPredicate(format: "date < %@", cutoffDate)))
+    // MARK: - Writing
 
-                // add the new message
-                realm.add(LoggingMessage(text: string, type: type, date: date))
-            }
+    /// Buffers messages until they are written to the store.
+    fileprivate let buffer: LoggingBuffer
+
+    /// The delay between the first buffered message and writing the buffer to the store.
+    fileprivate let writeInterval: DispatchTimeInterval
+
+    /// A serial queue for all access to `store`.
+    fileprivate let writeQueue = DispatchQueue(label: "com.ringly.logging", qos: .utility)
+
+    /// The segment files that messages are stored in. Only accessed on `writeQueue`.
+    fileprivate let store: LoggingSegmentStore
+
+    /// The directory in which message segment files are stored.
+    var segmentsDirectoryURL: URL
+    {
+        return store.directoryURL
+    }
+
+    /// Sends the messages written to the store, on `writeQueue`, after each write of buffered messages.
+    let messagesWritten: Signal<[LoggingMessage], NoError>
+    fileprivate let messagesWrittenObserver: Observer<[LoggingMessage], NoError>
+
+    /// Writes all buffered messages to the store, in a single write. Must be called on `writeQueue`.
+    fileprivate func writeBuffer()
+    {
+        let (messages, dropped) = buffer.drain()
+        guard let first = messages.first else { return }
+
+        let droppedMessages = dropped > 0 ? [LoggingMessage(
+            text: "Dropped \(dropped) log messages, logging buffer was full",
+            type: .generic,
+            date: first.date
+        )] : []
+
+        do
+        {
+            let written = droppedMessages + messages
+            try store.append(written)
+            messagesWrittenObserver.send(value: written)
         }
         catch let error as NSError
         {
-            print("Error saving logging context: ", error)
+            print("Error writing log messages: ", error)
         }
     }
+
+    /**
+     Deletes the segments containing only messages recorded before a date, on `writeQueue`.
+
+     - parameter date: The cutoff date.
+     */
+    fileprivate func prune(before date: Date)
+    {
+        writeQueue.async(execute: { [weak self] in
+            self?.store.prune(before: date)
+        })
+    }
+
+    /// Synchronously writes all buffered messages to the store, and waits for any pending pruning to complete.
+    func flush()
+    {
+        writeQueue.sync(execute: writeBuffer)
+    }
+
+    /// Writes all buffered messages to the store, then returns the store's segment file URLs, oldest first.
+    fileprivate func flushedSegmentURLs() -> [URL]
+    {
+        return writeQueue.sync(execute: {
+            writeBuffer()
+            return store.segmentURLs
+        })
+    }
 }
 
 extension LoggingService
 {
-    /// A signal producer that will yield the service's logging messages.
-    var csvProducer: SignalProducer<String, NSError>
+    /// Writes the service's messages to a file handle as comma-separated values, including buffered messages. Segment
+    /// files are mapped and written a chunk at a time, so memory use does not grow with the number of messages.
+    ///
+    /// - Parameter fileHandle: The file handle to write to.
+    func writeCommaSeparatedValues(to fileHandle: FileHandle)
     {
-        let queue = DispatchQueue.global(qos: DispatchQoS.QoSClass.userInitiated)
+        let writer = CommaSeparatedValueWriter(fileHandle: fileHandle)
+        writer.append(row: LoggingMessage.commaSeparatedHeaders)
+
+        let formatter = LoggingMessage.commaSeparatedDateFormatter
 
-        return configuration.realmProducer(queue: queue) { realm, observer, _ in
-            let messages = realm.objects(LoggingMessage.self).sorted(byKeyPath: "date", ascending: true)
-            observer.send(value: messages.commaSeparatedValueRepresentation)
-            observer.sendCompleted()
+        for url in flushedSegmentURLs()
+        {
+            autoreleasepool {
+                LoggingSegmentStore.enumerateRecords(inSegmentAt: url, { date, type, text in
+                    writer.append(field: formatter.string(from: date))
+                    writer.append(field: RLogTypeToString(type))
+                    writer.append(field: text)
+                    writer.endRow()
+                })
+            }
         }
+
+        writer.finish()
     }
 
-    /// Attempts to write the logging service's message to a temporary file URL.
+    /// Attempts to write the logging service's messages to a temporary file URL.
     var csvDataURLProducer: SignalProducer<URL, NSError>
     {
-        return csvProducer.attemptMap({ csv -> Result<URL, NSError> in
-            guard let data = csv.data(using: String.Encoding.utf8) else {
-                return .failure(MailComposeError(
-                    errorDescription: "Error",
-                    failureReason: "Error converting to data representation. Please contact support@ringly.com."
-                ) as NSError)
-            }
-
+        return SignalProducer.attempt({ [weak self] () -> Result<URL, NSError> in
             do
             {
                 let directory = try ZipArchive.createTemporaryFolderPath("ringly-diagnostics-\(arc4random())")
+                let fileURL = URL(fileURLWithPath: directory).appendingPathComponent("logs.csv")
 
-                guard let fileURL = NSURL(fileURLWithPath: directory).appendingPathComponent("logs.csv") else {
+                guard FileManager.default.createFile(atPath: fileURL.path, contents: nil, attributes: nil),
+                      let fileHandle = FileHandle(forWritingAtPath: fileURL.path)
+                else {
                     return .failure(MailComposeError(
                         errorDescription: "Error",
                         failureReason: "Error creating temporary path. Please contact support@ringly.com."
                     ) as NSError)
                 }
 
-                try data.write(to: fileURL, options: .atomic)
+                self?.writeCommaSeparatedValues(to: fileHandle)
+                fileHandle.closeFile()
 
                 return .success(fileURL)
             }
@@ -118,12 +276,39 @@ extension LoggingService
             {
                 return .failure(error)
             }
-        })
+        }).start(on: QueueScheduler(qos: .userInitiated, name: "com.ringly.logging.export"))
+    }
+
+    /// A producer for all messages stored in the service, including buffered messages, followed by each batch of
+    /// messages as it is written. Stored messages are only read once, so observers should append later batches.
+    ///
+    /// The stored messages are read on `writeQueue`, so that no batch is missed or sent twice.
+    var messageBatchesProducer: SignalProducer<[LoggingMessage], NoError>
+    {
+        return SignalProducer { [weak self] observer, disposable in
+            guard let writeQueue = self?.writeQueue else {
+                observer.sendCompleted()
+                return
+            }
+
+            writeQueue.async(execute: {
+                guard !disposable.isDisposed else { return }
+
+                guard let strong = self else {
+                    observer.sendCompleted()
+                    return
+                }
+
+                strong.writeBuffer()
+                observer.send(value: LoggingSegmentStore.messages(inSegmentsAt: strong.store.segmentURLs))
+                disposable += strong.messagesWritten.observe(observer)
+            })
+        }
     }
 
-    /// All messages stored in the service. Probably slow.
-    func messages() throws -> [LoggingMessage]
+    /// All messages stored in the service, including buffered messages. Probably slow.
+    func messages() -> [LoggingMessage]
     {
-        return Array(try Realm(configuration: configuration).objects(LoggingMessage.self))
+        return LoggingSegmentStore.messages(inSegmentsAt: flushedSegmentURLs())
     }
 }
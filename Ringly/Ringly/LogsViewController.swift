@@ -2,10 +2,7 @@
 
 import MessageUI
 import ReactiveSwift
-import RealmSwift
-import RinglyActivityTracking
 import UIKit
-import enum Result.NoError
 
 final class LogsViewController: ServicesViewController
 {
@@ -55,47 +52,25 @@ final class LogsViewController: ServicesViewController
             UIBarButtonItem(barButtonSystemItem: .flexibleSpace, target: nil, action: nil)
         ]
 
-        let configuration = services.logging!.configuration
-
-        let predicateProducer = logTypes.producer.map({ types -> NSPredicate? in
-            var predicates: [NSPredicate] = []
+        // read the stored messages once, then insert only newly written messages
+        services.logging!.messageBatchesProducer
+            .observe(on: UIScheduler())
+            .take(until: reactive.lifetime.ended)
+            .startWithValues({ [weak self] batch in
+                guard let strong = self else { return }
 
-            RLogEnumerateTypes({ type in
-                if types.contains(type)
-                {
-                    predicates.append(NSPredicate(format: "_type == %d", type.rawValue))
-                }
+                strong.messages.append(contentsOf: batch)
+                strong.results.value = strong.filtered(batch) + (strong.results.value ?? [])
+                strong.tableView.reloadData()
             })
 
-            return predicates.count > 0
-                ? NSCompoundPredicate(orPredicateWithSubpredicates: predicates)
-                : nil
-        })
-
-        predicateProducer
-            .flatMap(.latest, transform: { optionalPredicate in
-                return configuration.realmResultsProducer { realm -> Results<LoggingMessage> in
-                    let sorted = realm.objects(LoggingMessage.self).sorted(byKeyPath: "date", ascending: false)
-                    return optionalPredicate.map({ sorted.filter($0) }) ?? sorted
-                }.resultify()
-            })
-            .take(until: reactive.lifetime.ended)
-            .startWithValues({ [weak self] result in
-                switch result
-                {
-                case let .success(results):
-                    self?.results.value = Array(results)
-                    self?.tableView.reloadData()
-
-                case let .failure(error):
-                    print("Log fetch error", error)
-                    self?.results.value = nil
-                    self?.tableView.reloadData()
-                }
-            })
+        // filter the messages that have already been read when the filter changes
+        logTypes.producer.skip(first: 1).startWithValues({ [weak self] types in
+            UserDefaults.standard.set(types.rawValue, forKey: RLogTypeDefaultsKey)
 
-        logTypes.producer.skip(first: 1).startWithValues({
-            UserDefaults.standard.set($0.rawValue, forKey: RLogTypeDefaultsKey)
+            guard let strong = self, strong.results.value != nil else { return }
+            strong.results.value = strong.filtered(strong.messages)
+            strong.tableView.reloadData()
         })
     }
 
@@ -104,8 +79,26 @@ final class LogsViewController: ServicesViewController
             .flatMap(RLogType.init) ?? RLogType.all
     )
 
+    /// All messages read from the logging service, oldest first.
+    private var messages = [LoggingMessage]()
+
+    /// The messages matching the selected log types, newest first.
     fileprivate let results = MutableProperty([LoggingMessage]?.none)
 
+    /**
+     Filters messages to the selected log types.
+
+     - parameter messages: The messages to filter, oldest first.
+
+     - returns: The matching messages, newest first.
+     */
+    private func filtered(_ messages: [LoggingMessage]) -> [LoggingMessage]
+    {
+        let types = logTypes.value
+        let newestFirst = messages.reversed() as [LoggingMessage]
+        return types.isEmpty ? newestFirst : newestFirst.filter({ types.contains($0.type) })
+    }
+
     // MARK: - Toolbar Actions
     @objc private func filterAction()
     {
@@ -136,12 +129,12 @@ final class LogsViewController: ServicesViewController
         alert.content = AlertActivityContent(text: "Collecting Logs", activityIndicatorType: .ui)
         alert.present(above: self)
 
-        logging.csvProducer.observe(on: UIScheduler()).startWithResult({ [weak self] result in
+        logging.csvDataURLProducer.observe(on: UIScheduler()).startWithResult({ [weak self] result in
             alert.dismiss()
 
             switch result
             {
-            case let .success(csv):
+            case let .success(url):
                 let mail = MFMailComposeViewController()
                 mail.mailComposeDelegate = self
                 mail.setSubject("Ringly iOS Logs")
@@ -153,7 +146,7 @@ final class LogsViewController: ServicesViewController
                 )
 
                 mail.addAttachmentData(
-                    csv.data(using: String.Encoding.utf8) ?? Data(),
+                    (try? Data(contentsOf: url, options: .alwaysMapped)) ?? Data(),
                     mimeType: "text/csv",
                     fileName: "log-\(Date()).csv"
                 )
@@ -0,0 +1,374 @@
+import Foundation
+import RinglyKit
+
+/// A bounded set of notification signatures, used to prevent sending the same notification to a peripheral twice.
+///
+/// When the cache is full, the least recently inserted signature is evicted. Insertion and lookup are constant time.
+///
+/// Signatures are persisted to an append-only log file: each insertion appends a single record, rather than rewriting
+/// the entire cache. Appends made in quick succession are coalesced into a single write. Once the log contains enough
+/// superseded records, it is compacted by rewriting it with only the current signatures.
+///
+/// The cache may be used from any thread.
+final class NotificationSignatureCache
+{
+    // MARK: - Initialization
+
+    /**
+     Initializes a signature cache, reading any signatures previously written to `filePath`.
+
+     - parameter capacity:    The maximum number of signatures to store.
+     - parameter filePath:    The log file to read from and write to. If `nil`, the cache is not persisted.
+     - parameter logFunction: A function to log errors to.
+     */
+    init(capacity: Int = 300, filePath: String?, loggingTo logFunction: @escaping (String) -> ())
+    {
+        precondition(capacity > 0, "Signature cache capacity must be positive")
+
+        self.capacity = capacity
+        self.filePath = filePath
+        self.logFunction = logFunction
+
+        if let path = filePath, let data = FileManager.default.contents(atPath: path)
+        {
+            let (signatures, complete) = NotificationSignatureCache.records(in: data)
+            signatures.forEach(insertLocked)
+            logRecordCount = signatures.count
+
+            if !complete
+            {
+                logFunction("Notification signature log at “\(path)” is truncated, read \(signatures.count) signatures")
+            }
+
+            // an incomplete record must be removed before more records are appended after it
+            if !complete || logRecordCount >= compactionThreshold
+            {
+                compactLocked()
+            }
+        }
+    }
+
+    // MARK: - Properties
+
+    /// The maximum number of signatures stored by the cache.
+    let capacity: Int
+
+    /// The log file to read from and write to.
+    fileprivate let filePath: String?
+
+    /// A function to log errors to.
+    fileprivate let logFunction: (String) -> ()
+
+    /// Protects the in-memory state of the cache.
+    fileprivate let lock = NSLock()
+
+    // MARK: - Signatures
+
+    /// The insertion sequence number of each signature currently in the cache.
+    fileprivate var sequences = [String:Int]()
+
+    /// Signatures in insertion order, with their sequence numbers. Entries whose sequence number does not match
+    /// `sequences` have been reinserted or evicted, and are skipped.
+    fileprivate var order = [(sequence: Int, signature: String)]()
+
+    /// The index of the oldest entry in `order` that has not been evicted.
+    fileprivate var orderStart = 0
+
+    /// The sequence number for the next insertion.
+    fileprivate var nextSequence = 0
+
+    /// The number of signatures currently in the cache.
+    var count: Int
+    {
+        lock.lock()
+        defer { lock.unlock() }
+        return sequences.count
+    }
+
+    /// The signatures currently in the cache, most recently inserted first.
+    var signatures: [String]
+    {
+        lock.lock()
+        defer { lock.unlock() }
+        return currentSignaturesLocked().reversed()
+    }
+
+    /**
+     Returns `true` if the cache contains the signature.
+
+     - parameter signature: The signature.
+     */
+    func contains(_ signature: String) -> Bool
+    {
+        lock.lock()
+        defer { lock.unlock() }
+        return sequences[signature] != nil
+    }
+
+    /**
+     Inserts a signature, evicting the least recently inserted signature if the cache is full. If the signature is
+     already present, it becomes the most recently inserted signature.
+
+     - parameter signature: The signature.
+     */
+    func insert(_ signature: String)
+    {
+        lock.lock()
+        defer { lock.unlock() }
+
+        insertLocked(signature)
+        append(NotificationSignatureCache.record(for: signature))
+        logRecordCount += 1
+
+        if logRecordCount >= compactionThreshold
+        {
+            compactLocked()
+        }
+    }
+
+    /**
+     Inserts a signature. The lock must be held, or the cache must not yet be shared.
+
+     - parameter signature: The signature.
+     */
+    fileprivate func insertLocked(_ signature: String)
+    {
+        let sequence = nextSequence
+        nextSequence += 1
+
+        sequences[signature] = sequence
+        order.append((sequence: sequence, signature: signature))
+
+        while sequences.count > capacity
+        {
+            let oldest = order[orderStart]
+            orderStart += 1
+
+            if sequences[oldest.signature] == oldest.sequence
+            {
+                sequences.removeValue(forKey: oldest.signature)
+            }
+        }
+
+        // drop evicted and superseded entries once they outnumber current entries, so that insertion is amortized
+        // constant time and `order` remains bounded - the evicted prefix before `orderStart` must be counted, since
+        // with unique insertions at capacity it is the only part of `order` that grows
+        if order.count > 2 * max(sequences.count, 16)
+        {
+            order = currentSignaturesLocked().enumerated().map({ (sequence: $0, signature: $1) })
+            orderStart = 0
+            nextSequence = order.count
+
+            for (sequence, signature) in order
+            {
+                sequences[signature] = sequence
+            }
+        }
+    }
+
+    /// The number of entries in `order`, including evicted and superseded entries. This is intended for testing.
+    var orderCount: Int
+    {
+        lock.lock()
+        defer { lock.unlock() }
+        return order.count
+    }
+
+    /// Returns the current signatures, least recently inserted first. The lock must be held.
+    fileprivate func currentSignaturesLocked() -> [String]
+    {
+        return order[orderStart..<order.count].flatMap({ entry in
+            sequences[entry.signature] == entry.sequence ? entry.signature : nil
+        })
+    }
+
+    // MARK: - Persistence
+
+    /// The queue on which the log file is written.
+    fileprivate let queue = DispatchQueue(label: "com.ringly.Ringly.NotificationSignatureCache", qos: .utility)
+
+    /// Records waiting to be appended to the log file. Only accessed on `queue`.
+    fileprivate var pendingRecords = Data()
+
+    /// The number of records in the log file, including pending records.
+    fileprivate var logRecordCount = 0
+
+    /// Once the log file contains this many records, it is compacted.
+    fileprivate var compactionThreshold: Int
+    {
+        return capacity * 4
+    }
+
+    /// The delay before pending records are appended to the log file, so that records inserted in quick succession are
+    /// written together.
+    fileprivate static let appendDelay = DispatchTimeInterval.milliseconds(250)
+
+    /**
+     Appends a record to the log file, asynchronously.
+
+     - parameter record: The record data.
+     */
+    fileprivate func append(_ record: Data)
+    {
+        guard filePath != nil else { return }
+
+        queue.async {
+            let scheduleFlush = self.pendingRecords.isEmpty
+            self.pendingRecords.append(record)
+
+            if scheduleFlush
+            {
+                self.queue.asyncAfter(deadline: .now() + NotificationSignatureCache.appendDelay, execute: self.flush)
+            }
+        }
+    }
+
+    /// Appends pending records to the log file. Must be called on `queue`.
+    fileprivate func flush()
+    {
+        guard let path = filePath, !pendingRecords.isEmpty else { return }
+
+        let records = pendingRecords
+        pendingRecords = Data()
+
+        if !FileManager.default.fileExists(atPath: path)
+        {
+            FileManager.default.createFile(atPath: path, contents: nil, attributes: nil)
+        }
+
+        guard let handle = FileHandle(forWritingAtPath: path) else {
+            logFunction("Could not open notification signature log at “\(path)”")
+            return
+        }
+
+        handle.seekToEndOfFile()
+        handle.write(records)
+        handle.closeFile()
+    }
+
+    /// Rewrites the log file with only the current signatures, asynchronously. The lock must be held.
+    fileprivate func compactLocked()
+    {
+        guard let path = filePath else { return }
+
+        let signatures = currentSignaturesLocked()
+        logRecordCount = signatures.count
+
+        queue.async {
+            // the current signatures include every pending record, since records are enqueued with the lock held
+            self.pendingRecords = Data()
+
+            var data = Data()
+            signatures.forEach({ data.append(NotificationSignatureCache.record(for: $0)) })
+
+            do
+            {
+                try data.write(to: URL(fileURLWithPath: path), options: .atomicWrite)
+            }
+            catch let error as NSError
+            {
+                self.logFunction("Error compacting notification signature log at “\(path)”: \(error)")
+            }
+        }
+    }
+
+    /// Blocks until all pending writes to the log file have completed. This is intended for testing.
+    func waitForWrites()
+    {
+        queue.sync(execute: flush)
+    }
+
+    // MARK: - Migration
+
+    /**
+     Imports signatures from a property list array, most recently inserted first, as written by previous versions of
+     the app. The property list file is removed once its signatures have been imported.
+
+     - parameter path: The property list file.
+     */
+    func importPropertyList(atPath path: String)
+    {
+        guard FileManager.default.fileExists(atPath: path) else { return }
+
+        if let array = NSArray(contentsOfFile: path) as? [String]
+        {
+            array.reversed().forEach(insert)
+        }
+        else
+        {
+            logFunction("Could not load notification signatures from property list file at “\(path)”")
+        }
+
+        do
+        {
+            try FileManager.default.removeItem(atPath: path)
+        }
+        catch let error as NSError
+        {
+            logFunction("Error removing notification signature property list file at “\(path)”: \(error)")
+        }
+    }
+
+    // MARK: - Records
+
+    /**
+     Encodes a log record for a signature, as a 32-bit little-endian length, followed by the signature's UTF-8 bytes.
+
+     - parameter signature: The signature.
+     */
+    fileprivate static func record(for signature: String) -> Data
+    {
+        let bytes = Array(signature.utf8)
+        let header = (0..<4).map({ byte in UInt8(truncatingBitPattern: bytes.count >> (8 * byte)) })
+
+        return Data(bytes: header + bytes)
+    }
+
+    /**
+     Decodes the signatures in a log file.
+
+     - parameter data: The log file data.
+
+     - returns: The signatures, in insertion order, and whether or not the data ended with a complete record.
+     */
+    fileprivate static func records(in data: Data) -> (signatures: [String], complete: Bool)
+    {
+        var signatures = [String]()
+        var offset = 0
+        let headerSize = 4
+
+        while offset + headerSize <= data.count
+        {
+            let length = (0..<headerSize).reduce(0, { length, byte in
+                length | Int(data[offset + byte]) << (8 * byte)
+            })
+
+            let start = offset + headerSize
+            let end = start + length
+
+            guard end <= data.count, let signature = String(data: data.subdata(in: start..<end), encoding: .utf8) else {
+                return (signatures, false)
+            }
+
+            signatures.append(signature)
+            offset = end
+        }
+
+        return (signatures, offset == data.count)
+    }
+}
+
+extension NotificationSignatureCache
+{
+    // MARK: - Notifications
+
+    /**
+     Inserts a notification's signature.
+
+     - parameter notification: The notification.
+     */
+    func insertSignature(for notification: RLYANCSNotification)
+    {
+        insert(notification.ANCSV1Signature)
+    }
+}
@@ -0,0 +1,61 @@
+/// A prefix trie of strings, storing the lowest index of a string inserted beneath each node.
+///
+/// This is used to match strings that ANCS has truncated against configured strings, in time proportional to the length
+/// of the truncated string, rather than the number of configured strings. Strings should be case-folded (and normalized,
+/// if necessary) before insertion and lookup - the trie compares characters exactly.
+struct PrefixTrie
+{
+    /// The children of each node, keyed by character. The root node is at index `0`.
+    fileprivate var children: [[Character:Int]] = [[:]]
+
+    /// The lowest index of a string with each node's prefix.
+    fileprivate var firstIndices: [Int] = [Int.max]
+
+    /**
+     Inserts a string.
+
+     - parameter string: The folded string.
+     - parameter index:  The index associated with the string, typically the index of its configuration.
+     */
+    mutating func insert(_ string: String, index: Int)
+    {
+        var node = 0
+        firstIndices[node] = min(firstIndices[node], index)
+
+        for character in string.characters
+        {
+            if let child = children[node][character]
+            {
+                node = child
+            }
+            else
+            {
+                let child = children.count
+                children.append([:])
+                firstIndices.append(Int.max)
+                children[node][character] = child
+                node = child
+            }
+
+            firstIndices[node] = min(firstIndices[node], index)
+        }
+    }
+
+    /**
+     Returns the lowest index of a string with the specified prefix.
+
+     - parameter prefix: The folded prefix.
+     */
+    func firstIndex(withPrefix prefix: String) -> Int?
+    {
+        var node = 0
+
+        for character in prefix.characters
+        {
+            guard let child = children[node][character] else { return nil }
+            node = child
+        }
+
+        return firstIndices[node] == Int.max ? nil : firstIndices[node]
+    }
+}
@@ -19,18 +19,22 @@ extension Reactive where Base: RLYPeripheral
         (applicationsProducer: SignalProducer<[ApplicationConfiguration], NoError>,
          contactsProducer: SignalProducer<[ContactConfiguration], NoError>,
          innerRingProducer: SignalProducer<Bool, NoError>,
-         signatureCache: MutableProperty<[String]>,
+         signatureCache: NotificationSignatureCache,
          analyticsService: AnalyticsService)
         -> SignalProducer<(), NoError>
     {
         // observe and respond to the peripheral's notifications
-        let configuration = SignalProducer.combineLatest(applicationsProducer, contactsProducer, innerRingProducer)
+        let configuration = SignalProducer.combineLatest(
+            applicationsProducer.indexed(),
+            contactsProducer.indexed(),
+            innerRingProducer
+        )
 
         // determine whether or not we should handle this notification
         let testResults = configuration.sample(with: ANCSNotification).map(append)
             .map({ applications, contacts, innerRing, notification in
                 notification.ANCSV1TestResult(
-                    sentSignatures: signatureCache.value,
+                    sentSignatures: signatureCache,
                     applicationConfigurations: applications,
                     contactConfigurations: contacts,
                     innerRingEnabled: innerRing
@@ -97,75 +101,23 @@ extension Reactive where Base: RLYPeripheral
 
 extension RLYPeripheral
 {
-    /// The file that notification signatures are written to.
-    @nonobjc fileprivate static let signatureCacheFileName = "notificationSigCache"
+    /// The file that notification signatures were written to by previous versions, as a property list array.
+    @nonobjc fileprivate static let signatureCachePropertyListFileName = "notificationSigCache"
 
-    /// A shared cache of notification signatures, to prevent duplicates.
-    @nonobjc static let sharedSignatureCache = MutableProperty(
-        filePath: FileManager.default.rly_documentsFile(withName: signatureCacheFileName),
-        contentDescription: "notification signature cache",
-        loggingTo: SLogANCS
-    )
-}
-
-extension ModifiableMutablePropertyType where Value == [String]
-{
-    /// Writes a notification to the shared signature cache.
-    ///
-    /// - Parameter notification: The notification to write
-    /// - Parameter count: The maximum number of signatures to store. The default value of this parameter is `300`.
-    func insertSignature(for notification: RLYANCSNotification, limitingTo count: Int = 300)
-    {
-        pureModify({ current in
-            var mutable = current
-            mutable.insert(notification.ANCSV1Signature, at: 0)
-
-            while mutable.count > count
-            {
-                mutable.removeLast()
-            }
-
-            return mutable
-        })
-    }
-}
-
-extension InitializableMutablePropertyProtocol where Value == [String]
-{
-    /// Creates a property that reads an array of strings from a property list file, then writes modifications to the
-    /// same file.
-    ///
-    /// - Parameters:
-    ///   - filePath: The file path to read from and write to.
-    ///   - contentDescription: A description of the file content, which will be logged to `logFunction`.
-    ///   - logFunction: A function to log errors to.
-    init(filePath: String, contentDescription: String, loggingTo logFunction: @escaping (String) -> ())
-    {
-        self.init({ () -> [String] in
-            if let array = NSArray(contentsOfFile: filePath) as? [String]
-            {
-                return array
-            }
-            else
-            {
-                logFunction("Could not load \(contentDescription) from property list file at “\(filePath)”")
-                return []
-            }
-        }())
+    /// The file that notification signatures are logged to.
+    @nonobjc fileprivate static let signatureCacheLogFileName = "notificationSignatures.log"
 
-        // write the signature cache to disk after each change
-        let scheduler = QueueScheduler(qos: .userInitiated, name: "Writing Configurations", targeting: nil)
-
-        signal.observe(on: scheduler).observeValues({ signatures in
-            do
-            {
-                let data = try PropertyListSerialization.data(fromPropertyList: signatures, format: .xml, options: 0)
-                try data.write(to: URL(fileURLWithPath: filePath), options: .atomicWrite)
-            }
-            catch let error as NSError
-            {
-                logFunction("Error writing \(contentDescription) to property list file at “\(filePath)”: \(error)")
-            }
-        })
-    }
+    /// A shared cache of notification signatures, to prevent duplicates.
+    @nonobjc static let sharedSignatureCache: NotificationSignatureCache = {
+        let cache = NotificationSignatureCache(
+            filePath: FileManager.default.rly_documentsFile(withName: RLYPeripheral.signatureCacheLogFileName),
+            loggingTo: SLogANCS
+        )
+
+        cache.importPropertyList(
+            atPath: FileManager.default.rly_documentsFile(withName: RLYPeripheral.signatureCachePropertyListFileName)
+        )
+
+        return cache
+    }()
 }
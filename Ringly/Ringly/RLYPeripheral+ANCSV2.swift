@@ -56,10 +56,10 @@ extension Reactive where Base: RLYPeripheral
             })
 
         // write analytics event when notifications are received
-        let analyticsProducer = applicationsProducer.sample(with: ANCSV2NotificationsProducer())
+        let analyticsProducer = applicationsProducer.indexed().sample(with: ANCSV2NotificationsProducer())
             .map({ configurations, notification in
                 unwrap(
-                    configurations.configurationMatching(applicationIdentifier: notification.applicationIdentifier),
+                    configurations.configuration(matching: notification.applicationIdentifier),
                     notification
                 )
             })
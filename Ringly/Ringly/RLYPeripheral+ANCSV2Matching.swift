@@ -25,14 +25,20 @@ extension RLYPeripheral
      If the configuration hash read fails, the producer logs the error.
 
      - parameter snapshot: The configuration snapshot to match.
+     - parameter store:    A store for the configuration most recently applied to each peripheral, which allows only the
+                           differences between configurations to be written. The default value of this parameter is
+                           `RLYPeripheral.sharedANCSV2AppliedConfigurations`.
      */
     
-    func ensureMatches(configurationSnapshot snapshot: ANCSV2ConfigurationSnapshot) -> SignalProducer<(), NoError>
+    func ensureMatches(configurationSnapshot snapshot: ANCSV2ConfigurationSnapshot,
+                       appliedConfigurations store: ANCSV2AppliedConfigurationStore
+                           = RLYPeripheral.sharedANCSV2AppliedConfigurations)
+        -> SignalProducer<(), NoError>
     {
         return reactive.readConfigurationHash()
             .map(ANCSV2PackedHash.init)
             .on(value: { [weak self] currentHash in
-                self?.ensure(configurationSnapshot: snapshot, matchesCurrentHash: currentHash)
+                self?.ensure(configurationSnapshot: snapshot, matchesCurrentHash: currentHash, store: store)
             })
             .ignoreValues()
             .flatMapError({ [weak self] error -> SignalProducer<(), NoError> in
@@ -46,14 +52,30 @@ extension RLYPeripheral
 
      - parameter snapshot:    The configuration snapshot to match.
      - parameter currentHash: The current hash, previously read from the peripheral.
+     - parameter store:       The applied configuration store.
      */
     fileprivate func ensure(configurationSnapshot snapshot: ANCSV2ConfigurationSnapshot,
-                            matchesCurrentHash currentHash: ANCSV2PackedHash)
+                            matchesCurrentHash currentHash: ANCSV2PackedHash,
+                            store: ANCSV2AppliedConfigurationStore)
     {
-        if let (commands, hash) = commandsToEnsure(configurationSnapshot: snapshot, matchesCurrentHash: currentHash)
+        let applied = store[identifier]
+
+        if let (commands, hash) = commandsToEnsure(
+            configurationSnapshot: snapshot,
+            matchesCurrentHash: currentHash,
+            applied: applied
+        )
         {
+            // the hash is written after the commands, so these settings will only be used for a delta if the peripheral
+            // reports the new hash, which it will only do if it has received them
+            store[identifier] = snapshot.appliedConfiguration
             write(commands: commands, thenHash: hash.packed)
         }
+        else if applied == nil
+        {
+            // the peripheral already matches, but its settings are unknown - for example, after upgrading
+            store[identifier] = snapshot.appliedConfiguration
+        }
     }
 
     /**
@@ -62,49 +84,43 @@ extension RLYPeripheral
 
      - parameter snapshot:    The configuration snapshot to match.
      - parameter currentHash: The current hash, previously read from the peripheral.
+     - parameter applied:     The configuration most recently applied to the peripheral, if known.
 
      - returns: An array of commands, or `nil` if the hash values already match.
      */
     
     fileprivate func commandsToEnsure(configurationSnapshot snapshot: ANCSV2ConfigurationSnapshot,
-                                      matchesCurrentHash currentHash: ANCSV2PackedHash)
+                                      matchesCurrentHash currentHash: ANCSV2PackedHash,
+                                      applied: ANCSV2AppliedConfiguration?)
         -> (commands: [RLYCommand], hash: ANCSV2PackedHash)?
     {
-        let correctHash = ANCSV2PackedHash(applications: snapshot.applications, contacts: snapshot.contacts)
+        let correctHash = snapshot.hash
 
         // always log the hashes, before aborting if they match
         SLogBluetooth("Read configuration hashes from \(loggingName), results are:\n" +
             "Current Application Hash: \(String(currentHash.first, radix: 16))\n" +
             "Correct Application Hash: \(String(correctHash.first, radix: 16))\n" +
+            "Applied Application Hash: \((applied?.applications?.hash).map({ String($0, radix: 16) }) ?? "unknown")\n" +
             "   Current Contacts Hash: \(String(currentHash.second, radix: 16))\n" +
-            "   Correct Contacts Hash: \(String(correctHash.second, radix: 16))\n"
+            "   Correct Contacts Hash: \(String(correctHash.second, radix: 16))\n" +
+            "   Applied Contacts Hash: \((applied?.contacts?.hash).map({ String($0, radix: 16) }) ?? "unknown")\n"
         )
 
         // if the hashes already match
         guard currentHash != correctHash else { return nil }
 
-        var commands = [RLYCommand]()
-
-        // make sure that the current application settings are correct
-        if currentHash.first != correctHash.first
-        {
-            commands.append(RLYClearApplicationSettingsCommand())
-
-            commands += snapshot.applications.flatMap({ configuration in
-                configuration.commands(for: .add) as [RLYCommand]
-            })
-        }
-
-        // make sure that the current contact settings are correct
-        if currentHash.second != correctHash.second
-        {
-            commands.append(RLYClearContactSettingsCommand())
-
-            commands += snapshot.contacts.flatMap({ configuration -> [RLYCommand] in
-                configuration.commands(for: .add)
-            })
-        }
-
-        return (commands: commands, hash: correctHash)
+        return (commands: snapshot.commands(toChange: currentHash, applied: applied), hash: correctHash)
     }
 }
+
+extension RLYPeripheral
+{
+    /// The file that applied ANCS v2 configurations are written to.
+    @nonobjc fileprivate static let appliedConfigurationsFileName = "ANCSV2AppliedConfigurations.plist"
+
+    /// A shared store of the ANCS v2 configuration most recently applied to each peripheral.
+    @nonobjc static let sharedANCSV2AppliedConfigurations = ANCSV2AppliedConfigurationStore(
+        filePath: FileManager.default.rly_documentsFile(withName: appliedConfigurationsFileName),
+        loggingTo: SLogANCS
+    )
+}
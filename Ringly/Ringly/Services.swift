@@ -92,6 +92,13 @@ final class Services: NSObject
         // activity tracking
         activityTracking = ActivityTrackingService.with(healthKitIfAvailable: true)
 
+        activityCache = ActivityCache(fileURL: fm.rly_cachesURL.appendingPathComponent("activity.realm"))
+
+        if let realmService = activityTracking.realmService
+        {
+            activityCache.invalidateSteps(writtenIn: realmService.writtenStepsIntervals)
+        }
+
         activityNotifications = ActivityNotificationsService(
             state: preferences.activityNotificationsState.value ?? ActivityNotificationsState.empty,
             reminderState: preferences.activityReminderNotificationsState.value
@@ -127,7 +134,9 @@ final class Services: NSObject
         preferences.savedPeripherals <~ peripherals.savedPeripheralsProducer.skip(first: 1)
         preferences.activatedPeripheralIdentifier <~ peripherals.activatedIdentifier.signal
 
-        activityTracking.realmService?.writeSourcedUpdatesProducer(peripherals.activityUpdatesProducer).start()
+        activityTracking.backupUpdatesSinks.forEach({ sink in
+            sink.writeSourcedUpdatesProducer(peripherals.activityUpdatesProducer).start()
+        })
         
         // updates
         updates = UpdatesService(api: api, peripheralsService: peripherals)
@@ -206,6 +215,9 @@ final class Services: NSObject
     /// The activity tracking service.
     let activityTracking: ActivityTrackingService
 
+    /// The cache of daily and hourly activity data, shared by all activity screens.
+    let activityCache: ActivityCache
+
     /// The activity notifications service.
     let activityNotifications: ActivityNotificationsService
     
@@ -222,12 +234,7 @@ extension Services
 {
     
     func dailyStepsMultipartFileProducer() -> SignalProducer<MultipartFile?, NoError> {
-        let cache = ActivityCache(
-            fileURL: FileManager.default.rly_cachesURL
-                .appendingPathComponent("activity-week.realm")
-            )
-        
-            return cache.stepsProducer()
+            return activityCache.stepsProducer()
                 .map({ stepsAndDates in
                     stepsAndDates.map({ (date, steps) in
                        return "\(DateFormatter.localizedString(from: date, dateStyle: .short, timeStyle: .none)),\(steps.stepCount)"
@@ -239,40 +246,43 @@ extension Services
     /// A producer yielding a diagnostic data request, to send to the API.
     ///
     /// This includes a CSV of the user's logs, their application, contacts, and user defaults as property lists; and
-    /// the user's activity tracking Realm database.
+    /// the user's activity tracking Realm database. Files on disk are gzipped as they are read, so they are never
+    /// loaded into memory. The request's temporary files should be removed once it has been sent - if the producer is
+    /// interrupted before sending the request, its files are removed automatically.
     ///
     /// - Parameter reference: The reference value to include in the endpoint.
     
-    @nonobjc func diagnosticDataRequestProducer(queryItems:[URLQueryItem]?) -> SignalProducer<DiagnosticDataRequest, NoError>
+    @nonobjc func diagnosticDataRequestProducer(queryItems:[URLQueryItem]?)
+        -> SignalProducer<DiagnosticDataRequest, NSError>
     {
         // configuration urls
         let applicationsURL = URL(fileURLWithPath: applicationsPath)
         let contactsURL = URL(fileURLWithPath: contactsPath)
 
-        // perform data loading in background
+        // gzip files in background
         let scheduler = QueueScheduler(qos: .userInitiated, name: "diagnostic data")
 
         // create producers for each file that will be included in the endpoint request
         let fileProducers: [SignalProducer<MultipartFile?, NoError>] = [
             // activity tracking data
-            SignalProducer.deferValue({
-                (self.activityTracking.realmService?.fileURL).flatMap({ url in
-                    MultipartFile(name: "activity.realm", mime: "application/octet-stream", dataFrom: url)
-                })
-            }).start(on: scheduler),
+            SignalProducer(value: (activityTracking.realmService?.fileURL).map({ url in
+                MultipartFile(name: "activity.realm", mime: "application/octet-stream", fileURL: url)
+            })),
 
             // logs
-            logging?.csvProducer.diagnosticFileProducer(name: "logs.csv", mime: "text/csv")
+            logging?.csvDataURLProducer
+                .map({ MultipartFile(name: "logs.csv", mime: "text/csv", fileURL: $0) })
+                .catchingErrorsToFile(name: "logs.csv")
                 ?? SignalProducer(value: nil),
 
             // configurations
-            SignalProducer.deferValue({
-                MultipartFile(name: "applications.plist", mime: "application/xml", dataFrom: applicationsURL)
-            }).start(on: scheduler),
+            SignalProducer(value: MultipartFile(
+                name: "applications.plist",
+                mime: "application/xml",
+                fileURL: applicationsURL
+            )),
 
-            SignalProducer.deferValue({
-                MultipartFile(name: "contacts.plist", mime: "application/xml", dataFrom: contactsURL)
-            }).start(on: scheduler),
+            SignalProducer(value: MultipartFile(name: "contacts.plist", mime: "application/xml", fileURL: contactsURL)),
 
             SignalProducer(result: UserDefaults.standard.dataRepresentation())
                 .diagnosticFileProducer(name: "userdefaults.plist", mime: "application/xml"),
@@ -281,45 +291,43 @@ extension Services
             self.dailyStepsMultipartFileProducer()
         ]
 
-        // emit an endpoint with all non-nil files
-        return SignalProducer.combineLatest(fileProducers).map({ files in
-            DiagnosticDataRequest(queryItems: queryItems, files: files.flatMap({ $0 }).flatMap({ file in
-                // the API requires that files be gzipped
-                do
-                {
-                    return MultipartFile(
-                        name: file.name,
-                        mime: file.mime,
-                        data: try (file.data as NSData).byGZipCompressing()
-                    )
+        // create a request with all non-nil files, gzipping each in the background
+        return SignalProducer.combineLatest(fileProducers)
+            .promoteErrors(NSError.self)
+            .observe(on: scheduler)
+            .flatMap(.latest, transform: { files in
+                SignalProducer { observer, disposable in
+                    let temporaryDirectoryURL = URL(fileURLWithPath: NSTemporaryDirectory())
+                        .appendingPathComponent("ringly-diagnostics-\(UUID().uuidString)")
+
+                    do
+                    {
+                        let request = try DiagnosticDataRequest(
+                            queryItems: queryItems,
+                            files: files.flatMap({ $0 }),
+                            temporaryDirectoryURL: temporaryDirectoryURL
+                        )
+
+                        // if the producer was interrupted while gzipping, nothing will receive the request, so its
+                        // files must be removed here
+                        guard !disposable.isDisposed else {
+                            request.removeTemporaryFiles()
+                            return
+                        }
+
+                        observer.send(value: request)
+                        observer.sendCompleted()
+                    }
+                    catch let error as NSError
+                    {
+                        observer.send(error: error)
+                    }
                 }
-                catch let error as NSError
-                {
-                    SLogAPI("Error gzip compressing \(file.name): \(error)")
-                    return nil
-                }
-            }))
-        })
+            })
     }
 }
 
 // MARK: - Diagnostic Data Extensions
-extension MultipartFile
-{
-    init?(name: String, mime: String, dataFrom url: URL)
-    {
-        do
-        {
-            self.init(name: name, mime: mime, data: try Data(contentsOf: url))
-        }
-        catch let error as NSError
-        {
-            SLogAPI("Error loading data from \(url): \(error)")
-            self.init(name: name.errorFileName, mime: "text/plain", contents: "\(error)")
-        }
-    }
-}
-
 extension SignalProducerProtocol where Value == Data
 {
     fileprivate func diagnosticFileProducer(name: String, mime: String) -> SignalProducer<MultipartFile?, NoError>
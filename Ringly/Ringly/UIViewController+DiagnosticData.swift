@@ -15,7 +15,9 @@ extension UIViewController
             .concat(services.diagnosticDataRequestProducer(queryItems: queryItems)
                 .flatMap(.concat, transform: { request in
                     SignalProducer(value: .uploading).concat(
-                        services.api.producer(for: request).ignoreValues(CollectDiagnosticDataStep.self)
+                        services.api.producer(for: request)
+                            .ignoreValues(CollectDiagnosticDataStep.self)
+                            .on(disposed: request.removeTemporaryFiles)
                     )
                 })
             )
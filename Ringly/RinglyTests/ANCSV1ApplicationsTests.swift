@@ -31,7 +31,7 @@ final class ANCSV1ApplicationsTests: XCTestCase
             flagsValue: nil
         )
 
-        let result = notification.applicationsTest(configurations: configurations)
+        let result = notification.applicationsTest(configurations: ApplicationConfigurationIndex(configurations))
         XCTAssertEqual(result.value, configurations[0])
         XCTAssertNil(result.error)
     }
@@ -48,7 +48,7 @@ final class ANCSV1ApplicationsTests: XCTestCase
             flagsValue: nil
         )
 
-        let result = notification.applicationsTest(configurations: configurations)
+        let result = notification.applicationsTest(configurations: ApplicationConfigurationIndex(configurations))
         XCTAssertEqual(result.error, .applicationNotActivated)
         XCTAssertNil(result.value)
     }
@@ -65,7 +65,7 @@ final class ANCSV1ApplicationsTests: XCTestCase
             flagsValue: nil
         )
 
-        let result = notification.applicationsTest(configurations: configurations)
+        let result = notification.applicationsTest(configurations: ApplicationConfigurationIndex(configurations))
         XCTAssertEqual(result.error, .noApplicationConfiguration)
         XCTAssertNil(result.value)
     }
@@ -19,10 +19,10 @@ extension MockDataSource: ContactDataSource
 @available(iOS 9.0, *)
 final class ANCSV1ContactsTest: XCTestCase
 {
-    fileprivate let contacts: [ContactConfiguration] = [
+    fileprivate let contacts = ContactConfigurationIndex([
         MockDataSource(identifier: "1", names: ["Foo"]),
         MockDataSource(identifier: "2", names: ["Bar"])
-    ].map({ ContactConfiguration(dataSource: $0, color: .red) })
+    ].map({ ContactConfiguration(dataSource: $0, color: .red) }))
 
     func testContactPresentWithInnerRing()
     {
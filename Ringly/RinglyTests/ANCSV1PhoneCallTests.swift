@@ -4,14 +4,14 @@ import XCTest
 
 final class ANCSV1PhoneCallTests: XCTestCase
 {
-    fileprivate let applicationConfigurations = SupportedApplication.all.map({ app in
+    fileprivate let applicationConfigurations = ApplicationConfigurationIndex(SupportedApplication.all.map({ app in
         ApplicationConfiguration(application: app, color: .blue, vibration: .onePulse, activated: true)
-    })
+    }))
 
-    fileprivate let contactConfigurations: [ContactConfiguration] = [
+    fileprivate let contactConfigurations = ContactConfigurationIndex([
         MockDataSource(identifier: "1", names: ["Foo"]),
         MockDataSource(identifier: "2", names: ["Bar"])
-    ].map({ ContactConfiguration(dataSource: $0, color: .red) })
+    ].map({ ContactConfiguration(dataSource: $0, color: .red) }))
 
     func testPhoneCall()
     {
@@ -26,9 +26,9 @@ final class ANCSV1PhoneCallTests: XCTestCase
         )
 
         let result = notification.ANCSV1TestResult(
-            sentSignatures: [],
+            sentSignatures: NotificationSignatureCache(filePath: nil, loggingTo: { _ in }),
             applicationConfigurations: applicationConfigurations,
-            contactConfigurations: [],
+            contactConfigurations: ContactConfigurationIndex([]),
             innerRingEnabled: false
         )
 
@@ -48,7 +48,7 @@ final class ANCSV1PhoneCallTests: XCTestCase
         )
 
         let result = notification.ANCSV1TestResult(
-            sentSignatures: [],
+            sentSignatures: NotificationSignatureCache(filePath: nil, loggingTo: { _ in }),
             applicationConfigurations: applicationConfigurations,
             contactConfigurations: contactConfigurations,
             innerRingEnabled: true
@@ -70,7 +70,7 @@ final class ANCSV1PhoneCallTests: XCTestCase
         )
 
         let result = notification.ANCSV1TestResult(
-            sentSignatures: [],
+            sentSignatures: NotificationSignatureCache(filePath: nil, loggingTo: { _ in }),
             applicationConfigurations: applicationConfigurations,
             contactConfigurations: contactConfigurations,
             innerRingEnabled: true
@@ -0,0 +1,144 @@
+@testable import Ringly
+import RinglyKit
+import XCTest
+
+final class ANCSV2AppliedSettingsTests: XCTestCase
+{
+    // MARK: - Configurations
+    fileprivate func application(_ name: String, color: DefaultColor = .blue) -> ApplicationConfiguration
+    {
+        return ApplicationConfiguration(
+            application: SupportedApplication(name: name, scheme: name, identifiers: [name], analyticsName: name),
+            color: color,
+            vibration: .onePulse,
+            activated: true
+        )
+    }
+
+    fileprivate func contact(_ name: String, color: DefaultColor = .red) -> ContactConfiguration
+    {
+        return ContactConfiguration(dataSource: MockDataSource(identifier: name, names: [name]), color: color)
+    }
+
+    /// Describes application settings commands as strings, for comparison.
+    fileprivate func describe(_ commands: [RLYCommand]) -> [String]
+    {
+        return commands.map({ command in
+            if let application = command as? RLYApplicationSettingsCommand
+            {
+                return "\(application.mode == .add ? "+" : "-")\(application.applicationIdentifier)"
+            }
+            else if let contact = command as? RLYContactSettingsCommand
+            {
+                return "\(contact.mode == .add ? "+" : "-")\(contact.contactName)"
+            }
+            else if command is RLYClearApplicationSettingsCommand
+            {
+                return "clear applications"
+            }
+            else if command is RLYClearContactSettingsCommand
+            {
+                return "clear contacts"
+            }
+            else
+            {
+                return "\(command)"
+            }
+        })
+    }
+
+    // MARK: - Deltas
+    func testApplicationDelta()
+    {
+        let old = ANCSV2ConfigurationSnapshot(
+            applications: [application("a"), application("b"), application("c")],
+            contacts: [contact("x")]
+        )
+
+        let new = ANCSV2ConfigurationSnapshot(
+            applications: [application("a"), application("c", color: .green), application("d")],
+            contacts: [contact("x")]
+        )
+
+        let commands = new.commands(toChange: old.hash, applied: old.appliedConfiguration)
+        XCTAssertEqual(describe(commands), ["-b", "-c", "+c", "+d"])
+    }
+
+    func testContactDelta()
+    {
+        let old = ANCSV2ConfigurationSnapshot(applications: [application("a")], contacts: [contact("x"), contact("y")])
+        let new = ANCSV2ConfigurationSnapshot(applications: [application("a")], contacts: [contact("y"), contact("z")])
+
+        let commands = new.commands(toChange: old.hash, applied: old.appliedConfiguration)
+        XCTAssertEqual(describe(commands), ["-x", "+z"])
+    }
+
+    func testFullRewriteWhenAppliedHashDiffers()
+    {
+        let old = ANCSV2ConfigurationSnapshot(applications: [application("a")], contacts: [])
+        let new = ANCSV2ConfigurationSnapshot(applications: [application("b")], contacts: [])
+
+        // the peripheral reports a hash that doesn't match the stored settings
+        let unknownHash = ANCSV2PackedHash(first: old.hash.first ^ 1, second: old.hash.second)
+
+        let commands = new.commands(toChange: unknownHash, applied: old.appliedConfiguration)
+        XCTAssertEqual(describe(commands), ["clear applications", "+b"])
+    }
+
+    func testFullRewriteWhenAppliedUnknown()
+    {
+        let old = ANCSV2ConfigurationSnapshot(applications: [application("a")], contacts: [contact("x")])
+        let new = ANCSV2ConfigurationSnapshot(applications: [application("b")], contacts: [contact("y")])
+
+        let commands = new.commands(toChange: old.hash, applied: nil)
+        XCTAssertEqual(describe(commands), ["clear applications", "+b", "clear contacts", "+y"])
+    }
+
+    func testFullRewriteWithDuplicateKeys()
+    {
+        let old = ANCSV2ConfigurationSnapshot(applications: [], contacts: [contact("x")])
+        let new = ANCSV2ConfigurationSnapshot(applications: [], contacts: [contact("y"), contact("y", color: .green)])
+
+        XCTAssertNil(new.appliedConfiguration.contacts)
+
+        let commands = new.commands(toChange: old.hash, applied: old.appliedConfiguration)
+        XCTAssertEqual(describe(commands), ["clear contacts", "+y", "+y"])
+    }
+
+    // MARK: - Coding
+    func testCodingRoundTrip()
+    {
+        let snapshot = ANCSV2ConfigurationSnapshot(
+            applications: [application("a"), application("b", color: .purple)],
+            contacts: [contact("x")]
+        )
+
+        let applied = snapshot.appliedConfiguration
+        let decoded = ANCSV2AppliedConfiguration(encoded: applied.encoded)
+
+        XCTAssertEqual(decoded.applications?.hash, applied.applications?.hash)
+        XCTAssertEqual(decoded.contacts?.hash, applied.contacts?.hash)
+        XCTAssertTrue(decoded.applications.map({ $0.settings == applied.applications!.settings }) ?? false)
+        XCTAssertTrue(decoded.contacts.map({ $0.settings == applied.contacts!.settings }) ?? false)
+    }
+
+    func testStore()
+    {
+        let path = (NSTemporaryDirectory() as NSString).appendingPathComponent(UUID().uuidString)
+        let identifier = UUID()
+
+        let store = ANCSV2AppliedConfigurationStore(filePath: nil, loggingTo: { _ in })
+        XCTAssertNil(store[identifier])
+
+        store[identifier] = ANCSV2ConfigurationSnapshot(applications: [application("a")], contacts: []).appliedConfiguration
+        XCTAssertEqual(store[identifier]?.applications?.settings.count, 1)
+
+        store[identifier] = nil
+        XCTAssertNil(store[identifier])
+
+        // unreadable files are ignored
+        try? Data(bytes: [1, 2, 3]).write(to: URL(fileURLWithPath: path))
+        XCTAssertNil(ANCSV2AppliedConfigurationStore(filePath: path, loggingTo: { _ in })[identifier])
+        try? FileManager.default.removeItem(atPath: path)
+    }
+}
@@ -0,0 +1,152 @@
+@testable import Ringly
+import Nimble
+import XCTest
+
+final class AnalyticsEventJournalTests: XCTestCase
+{
+    // MARK: - Setup
+    fileprivate var fileURL: URL!
+
+    override func setUp()
+    {
+        super.setUp()
+        fileURL = URL(fileURLWithPath: NSTemporaryDirectory())
+            .appendingPathComponent("journal-test-\(getpid())-\(UUID().uuidString).journal")
+    }
+
+    override func tearDown()
+    {
+        try? FileManager.default.removeItem(at: fileURL)
+        super.tearDown()
+    }
+
+    fileprivate func makeJournal(labels: [String] = []) -> AnalyticsEventJournal
+    {
+        let journal = AnalyticsEventJournal(fileURL: fileURL)
+
+        labels.enumerated().forEach({ index, label in
+            try! journal.append(["label": label], date: Date(timeIntervalSinceReferenceDate: TimeInterval(index)))
+        })
+
+        return journal
+    }
+
+    fileprivate func labels(in journal: AnalyticsEventJournal) -> [String]
+    {
+        return journal.oldestEvents(maximumCount: Int.max, maximumBytes: Int.max).events.map({ $0["label"] as! String })
+    }
+
+    fileprivate var fileSize: Int
+    {
+        let attributes = try? FileManager.default.attributesOfItem(atPath: fileURL.path)
+        return (attributes?[.size] as? NSNumber)?.intValue ?? 0
+    }
+
+    // MARK: - Appending
+    func testAppendedEventsAreRead()
+    {
+        let journal = makeJournal(labels: ["A", "B", "C"])
+
+        expect(journal.count) == 3
+        expect(journal.oldestDate) == Date(timeIntervalSinceReferenceDate: 0)
+        expect(self.labels(in: journal)) == ["A", "B", "C"]
+    }
+
+    func testNullValuesAreStored()
+    {
+        let journal = makeJournal()
+        try! journal.append(["label": "A", "application_version": NSNull()], date: Date())
+
+        let event = journal.oldestEvents(maximumCount: 1, maximumBytes: Int.max).events.first
+        expect(event?["application_version"] is NSNull) == true
+    }
+
+    func testAppendingOnlyWritesNewRecord()
+    {
+        let journal = makeJournal(labels: ["A"])
+        let sizeAfterFirst = fileSize
+
+        try! journal.append(["label": "B"], date: Date())
+        expect(self.fileSize) == sizeAfterFirst * 2
+    }
+
+    // MARK: - Loading
+    func testReloadsStoredEvents()
+    {
+        let journal = makeJournal(labels: ["A", "B"])
+        let reloaded = AnalyticsEventJournal(fileURL: fileURL)
+
+        expect(reloaded.count) == 2
+        expect(reloaded.byteCount) == journal.byteCount
+        expect(reloaded.oldestDate) == journal.oldestDate
+        expect(self.labels(in: reloaded)) == ["A", "B"]
+    }
+
+    func testTruncatesIncompleteRecord()
+    {
+        _ = makeJournal(labels: ["Complete"])
+        let completeSize = fileSize
+
+        // simulate a write interrupted partway through a record
+        let handle = FileHandle(forWritingAtPath: fileURL.path)!
+        handle.seekToEndOfFile()
+        handle.write(Data(bytes: [1, 2, 3, 4, 5, 6, 7, 8, 255, 0, 0, 0, 123]))
+        handle.closeFile()
+
+        let reloaded = AnalyticsEventJournal(fileURL: fileURL)
+        expect(reloaded.count) == 1
+        expect(self.fileSize) == completeSize
+
+        try! reloaded.append(["label": "Appended"], date: Date())
+        expect(self.labels(in: AnalyticsEventJournal(fileURL: self.fileURL))) == ["Complete", "Appended"]
+    }
+
+    // MARK: - Batches
+    func testBatchesAreLimitedByCount()
+    {
+        let batch = makeJournal(labels: ["A", "B", "C"]).oldestEvents(maximumCount: 2, maximumBytes: Int.max)
+
+        expect(batch.recordCount) == 2
+        expect(batch.events.map({ $0["label"] as! String })) == ["A", "B"]
+    }
+
+    func testBatchesAreLimitedBySize()
+    {
+        let journal = makeJournal(labels: ["A", "B", "C"])
+        let eventSize = journal.byteCount / 3
+
+        expect(journal.oldestEvents(maximumCount: 10, maximumBytes: eventSize * 2).recordCount) == 2
+        expect(journal.oldestEvents(maximumCount: 10, maximumBytes: eventSize * 2 - 1).recordCount) == 1
+    }
+
+    func testBatchesIncludeOversizedFirstEvent()
+    {
+        let batch = makeJournal(labels: ["Large", "B"]).oldestEvents(maximumCount: 10, maximumBytes: 1)
+        expect(batch.recordCount) == 1
+    }
+
+    // MARK: - Acknowledging
+    func testAcknowledgingCompactsFile()
+    {
+        let journal = makeJournal(labels: ["A", "B", "C"])
+        let sizeBefore = fileSize
+
+        try! journal.acknowledge(2)
+
+        expect(journal.count) == 1
+        expect(journal.oldestDate) == Date(timeIntervalSinceReferenceDate: 2)
+        expect(self.fileSize) == sizeBefore / 3
+        expect(self.labels(in: AnalyticsEventJournal(fileURL: self.fileURL))) == ["C"]
+    }
+
+    func testAcknowledgingAllEventsRemovesFile()
+    {
+        let journal = makeJournal(labels: ["A", "B"])
+        try! journal.acknowledge(2)
+
+        expect(journal.count) == 0
+        expect(journal.byteCount) == 0
+        expect(journal.oldestDate).to(beNil())
+        expect(FileManager.default.fileExists(atPath: self.fileURL.path)) == false
+    }
+}
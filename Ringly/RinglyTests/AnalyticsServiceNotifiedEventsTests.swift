@@ -0,0 +1,163 @@
+@testable import Ringly
+import Nimble
+import RinglyAPI
+import XCTest
+
+final class AnalyticsServiceNotifiedEventsTests: AnalyticsServiceTestCase
+{
+    // MARK: - Utilities
+
+    /// Tracks a number of notified events.
+    fileprivate func trackNotifiedEvents(_ count: Int, label: String = "Test")
+    {
+        (0..<count).forEach({ _ in service.trackNotifiedEventWithLabel(label) })
+    }
+
+    /// Stores events in the journal, then relaunches the service, as if the events were stored by a previous launch.
+    fileprivate func relaunchService(withStoredLabels labels: [String])
+    {
+        let journal = AnalyticsEventJournal(fileURL: notifiedJournalURL)
+        labels.forEach({ try! journal.append(["label": $0], date: scheduler.currentDate) })
+        relaunchService()
+    }
+
+    /// Waits for all blocks already enqueued on the main queue, which includes delivery of upload results.
+    fileprivate func drainMainQueue()
+    {
+        let drained = expectation(description: "main queue drained")
+        DispatchQueue.main.async(execute: drained.fulfill)
+        waitForExpectations(timeout: 1, handler: nil)
+    }
+
+    // MARK: - Flush Triggers
+    func testEventsBelowThresholdsAreNotUploaded()
+    {
+        trackNotifiedEvents(4)
+        drainMainQueue()
+
+        expect(self.stores.notified.requestCount) == 0
+        expect(self.notifiedJournal.count) == 4
+    }
+
+    func testEventCountTriggersUpload()
+    {
+        trackNotifiedEvents(5)
+
+        expect(self.stores.notified.requestCount) == 1
+        expect(self.stores.notified.eventCounts) == [5]
+        expect(self.stores.notified.byteCount) > 0
+        expect(self.notifiedJournal.count).toEventually(equal(0))
+    }
+
+    func testEventSizeTriggersUpload()
+    {
+        trackNotifiedEvents(1, label: String(repeating: "a", count: 16 * 1024))
+        expect(self.stores.notified.requestCount) == 1
+    }
+
+    func testEventAgeTriggersUpload()
+    {
+        trackNotifiedEvents(1)
+
+        scheduler.advance(by: .seconds(15 * 60 - 1))
+        expect(self.stores.notified.requestCount) == 0
+
+        scheduler.advance(by: .seconds(1))
+        expect(self.stores.notified.requestCount) == 1
+    }
+
+    // MARK: - Persistence
+    func testEventsPersistAcrossLaunches()
+    {
+        trackNotifiedEvents(3)
+        relaunchService()
+
+        expect(self.notifiedJournal.count) == 3
+
+        trackNotifiedEvents(2)
+        expect(self.stores.notified.eventCounts) == [5]
+    }
+
+    func testStoredEventsAreUploadedAtLaunch()
+    {
+        relaunchService(withStoredLabels: (0..<5).map({ "Stored \($0)" }))
+        expect(self.stores.notified.eventCounts) == [5]
+    }
+
+    // MARK: - Batches
+    func testBatchesAreLimitedByCount()
+    {
+        relaunchService(withStoredLabels: (0..<120).map({ "Stored \($0)" }))
+
+        expect(self.stores.notified.eventCounts).toEventually(equal([50, 50, 20]))
+        expect(self.notifiedJournal.count).toEventually(equal(0))
+    }
+
+    func testBatchesAreLimitedBySize()
+    {
+        let label = String(repeating: "a", count: 20_000)
+        relaunchService(withStoredLabels: Array(repeating: label, count: 8))
+
+        expect(self.stores.notified.eventCounts).toEventually(equal([3, 3, 2]))
+    }
+
+    // MARK: - Failures
+    func testFailedUploadsAreRetriedWithBackoff()
+    {
+        stores.notified.error = NSError(domain: NSURLErrorDomain, code: NSURLErrorNotConnectedToInternet, userInfo: nil)
+
+        trackNotifiedEvents(5)
+        drainMainQueue()
+        expect(self.stores.notified.requestCount) == 1
+
+        // events tracked while waiting to retry do not trigger an upload
+        trackNotifiedEvents(5)
+        expect(self.stores.notified.requestCount) == 1
+
+        scheduler.advance(by: .seconds(29))
+        expect(self.stores.notified.requestCount) == 1
+        scheduler.advance(by: .seconds(1))
+        expect(self.stores.notified.requestCount) == 2
+        drainMainQueue()
+
+        // the delay doubles after each consecutive failure
+        scheduler.advance(by: .seconds(59))
+        expect(self.stores.notified.requestCount) == 2
+        scheduler.advance(by: .seconds(1))
+        expect(self.stores.notified.requestCount) == 3
+        drainMainQueue()
+
+        stores.notified.error = nil
+        scheduler.advance(by: .seconds(120))
+
+        expect(self.stores.notified.eventCounts) == [5, 10, 10, 10]
+        expect(self.notifiedJournal.count).toEventually(equal(0))
+    }
+
+    func testRejectedUploadsAreDropped()
+    {
+        stores.notified.error = NSError(domain: APIService.httpErrorDomain, code: 400, userInfo: nil)
+
+        trackNotifiedEvents(5)
+        expect(self.notifiedJournal.count).toEventually(equal(0))
+
+        scheduler.advance(by: .seconds(60 * 60))
+        expect(self.stores.notified.requestCount) == 1
+    }
+
+    func testRateLimitedUploadsAreRetried()
+    {
+        stores.notified.error = NSError(domain: APIService.httpErrorDomain, code: 429, userInfo: nil)
+
+        trackNotifiedEvents(5)
+        drainMainQueue()
+        expect(self.stores.notified.requestCount) == 1
+        expect(self.notifiedJournal.count) == 5
+
+        stores.notified.error = nil
+        scheduler.advance(by: .seconds(30))
+
+        expect(self.stores.notified.eventCounts) == [5, 5]
+        expect(self.notifiedJournal.count).toEventually(equal(0))
+    }
+}
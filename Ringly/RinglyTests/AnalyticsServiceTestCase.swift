@@ -24,6 +24,12 @@ class AnalyticsServiceTestCase: XCTestCase
     /// The test scheduler passed to the analytics service.
     fileprivate(set) var scheduler: TestScheduler!
 
+    /// The URL of the journal file for the service's notified events. This is removed after each test is run.
+    fileprivate(set) var notifiedJournalURL: URL!
+
+    /// The journal of notified events passed to the analytics service.
+    fileprivate(set) var notifiedJournal: AnalyticsEventJournal!
+
     /// A backing pipe for the service's `authenticationProducer`.
     fileprivate var authenticationPipe: (Signal<Authentication, NoError>, Observer<Authentication, NoError>)!
 
@@ -47,14 +53,10 @@ class AnalyticsServiceTestCase: XCTestCase
         scheduler = TestScheduler()
         authenticationPipe = Signal<Authentication, NoError>.pipe()
 
-        service = AnalyticsService(
-            authenticationProducer: SignalProducer(authenticationPipe.0),
-            dateScheduler: scheduler,
-            eventStore: stores.event,
-            identityStore: stores.identity,
-            notifiedStore: stores.notified,
-            superPropertyStore: stores.superProperty
-        )
+        notifiedJournalURL = URL(fileURLWithPath: NSTemporaryDirectory())
+            .appendingPathComponent("notified-test-\(getpid())-\(UUID().uuidString).journal")
+
+        relaunchService()
     }
 
     override func tearDown()
@@ -63,6 +65,26 @@ class AnalyticsServiceTestCase: XCTestCase
         stores = nil
         authenticationPipe = nil
         service = nil
+        notifiedJournal = nil
+        try? FileManager.default.removeItem(at: notifiedJournalURL)
+    }
+
+    /// Replaces `service` with a new service, using the same stores, scheduler, and notified journal file, as if the
+    /// app had been relaunched.
+    func relaunchService()
+    {
+        service = nil
+        notifiedJournal = AnalyticsEventJournal(fileURL: notifiedJournalURL)
+
+        service = AnalyticsService(
+            authenticationProducer: SignalProducer(authenticationPipe.0),
+            dateScheduler: scheduler,
+            eventStore: stores.event,
+            identityStore: stores.identity,
+            notifiedStore: stores.notified,
+            notifiedJournal: notifiedJournal,
+            superPropertyStore: stores.superProperty
+        )
     }
 }
 
@@ -158,15 +180,41 @@ func ==(lhs: TestIdentityStore.Event, rhs: TestIdentityStore.Event) -> Bool
 }
 
 // MARK: - Test Notified Store
+
+/// Stands in for the notified endpoint, building the same gzipped request that the API would receive, and counting
+/// requests, bytes, and events.
 class TestNotifiedStore: AnalyticsNotifiedStore
 {
-    var succeed = true
+    /// If non-`nil`, uploads fail with this error.
+    var error: NSError?
+
+    /// The number of upload requests started.
+    fileprivate(set) var requestCount = 0
+
+    /// The total size of the bodies of upload requests, in bytes.
+    fileprivate(set) var byteCount = 0
+
+    /// The number of events in each upload request.
+    fileprivate(set) var eventCounts: [Int] = []
 
     func trackNotifiedProducer(parameters: [String : AnyObject]) -> SignalProducer<(), NSError>
     {
-        return succeed
-            ? SignalProducer.empty
-            : SignalProducer(error: NSError(domain: "Test", code: 0, userInfo: nil))
+        return SignalProducer { observer, _ in
+            let request = AppEventsRequest(parameters: parameters).request(for: URL(string: "https://test.com/")!)
+
+            self.requestCount += 1
+            self.byteCount += request?.httpBody?.count ?? 0
+            self.eventCounts.append((parameters["events"] as? [Any])?.count ?? 0)
+
+            if let error = self.error
+            {
+                observer.send(error: error)
+            }
+            else
+            {
+                observer.sendCompleted()
+            }
+        }
     }
 }
 
@@ -0,0 +1,40 @@
+@testable import Ringly
+import RinglyExtensions
+import XCTest
+
+final class ApplicationConfigurationIndexTests: XCTestCase
+{
+    // MARK: - Configurations
+    let configurations = SupportedApplication.all.map({ app in
+        ApplicationConfiguration(application: app, color: .blue, vibration: .none, activated: true)
+    })
+
+    // MARK: - Matching
+    func testMatchesLinearSearch()
+    {
+        let index = ApplicationConfigurationIndex(configurations)
+        let identifiers = configurations.flatMap({ $0.application.identifiers })
+
+        // every supported identifier, in several cases and truncations, and some unsupported identifiers
+        let lookups = identifiers
+            + identifiers.map({ $0.uppercased() })
+            + identifiers.map({ $0.trimmedTo(length: 31) })
+            + identifiers.map({ $0.trimmedTo(length: 10) })
+            + ["", "com", "com.example.unsupported", "COM.APPLE"]
+
+        for identifier in lookups
+        {
+            for trim in [false, true]
+            {
+                let expected = configurations.configurationMatching(
+                    applicationIdentifier: identifier,
+                    trimLengthToMatch: trim
+                )
+
+                let actual = index.configuration(matching: identifier, trimLengthToMatch: trim)
+
+                XCTAssertEqual(actual?.application, expected?.application, "\(identifier), trim: \(trim)")
+            }
+        }
+    }
+}
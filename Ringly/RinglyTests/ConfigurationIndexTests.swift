@@ -0,0 +1,171 @@
+@testable import Ringly
+import RinglyExtensions
+import XCTest
+
+final class ConfigurationIndexTests: XCTestCase
+{
+    // MARK: - Configurations
+    let configurations = [
+        TestKeyedConfiguration(identifier: "1", indexKeys: ["Foo Bar", "Foo"]),
+        TestKeyedConfiguration(identifier: "2", indexKeys: ["Bar"]),
+        TestKeyedConfiguration(identifier: "3", indexKeys: ["Foo Baz"]),
+        TestKeyedConfiguration(identifier: "4", indexKeys: [])
+    ]
+
+    /// Generates configurations with unique keys, for performance tests.
+    ///
+    /// - parameter count: The number of configurations to generate.
+    func generatedConfigurations(count: Int) -> [TestKeyedConfiguration]
+    {
+        return (0..<count).map({ index -> TestKeyedConfiguration in
+            let key = "Key \(String(index, radix: 36)) Suffix\(index)"
+            return TestKeyedConfiguration(identifier: "\(index)", indexKeys: [key])
+        })
+    }
+
+    /// Truncated strings to look up in generated configurations, some of which do not match any configuration.
+    ///
+    /// - parameter count: The number of generated configurations.
+    func generatedLookups(count: Int) -> [String]
+    {
+        return stride(from: 0, to: count, by: max(count / 100, 1)).flatMap({ index in
+            ["Key \(String(index, radix: 36)) Suffix\(index)".trimmedTo(length: 12).uppercased(), "Unknown \(index)"]
+        })
+    }
+
+    // MARK: - Matching
+    func testMatchesLinearSearch()
+    {
+        let index = ConfigurationIndex(configurations)
+        let strings = ["", "F", "foo", "FOO BA", "foo bar", "Foo Bar Baz", "Foo Baz", "bar", "Ba", "Q"]
+
+        for string in strings
+        {
+            for trim in [false, true]
+            {
+                let expected = configurations.linearMatch(string, trimLengthToMatch: trim)
+                let actual = index.configuration(matching: string, trimLengthToMatch: trim)
+
+                XCTAssertEqual(actual?.identifier, expected?.identifier, "\(string), trim: \(trim)")
+            }
+        }
+    }
+
+    func testMatchesFirstConfiguration()
+    {
+        let index = ConfigurationIndex(configurations)
+
+        // "Foo Ba" is a prefix of keys in both the first and third configurations
+        XCTAssertEqual(index.configuration(matching: "Foo Ba", trimLengthToMatch: true)?.identifier, "1")
+        XCTAssertEqual(index.configuration(matching: "Foo Baz", trimLengthToMatch: true)?.identifier, "3")
+        XCTAssertNil(index.configuration(matching: "Foo Ba", trimLengthToMatch: false))
+    }
+
+    // MARK: - Updating
+    func testUpdatedWithUnchangedKeys()
+    {
+        let index = ConfigurationIndex(configurations)
+
+        let changed = configurations.map({ configuration in
+            TestKeyedConfiguration(identifier: "new \(configuration.identifier)", indexKeys: configuration.indexKeys)
+        })
+
+        XCTAssertEqual(index.updated(with: changed).configuration(matching: "Bar")?.identifier, "new 2")
+    }
+
+    func testUpdatedWithChangedKeys()
+    {
+        let index = ConfigurationIndex(configurations)
+        let updated = index.updated(with: [TestKeyedConfiguration(identifier: "2", indexKeys: ["Baz"])])
+
+        XCTAssertNil(updated.configuration(matching: "Bar", trimLengthToMatch: true))
+        XCTAssertEqual(updated.configuration(matching: "Baz", trimLengthToMatch: true)?.identifier, "2")
+        XCTAssertNil(index.updated(with: []).configuration(matching: "Bar"))
+    }
+
+    // MARK: - Performance
+    func measureIndex(count: Int)
+    {
+        let index = ConfigurationIndex(generatedConfigurations(count: count))
+        let lookups = generatedLookups(count: count)
+
+        measure {
+            for _ in 0..<10
+            {
+                for string in lookups
+                {
+                    _ = index.configuration(matching: string, trimLengthToMatch: true)
+                }
+            }
+        }
+    }
+
+    func measureLinearSearch(count: Int)
+    {
+        // the previous implementation, for comparison
+        let configurations = generatedConfigurations(count: count)
+        let lookups = generatedLookups(count: count)
+
+        measure {
+            for _ in 0..<10
+            {
+                for string in lookups
+                {
+                    _ = configurations.linearMatch(string, trimLengthToMatch: true)
+                }
+            }
+        }
+    }
+
+    func testIndexPerformance1000()
+    {
+        measureIndex(count: 1000)
+    }
+
+    func testIndexPerformance10000()
+    {
+        measureIndex(count: 10000)
+    }
+
+    func testLinearSearchPerformance1000()
+    {
+        measureLinearSearch(count: 1000)
+    }
+
+    func testLinearSearchPerformance10000()
+    {
+        measureLinearSearch(count: 10000)
+    }
+
+    func testIndexingPerformance10000()
+    {
+        let configurations = generatedConfigurations(count: 10000)
+
+        measure {
+            _ = ConfigurationIndex(configurations)
+        }
+    }
+}
+
+// MARK: - Test Configuration
+struct TestKeyedConfiguration: KeyedConfigurable
+{
+    let identifier: String
+    let indexKeys: [String]
+
+    static func normalizedKey(_ key: String) -> String
+    {
+        return key.folding(options: .caseInsensitive, locale: nil)
+    }
+}
+
+extension Sequence where Iterator.Element == TestKeyedConfiguration
+{
+    /// Finds the first configuration matching a string by comparing every key, as the services' arrays do.
+    fileprivate func linearMatch(_ string: String, trimLengthToMatch: Bool) -> TestKeyedConfiguration?
+    {
+        return first(where: { configuration in
+            configuration.indexKeys.containsCaseInsensitive(string, trimLengthToMatch: trimLengthToMatch)
+        })
+    }
+}
@@ -0,0 +1,43 @@
+@testable import Ringly
+import XCTest
+
+final class ContactConfigurationIndexTests: XCTestCase
+{
+    // MARK: - Configurations
+    let configurations = [
+        MockDataSource(identifier: "1", names: ["Foo Bar", "Foo"]),
+        MockDataSource(identifier: "2", names: ["Bar"]),
+        MockDataSource(identifier: "3", names: ["Foo Baz"]),
+        MockDataSource(identifier: "4", names: ["Zoë Smith"]),
+        MockDataSource(identifier: "5", names: [])
+    ].map({ ContactConfiguration(dataSource: $0, color: .red) })
+
+    // MARK: - Matching
+    func testMatchesLinearSearch()
+    {
+        let index = ContactConfigurationIndex(configurations)
+        let names = ["", "F", "foo", "FOO BA", "foo bar", "Foo Bar Baz", "Foo Baz", "bar", "Ba", "zoë", "ZOË SMITH", "Q"]
+
+        for name in names
+        {
+            for trim in [false, true]
+            {
+                let expected = configurations.contactConfiguration(name, trimLengthToMatch: trim)
+                let actual = index.configuration(matching: name, trimLengthToMatch: trim)
+
+                XCTAssertEqual(actual?.identifier, expected?.identifier, "\(name), trim: \(trim)")
+            }
+        }
+    }
+
+    func testMatchesDecomposedCharacters()
+    {
+        let index = ContactConfigurationIndex(configurations)
+
+        // "Zoë" with a combining diaeresis, rather than the precomposed character
+        let decomposed = "Zoe\u{0308} Smith"
+
+        XCTAssertEqual(index.configuration(matching: decomposed, trimLengthToMatch: false)?.identifier, "4")
+        XCTAssertEqual(index.configuration(matching: "ZOE\u{0308}", trimLengthToMatch: true)?.identifier, "4")
+    }
+}
@@ -0,0 +1,112 @@
+@testable import Ringly
+import Nimble
+import XCTest
+
+final class LoggingSegmentStoreTests: XCTestCase
+{
+    // MARK: - Setup
+    fileprivate var directoryURL: URL!
+
+    override func setUp()
+    {
+        super.setUp()
+
+        let path = "log-segment-test-\(getpid())-\(UUID().uuidString)"
+        directoryURL = URL(fileURLWithPath: NSTemporaryDirectory()).appendingPathComponent(path)
+        try! FileManager.default.createDirectory(at: directoryURL, withIntermediateDirectories: true, attributes: nil)
+    }
+
+    override func tearDown()
+    {
+        try? FileManager.default.removeItem(at: directoryURL)
+        super.tearDown()
+    }
+
+    fileprivate func makeStore(maximumSegmentSize: Int = 1024) -> LoggingSegmentStore
+    {
+        return LoggingSegmentStore(directoryURL: directoryURL, maximumSegmentSize: maximumSegmentSize)
+    }
+
+    fileprivate func message(_ text: String, offset: TimeInterval) -> LoggingMessage
+    {
+        return LoggingMessage(text: text, type: .bluetooth, date: Date(timeIntervalSinceReferenceDate: offset))
+    }
+
+    // MARK: - Encoding
+    func testRecordsRoundTrip()
+    {
+        let messages = [
+            message("ASCII", offset: 0.001),
+            message("“Unicode” ✨", offset: 1000),
+            LoggingMessage(text: "", type: .analytics, date: Date(timeIntervalSinceReferenceDate: -1))
+        ]
+
+        var data = Data(bytes: LoggingSegment.header)
+        messages.forEach({ LoggingSegment.append($0, to: &data) })
+
+        var decoded = [LoggingMessage]()
+
+        LoggingSegment.enumerateRecords(in: data, { date, type, text in
+            decoded.append(LoggingMessage(text: String(bytes: text, encoding: .utf8)!, type: type, date: date))
+        })
+
+        expect(decoded) == messages
+    }
+
+    func testDataWithoutHeaderHasNoRecords()
+    {
+        var data = Data(bytes: Array("ABCD".utf8))
+        LoggingSegment.append(message("Test", offset: 0), to: &data)
+
+        var count = 0
+        LoggingSegment.enumerateRecords(in: data, { _, _, _ in count += 1 })
+        expect(count) == 0
+    }
+
+    // MARK: - Loading
+    func testReloadsExistingSegments()
+    {
+        let messages = (0..<10).map({ message("Message \($0)", offset: TimeInterval($0)) })
+        let store = makeStore(maximumSegmentSize: 64)
+        messages.forEach({ try! store.append([$0]) })
+
+        let reloaded = makeStore(maximumSegmentSize: 64)
+        expect(reloaded.segmentURLs) == store.segmentURLs
+        expect(LoggingSegmentStore.messages(inSegmentsAt: reloaded.segmentURLs)) == messages
+
+        // appending continues in the newest segment
+        try! reloaded.append([message("Appended", offset: 10)])
+        expect(LoggingSegmentStore.messages(inSegmentsAt: reloaded.segmentURLs).last?.text) == "Appended"
+    }
+
+    func testTruncatesIncompleteRecordBeforeAppending()
+    {
+        let store = makeStore()
+        try! store.append([message("Complete", offset: 0)])
+
+        // simulate a write interrupted partway through a record
+        let url = store.segmentURLs[0]
+        var partial = Data()
+        LoggingSegment.append(message("Incomplete", offset: 1), to: &partial)
+
+        let handle = FileHandle(forWritingAtPath: url.path)!
+        handle.seekToEndOfFile()
+        handle.write(partial.subdata(in: 0..<(partial.count - 3)))
+        handle.closeFile()
+
+        let reloaded = makeStore()
+        try! reloaded.append([message("Appended", offset: 2)])
+
+        expect(LoggingSegmentStore.messages(inSegmentsAt: reloaded.segmentURLs).map({ $0.text }))
+            == ["Complete", "Appended"]
+    }
+
+    func testRemovesSegmentsWithoutRecords()
+    {
+        let url = directoryURL.appendingPathComponent("1.rlog")
+        try! Data(bytes: LoggingSegment.header).write(to: url)
+
+        expect(self.makeStore().segmentURLs) == []
+        expect(FileManager.default.fileExists(atPath: url.path)) == false
+    }
+}
@@ -1,7 +1,8 @@
 @testable import Ringly
 import Nimble
-import RealmSwift
 import ReactiveSwift
+import RealmSwift
+import UIKit
 import XCTest
 
 final class LoggingServiceTests: XCTestCase
@@ -16,10 +17,42 @@ final class LoggingServiceTests: XCTestCase
 
         scheduler = TestScheduler()
 
-        // logging service setup
+        // logging service setup, with writes only performed when flushed
+        logging = makeLogging(writeInterval: .seconds(60))
+    }
+
+    fileprivate func makeLogging(bufferCapacity: Int = 4096,
+                                 writeInterval: DispatchTimeInterval,
+                                 maximumSegmentSize: Int = 256 * 1024) -> LoggingService
+    {
+        return try! LoggingService(
+            directoryURL: temporaryDirectoryURL(),
+            cutoff: 0.8,
+            dateScheduler: scheduler,
+            bufferCapacity: bufferCapacity,
+            writeInterval: writeInterval,
+            pruneInterval: .seconds(10),
+            maximumSegmentSize: maximumSegmentSize
+        )
+    }
+
+    fileprivate func temporaryDirectoryURL() -> URL
+    {
         let path = "log-test-\(getpid())-\(UUID().uuidString)"
-        let temporary = URL(fileURLWithPath: NSTemporaryDirectory()).appendingPathComponent(path)
-        logging = try! LoggingService(storeURL: temporary, cutoff: 0.8, dateScheduler: scheduler)
+        return URL(fileURLWithPath: NSTemporaryDirectory()).appendingPathComponent(path)
+    }
+
+    /// The number of messages written to the store, without flushing buffered messages.
+    fileprivate func storedCount(_ logging: LoggingService) -> Int
+    {
+        let urls = LoggingSegmentStore.segmentURLs(in: logging.segmentsDirectoryURL)
+        return LoggingSegmentStore.messages(inSegmentsAt: urls).count
+    }
+
+    /// The number of segment files written to the store.
+    fileprivate func segmentCount(_ logging: LoggingService) -> Int
+    {
+        return LoggingSegmentStore.segmentURLs(in: logging.segmentsDirectoryURL).count
     }
 
     // MARK: - Cases
@@ -27,27 +60,364 @@ final class LoggingServiceTests: XCTestCase
     {
         logging.log("Test", type: .analytics)
 
-        let messages = (try? logging.messages()) ?? []
+        let messages = logging.messages()
         expect(messages) == [LoggingMessage(text: "Test", type: .analytics, date: scheduler.currentDate)]
     }
 
-    func testNoExpirationWithoutLog()
+    func testMessagesAreWrittenInOrder()
+    {
+        let dates = (0..<5).map({ offset -> Date in
+            scheduler.advance(by: .milliseconds(1))
+            logging.log("\(offset)", type: .bluetooth)
+            return scheduler.currentDate
+        })
+
+        let messages = logging.messages()
+        expect(messages) == dates.enumerated().map({ offset, date in
+            LoggingMessage(text: "\(offset)", type: .bluetooth, date: date)
+        })
+    }
+
+    func testMessageBatchesProducerSendsStoredMessagesThenWrittenMessages()
+    {
+        logging.log("Stored", type: .analytics)
+
+        var batches = [String]()
+        let disposable = logging.messageBatchesProducer.startWithValues({ batch in
+            batches.append(batch.map({ $0.text }).joined(separator: ", "))
+        })
+
+        logging.flush()
+        logging.log("Written", type: .bluetooth)
+        logging.flush()
+        disposable.dispose()
+
+        expect(batches) == ["Stored", "Written"]
+    }
+
+    // MARK: - Buffering
+    func testLoggingDoesNotWriteSynchronously()
+    {
+        logging.log("Test", type: .analytics)
+        expect(self.storedCount(self.logging)) == 0
+
+        logging.flush()
+        expect(self.storedCount(self.logging)) == 1
+    }
+
+    func testBufferedMessagesAreWrittenAfterInterval()
+    {
+        let logging = makeLogging(writeInterval: .milliseconds(50))
+        logging.log("Test", type: .analytics)
+        logging.log("Test", type: .analytics)
+
+        expect(self.storedCount(logging)).toEventually(equal(2), timeout: 1)
+    }
+
+    func testBusyBufferIsWrittenBeforeInterval()
+    {
+        let logging = makeLogging(bufferCapacity: 8, writeInterval: .seconds(60))
+        (0..<4).forEach({ logging.log("\($0)", type: .bluetooth) })
+
+        expect(self.storedCount(logging)).toEventually(equal(4), timeout: 1)
+    }
+
+    func testFlushWritesAllBufferedMessages()
+    {
+        (0..<1000).forEach({ logging.log("Peripheral wrote characteristic \($0)", type: .bluetooth) })
+        logging.flush()
+
+        expect(self.storedCount(self.logging)) == 1000
+    }
+
+    func testBufferedMessagesAreWrittenOnTerminate()
+    {
+        logging.log("Test", type: .analytics)
+        NotificationCenter.default.post(name: .UIApplicationWillTerminate, object: nil)
+
+        expect(self.storedCount(self.logging)) == 1
+    }
+
+    func testBufferedMessagesAreWrittenOnEnteringBackground()
+    {
+        logging.log("Test", type: .analytics)
+        NotificationCenter.default.post(name: .UIApplicationDidEnterBackground, object: nil)
+
+        expect(self.storedCount(self.logging)) == 1
+    }
+
+    func testOverwrittenMessagesAreReported()
+    {
+        // the second message overwrites the first before the buffer is written
+        let logging = makeLogging(bufferCapacity: 1, writeInterval: .seconds(60))
+        logging.log("Overwritten", type: .analytics)
+        logging.log("Test", type: .analytics)
+
+        let texts = logging.messages().map({ $0.text })
+        expect(texts.contains("Overwritten")) == false
+        expect(texts.contains("Test")) == true
+        expect(texts.contains(where: { $0.hasPrefix("Dropped 1 log messages") })) == true
+    }
+
+    // MARK: - Expiration
+    func testNoExpirationBeforePruneInterval()
     {
         let date = scheduler.currentDate
         logging.log("Expired", type: .analytics)
         scheduler.advance(by: .seconds(1))
+        logging.log("Test", type: .analytics)
 
-        let messages = (try? logging.messages()) ?? []
-        expect(messages) == [LoggingMessage(text: "Expired", type: .analytics, date: date)]
+        let messages = logging.messages()
+        expect(messages) == [
+            LoggingMessage(text: "Expired", type: .analytics, date: date),
+            LoggingMessage(text: "Test", type: .analytics, date: scheduler.currentDate)
+        ]
     }
 
-    func testExpirationWithLog()
+    func testExpirationAtPruneInterval()
     {
         logging.log("Expired", type: .analytics)
-        scheduler.advance(by: .seconds(1))
+        logging.flush()
+
+        scheduler.advance(by: .seconds(10))
         logging.log("Test", type: .analytics)
 
-        let messages = (try? logging.messages()) ?? []
+        let messages = logging.messages()
         expect(messages) == [LoggingMessage(text: "Test", type: .analytics, date: scheduler.currentDate)]
     }
+
+    // MARK: - Segments
+    func testSegmentsAreRotatedAtMaximumSize()
+    {
+        let logging = makeLogging(writeInterval: .seconds(60), maximumSegmentSize: 64)
+
+        (0..<3).forEach({ index in
+            logging.log("Segment \(index) message", type: .bluetooth)
+            logging.flush()
+        })
+
+        expect(self.segmentCount(logging)) == 3
+        expect(logging.messages().map({ $0.text })) == (0..<3).map({ "Segment \($0) message" })
+    }
+
+    func testPruningDropsWholeExpiredSegments()
+    {
+        // each segment holds two messages
+        let logging = makeLogging(writeInterval: .seconds(60), maximumSegmentSize: 64)
+
+        logging.log("Expired", type: .analytics)
+        scheduler.advance(by: .seconds(1))
+        logging.log("Expired", type: .analytics)
+        logging.flush()
+
+        // this message is expired when pruned, but its segment also contains a current message
+        logging.log("Retains", type: .analytics)
+        logging.flush()
+        scheduler.advance(by: .milliseconds(8500))
+        logging.log("Current", type: .analytics)
+        logging.flush()
+
+        scheduler.advance(by: .milliseconds(500))
+
+        expect(logging.messages().map({ $0.text })) == ["Retains", "Current"]
+        expect(self.segmentCount(logging)) == 1
+    }
+
+    func testPruningDropsNewestSegmentOnceExpired()
+    {
+        logging.log("Expired", type: .analytics)
+        logging.flush()
+        scheduler.advance(by: .seconds(10))
+
+        expect(self.logging.messages()) == []
+        expect(self.segmentCount(self.logging)) == 0
+    }
+
+    // MARK: - Comma-Separated Values
+    fileprivate func commaSeparatedValues(_ logging: LoggingService) -> String?
+    {
+        let url = temporaryDirectoryURL()
+        FileManager.default.createFile(atPath: url.path, contents: nil, attributes: nil)
+        defer { try? FileManager.default.removeItem(at: url) }
+
+        guard let handle = FileHandle(forWritingAtPath: url.path) else { return nil }
+        logging.writeCommaSeparatedValues(to: handle)
+        handle.closeFile()
+
+        return (try? Data(contentsOf: url)).flatMap({ String(data: $0, encoding: .utf8) })
+    }
+
+    func testCommaSeparatedValuesAreEscaped()
+    {
+        logging.log("Wrote \"hello, world\"\nto peripheral", type: .bluetooth)
+
+        let date = LoggingMessage.commaSeparatedDateFormatter.string(from: scheduler.currentDate)
+
+        expect(self.commaSeparatedValues(self.logging)) == [
+            "\"Date\",\"Type\",\"Message\"",
+            "\"\(date)\",\"Bluetooth\",\"Wrote \"\"hello, world\"\"\nto peripheral\"",
+            ""
+        ].joined(separator: "\n")
+    }
+
+    func testCommaSeparatedValuesIncludeAllSegments()
+    {
+        let logging = makeLogging(writeInterval: .seconds(60), maximumSegmentSize: 1024)
+        let count = 500
+
+        (0..<count).forEach({ index in
+            logging.log("Message \(index)", type: .bluetooth)
+
+            if index % 50 == 0
+            {
+                logging.flush()
+            }
+        })
+
+        let lines = commaSeparatedValues(logging)?.components(separatedBy: "\n") ?? []
+        expect(self.segmentCount(logging)) > 1
+        expect(lines.count) == count + 2
+        expect(lines[count].hasSuffix("\"Message \(count - 1)\"")) == true
+    }
+
+    func testCommaSeparatedValueWriterWritesInChunks()
+    {
+        let url = temporaryDirectoryURL()
+        FileManager.default.createFile(atPath: url.path, contents: nil, attributes: nil)
+        defer { try? FileManager.default.removeItem(at: url) }
+
+        let handle = FileHandle(forWritingAtPath: url.path)!
+        let writer = CommaSeparatedValueWriter(fileHandle: handle, chunkSize: 16)
+
+        // the first row is smaller than a chunk, so it is buffered until the second row fills the chunk
+        writer.append(row: ["A", "B"])
+        expect((try? Data(contentsOf: url))?.count) == 0
+
+        writer.append(row: ["0123456789", "0123456789"])
+        expect((try? Data(contentsOf: url))?.count) == 34
+
+        writer.append(row: ["C"])
+        writer.finish()
+        handle.closeFile()
+
+        expect((try? Data(contentsOf: url)).flatMap({ String(data: $0, encoding: .utf8) }))
+            == "\"A\",\"B\"\n\"0123456789\",\"0123456789\"\n\"C\"\n"
+    }
+
+    // MARK: - Performance
+
+    /// The number of messages logged in each iteration of the performance tests.
+    fileprivate let benchmarkCount = 1000
+
+    /// Logs a message to a Realm store, opening the store, deleting expired messages, and inserting the message in a
+    /// transaction on the calling thread, as the logging service did before buffering its writes.
+    fileprivate func logToRealm(_ string: String, type: RLogType, configuration: Realm.Configuration)
+    {
+        let realm = try! Realm(configuration: configuration)
+
+        try! realm.write {
+            let cutoffDate = NSDate(timeIntervalSinceNow: -604800)
+            realm.delete(realm.objects(RealmLoggingMessage.self).filter(NSPredicate(format: "date < %@", cutoffDate)))
+            realm.add(RealmLoggingMessage(text: string, type: type, date: Date()))
+        }
+    }
+
+    /// A Realm configuration for the store used before the logging service buffered its writes.
+    fileprivate func makeRealmConfiguration() -> Realm.Configuration
+    {
+        return Realm.Configuration(
+            fileURL: temporaryDirectoryURL().appendingPathExtension("realm"),
+            objectTypes: [RealmLoggingMessage.self]
+        )
+    }
+
+    /// Measures the throughput of `log`. Each iteration logs a fixed number of messages, so the measured time is the
+    /// inverse of the number of messages logged per second.
+    ///
+    /// - Parameters:
+    ///   - log: The logging function.
+    ///   - completion: A function to call after logging the messages, which is included in the measured time.
+    fileprivate func measureThroughput(log: @escaping (String) -> (), completion: @escaping () -> () = {})
+    {
+        let count = benchmarkCount
+
+        measure {
+            (0..<count).forEach({ log("Peripheral wrote characteristic \($0)") })
+            completion()
+        }
+    }
+
+    /// Measures the 99th percentile latency of each call to `log`. Each iteration times every call, then measures a
+    /// wait of the 99th percentile call's duration, so that the time reported for the iteration is that latency.
+    ///
+    /// - Parameter log: The logging function.
+    fileprivate func measureP99Latency(log: @escaping (String) -> ())
+    {
+        let count = benchmarkCount
+
+        measureMetrics(type(of: self).defaultPerformanceMetrics(), automaticallyStartMeasuring: false, for: {
+            var latencies = [TimeInterval]()
+            latencies.reserveCapacity(count)
+
+            for index in 0..<count
+            {
+                let start = ProcessInfo.processInfo.systemUptime
+                log("Peripheral wrote characteristic \(index)")
+                latencies.append(ProcessInfo.processInfo.systemUptime - start)
+            }
+
+            let p99 = latencies.sorted()[count * 99 / 100]
+
+            self.startMeasuring()
+            let end = ProcessInfo.processInfo.systemUptime + p99
+            while ProcessInfo.processInfo.systemUptime < end {}
+            self.stopMeasuring()
+        })
+    }
+
+    func testRealmLoggingThroughput()
+    {
+        let configuration = makeRealmConfiguration()
+        measureThroughput(log: { self.logToRealm($0, type: .bluetooth, configuration: configuration) })
+    }
+
+    func testRealmLoggingP99Latency()
+    {
+        let configuration = makeRealmConfiguration()
+        measureP99Latency(log: { self.logToRealm($0, type: .bluetooth, configuration: configuration) })
+    }
+
+    func testBufferedLoggingThroughput()
+    {
+        let logging = makeLogging(writeInterval: .seconds(1))
+
+        measureThroughput(
+            log: { logging.log($0, type: .bluetooth) },
+            completion: { logging.flush() }
+        )
+    }
+
+    func testBufferedLoggingP99Latency()
+    {
+        // use the production write interval, so that writes are scheduled as they would be in the app
+        let logging = makeLogging(writeInterval: .seconds(1))
+        measureP99Latency(log: { logging.log($0, type: .bluetooth) })
+        logging.flush()
+    }
+}
+
+/// A log message stored in Realm, as the logging service stored messages before buffering its writes.
+final class RealmLoggingMessage: Object
+{
+    convenience init(text: String, type: RLogType, date: Date)
+    {
+        self.init()
+        self.text = text
+        self.type = type.rawValue
+        self.date = date
+    }
+
+    dynamic var text = ""
+    dynamic var type = 0
+    dynamic var date = Date()
 }
@@ -0,0 +1,198 @@
+@testable import Ringly
+import XCTest
+
+final class NotificationSignatureCacheTests: XCTestCase
+{
+    // MARK: - Files
+    fileprivate var path: String!
+
+    override func setUp()
+    {
+        super.setUp()
+        path = (NSTemporaryDirectory() as NSString).appendingPathComponent(UUID().uuidString)
+    }
+
+    override func tearDown()
+    {
+        try? FileManager.default.removeItem(atPath: path)
+        super.tearDown()
+    }
+
+    fileprivate func cache(capacity: Int = 300, filePath: String? = nil) -> NotificationSignatureCache
+    {
+        return NotificationSignatureCache(capacity: capacity, filePath: filePath, loggingTo: { _ in })
+    }
+
+    // MARK: - Insertion
+    func testContains()
+    {
+        let cache = self.cache()
+        cache.insert("a")
+
+        XCTAssertTrue(cache.contains("a"))
+        XCTAssertFalse(cache.contains("b"))
+    }
+
+    func testEvictsLeastRecentlyInserted()
+    {
+        let cache = self.cache(capacity: 3)
+        ["a", "b", "c", "d"].forEach(cache.insert)
+
+        XCTAssertEqual(cache.signatures, ["d", "c", "b"])
+        XCTAssertFalse(cache.contains("a"))
+    }
+
+    func testReinsertionMovesToFront()
+    {
+        let cache = self.cache(capacity: 3)
+        ["a", "b", "c", "a", "d"].forEach(cache.insert)
+
+        XCTAssertEqual(cache.signatures, ["d", "a", "c"])
+        XCTAssertEqual(cache.count, 3)
+    }
+
+    func testRepeatedReinsertion()
+    {
+        let cache = self.cache(capacity: 5)
+
+        for index in 0..<1000
+        {
+            cache.insert("\(index % 7)")
+        }
+
+        XCTAssertEqual(cache.signatures, ["5", "4", "3", "2", "1"])
+    }
+
+    func testUniqueInsertionsRemainBounded()
+    {
+        let capacity = 50
+        let cache = self.cache(capacity: capacity)
+
+        for index in 0..<(capacity * 100)
+        {
+            cache.insert("\(index)")
+            XCTAssertLessThanOrEqual(cache.orderCount, 2 * capacity + 1)
+        }
+
+        XCTAssertEqual(cache.count, capacity)
+        XCTAssertEqual(cache.signatures.first, "\(capacity * 100 - 1)")
+        XCTAssertEqual(cache.signatures.last, "\(capacity * 99)")
+    }
+
+    func testReinsertionsRemainBounded()
+    {
+        let capacity = 50
+        let cache = self.cache(capacity: capacity)
+
+        for index in 0..<(capacity * 100)
+        {
+            cache.insert("\(index % (capacity / 2))")
+            XCTAssertLessThanOrEqual(cache.orderCount, 2 * max(capacity / 2, 16) + 1)
+        }
+
+        XCTAssertEqual(cache.count, capacity / 2)
+    }
+
+    // MARK: - Persistence
+    func testReadsLog()
+    {
+        let first = cache(capacity: 3, filePath: path)
+        ["a", "b\nwith newline", "c", "a"].forEach(first.insert)
+        first.waitForWrites()
+
+        XCTAssertEqual(cache(capacity: 3, filePath: path).signatures, ["a", "c", "b\nwith newline"])
+    }
+
+    func testCompactsLog()
+    {
+        let first = cache(capacity: 3, filePath: path)
+
+        for index in 0..<100
+        {
+            first.insert("\(index)")
+        }
+
+        first.waitForWrites()
+
+        // the log holds at most four times the capacity in records, each of which is at most six bytes here
+        let attributes = try? FileManager.default.attributesOfItem(atPath: path)
+        XCTAssertLessThanOrEqual((attributes?[.size] as? NSNumber)?.intValue ?? Int.max, 12 * 6)
+
+        XCTAssertEqual(cache(capacity: 3, filePath: path).signatures, ["99", "98", "97"])
+    }
+
+    func testTruncatedLog()
+    {
+        let first = cache(capacity: 3, filePath: path)
+        ["a", "b"].forEach(first.insert)
+        first.waitForWrites()
+
+        // simulate a partially written record
+        let handle = FileHandle(forWritingAtPath: path)
+        handle?.seekToEndOfFile()
+        handle?.write(Data(bytes: [10, 0, 0, 0, 65]))
+        handle?.closeFile()
+
+        let second = cache(capacity: 3, filePath: path)
+        XCTAssertEqual(second.signatures, ["b", "a"])
+
+        second.insert("c")
+        second.waitForWrites()
+
+        XCTAssertEqual(cache(capacity: 3, filePath: path).signatures, ["c", "b", "a"])
+    }
+
+    func testImportsPropertyList()
+    {
+        let propertyListPath = path + ".plist"
+        XCTAssertTrue((["c", "b", "a"] as NSArray).write(toFile: propertyListPath, atomically: true))
+
+        let cache = self.cache(filePath: path)
+        cache.importPropertyList(atPath: propertyListPath)
+        cache.waitForWrites()
+
+        XCTAssertEqual(cache.signatures, ["c", "b", "a"])
+        XCTAssertFalse(FileManager.default.fileExists(atPath: propertyListPath))
+    }
+
+    // MARK: - Performance
+    func testInsertionPerformance()
+    {
+        let signatures = (0..<10000).map({ "\($0)~*~com.apple.MobileSMS~*~Title~*~1480000000" })
+
+        measure {
+            let cache = self.cache()
+
+            for signature in signatures
+            {
+                if !cache.contains(signature)
+                {
+                    cache.insert(signature)
+                }
+            }
+        }
+    }
+
+    func testArrayInsertionPerformance()
+    {
+        // the previous implementation, for comparison, without the property list write after each insertion
+        let signatures = (0..<10000).map({ "\($0)~*~com.apple.MobileSMS~*~Title~*~1480000000" })
+
+        measure {
+            var cache = [String]()
+
+            for signature in signatures
+            {
+                if !cache.contains(signature)
+                {
+                    cache.insert(signature, at: 0)
+
+                    while cache.count > 300
+                    {
+                        cache.removeLast()
+                    }
+                }
+            }
+        }
+    }
+}
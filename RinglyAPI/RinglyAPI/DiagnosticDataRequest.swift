@@ -1,20 +1,59 @@
 import Foundation
 
 /// A request type for uploading users' diagnostic data to the API.
+///
+/// When the request is created, each file is gzipped into a temporary directory as it is read, so that the files are
+/// never held in memory. The `multipart/form-data` body is then streamed from the gzipped files as it is uploaded. The
+/// temporary directory should be removed with `removeTemporaryFiles()` once the request is no longer needed.
 public struct DiagnosticDataRequest
 {
     // MARK: - Initialization
 
-    /// Initializes a diagnostic data request.
+    /// Initializes a diagnostic data request, writing gzipped copies of its files.
     ///
     /// - Parameters:
     ///   - reference: The reference value for the diagnostic data upload (typically a Zendesk thread, but transparent
     ///                to the iOS app).
-    ///   - files: The files attached to the endpoint.
-    public init(queryItems: [URLQueryItem]?, files: [MultipartFile])
+    ///   - files: The files attached to the endpoint. These are gzipped, as required by the API.
+    ///   - temporaryDirectoryURL: The directory in which to write the gzipped files. This directory is created if
+    ///                            necessary.
+    /// - Throws: An error if the gzipped files could not be written. In this case, the temporary directory is removed.
+    public init(queryItems: [URLQueryItem]?, files: [MultipartFile], temporaryDirectoryURL: URL) throws
     {
         self.queryItems = queryItems
         self.files = files
+        self.temporaryDirectoryURL = temporaryDirectoryURL
+
+        try FileManager.default.createDirectory(
+            at: temporaryDirectoryURL,
+            withIntermediateDirectories: true,
+            attributes: nil
+        )
+
+        do
+        {
+            let gzippedFiles = try files.enumerated().map({ index, file in
+                try autoreleasepool {
+                    try DiagnosticDataRequest.gzip(
+                        file: file,
+                        to: temporaryDirectoryURL.appendingPathComponent("\(index).gz")
+                    )
+                }
+            })
+
+            let validQueryItems = queryItems?.filter({ $0.value != nil }) ?? []
+
+            self.encoder = try MultipartEncoder(
+                fields: validQueryItems.map({ MultipartField(name: $0.name, value: $0.value!) }),
+                files: gzippedFiles
+            )
+        }
+        catch
+        {
+            // the request will not be returned, so nothing else can remove the partially written files
+            try? FileManager.default.removeItem(at: temporaryDirectoryURL)
+            throw error
+        }
     }
 
     // MARK: - Information
@@ -27,30 +66,104 @@ public struct DiagnosticDataRequest
     /// The files attached to the endpoint.
     public let files: [MultipartFile]
 
-    // MARK: - Boundary
+    // MARK: - Body
+
+    /// The directory containing the gzipped files.
+    public let temporaryDirectoryURL: URL
 
-    /// The boundary value to use for `multipart/form-data`.
-    fileprivate let boundary: String = "boundary-\(UUID().uuidString)"
+    /// The encoder for the request body.
+    public let encoder: MultipartEncoder
+
+    /// Removes the gzipped files. After this, the request can no longer be sent.
+    public func removeTemporaryFiles()
+    {
+        try? FileManager.default.removeItem(at: temporaryDirectoryURL)
+    }
 }
 
 extension DiagnosticDataRequest: RequestProviding
 {
     public func request(for baseURL: URL) -> URLRequest?
     {
-        let validQueryItems = queryItems?.filter({ $0.value != nil }) ?? []
-        
-        let body = Data(
-            multipartFields: validQueryItems.map({ MultipartField(name: $0.name, value: $0.value!) }),
-            multipartFiles: files,
-            boundary: boundary
-        )
-
-        return URLRequest(
+        var request = URLRequest(
             method: .post,
             baseURL: baseURL,
             relativeURLString: "users/collect-diagnostics",
-            body: body,
-            headerFields: ["Content-Type": "multipart/form-data; boundary=\(boundary)"]
+            headerFields: [
+                "Content-Type": encoder.contentType,
+                "Content-Length": String(encoder.contentLength)
+            ]
         )
+
+        request?.httpBodyStream = encoder.makeInputStream()
+        return request
+    }
+}
+
+// MARK: - Gzipping Files
+extension DiagnosticDataRequest
+{
+    /// The number of bytes read from each file at a time.
+    fileprivate static let readChunkSize = 64 * 1024
+
+    /// Writes a gzipped copy of a file. If a file-backed file cannot be opened, a text file describing the error is
+    /// gzipped in its place.
+    ///
+    /// - Parameters:
+    ///   - file: The file to gzip.
+    ///   - url: The URL to write the gzipped file to.
+    /// - Returns: A file-backed file for the gzipped copy.
+    fileprivate static func gzip(file: MultipartFile, to url: URL) throws -> MultipartFile
+    {
+        guard FileManager.default.createFile(atPath: url.path, contents: nil, attributes: nil),
+              let handle = FileHandle(forWritingAtPath: url.path)
+        else {
+            throw NSError(domain: NSCocoaErrorDomain, code: NSFileWriteUnknownError, userInfo: [
+                NSFilePathErrorKey: url.path
+            ])
+        }
+
+        defer { handle.closeFile() }
+
+        let encoder = RLYGZipEncoder(outputHandler: { handle.write($0) })
+        var gzippedFile = MultipartFile(name: file.name, mime: file.mime, fileURL: url)
+
+        switch file.source
+        {
+        case let .data(data):
+            try encoder.append(data)
+
+        case let .file(fileURL):
+            let reader: FileHandle
+
+            do
+            {
+                reader = try FileHandle(forReadingFrom: fileURL)
+            }
+            catch let error as NSError
+            {
+                APILogFunction("Error opening \(fileURL) for diagnostic data: \(error)")
+
+                gzippedFile = MultipartFile(name: "\(file.name).error.txt", mime: "text/plain", fileURL: url)
+                try encoder.append("\(error)".data(using: .utf8) ?? Data())
+                break
+            }
+
+            defer { reader.closeFile() }
+
+            while true
+            {
+                let finished: Bool = try autoreleasepool {
+                    let chunk = reader.readData(ofLength: readChunkSize)
+                    try encoder.append(chunk)
+                    return chunk.count < readChunkSize
+                }
+
+                if finished { break }
+            }
+        }
+
+        try encoder.finish()
+        return gzippedFile
     }
 }
@@ -40,7 +40,7 @@ public struct MultipartFile
     {
         self.name = name
         self.mime = mime
-        self.data = data
+        self.source = .data(data)
     }
 
     /// Initializes a file value.
@@ -55,6 +55,19 @@ public struct MultipartFile
         self.init(name: name, mime: mime, data: data)
     }
 
+    /// Initializes a file value, backed by a file on disk. The file is not read until the multipart body is written.
+    ///
+    /// - Parameters:
+    ///   - name: The name of the file.
+    ///   - mime: The MIME type of the file.
+    ///   - fileURL: The URL of the file to upload.
+    public init(name: String, mime: String, fileURL: URL)
+    {
+        self.name = name
+        self.mime = mime
+        self.source = .file(fileURL)
+    }
+
     // MARK: - Properties
 
     /// The name of the file.
@@ -63,54 +76,410 @@ public struct MultipartFile
     /// The MIME type of the file.
     public let mime: String
 
-    /// The data to upload for the file.
-    public let data: Data
+    /// The source of the file's contents.
+    public let source: Source
+
+    // MARK: - Source
+
+    /// Enumerates the sources of a file's contents.
+    public enum Source
+    {
+        /// The contents are held in memory.
+        case data(Data)
+
+        /// The contents are read from a file on disk.
+        case file(URL)
+    }
 }
 
-extension Data
+// MARK: - Encoder
+
+/// Encodes a `multipart/form-data` body.
+///
+/// The length of the body is computed when the encoder is created, from the sizes of any file-backed files at that
+/// time. File-backed files are only read as the body is encoded, a chunk at a time, so bodies of any size may be
+/// encoded with constant memory. If a file grows after the encoder is created, only the bytes included in the content
+/// length are encoded.
+public struct MultipartEncoder
 {
-    /// Initializes a data value for `multipart/form-data` upload.
+    // MARK: - Initialization
+
+    /// Initializes a multipart encoder.
     ///
     /// - Parameters:
-    ///   - multipartFields: The fields to include in the data.
-    ///   - multipartFiles: The files to include in the data.
-    ///   - boundary: The boundary to use to separate elements of the data.
-    init(multipartFields: [MultipartField], multipartFiles: [MultipartFile], boundary: String)
+    ///   - fields: The fields to include in the body.
+    ///   - files: The files to include in the body. File-backed files must exist.
+    ///   - boundary: The boundary separating parts of the body.
+    /// - Throws: An error if the size of a file-backed file could not be determined.
+    public init(fields: [MultipartField], files: [MultipartFile], boundary: String = "boundary-\(UUID().uuidString)")
+        throws
     {
-        var data = Data()
+        var segments = fields.map({ field in Segment.data(field.encoded(boundary: boundary)) })
 
-        multipartFields.forEach({ field in
-            data.append("--\(boundary)\r\n")
-            data.append("Content-Disposition: form-data; name=\(field.name.quoted)\r\n\r\n")
-            data.append("\(field.value)\r\n")
-        })
+        for (index, file) in files.enumerated()
+        {
+            segments.append(.data(file.encodedHeaders(fieldName: "file_\(index)", boundary: boundary)))
 
-        multipartFiles.enumerated().forEach({ index, file in
-            let name = "file_\(index)"
-            data.append("--\(boundary)\r\n")
-            data.append("Content-Disposition: form-data; name=\(name.quoted); filename=\(file.name.quoted)\r\n")
-            data.append("Content-Type: \(file.mime)\r\n\r\n")
-            data.append(file.data)
-            data.append("\r\n")
-        })
+            switch file.source
+            {
+            case let .data(data):
+                segments.append(.data(data))
+
+            case let .file(url):
+                let attributes = try FileManager.default.attributesOfItem(atPath: url.path)
+                let length = (attributes[.size] as? NSNumber)?.uint64Value ?? 0
+                segments.append(.file(url, length: length))
+            }
+
+            segments.append(.data(MultipartEncoder.partTerminator))
+        }
+
+        segments.append(.data(MultipartEncoder.encodedString("--\(boundary)--\r\n")))
+
+        self.boundary = boundary
+        self.segments = segments
+        self.contentLength = segments.reduce(0, { $0 + $1.length })
+    }
+
+    // MARK: - Body
+
+    /// The boundary separating parts of the body.
+    public let boundary: String
+
+    /// The value of the `Content-Type` header for the body.
+    public var contentType: String
+    {
+        return "multipart/form-data; boundary=\(boundary)"
+    }
+
+    /// The length of the body, in bytes.
+    public let contentLength: UInt64
+
+    /// The segments of the body, in order.
+    fileprivate let segments: [Segment]
+
+    /// A contiguous segment of a multipart body.
+    fileprivate enum Segment
+    {
+        /// Bytes held in memory.
+        case data(Data)
+
+        /// The first `length` bytes of a file.
+        case file(URL, length: UInt64)
+
+        /// The length of the segment, in bytes.
+        var length: UInt64
+        {
+            switch self
+            {
+            case let .data(data):
+                return UInt64(data.count)
+            case let .file(_, length):
+                return length
+            }
+        }
+    }
+
+    // MARK: - Encoding
+
+    /// Encodes the body, passing it to a function in order, in chunks of at most `chunkSize` bytes for file-backed
+    /// files.
+    ///
+    /// - Parameters:
+    ///   - chunkSize: The maximum number of bytes to read from a file at a time.
+    ///   - output: A function to receive the encoded body. If this function throws, encoding stops.
+    /// - Throws: An error if a file-backed file could not be read, is shorter than when the encoder was created, or if
+    ///           `output` throws.
+    public func encode(chunkSize: Int = 64 * 1024, to output: (Data) throws -> ()) throws
+    {
+        for segment in segments
+        {
+            switch segment
+            {
+            case let .data(data):
+                try output(data)
+
+            case let .file(url, length):
+                let handle = try FileHandle(forReadingFrom: url)
+                defer { handle.closeFile() }
+
+                var remaining = length
 
-        data.append("--\(boundary)--\r\n")
+                while remaining > 0
+                {
+                    try autoreleasepool {
+                        let chunk = handle.readData(ofLength: Int(min(UInt64(max(chunkSize, 1)), remaining)))
 
-        self = data
+                        guard !chunk.isEmpty else {
+                            throw NSError(domain: NSCocoaErrorDomain, code: NSFileReadCorruptFileError, userInfo: [
+                                NSFilePathErrorKey: url.path
+                            ])
+                        }
+
+                        try output(chunk)
+                        remaining -= UInt64(chunk.count)
+                    }
+                }
+            }
+        }
+    }
+
+    /// Encodes the body to a file handle.
+    ///
+    /// - Parameter fileHandle: The file handle to write to.
+    /// - Throws: An error if a file-backed file could not be read.
+    public func write(to fileHandle: FileHandle) throws
+    {
+        try encode(to: { fileHandle.write($0) })
+    }
+
+    /// Creates a stream of the encoded body, suitable for use as a request's `httpBodyStream`.
+    ///
+    /// The body is encoded on a background queue when the stream is first opened, so creating a request with the
+    /// stream does no work until it is sent. The queue waits while the stream's buffer is full. Encoding ends early if
+    /// the stream is closed or released, or if a file-backed file cannot be read, in which case the stream will be
+    /// shorter than `contentLength`.
+    ///
+    /// The stream can only be read once. A request using it cannot be replayed - if `URLSession` needs to resend the
+    /// body (for a redirect or an authentication challenge), a new stream must be provided.
+    ///
+    /// - Parameter bufferSize: The size of the stream's buffer, and the maximum size of each chunk read from a file.
+    public func makeInputStream(bufferSize: Int = 64 * 1024) -> InputStream
+    {
+        return MultipartInputStream(encoder: self, bufferSize: bufferSize)
     }
 }
 
-extension Data
+// MARK: - Input Stream
+
+/// An input stream that encodes a multipart body when it is first opened, reading from one end of a bound stream pair
+/// that the encoder writes to on a background queue.
+///
+/// `URLSession` schedules a request's body stream through private Core Foundation methods, so these are forwarded to
+/// the bound stream as well, with its events reported to the client as events of this stream.
+private final class MultipartInputStream: InputStream, StreamDelegate
 {
-    fileprivate mutating func append(_ string: String)
+    // MARK: - Initialization
+    init(encoder: MultipartEncoder, bufferSize: Int)
+    {
+        var boundInput: InputStream?, boundOutput: OutputStream?
+        Stream.getBoundStreams(withBufferSize: bufferSize, inputStream: &boundInput, outputStream: &boundOutput)
+
+        self.encoder = encoder
+        self.bufferSize = bufferSize
+        self.boundInputStream = boundInput!
+        self.boundOutputStream = boundOutput!
+
+        super.init(data: Data())
+
+        boundInputStream.delegate = self
+    }
+
+    // MARK: - Encoding
+    fileprivate let encoder: MultipartEncoder
+    fileprivate let bufferSize: Int
+    fileprivate let boundInputStream: InputStream
+    fileprivate let boundOutputStream: OutputStream
+
+    /// `true` once the stream has been opened, and encoding has started.
+    fileprivate var encodingStarted = false
+
+    /// Starts encoding the body to the bound output stream.
+    fileprivate func startEncoding()
+    {
+        let (encoder, bufferSize, outputStream) = (self.encoder, self.bufferSize, boundOutputStream)
+
+        DispatchQueue.global(qos: .utility).async(execute: {
+            outputStream.open()
+            defer { outputStream.close() }
+
+            do
+            {
+                try encoder.encode(chunkSize: bufferSize, to: { try outputStream.write(all: $0) })
+            }
+            catch let error as NSError
+            {
+                APILogFunction("Stopped encoding multipart body: \(error)")
+            }
+        })
+    }
+
+    // MARK: - Stream
+    override func open()
     {
-        if let data = string.data(using: .utf8)
+        boundInputStream.open()
+
+        guard !encodingStarted else { return }
+        encodingStarted = true
+        startEncoding()
+    }
+
+    override func close()
+    {
+        boundInputStream.close()
+    }
+
+    override func read(_ buffer: UnsafeMutablePointer<UInt8>, maxLength len: Int) -> Int
+    {
+        return boundInputStream.read(buffer, maxLength: len)
+    }
+
+    override func getBuffer(_ buffer: UnsafeMutablePointer<UnsafeMutablePointer<UInt8>?>,
+                            length len: UnsafeMutablePointer<Int>) -> Bool
+    {
+        return false
+    }
+
+    override var hasBytesAvailable: Bool { return boundInputStream.hasBytesAvailable }
+    override var streamStatus: Stream.Status { return boundInputStream.streamStatus }
+    override var streamError: Error? { return boundInputStream.streamError }
+
+    override func property(forKey key: Stream.PropertyKey) -> Any?
+    {
+        return boundInputStream.property(forKey: key)
+    }
+
+    override func setProperty(_ property: Any?, forKey key: Stream.PropertyKey) -> Bool
+    {
+        return boundInputStream.setProperty(property, forKey: key)
+    }
+
+    // MARK: - Scheduling
+    override func schedule(in aRunLoop: RunLoop, forMode mode: RunLoopMode)
+    {
+        boundInputStream.schedule(in: aRunLoop, forMode: mode)
+    }
+
+    override func remove(from aRunLoop: RunLoop, forMode mode: RunLoopMode)
+    {
+        boundInputStream.remove(from: aRunLoop, forMode: mode)
+    }
+
+    @objc(_scheduleInCFRunLoop:forMode:)
+    fileprivate func scheduleInCFRunLoop(_ runLoop: CFRunLoop, forMode mode: CFString)
+    {
+        CFReadStreamScheduleWithRunLoop(boundReadStream, runLoop, CFRunLoopMode(mode))
+    }
+
+    @objc(_unscheduleFromCFRunLoop:forMode:)
+    fileprivate func unscheduleFromCFRunLoop(_ runLoop: CFRunLoop, forMode mode: CFString)
+    {
+        CFReadStreamUnscheduleFromRunLoop(boundReadStream, runLoop, CFRunLoopMode(mode))
+    }
+
+    // MARK: - Events
+
+    /// The stream's delegate, which receives the bound stream's events.
+    override var delegate: StreamDelegate?
+    {
+        get { return forwardedDelegate }
+        set { forwardedDelegate = newValue }
+    }
+
+    fileprivate weak var forwardedDelegate: StreamDelegate?
+
+    /// The Core Foundation client set by `URLSession`, which receives the bound stream's events.
+    fileprivate var client: (flags: CFOptionFlags, callback: CFReadStreamClientCallBack, context: Context)?
+
+    fileprivate typealias Context = CFStreamClientContext
+
+    fileprivate var boundReadStream: CFReadStream
+    {
+        return unsafeBitCast(boundInputStream, to: CFReadStream.self)
+    }
+
+    @objc(_setCFClientFlags:callback:context:)
+    fileprivate func setCFClientFlags(_ flags: CFOptionFlags,
+                                      callback: CFReadStreamClientCallBack?,
+                                      context: UnsafeMutablePointer<CFStreamClientContext>?) -> Bool
+    {
+        client = callback.map({ (flags: flags, callback: $0, context: context?.pointee ?? CFStreamClientContext()) })
+        return true
+    }
+
+    @objc func stream(_ aStream: Stream, handle eventCode: Stream.Event)
+    {
+        forwardedDelegate?.stream?(self, handle: eventCode)
+
+        if let client = self.client, client.flags & CFOptionFlags(eventCode.rawValue) != 0
         {
-            append(data)
+            client.callback(
+                unsafeBitCast(self, to: CFReadStream.self),
+                CFStreamEventType(rawValue: CFOptionFlags(eventCode.rawValue)),
+                client.context.info
+            )
         }
     }
 }
 
+// MARK: - Encoding Parts
+extension MultipartField
+{
+    /// Encodes the field as a part of a `multipart/form-data` body.
+    ///
+    /// - Parameter boundary: The boundary separating parts of the body.
+    fileprivate func encoded(boundary: String) -> Data
+    {
+        return MultipartEncoder.encodedString(
+            "--\(boundary)\r\nContent-Disposition: form-data; name=\(name.quoted)\r\n\r\n\(value)\r\n"
+        )
+    }
+}
+
+extension MultipartFile
+{
+    /// Encodes the headers that precede the file's contents in a `multipart/form-data` body.
+    ///
+    /// - Parameters:
+    ///   - fieldName: The form field name of the file.
+    ///   - boundary: The boundary separating parts of the body.
+    fileprivate func encodedHeaders(fieldName: String, boundary: String) -> Data
+    {
+        return MultipartEncoder.encodedString(
+            "--\(boundary)\r\n"
+          + "Content-Disposition: form-data; name=\(fieldName.quoted); filename=\(name.quoted)\r\n"
+          + "Content-Type: \(mime)\r\n\r\n"
+        )
+    }
+}
+
+extension MultipartEncoder
+{
+    /// The line ending that follows each part's contents.
+    fileprivate static let partTerminator = encodedString("\r\n")
+
+    /// Encodes a string as UTF-8.
+    fileprivate static func encodedString(_ string: String) -> Data
+    {
+        return Data(bytes: string.utf8)
+    }
+}
+
+extension OutputStream
+{
+    /// Writes all of the bytes of a data value, waiting for space to become available if necessary.
+    ///
+    /// - Parameter data: The data to write.
+    /// - Throws: The stream's error, if it stops accepting bytes.
+    fileprivate func write(all data: Data) throws
+    {
+        try data.withUnsafeBytes({ (bytes: UnsafePointer<UInt8>) -> () in
+            var offset = 0
+
+            while offset < data.count
+            {
+                let written = write(bytes + offset, maxLength: data.count - offset)
+
+                guard written > 0 else {
+                    throw streamError ?? NSError(domain: NSPOSIXErrorDomain, code: Int(EPIPE), userInfo: nil)
+                }
+
+                offset += written
+            }
+        })
+    }
+}
+
 extension String
 {
     fileprivate var quoted: String { return "\"\(self)\"" }
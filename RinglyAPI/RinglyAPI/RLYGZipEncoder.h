@@ -0,0 +1,51 @@
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ *  The error domain for `RLYGZipEncoder` errors. Error codes are zlib status codes.
+ */
+FOUNDATION_EXTERN NSString *const RLYGZipEncoderErrorDomain;
+
+/**
+ *  Incrementally compresses data in the gzip format. Compressed output is passed to an output handler as it becomes
+ *  available, so that large inputs can be compressed without holding either the input or the output in memory.
+ */
+@interface RLYGZipEncoder : NSObject
+
+#pragma mark - Initialization
+
+/**
+ *  Initializes a gzip encoder.
+ *
+ *  @param outputHandler A block called with each chunk of compressed output, in order.
+ */
+-(instancetype)initWithOutputHandler:(void(^)(NSData *data))outputHandler NS_DESIGNATED_INITIALIZER;
+
++(instancetype)new NS_UNAVAILABLE;
+-(instancetype)init NS_UNAVAILABLE;
+
+#pragma mark - Encoding
+
+/**
+ *  Compresses data, passing any available output to the output handler.
+ *
+ *  @param data  The data to compress.
+ *  @param error An error pointer, set if compression fails or the encoder has already been finished.
+ *
+ *  @returns `YES` if successful, otherwise `NO`.
+ */
+-(BOOL)appendData:(NSData*)data error:(NSError**)error;
+
+/**
+ *  Finishes the gzip stream, passing all remaining output to the output handler. No further data may be appended.
+ *
+ *  @param error An error pointer, set if compression fails or the encoder has already been finished.
+ *
+ *  @returns `YES` if successful, otherwise `NO`.
+ */
+-(BOOL)finishWithError:(NSError**)error;
+
+@end
+
+NS_ASSUME_NONNULL_END
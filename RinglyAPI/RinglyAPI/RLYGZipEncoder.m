@@ -0,0 +1,137 @@
+#import "RLYGZipEncoder.h"
+#import <zlib.h>
+
+NSString *const RLYGZipEncoderErrorDomain = @"RLYGZipEncoderErrorDomain";
+
+/// The size of each chunk of output passed to the output handler.
+static const NSUInteger RLYGZipEncoderChunkSize = 64 * 1024;
+
+/// Adding 16 to the maximum window bits selects a gzip header and trailer instead of a zlib wrapper.
+static const int RLYGZipEncoderWindowBits = MAX_WBITS + 16;
+
+@interface RLYGZipEncoder ()
+{
+@private
+    z_stream _stream;
+    BOOL _initialized;
+    BOOL _finished;
+    void (^_outputHandler)(NSData *data);
+}
+
+@end
+
+@implementation RLYGZipEncoder
+
+#pragma mark - Initialization
+-(instancetype)initWithOutputHandler:(void(^)(NSData*))outputHandler
+{
+    self = [super init];
+
+    if (self)
+    {
+        _outputHandler = [outputHandler copy];
+        _initialized = deflateInit2(&_stream,
+                                    Z_DEFAULT_COMPRESSION,
+                                    Z_DEFLATED,
+                                    RLYGZipEncoderWindowBits,
+                                    8,
+                                    Z_DEFAULT_STRATEGY) == Z_OK;
+    }
+
+    return self;
+}
+
+-(void)dealloc
+{
+    if (_initialized)
+    {
+        deflateEnd(&_stream);
+    }
+}
+
+#pragma mark - Encoding
+-(BOOL)appendData:(NSData*)data error:(NSError**)error
+{
+    __block BOOL success = YES;
+
+    [data enumerateByteRangesUsingBlock:^(const void *bytes, NSRange byteRange, BOOL *stop) {
+        if (![self deflateBytes:bytes length:byteRange.length flush:Z_NO_FLUSH error:error])
+        {
+            success = NO;
+            *stop = YES;
+        }
+    }];
+
+    return success;
+}
+
+-(BOOL)finishWithError:(NSError**)error
+{
+    if (![self deflateBytes:NULL length:0 flush:Z_FINISH error:error])
+    {
+        return NO;
+    }
+
+    _finished = YES;
+    return YES;
+}
+
+/**
+ *  Compresses bytes, passing each full chunk of output to the output handler.
+ *
+ *  @param bytes  The bytes to compress.
+ *  @param length The number of bytes.
+ *  @param flush  The zlib flush mode.
+ *  @param error  An error pointer.
+ */
+-(BOOL)deflateBytes:(const void*)bytes length:(NSUInteger)length flush:(int)flush error:(NSError**)error
+{
+    if (!_initialized || _finished)
+    {
+        if (error)
+        {
+            *error = [NSError errorWithDomain:RLYGZipEncoderErrorDomain code:Z_STREAM_ERROR userInfo:@{
+                NSLocalizedDescriptionKey: _finished ? @"The gzip stream is already finished" : @"Failed to initialize zlib"
+            }];
+        }
+
+        return NO;
+    }
+
+    _stream.next_in = (Bytef*)bytes;
+    _stream.avail_in = (uInt)length;
+
+    uint8_t output[RLYGZipEncoderChunkSize];
+    int status = Z_OK;
+
+    do
+    {
+        _stream.next_out = output;
+        _stream.avail_out = (uInt)RLYGZipEncoderChunkSize;
+
+        status = deflate(&_stream, flush);
+
+        if (status == Z_STREAM_ERROR)
+        {
+            if (error)
+            {
+                *error = [NSError errorWithDomain:RLYGZipEncoderErrorDomain code:status userInfo:@{
+                    NSLocalizedDescriptionKey: @"Failed to compress data"
+                }];
+            }
+
+            return NO;
+        }
+
+        NSUInteger produced = RLYGZipEncoderChunkSize - _stream.avail_out;
+
+        if (produced > 0)
+        {
+            _outputHandler([NSData dataWithBytes:output length:produced]);
+        }
+    } while (_stream.avail_out == 0 || (flush == Z_FINISH && status != Z_STREAM_END));
+
+    return YES;
+}
+
+@end
@@ -7,6 +7,7 @@
 //
 #import <Foundation/Foundation.h>
 #import "NSData+Godzippa.h"
+#import "RLYGZipEncoder.h"
 
 //! Project version number for RinglyAPI.
 FOUNDATION_EXPORT double RinglyAPIVersionNumber;
@@ -0,0 +1,320 @@
+@testable import RinglyAPI
+import Nimble
+import XCTest
+
+final class DiagnosticDataRequestTests: XCTestCase
+{
+    // MARK: - Setup
+    fileprivate var directoryURL: URL!
+
+    override func setUp()
+    {
+        super.setUp()
+
+        let path = "diagnostic-data-test-\(getpid())-\(UUID().uuidString)"
+        directoryURL = URL(fileURLWithPath: NSTemporaryDirectory()).appendingPathComponent(path)
+        try! FileManager.default.createDirectory(at: directoryURL, withIntermediateDirectories: true, attributes: nil)
+    }
+
+    override func tearDown()
+    {
+        try? FileManager.default.removeItem(at: directoryURL)
+        super.tearDown()
+    }
+
+    fileprivate func makeRequest(queryItems: [URLQueryItem]? = nil, files: [MultipartFile]) -> DiagnosticDataRequest
+    {
+        return try! DiagnosticDataRequest(
+            queryItems: queryItems,
+            files: files,
+            temporaryDirectoryURL: directoryURL.appendingPathComponent("gzipped")
+        )
+    }
+
+    fileprivate func writeFile(named name: String, contents: String) -> URL
+    {
+        let url = directoryURL.appendingPathComponent(name)
+        try! contents.data(using: .utf8)!.write(to: url)
+        return url
+    }
+
+    fileprivate func body(of request: DiagnosticDataRequest) -> Data
+    {
+        var body = Data()
+        try! request.encoder.encode(to: { body.append($0) })
+        return body
+    }
+
+    fileprivate func bodyParts(of request: DiagnosticDataRequest) -> [MultipartPart]
+    {
+        return multipartParts(of: body(of: request), boundary: request.encoder.boundary)
+    }
+
+    /// Uploads a request to `UploadStandInProtocol`, waiting for the upload to complete.
+    ///
+    /// - Parameter urlRequest: The request to upload.
+    /// - Returns: The status code of the response, if any.
+    fileprivate func upload(_ urlRequest: URLRequest) -> Int?
+    {
+        let configuration = URLSessionConfiguration.ephemeral
+        configuration.protocolClasses = [UploadStandInProtocol.self]
+        let session = URLSession(configuration: configuration)
+        defer { session.finishTasksAndInvalidate() }
+
+        let completed = expectation(description: "upload completed")
+        var statusCode: Int?
+
+        session.dataTask(with: urlRequest, completionHandler: { _, response, _ in
+            statusCode = (response as? HTTPURLResponse)?.statusCode
+            completed.fulfill()
+        }).resume()
+
+        waitForExpectations(timeout: 60, handler: nil)
+        return statusCode
+    }
+
+    // MARK: - Body
+    func testBodyContainsFieldsAndGzippedFiles()
+    {
+        let diskURL = writeFile(named: "disk.csv", contents: "a,b")
+
+        let request = makeRequest(
+            queryItems: [URLQueryItem(name: "reference", value: "1234"), URLQueryItem(name: "empty", value: nil)],
+            files: [
+                MultipartFile(name: "memory.txt", mime: "text/plain", contents: "In memory")!,
+                MultipartFile(name: "disk.csv", mime: "text/csv", fileURL: diskURL)
+            ]
+        )
+
+        expect(UInt64(body(of: request).count)) == request.encoder.contentLength
+
+        let parts = bodyParts(of: request)
+        expect(parts.count) == 3
+
+        expect(parts[0].headers) == "Content-Disposition: form-data; name=\"reference\""
+        expect(String(data: parts[0].contents, encoding: .utf8)) == "1234"
+
+        expect(parts[1].headers) == "Content-Disposition: form-data; name=\"file_0\"; filename=\"memory.txt\"\r\n"
+            + "Content-Type: text/plain"
+        expect(gunzippedString(parts[1].contents)) == "In memory"
+
+        expect(parts[2].headers) == "Content-Disposition: form-data; name=\"file_1\"; filename=\"disk.csv\"\r\n"
+            + "Content-Type: text/csv"
+        expect(gunzippedString(parts[2].contents)) == "a,b"
+    }
+
+    func testLargeFileRoundTrips()
+    {
+        // spans several read chunks, and is not a multiple of the chunk size
+        let contents = String(repeating: "0123456789abcdef", count: 20_001)
+        let url = writeFile(named: "large.txt", contents: contents)
+        let request = makeRequest(files: [MultipartFile(name: "large.txt", mime: "text/plain", fileURL: url)])
+
+        let parts = bodyParts(of: request)
+        expect(parts.count) == 1
+        expect(gunzippedString(parts[0].contents)) == contents
+    }
+
+    func testUnreadableFileIsReplacedWithError()
+    {
+        let url = directoryURL.appendingPathComponent("missing.plist")
+        let request = makeRequest(files: [MultipartFile(name: "missing.plist", mime: "application/xml", fileURL: url)])
+
+        let parts = bodyParts(of: request)
+        expect(parts.count) == 1
+        expect(parts[0].headers)
+            == "Content-Disposition: form-data; name=\"file_0\"; filename=\"missing.plist.error.txt\"\r\n"
+            + "Content-Type: text/plain"
+        expect(gunzippedString(parts[0].contents)?.isEmpty) == false
+    }
+
+    func testRemoveTemporaryFiles()
+    {
+        let request = makeRequest(files: [MultipartFile(name: "memory.txt", mime: "text/plain", contents: "Test")!])
+        expect(FileManager.default.fileExists(atPath: request.temporaryDirectoryURL.path)) == true
+
+        request.removeTemporaryFiles()
+        expect(FileManager.default.fileExists(atPath: request.temporaryDirectoryURL.path)) == false
+    }
+
+    func testFailedInitializationRemovesTemporaryFiles()
+    {
+        // a directory where the first gzipped file should be written prevents it from being created
+        let temporaryDirectoryURL = directoryURL.appendingPathComponent("gzipped")
+
+        try! FileManager.default.createDirectory(
+            at: temporaryDirectoryURL.appendingPathComponent("0.gz"),
+            withIntermediateDirectories: true,
+            attributes: nil
+        )
+
+        expect(try DiagnosticDataRequest(
+            queryItems: nil,
+            files: [MultipartFile(name: "memory.txt", mime: "text/plain", contents: "Test")!],
+            temporaryDirectoryURL: temporaryDirectoryURL
+        )).to(throwError())
+
+        expect(FileManager.default.fileExists(atPath: temporaryDirectoryURL.path)) == false
+    }
+
+    // MARK: - Uploading
+    func testUploadStreamsEntireBody()
+    {
+        let url = writeFile(named: "upload.txt", contents: String(repeating: "upload ", count: 50_000))
+        let request = makeRequest(files: [MultipartFile(name: "upload.txt", mime: "text/plain", fileURL: url)])
+        let urlRequest = request.request(for: URL(string: "https://test.com/")!)!
+
+        expect(urlRequest.httpBody).to(beNil())
+        expect(urlRequest.httpBodyStream).notTo(beNil())
+        expect(urlRequest.value(forHTTPHeaderField: "Content-Length")) == String(request.encoder.contentLength)
+
+        expect(self.upload(urlRequest)) == 200
+        expect(UploadStandInProtocol.receivedBody) == body(of: request)
+        expect(UploadStandInProtocol.receivedByteCount) == Int(request.encoder.contentLength)
+        expect(UploadStandInProtocol.receivedContentLength) == String(request.encoder.contentLength)
+    }
+
+    // MARK: - Memory
+    func testPeakMemoryIsIndependentOfFileSize()
+    {
+        let url = directoryURL.appendingPathComponent("large.realm")
+        writeIncompressibleFile(to: url, megabytes: 64)
+
+        var request: DiagnosticDataRequest?
+
+        let requestIncrease = peakResidentSizeIncrease(during: {
+            request = makeRequest(files: [
+                MultipartFile(name: "large.realm", mime: "application/octet-stream", fileURL: url)
+            ])
+        })
+
+        expect(request?.encoder.contentLength) > 64 * 1024 * 1024
+        expect(requestIncrease) < 16 * 1024 * 1024
+
+        // count the uploaded bytes, rather than holding the body in memory
+        UploadStandInProtocol.retainsBody = false
+        defer { UploadStandInProtocol.retainsBody = true }
+
+        let urlRequest = request!.request(for: URL(string: "https://test.com/")!)!
+        var statusCode: Int?
+
+        let uploadIncrease = peakResidentSizeIncrease(during: {
+            statusCode = upload(urlRequest)
+        })
+
+        expect(statusCode) == 200
+        expect(UploadStandInProtocol.receivedByteCount) == Int(request!.encoder.contentLength)
+        expect(uploadIncrease) < 16 * 1024 * 1024
+    }
+}
+
+// MARK: - Multipart Parsing
+private struct MultipartPart
+{
+    let headers: String
+    let contents: Data
+}
+
+/// Splits a `multipart/form-data` body into its parts.
+private func multipartParts(of body: Data, boundary: String) -> [MultipartPart]
+{
+    let delimiter = "\r\n--\(boundary)".data(using: .utf8)!
+    let headerEnd = "\r\n\r\n".data(using: .utf8)!
+
+    // prefixing a line ending lets the first delimiter be found in the same way as the others
+    var data = "\r\n".data(using: .utf8)!
+    data.append(body)
+
+    var parts = [MultipartPart]()
+    var searchStart = data.startIndex
+
+    while let start = data.range(of: delimiter, in: searchStart..<data.endIndex),
+          let end = data.range(of: delimiter, in: start.upperBound..<data.endIndex)
+    {
+        // skip the line ending that follows the delimiter
+        let part = data.subdata(in: (start.upperBound + 2)..<end.lowerBound)
+
+        if let split = part.range(of: headerEnd)
+        {
+            parts.append(MultipartPart(
+                headers: String(data: part.subdata(in: part.startIndex..<split.lowerBound), encoding: .utf8)!,
+                contents: part.subdata(in: split.upperBound..<part.endIndex)
+            ))
+        }
+
+        searchStart = end.lowerBound
+    }
+
+    return parts
+}
+
+private func gunzippedString(_ data: Data) -> String?
+{
+    return (try? (data as NSData).byGZipDecompressingData()).flatMap({ String(data: $0, encoding: .utf8) })
+}
+
+// MARK: - Upload Stand-In
+
+/// Stands in for the API, reading the streamed body of each request and responding with an empty success.
+private final class UploadStandInProtocol: URLProtocol
+{
+    /// Whether the body of each request is kept in `receivedBody`. If `false`, the body is only counted.
+    static var retainsBody = true
+
+    /// The body received by the most recent request, if `retainsBody` was `true`.
+    static var receivedBody: Data?
+
+    /// The size of the body received by the most recent request, in bytes.
+    static var receivedByteCount = 0
+
+    /// The `Content-Length` header of the most recent request.
+    static var receivedContentLength: String?
+
+    override class func canInit(with request: URLRequest) -> Bool
+    {
+        return true
+    }
+
+    override class func canonicalRequest(for request: URLRequest) -> URLRequest
+    {
+        return request
+    }
+
+    override func startLoading()
+    {
+        var body = Data()
+        var byteCount = 0
+
+        if let stream = request.httpBodyStream
+        {
+            var buffer = [UInt8](repeating: 0, count: 16 * 1024)
+            stream.open()
+
+            while true
+            {
+                let read = stream.read(&buffer, maxLength: buffer.count)
+                guard read > 0 else { break }
+
+                byteCount += read
+
+                if UploadStandInProtocol.retainsBody
+                {
+                    body.append(buffer, count: read)
+                }
+            }
+
+            stream.close()
+        }
+
+        UploadStandInProtocol.receivedBody = UploadStandInProtocol.retainsBody ? body : nil
+        UploadStandInProtocol.receivedByteCount = byteCount
+        UploadStandInProtocol.receivedContentLength = request.value(forHTTPHeaderField: "Content-Length")
+
+        let response = HTTPURLResponse(url: request.url!, statusCode: 200, httpVersion: "HTTP/1.1", headerFields: [:])!
+        client?.urlProtocol(self, didReceive: response, cacheStoragePolicy: .notAllowed)
+        client?.urlProtocol(self, didLoad: Data())
+        client?.urlProtocolDidFinishLoading(self)
+    }
+
+    override func stopLoading() {}
+}
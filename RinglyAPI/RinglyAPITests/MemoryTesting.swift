@@ -0,0 +1,71 @@
+import Foundation
+
+/// The resident memory size of the test process, in bytes.
+func residentSize() -> UInt64
+{
+    var info = mach_task_basic_info()
+    var count = mach_msg_type_number_t(MemoryLayout<mach_task_basic_info>.size / MemoryLayout<natural_t>.size)
+
+    let result = withUnsafeMutablePointer(to: &info, { pointer in
+        pointer.withMemoryRebound(to: integer_t.self, capacity: Int(count), { reboundPointer in
+            task_info(mach_task_self_, task_flavor_t(MACH_TASK_BASIC_INFO), reboundPointer, &count)
+        })
+    })
+
+    return result == KERN_SUCCESS ? info.resident_size : 0
+}
+
+/// Measures the largest increase in resident memory size while a function runs, sampling every 5 milliseconds.
+///
+/// - Parameter body: The function to measure.
+/// - Returns: The increase, in bytes.
+func peakResidentSizeIncrease(during body: () throws -> ()) rethrows -> UInt64
+{
+    let baseline = residentSize()
+    var peak = baseline
+
+    let queue = DispatchQueue(label: "memory sampling")
+    let timer = DispatchSource.makeTimerSource(queue: queue)
+    timer.scheduleRepeating(deadline: .now(), interval: .milliseconds(5))
+    timer.setEventHandler(handler: { peak = max(peak, residentSize()) })
+    timer.resume()
+
+    // cancel on the sampling queue, so that the timer cannot write to `peak` after it is read
+    let finish: () -> UInt64 = {
+        queue.sync(execute: { () -> UInt64 in
+            timer.cancel()
+            peak = max(peak, residentSize())
+            return peak - baseline
+        })
+    }
+
+    do
+    {
+        try body()
+    }
+    catch
+    {
+        _ = finish()
+        throw error
+    }
+
+    return finish()
+}
+
+/// Writes a file of random, incompressible data, one megabyte at a time.
+///
+/// - Parameters:
+///   - url: The URL of the file.
+///   - megabytes: The size of the file, in megabytes.
+func writeIncompressibleFile(to url: URL, megabytes: Int)
+{
+    FileManager.default.createFile(atPath: url.path, contents: nil, attributes: nil)
+    let handle = FileHandle(forWritingAtPath: url.path)!
+
+    let chunkSize = 1024 * 1024
+    var chunk = Data(count: chunkSize)
+    chunk.withUnsafeMutableBytes({ (bytes: UnsafeMutablePointer<UInt8>) in arc4random_buf(bytes, chunkSize) })
+
+    (0..<megabytes).forEach({ _ in handle.write(chunk) })
+    handle.closeFile()
+}
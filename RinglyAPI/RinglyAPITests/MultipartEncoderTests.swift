@@ -0,0 +1,235 @@
+@testable import RinglyAPI
+import Nimble
+import XCTest
+
+final class MultipartEncoderTests: XCTestCase
+{
+    // MARK: - Setup
+    fileprivate var directoryURL: URL!
+
+    override func setUp()
+    {
+        super.setUp()
+
+        let path = "multipart-test-\(getpid())-\(UUID().uuidString)"
+        directoryURL = URL(fileURLWithPath: NSTemporaryDirectory()).appendingPathComponent(path)
+        try! FileManager.default.createDirectory(at: directoryURL, withIntermediateDirectories: true, attributes: nil)
+    }
+
+    override func tearDown()
+    {
+        try? FileManager.default.removeItem(at: directoryURL)
+        super.tearDown()
+    }
+
+    fileprivate func writeFile(named name: String, contents: String) -> URL
+    {
+        let url = directoryURL.appendingPathComponent(name)
+        try! contents.data(using: .utf8)!.write(to: url)
+        return url
+    }
+
+    fileprivate func encodedBody(_ encoder: MultipartEncoder, chunkSize: Int = 64 * 1024) -> Data
+    {
+        var body = Data()
+        try! encoder.encode(chunkSize: chunkSize, to: { body.append($0) })
+        return body
+    }
+
+    // MARK: - Encoding
+    func testEncodesFieldsAndFiles()
+    {
+        let diskURL = writeFile(named: "disk.csv", contents: "a,b")
+
+        let encoder = try! MultipartEncoder(
+            fields: [MultipartField(name: "reference", value: "1234")],
+            files: [
+                MultipartFile(name: "memory.txt", mime: "text/plain", contents: "In memory")!,
+                MultipartFile(name: "disk.csv", mime: "text/csv", fileURL: diskURL)
+            ],
+            boundary: "test"
+        )
+
+        let expected = [
+            "--test\r\n",
+            "Content-Disposition: form-data; name=\"reference\"\r\n\r\n",
+            "1234\r\n",
+            "--test\r\n",
+            "Content-Disposition: form-data; name=\"file_0\"; filename=\"memory.txt\"\r\n",
+            "Content-Type: text/plain\r\n\r\n",
+            "In memory\r\n",
+            "--test\r\n",
+            "Content-Disposition: form-data; name=\"file_1\"; filename=\"disk.csv\"\r\n",
+            "Content-Type: text/csv\r\n\r\n",
+            "a,b\r\n",
+            "--test--\r\n"
+        ].joined()
+
+        expect(String(data: self.encodedBody(encoder), encoding: .utf8)) == expected
+        expect(encoder.contentLength) == UInt64(expected.utf8.count)
+        expect(encoder.contentType) == "multipart/form-data; boundary=test"
+    }
+
+    func testEncodesFilesInChunks()
+    {
+        let contents = String(repeating: "0123456789", count: 1000)
+        let url = writeFile(named: "chunked.txt", contents: contents)
+        let encoder = try! MultipartEncoder(
+            fields: [],
+            files: [MultipartFile(name: "chunked.txt", mime: "text/plain", fileURL: url)]
+        )
+
+        var chunks = [Data]()
+        try! encoder.encode(chunkSize: 3000, to: { chunks.append($0) })
+
+        // headers, four file chunks, terminator, closing boundary
+        expect(chunks.count) == 7
+        expect(chunks[1...4].map({ $0.count })) == [3000, 3000, 3000, 1000]
+    }
+
+    func testContentLengthIsFixedWhenFileGrows()
+    {
+        let url = writeFile(named: "growing.log", contents: "Before")
+        let encoder = try! MultipartEncoder(
+            fields: [],
+            files: [MultipartFile(name: "growing.log", mime: "text/plain", fileURL: url)],
+            boundary: "test"
+        )
+
+        let handle = FileHandle(forWritingAtPath: url.path)!
+        handle.seekToEndOfFile()
+        handle.write("After".data(using: .utf8)!)
+        handle.closeFile()
+
+        let body = encodedBody(encoder)
+        expect(UInt64(body.count)) == encoder.contentLength
+        expect(String(data: body, encoding: .utf8)?.contains("Before\r\n--test--")) == true
+    }
+
+    func testMissingFileThrows()
+    {
+        let url = directoryURL.appendingPathComponent("missing.txt")
+        expect(try MultipartEncoder(
+            fields: [],
+            files: [MultipartFile(name: "missing.txt", mime: "text/plain", fileURL: url)]
+        )).to(throwError())
+    }
+
+    func testShortenedFileThrows()
+    {
+        let url = writeFile(named: "shortened.txt", contents: "Original")
+        let encoder = try! MultipartEncoder(
+            fields: [],
+            files: [MultipartFile(name: "shortened.txt", mime: "text/plain", fileURL: url)]
+        )
+
+        try! "Short".data(using: .utf8)!.write(to: url)
+        expect(try encoder.encode(to: { _ in })).to(throwError())
+    }
+
+    // MARK: - Input Stream
+    func testInputStreamMatchesEncodedBody()
+    {
+        let url = writeFile(named: "stream.txt", contents: String(repeating: "stream ", count: 100_000))
+        let encoder = try! MultipartEncoder(
+            fields: [MultipartField(name: "reference", value: "1234")],
+            files: [MultipartFile(name: "stream.txt", mime: "text/plain", fileURL: url)]
+        )
+
+        let streamed = readAll(encoder.makeInputStream(bufferSize: 4096))
+        expect(streamed.count) == Int(encoder.contentLength)
+        expect(streamed) == encodedBody(encoder)
+    }
+
+    func testInputStreamEncodesWhenOpened()
+    {
+        let url = writeFile(named: "opened.txt", contents: String(repeating: "before ", count: 100_000))
+        let encoder = try! MultipartEncoder(
+            fields: [],
+            files: [MultipartFile(name: "opened.txt", mime: "text/plain", fileURL: url)]
+        )
+
+        // the file is replaced after the stream is created, but before it is opened
+        let stream = encoder.makeInputStream(bufferSize: 4096)
+        try! String(repeating: "after! ", count: 100_000).data(using: .utf8)!.write(to: url)
+
+        expect(readAll(stream)) == encodedBody(encoder)
+    }
+
+    // MARK: - Performance
+    func testInputStreamPeakMemoryIsIndependentOfFileSize()
+    {
+        let url = directoryURL.appendingPathComponent("large.bin")
+        writeIncompressibleFile(to: url, megabytes: 64)
+
+        let encoder = try! MultipartEncoder(
+            fields: [],
+            files: [MultipartFile(name: "large.bin", mime: "application/octet-stream", fileURL: url)]
+        )
+
+        var count = 0
+
+        let increase = peakResidentSizeIncrease(during: {
+            count = byteCount(of: encoder.makeInputStream())
+        })
+
+        expect(count) == Int(encoder.contentLength)
+        expect(increase) < 16 * 1024 * 1024
+    }
+
+    func testInputStreamThroughputBenchmark()
+    {
+        let url = directoryURL.appendingPathComponent("benchmark.bin")
+        writeIncompressibleFile(to: url, megabytes: 32)
+
+        let encoder = try! MultipartEncoder(
+            fields: [MultipartField(name: "reference", value: "1234")],
+            files: [MultipartFile(name: "benchmark.bin", mime: "application/octet-stream", fileURL: url)]
+        )
+
+        measure {
+            _ = byteCount(of: encoder.makeInputStream())
+        }
+    }
+}
+
+// MARK: - Reading Streams
+
+/// Reads an input stream until it ends.
+///
+/// - Parameters:
+///   - stream: The stream.
+///   - body: A function called with each chunk of bytes read. The buffer is only valid for the duration of the call.
+private func read(_ stream: InputStream, _ body: (UnsafeBufferPointer<UInt8>) -> ())
+{
+    var buffer = [UInt8](repeating: 0, count: 16 * 1024)
+
+    stream.open()
+    defer { stream.close() }
+
+    while true
+    {
+        let count = stream.read(&buffer, maxLength: buffer.count)
+        guard count > 0 else { break }
+
+        buffer.withUnsafeBufferPointer({ pointer in
+            body(UnsafeBufferPointer(start: pointer.baseAddress, count: count))
+        })
+    }
+}
+
+/// Reads all of the bytes of an input stream into memory.
+private func readAll(_ stream: InputStream) -> Data
+{
+    var data = Data()
+    read(stream, { data.append($0) })
+    return data
+}
+
+/// Counts the bytes of an input stream, without keeping them in memory.
+private func byteCount(of stream: InputStream) -> Int
+{
+    var count = 0
+    read(stream, { count += $0.count })
+    return count
+}
@@ -4,207 +4,497 @@ import enum Result.NoError
 
 /// Caches single value representations of activity tracking data for much quicker loading.
 ///
-/// It is assumed that a single cache file represents a single unit of elapsed time (day, hour).
+/// Records are keyed by calendar day, or by hour within a calendar day, so a single cache can be shared by every
+/// screen that displays the same days or hours, regardless of the range that each screen requests.
 public final class ActivityCache
 {
     /// Initializes an activity cache.
     ///
-    /// - Parameter fileURL: The URL at which the cache file should be stored. This should be in a cache directory, so
-    ///                      that iOS can delete the cache if file space is needed.
-    public init(fileURL: URL?)
+    /// - Parameters:
+    ///   - fileURL: The URL at which the cache file should be stored. This should be in a cache directory, so that iOS
+    ///              can delete the cache if file space is needed.
+    ///   - calendar: The calendar used to determine the day and hour of each record.
+    ///   - flushInterval: The interval to accumulate writes for before committing them in a single transaction.
+    public init(fileURL: URL?, calendar: Calendar = Calendar.current, flushInterval: TimeInterval = 0.25)
     {
         configuration = Realm.Configuration(
             fileURL: fileURL,
-            schemaVersion: 1,
+            schemaVersion: 3,
             deleteRealmIfMigrationNeeded: true,
             objectTypes: [ActivityCacheRecord.self, MindfulCacheRecord.self]
         )
+
+        self.calendar = calendar
+        self.flushInterval = flushInterval
     }
 
     /// The Realm configuration for the activity cache database.
     fileprivate let configuration: Realm.Configuration
 
-    /// A producer for cached steps data.
-    ///
-    /// - Parameters:
-    ///   - startDate: The start date to request cached data from.
-    ///   - count: The number of days to request cached data for.
-    /// - Returns: A producer that will yield an array of cached steps data of length `count`. If data is unavailable
-    ///            for a specific index, that index will be populated with a zero value.
-    public func stepsProducer(startDate: Date, count: Int) -> SignalProducer<[Steps], NSError>
-    {
-        let results = configuration.realmResultsProducer { realm -> Results<ActivityCacheRecord> in
-            realm.objects(ActivityCacheRecord.self).filter(NSPredicate(startDate: startDate as Date))
-        }
+    /// The calendar used to determine the day and hour of each record.
+    fileprivate let calendar: Calendar
 
-        return results.map({ results in
-            var array = Array(repeating: Steps.zero, count: count)
+    // MARK: - Pending Writes
 
-            results.forEach({ record in
-                let index = record.index
+    /// The interval to accumulate writes for before committing them.
+    fileprivate let flushInterval: TimeInterval
 
-                if index < count
-                {
-                    array[index] = record.steps
-                }
-            })
+    /// The queue on which pending writes are accumulated and committed.
+    fileprivate let queue = DispatchQueue(label: "ActivityCache", qos: .userInitiated)
+
+    /// Steps data waiting to be written, with the start date of each record. Only the latest value for each record is
+    /// written. Only accessed on `queue`.
+    fileprivate var pendingSteps = [ActivityCacheRecordKey:(Date, Steps)]()
+
+    /// Mindful minute data waiting to be written. Only accessed on `queue`.
+    fileprivate var pendingMindfulMinutes = [ActivityCacheRecordKey:(Date, MindfulMinute)]()
 
-            return array
+    /// Whether or not a flush of the pending writes has been scheduled. Only accessed on `queue`.
+    fileprivate var flushScheduled = false
+}
+
+extension ActivityCache
+{
+    // MARK: - Reading
+
+    /// A producer for cached steps data.
+    ///
+    /// - Parameter boundaryDates: The days or hours to request cached data for.
+    /// - Returns: A producer that will yield an array of cached steps data, with an element for each of
+    ///            `boundaryDates`. If data is unavailable for a specific element, it will be a zero value.
+    public func stepsProducer(boundaryDates: [BoundaryDates]) -> SignalProducer<[Steps], NSError>
+    {
+        return recordsProducer(boundaryDates: boundaryDates).map({ (records: [ActivityCacheRecord?]) in
+            records.map({ $0?.steps ?? Steps.zero })
         })
     }
-    
-    /// A producer for all cached steps data.
 
+    /// A producer for all cached daily steps data, sorted by date.
     public func stepsProducer() -> SignalProducer<[(Date,Steps)], NSError>
     {
-        let results = configuration.realmResultsProducer { realm -> Results<ActivityCacheRecord> in
-            realm.objects(ActivityCacheRecord.self)
-        }
-        
-        do {
+        do
+        {
             let realm = try Realm(configuration: configuration)
-            let results = realm.objects(ActivityCacheRecord.self)
-            
-            var array = Array(repeating: (Date.distantPast, Steps.zero), count: results.count)
-            
-            results.forEach({ record in
-                if let startDate = record.startDate {
-                    let date = startDate.addingTimeInterval(Double(record.index) * 86400.0)
-                    array[record.index] =  (date, record.steps)
-                }
-            })
-            
-            return SignalProducer<[(Date,Steps)], NSError>(value: array)
 
-        } catch {
-            return SignalProducer<[(Date,Steps)], NSError>(value: [])
+            let records = realm.objects(ActivityCacheRecord.self)
+                .filter("hour == %d", ActivityCacheRecordKey.dayHour)
+                .sorted(byKeyPath: "day", ascending: true)
+
+            return SignalProducer(value: records.flatMap({ record in
+                record.startDate.map({ ($0, record.steps) })
+            }))
+        }
+        catch let error as NSError
+        {
+            return SignalProducer(error: error)
         }
     }
-    
+
     /// A producer for cached mindful minute data.
     ///
-    /// - Parameters:
-    ///   - startDate: The start date to request cached data from.
-    ///   - count: The number of days to request cached data for.
-    /// - Returns: A producer that will yield an array of cached mindful minute data of length `count`. If data is unavailable
-    ///            for a specific index, that index will be populated with a zero value.
-    public func mindfulMinutesProducer(startDate: Date, count: Int) -> SignalProducer<[MindfulMinute], NSError>
-    {
-        let results = configuration.realmResultsProducer { realm -> Results<MindfulCacheRecord> in
-            realm.objects(MindfulCacheRecord.self).filter(NSPredicate(startDate: startDate as Date))
+    /// - Parameter boundaryDates: The days or hours to request cached data for.
+    /// - Returns: A producer that will yield an array of cached mindful minute data, with an element for each of
+    ///            `boundaryDates`. If data is unavailable for a specific element, it will be a zero value.
+    public func mindfulMinutesProducer(boundaryDates: [BoundaryDates]) -> SignalProducer<[MindfulMinute], NSError>
+    {
+        return recordsProducer(boundaryDates: boundaryDates).map({ (records: [MindfulCacheRecord?]) in
+            records.map({ $0?.minutes ?? MindfulMinute.zero })
+        })
+    }
+
+    /// A producer for the cached records for a set of boundary dates, which are read with a single range query.
+    ///
+    /// Records are keyed by day and hour in the cache's calendar, so a record written in another time zone can have the
+    /// same key as a different interval. Records are only returned if they start at the requested date.
+    ///
+    /// - Parameter boundaryDates: The days or hours to request cached records for.
+    fileprivate func recordsProducer<Record: Object>(boundaryDates: [BoundaryDates])
+        -> SignalProducer<[Record?], NSError> where Record: ActivityCacheKeyedRecord
+    {
+        let calendar = self.calendar
+        let keys = boundaryDates.map({ ActivityCacheRecordKey(boundaryDates: $0, calendar: calendar) })
+        let days = keys.flatMap({ $0?.day })
+
+        guard let first = days.min(), let last = days.max() else {
+            return SignalProducer(value: Array(repeating: nil, count: keys.count))
         }
-        
+
+        let results = configuration.realmResultsProducer { realm -> Results<Record> in
+            realm.objects(Record.self).filter("day >= %d AND day <= %d", first, last)
+        }
+
         return results.map({ results in
-            var array = Array(repeating: MindfulMinute.zero, count: count)
-            
-            results.forEach({ record in
-                let index = record.index
-                
-                if index < count
-                {
-                    array[index] = record.minutes
-                }
+            var records = [String:Record](minimumCapacity: results.count)
+            results.forEach({ records[$0.key] = $0 })
+
+            return zip(keys, boundaryDates).map({ key, dates in
+                key.flatMap({ records[$0.primaryKey] }).flatMap({ $0.startDate == dates.start ? $0 : nil })
             })
-            
-            return array
         })
     }
-    
-    /// Writes data to the cache.
+}
+
+extension ActivityCache
+{
+    // MARK: - Writing
+
+    /// Writes data to the cache. The write is committed asynchronously, along with any other writes made within the
+    /// flush interval. If data is written to the same record multiple times in that interval, only the last value is
+    /// committed.
     ///
     /// - Parameters:
-    ///   - startDate: The start date for the data.
-    ///   - index: The index for the data (the number of calendar units elapsed since `startDate`).
+    ///   - boundaryDates: The day or hour of the data. Other intervals are not cached.
     ///   - steps: The steps data to write.
-    @discardableResult
-    public func write(startDate: Date, index: Int, steps: Steps) -> Disposable
+    public func write(boundaryDates: BoundaryDates, steps: Steps)
     {
-        let queue = DispatchQueue.global(qos: DispatchQoS.QoSClass.userInitiated)
-        let predicate = NSCompoundPredicate(startDate: startDate, index: index)
+        guard let key = ActivityCacheRecordKey(boundaryDates: boundaryDates, calendar: calendar) else { return }
 
-        let producer: SignalProducer<(), NSError> =
-            configuration.realmProducer(queue: queue) { realm, observer, disposable in
-                try realm.write {
-                    realm.delete(realm.objects(ActivityCacheRecord.self).filter(predicate))
-
-                    let record = ActivityCacheRecord()
-                    record.startDate = startDate
-                    record.index = index
-                    record.walkingStepCount = steps.walkingStepCount
-                    record.runningStepCount = steps.runningStepCount
-                    realm.add(record)
-                }
+        queue.async {
+            self.pendingSteps[key] = (boundaryDates.start, steps)
+            self.scheduleFlush()
+        }
+    }
 
-                observer.sendCompleted()
-            }
+    /// Writes mindful minute data to the cache, with the same batching behavior as steps data.
+    ///
+    /// - Parameters:
+    ///   - boundaryDates: The day or hour of the data. Other intervals are not cached.
+    ///   - mindfulMinutes: The mindful minute data to write.
+    public func write(boundaryDates: BoundaryDates, mindfulMinutes: MindfulMinute)
+    {
+        guard let key = ActivityCacheRecordKey(boundaryDates: boundaryDates, calendar: calendar) else { return }
+
+        queue.async {
+            self.pendingMindfulMinutes[key] = (boundaryDates.start, mindfulMinutes)
+            self.scheduleFlush()
+        }
+    }
+
+    /// Blocks until all writes made before calling this function have been committed.
+    func waitForWrites()
+    {
+        queue.sync(execute: flush)
+    }
+
+    /// Schedules a flush after the flush interval, unless one is already scheduled. Must be called on `queue`.
+    ///
+    /// The scheduled flush retains the cache, so that pending writes are committed even if all other references to the
+    /// cache are released.
+    fileprivate func scheduleFlush()
+    {
+        guard !flushScheduled else { return }
+        flushScheduled = true
+
+        queue.asyncAfter(deadline: .now() + flushInterval, execute: flush)
+    }
+
+    /// Commits all pending writes in a single transaction. Must be called on `queue`.
+    fileprivate func flush()
+    {
+        flushScheduled = false
+
+        let steps = pendingSteps, mindfulMinutes = pendingMindfulMinutes
+        guard !steps.isEmpty || !mindfulMinutes.isEmpty else { return }
+
+        pendingSteps = [:]
+        pendingMindfulMinutes = [:]
+
+        do
+        {
+            let realm = try Realm(configuration: configuration)
+
+            try realm.write {
+                realm.add(steps.map({ key, value in
+                    ActivityCacheRecord(key: key, startDate: value.0, steps: value.1)
+                }), update: true)
 
-        return producer.startWithFailed({ error in
+                realm.add(mindfulMinutes.map({ key, value in
+                    MindfulCacheRecord(key: key, startDate: value.0, minutes: value.1)
+                }), update: true)
+            }
+        }
+        catch let error as NSError
+        {
             print(error)
-        })
+        }
     }
-    
-    @discardableResult
-    public func write(startDate: Date, index: Int, mindfulMinutes: MindfulMinute) -> Disposable
+}
+
+extension ActivityCache
+{
+    // MARK: - Invalidation
+
+    /// The kinds of data stored in the cache.
+    public struct DataKinds: OptionSet
     {
-        let queue = DispatchQueue.global(qos: DispatchQoS.QoSClass.userInitiated)
-        let predicate = NSCompoundPredicate(startDate: startDate, index: index)
-        
-        let producer: SignalProducer<(), NSError> =
-            configuration.realmProducer(queue: queue) { realm, observer, disposable in
+        public init(rawValue: Int)
+        {
+            self.rawValue = rawValue
+        }
+
+        public let rawValue: Int
+
+        /// Steps data.
+        public static let steps = DataKinds(rawValue: 1 << 0)
+
+        /// Mindful minute data.
+        public static let mindfulMinutes = DataKinds(rawValue: 1 << 1)
+
+        /// All kinds of data.
+        public static let all: DataKinds = [.steps, .mindfulMinutes]
+    }
+
+    /// Removes cached data for every day and hour overlapping any of the specified intervals, including pending writes.
+    ///
+    /// - Parameters:
+    ///   - intervals: The intervals to invalidate.
+    ///   - kinds: The kinds of data to invalidate.
+    public func invalidate(_ intervals: [BoundaryDates], kinds: DataKinds = .all)
+    {
+        let calendar = self.calendar
+
+        let keys = Set(intervals.flatMap({ interval in
+            ActivityCacheRecordKey.keys(overlapping: interval, calendar: calendar)
+        }))
+
+        guard !keys.isEmpty && !kinds.isEmpty else { return }
+
+        queue.async {
+            keys.forEach({ key in
+                if kinds.contains(.steps)
+                {
+                    self.pendingSteps.removeValue(forKey: key)
+                }
+
+                if kinds.contains(.mindfulMinutes)
+                {
+                    self.pendingMindfulMinutes.removeValue(forKey: key)
+                }
+            })
+
+            do
+            {
+                let realm = try Realm(configuration: self.configuration)
+                let predicate = NSPredicate(format: "key IN %@", keys.map({ $0.primaryKey }))
+
                 try realm.write {
-                    realm.delete(realm.objects(MindfulCacheRecord.self).filter(predicate))
-                    
-                    let record = MindfulCacheRecord()
-                    record.startDate = startDate
-                    record.index = index
-                    record.minuteCount = mindfulMinutes.minuteCount
-                    realm.add(record)
+                    if kinds.contains(.steps)
+                    {
+                        realm.delete(realm.objects(ActivityCacheRecord.self).filter(predicate))
+                    }
+
+                    if kinds.contains(.mindfulMinutes)
+                    {
+                        realm.delete(realm.objects(MindfulCacheRecord.self).filter(predicate))
+                    }
                 }
-                
-                observer.sendCompleted()
+            }
+            catch let error as NSError
+            {
+                print(error)
+            }
         }
-        
-        return producer.startWithFailed({ error in
-            print(error)
+    }
+
+    /// Invalidates cached steps data for the intervals sent by a signal. Data controllers that are currently
+    /// displaying the affected days will rewrite them.
+    ///
+    /// - Parameter writtenIntervals: A signal sending the intervals that steps data is written to, each time it is
+    ///                               written, such as `RealmService.writtenStepsIntervals`.
+    /// - Returns: A disposable, which stops invalidation when disposed.
+    @discardableResult
+    public func invalidateSteps(writtenIn writtenIntervals: Signal<[BoundaryDates], NoError>) -> Disposable?
+    {
+        return writtenIntervals.observeValues({ [weak self] intervals in
+            self?.invalidate(intervals, kinds: .steps)
         })
     }
 }
 
+// MARK: - Keys
+
+/// Identifies a record in the activity cache.
+fileprivate struct ActivityCacheRecordKey: Hashable
+{
+    /// The value of `hour` for records that cover an entire day.
+    static let dayHour = -1
+
+    /// The absolute number of the record's day in its calendar.
+    let day: Int
+
+    /// The number of hours elapsed since the start of the day, or `dayHour` for a record covering the entire day.
+    let hour: Int
+
+    /// The primary key for the record.
+    var primaryKey: String
+    {
+        return "\(day):\(hour)"
+    }
+
+    var hashValue: Int
+    {
+        return day << 5 ^ hour
+    }
+}
+
+extension ActivityCacheRecordKey
+{
+    /// Initializes a record key, if the boundary dates cover exactly one calendar day or one hour.
+    ///
+    /// - Parameters:
+    ///   - boundaryDates: The boundary dates.
+    ///   - calendar: The calendar to use.
+    init?(boundaryDates: BoundaryDates, calendar: Calendar)
+    {
+        let start = boundaryDates.start
+        let components = calendar.dateComponents([.day, .hour, .minute, .second], from: start, to: boundaryDates.end)
+        let dayStart = calendar.startOfDay(for: start)
+
+        guard let day = calendar.ordinality(of: .day, in: .era, for: start),
+              components.minute == 0 && components.second == 0
+        else { return nil }
+
+        if components.day == 1 && components.hour == 0 && start == dayStart
+        {
+            self.init(day: day, hour: ActivityCacheRecordKey.dayHour)
+        }
+        else if components.day == 0 && components.hour == 1
+        {
+            // count elapsed hours rather than using the hour component, which repeats when clocks are set back
+            let elapsed = start.timeIntervalSince(dayStart)
+            guard elapsed.truncatingRemainder(dividingBy: 3600) == 0 else { return nil }
+
+            self.init(day: day, hour: Int(elapsed / 3600))
+        }
+        else
+        {
+            return nil
+        }
+    }
+
+    /// The keys for every day and hour overlapping an interval. An empty interval overlaps the day and hour containing
+    /// its start.
+    ///
+    /// - Parameters:
+    ///   - interval: The interval.
+    ///   - calendar: The calendar to use.
+    static func keys(overlapping interval: BoundaryDates, calendar: Calendar) -> [ActivityCacheRecordKey]
+    {
+        let end = max(interval.end, interval.start.addingTimeInterval(1))
+
+        var keys = [ActivityCacheRecordKey]()
+        var dayStart = calendar.startOfDay(for: interval.start)
+
+        while dayStart < end
+        {
+            guard let day = calendar.ordinality(of: .day, in: .era, for: dayStart),
+                  let nextDay = calendar.date(byAdding: .day, value: 1, to: dayStart)
+            else { break }
+
+            let nextDayStart = calendar.startOfDay(for: nextDay)
+
+            // hours are counted from the start of the day, as in `init(boundaryDates:calendar:)`
+            let firstHour = Int(max(interval.start.timeIntervalSince(dayStart), 0) / 3600)
+            let endHour = Int(ceil(min(end, nextDayStart).timeIntervalSince(dayStart) / 3600))
+
+            keys.append(ActivityCacheRecordKey(day: day, hour: ActivityCacheRecordKey.dayHour))
+            keys.append(contentsOf: (firstHour..<endHour).map({ ActivityCacheRecordKey(day: day, hour: $0) }))
+
+            dayStart = nextDayStart
+        }
+
+        return keys
+    }
+}
+
+private func ==(lhs: ActivityCacheRecordKey, rhs: ActivityCacheRecordKey) -> Bool
+{
+    return lhs.day == rhs.day && lhs.hour == rhs.hour
+}
+
+// MARK: - Records
+
+/// A cache record with a primary key derived from an `ActivityCacheRecordKey`.
+fileprivate protocol ActivityCacheKeyedRecord
+{
+    /// The primary key of the record.
+    var key: String { get }
+
+    /// The start date of the day or hour that the record was written for.
+    var startDate: Date? { get }
+}
+
 internal final class ActivityCacheRecord: Object, StepsData
 {
+    // MARK: - Initialization
+    fileprivate convenience init(key: ActivityCacheRecordKey, startDate: Date, steps: Steps)
+    {
+        self.init()
+        self.key = key.primaryKey
+        self.day = key.day
+        self.hour = key.hour
+        self.startDate = startDate
+        self.walkingStepCount = steps.walkingStepCount
+        self.runningStepCount = steps.runningStepCount
+    }
+
+    // MARK: - Key
+    dynamic var key = ""
+
+    override static func primaryKey() -> String?
+    {
+        return "key"
+    }
+
+    override static func indexedProperties() -> [String]
+    {
+        return ["day"]
+    }
+
     // MARK: - Dates
+    dynamic var day: Int = 0
+    dynamic var hour: Int = 0
     dynamic var startDate: Date?
-    dynamic var index: Int = 0
 
     // MARK: - Step Counts
     dynamic var walkingStepCount: Int = 0
     dynamic var runningStepCount: Int = 0
 }
 
+extension ActivityCacheRecord: ActivityCacheKeyedRecord {}
+
 internal final class MindfulCacheRecord: Object, MindfulMinuteData
 {
-    // MARK: - Dates
-    dynamic var startDate: Date?
-    dynamic var index: Int = 0
-    
-    dynamic var minuteCount: Int = 0
-}
+    // MARK: - Initialization
+    fileprivate convenience init(key: ActivityCacheRecordKey, startDate: Date, minutes: MindfulMinute)
+    {
+        self.init()
+        self.key = key.primaryKey
+        self.day = key.day
+        self.hour = key.hour
+        self.startDate = startDate
+        self.minuteCount = minutes.minuteCount
+    }
 
-extension NSPredicate
-{
-    @nonobjc fileprivate convenience init(startDate: Date)
+    // MARK: - Key
+    dynamic var key = ""
+
+    override static func primaryKey() -> String?
     {
-        self.init(format: "startDate == %@", startDate as NSDate)
+        return "key"
     }
-}
 
-extension NSCompoundPredicate
-{
-    @nonobjc fileprivate convenience init(startDate: Date, index: Int)
+    override static func indexedProperties() -> [String]
     {
-        self.init(andPredicateWithSubpredicates: [
-            NSPredicate(startDate: startDate),
-            NSPredicate(format: "index == %d", index)
-        ])
+        return ["day"]
     }
+
+    // MARK: - Dates
+    dynamic var day: Int = 0
+    dynamic var hour: Int = 0
+    dynamic var startDate: Date?
+
+    dynamic var minuteCount: Int = 0
 }
+
+extension MindfulCacheRecord: ActivityCacheKeyedRecord {}
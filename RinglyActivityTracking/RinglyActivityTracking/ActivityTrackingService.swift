@@ -130,7 +130,23 @@ public final class ActivityTrackingService: NSObject
     /// The Realm service, if available.
     public var realmService: RealmService?
     {
-        return backupStepsDataSource as? RealmService // used for a developer feature
+        // used for a developer feature, mindfulness sessions, and queueing HealthKit updates
+        return (backupStepsDataSource as? RealmService) ?? (backupMindfulMinuteDataSource as? RealmService)
+    }
+
+    /// The sinks that activity updates from peripherals should be written to.
+    ///
+    /// This includes the Realm service, which queues updates for HealthKit, and the backup steps data source, if it is
+    /// a separate sink.
+    public var backupUpdatesSinks: [SourcedUpdatesSink]
+    {
+        let realmSinks = realmService.map({ [$0 as SourcedUpdatesSink] }) ?? []
+
+        guard let sink = backupStepsDataSource as? SourcedUpdatesSink, !(sink is RealmService) else {
+            return realmSinks
+        }
+
+        return realmSinks + [sink]
     }
 
     // MARK: - Backup Sources
@@ -267,6 +283,14 @@ extension ActivityTrackingService: StepsDataSource
         )
     }
 
+    public func stepsDataProducer(boundaryDates: [BoundaryDates]) -> SignalProducer<[StepsData], NSError>
+    {
+        return healthKitService.healthKitStepsIfAvailableProducer(
+            fallbackDataSource: backupStepsDataSource,
+            makeProducer: { $0.stepsDataProducer(boundaryDates: boundaryDates) }
+        )
+    }
+
     public func stepsBoundaryDateProducer(ascending: Bool) -> SignalProducer<Date?, NSError>
     {
         func unresult(_ producer: SignalProducer<Result<Date?, NSError>?, NoError>) -> SignalProducer<Date?, NSError>
@@ -90,6 +90,69 @@ extension BoundaryDates
     }
 }
 
+extension Collection where Iterator.Element == BoundaryDates, Index == Int
+{
+    // MARK: - Distributing Values
+
+    /**
+     Sums dated values into the boundary dates that contain their dates, so that the results of a single query over
+     many boundary dates can be split between them. A date is contained if it is at or after the start date, and before
+     the end date. Boundary dates may overlap, in which case a value is added to each that contains it.
+
+     - parameter values: The dated values.
+
+     - returns: The total of the values in each boundary dates element, in the same order as the receiver.
+     */
+    func totals<S: Sequence>(of values: S) -> [Double] where S.Iterator.Element == (date: Date, value: Double)
+    {
+        // sort by start date, tracking the latest end date so far, so that the search for overlapping boundary dates
+        // can stop as soon as none remain
+        let sorted = indices.sorted(by: { self[$0].start < self[$1].start })
+        var latestEnds = [Date]()
+
+        for index in sorted
+        {
+            latestEnds.append(latestEnds.last.map({ max($0, self[index].end) }) ?? self[index].end)
+        }
+
+        var totals = Array(repeating: 0.0, count: sorted.count)
+
+        for (date, value) in values
+        {
+            // find the number of boundary dates starting at or before the date
+            var lower = 0, upper = sorted.count
+
+            while lower < upper
+            {
+                let middle = lower + (upper - lower) / 2
+
+                if self[sorted[middle]].start <= date
+                {
+                    lower = middle + 1
+                }
+                else
+                {
+                    upper = middle
+                }
+            }
+
+            var position = lower - 1
+
+            while position >= 0 && latestEnds[position] > date
+            {
+                if self[sorted[position]].end > date
+                {
+                    totals[sorted[position] - startIndex] += value
+                }
+
+                position -= 1
+            }
+        }
+
+        return totals
+    }
+}
+
 extension BoundaryDates: Hashable
 {
     public var hashValue: Int
@@ -10,11 +10,18 @@ public final class BoundaryDatesDataController
     /**
      Initializes an activity tracking boundary dates data controller.
 
-     - parameter dataSource:    The data source for steps data.
-     - parameter cache:         A cache for the steps data.
-     - parameter boundaryDates: The boundary dates between which the controller will load data.
+     - parameter dataSource:               The data source for steps data.
+     - parameter cache:                    A cache for the steps data.
+     - parameter boundaryDates:            The boundary dates between which the controller will load data.
+     - parameter maximumConcurrentQueries: The maximum number of steps queries to run at once.
+     - parameter maximumDatesPerQuery:     The maximum number of consecutive boundary dates to load with a single
+                                           steps query.
      */
-    public init(dataSource: StepsDataSource, cache: ActivityCache, boundaryDates: [BoundaryDates])
+    public init(dataSource: StepsDataSource,
+                cache: ActivityCache,
+                boundaryDates: [BoundaryDates],
+                maximumConcurrentQueries: Int = 3,
+                maximumDatesPerQuery: Int = 7)
     {
         self.boundaryDates = boundaryDates
 
@@ -25,43 +32,68 @@ public final class BoundaryDatesDataController
         let cacheCompleted = MutableProperty(false)
         self.cacheCompleted = cacheCompleted
 
-        let startDate = boundaryDates.first?.start
-
-        if let start = startDate
-        {
-            disposable += cache.stepsProducer(startDate: start, count: boundaryDates.count)
-                .on(value: { cached in
-                    if cached.any({ $0 != .zero })
-                    {
-                        steps.value = cached.map({ .success($0) })
-                    }
-                })
-                .take(first: 1)
-                .startWithCompleted({ cacheCompleted.value = true })
-        }
-        else
-        {
-            cacheCompleted.value = true
-        }
-
-        // create producers between boundary dates
+        disposable += cache.stepsProducer(boundaryDates: boundaryDates)
+            .on(value: { cached in
+                if cached.any({ $0 != .zero })
+                {
+                    steps.value = cached.map({ .success($0) })
+                }
+            })
+            .take(first: 1)
+            .startWithCompleted({ cacheCompleted.value = true })
+
+        let (queryMetrics, queryMetricsObserver) = Signal<ProducerQueueMetrics, NoError>.pipe()
+        self.queryMetrics = queryMetrics
+        self.queryMetricsObserver = queryMetricsObserver
+
+        // split the boundary dates into batches of consecutive indices, each loaded with a single query
+        let batchSize = max(maximumDatesPerQuery, 1)
+        let batches = stride(from: 0, to: boundaryDates.count, by: batchSize).map({ start in
+            start..<min(start + batchSize, boundaryDates.count)
+        })
+
+        self.batches = batches
+
+        // create producers for each batch, loading the most recent dates first until prioritized by a client
         queue = ProducerQueue(
-            content: boundaryDates.enumerated().reversed(),
-            makeProducer: { item -> SignalProducer<StepsResult, NoError> in
-                // request from the data source, writing results to the cache
-                dataSource.stepsProducer(startDate: item.element.start, endDate: item.element.end)
-                    .resultify()
-                    .on(value: { result in
-                        steps.modify({ $0[item.offset] = result })
+            content: batches,
+            maximumProducersStarted: maximumConcurrentQueries,
+            makeProducer: { batch -> SignalProducer<[StepsResult], NoError> in
+                let batchBoundaryDates = Array(boundaryDates[batch])
 
-                        if let steps = result.value, let start = startDate
+                // request from the data source, writing results to the cache
+                return dataSource.stepsProducer(boundaryDates: batchBoundaryDates)
+                    .map({ batchSteps in batchSteps.map(StepsResult.success) })
+                    .flatMapError({ _ in
+                        // a batch query fails if any of its dates fails, so query the dates individually, so that
+                        // only the dates that actually fail are failed
+                        SignalProducer.combineLatest(batchBoundaryDates.map({ dates in
+                            dataSource.stepsProducer(startDate: dates.start, endDate: dates.end).resultify()
+                        }))
+                    })
+                    .on(value: { results in
+                        steps.modify({ current in
+                            for (offset, index) in batch.enumerated()
+                            {
+                                current[index] = results[offset]
+                            }
+                        })
+
+                        for (dates, result) in zip(batchBoundaryDates, results)
                         {
-                            cache.write(startDate: start, index: item.offset, steps: steps)
+                            if let datesSteps = result.value
+                            {
+                                cache.write(boundaryDates: dates, steps: datesSteps)
+                            }
                         }
                     })
             }
         )
 
+        let count = batches.count
+        queue.prioritize({ count - 1 - $0 })
+        queue.metricsObserver = { queryMetricsObserver.send(value: $0) }
+
         // enable the queue draining when requested by clients
         queriesEnabled.producer.and(cacheCompleted.producer).startWithValues({ [weak queue] in queue?.draining = $0 })
     }
@@ -70,18 +102,75 @@ public final class BoundaryDatesDataController
     deinit
     {
         disposable.dispose()
+        queryMetricsObserver.sendCompleted()
     }
 
     fileprivate let disposable = CompositeDisposable()
 
     // MARK: - Queue
 
-    /// The producer queue for loading steps data.
-    fileprivate let queue: ProducerQueue<StepsResult, NoError>
+    /// The producer queue for loading steps data. Each producer loads a batch of boundary dates.
+    fileprivate let queue: ProducerQueue<[StepsResult], NoError>
+
+    /// The indices of `boundaryDates` loaded by each producer in `queue`.
+    fileprivate let batches: [CountableRange<Int>]
 
     /// While `true`, the data controller will dequeue steps producers.
     public let queriesEnabled = MutableProperty(false)
 
+    /// Sends timing information for each steps query, after it yields its first result. The offset of each value is
+    /// the index of the query's batch of boundary dates.
+    public let queryMetrics: Signal<ProducerQueueMetrics, NoError>
+    fileprivate let queryMetricsObserver: Observer<ProducerQueueMetrics, NoError>
+
+    /**
+     Prioritizes the steps queries that have not yet started, so that queries for the visible indices start first,
+     followed by the remaining indices in order of their distance from the visible indices. Each batch of boundary
+     dates is prioritized by its index nearest to the visible indices.
+
+     - parameter visibleIndices: The indices of `boundaryDates` that are currently visible.
+     */
+    public func prioritize(visibleIndices: CountableRange<Int>)
+    {
+        let batches = self.batches
+
+        queue.prioritize({ batch in
+            let indices = batches[batch]
+
+            if indices.upperBound <= visibleIndices.lowerBound
+            {
+                return visibleIndices.lowerBound - indices.upperBound + 1
+            }
+            else if indices.lowerBound >= visibleIndices.upperBound
+            {
+                return indices.lowerBound - visibleIndices.upperBound + 1
+            }
+            else
+            {
+                return 0
+            }
+        })
+    }
+
+    /**
+     Cancels the steps queries that have not yet started for indices outside of a range - for example, when the user
+     scrolls away from them. Queries for batches including any index in the range continue. Cancelled indices retain
+     their cached values, if any.
+
+     - parameter indices: The indices of `boundaryDates` to continue loading.
+     */
+    public func cancelQueries(outside indices: CountableRange<Int>)
+    {
+        let batches = self.batches
+        queue.cancelPending(where: { !batches[$0].overlaps(indices) })
+    }
+
+    /// The number of steps queries that have not yet started.
+    var pendingQueryCount: Int
+    {
+        return queue.pendingCount
+    }
+
     /// Set to `true` once the cache query has completed.
     fileprivate let cacheCompleted: MutableProperty<Bool>
 
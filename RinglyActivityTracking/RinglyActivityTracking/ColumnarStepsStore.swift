@@ -0,0 +1,677 @@
+import Foundation
+import ReactiveSwift
+import Result
+import RinglyKit
+
+/// Provides an activity data store using columnar files, as an alternative to `RealmService` for steps data.
+///
+/// Data is partitioned by source and by day. Each partition is a file of `2 × 1440` bytes: the walking step counts for
+/// each minute of the day, followed by the running step counts. Minutes without data are zero. New days are added as
+/// new partition files, and existing partitions are updated in place, writing only the minutes that changed. The
+/// partitions that exist are indexed in memory, so queries do not need to list the store's directories.
+///
+/// Range queries memory-map the partitions that they cover and sum contiguous byte ranges, rather than filtering and
+/// sorting a record for each minute. As with `RealmService`, when multiple sources have data for the same minute, the
+/// data with the most steps is used.
+public final class ColumnarStepsStore
+{
+    // MARK: - Initialization
+
+    /**
+     Initializes a columnar steps store.
+
+     - parameter directoryURL: The directory to store partitions in. This directory is created if necessary.
+     - parameter logFunction:  A function to use for logging.
+     */
+    public init(directoryURL: URL, logFunction: ((String) -> ())?)
+    {
+        self.directoryURL = directoryURL
+        self.queue = DispatchQueue(label: "Columnar Steps \(directoryURL.path)")
+        self.logFunction = logFunction
+
+        (changes, changesObserver) = Signal.pipe()
+    }
+
+    // MARK: - Properties
+
+    /// The directory that partitions are stored in.
+    public let directoryURL: URL
+
+    /// The queue to perform file operations on.
+    fileprivate let queue: DispatchQueue
+
+    /// Sends a value after each write that changes stored data.
+    fileprivate let changes: Signal<(), NoError>
+
+    /// The observer for `changes`.
+    fileprivate let changesObserver: Observer<(), NoError>
+
+    /// The days of the partitions stored for each source, in ascending order. This is loaded from `directoryURL` when
+    /// first needed, then kept up to date as partitions are written. Only accessed on `queue`.
+    fileprivate var partitionDays: [Int64:[Int]]?
+
+    // MARK: - Logging
+    fileprivate let logFunction: ((String) -> ())?
+}
+
+extension ColumnarStepsStore
+{
+    // MARK: - Partitions
+
+    /// The number of minutes in each partition.
+    static let minutesPerPartition = 1440
+
+    /// The size of each partition file, in bytes.
+    static let partitionSize = minutesPerPartition * 2
+
+    /// The path extension of partition files.
+    fileprivate static let partitionExtension = "steps"
+
+    /**
+     The directory for a source's partitions.
+
+     - parameter macAddress: The source MAC address.
+     */
+    fileprivate func directoryURL(macAddress: Int64) -> URL
+    {
+        return directoryURL.appendingPathComponent(String(UInt64(bitPattern: macAddress), radix: 16), isDirectory: true)
+    }
+
+    /**
+     The file for a partition.
+
+     - parameter macAddress: The source MAC address.
+     - parameter day:        The day of the partition, in minutes divided by `minutesPerPartition`.
+     */
+    fileprivate func partitionURL(macAddress: Int64, day: Int) -> URL
+    {
+        return directoryURL(macAddress: macAddress)
+            .appendingPathComponent("\(day)")
+            .appendingPathExtension(ColumnarStepsStore.partitionExtension)
+    }
+
+    /// The days of the partitions stored for each source, loading them from the store's directories if necessary.
+    fileprivate func indexedPartitionDays() -> [Int64:[Int]]
+    {
+        if let partitionDays = self.partitionDays
+        {
+            return partitionDays
+        }
+
+        let fileManager = FileManager.default
+        let names = (try? fileManager.contentsOfDirectory(atPath: directoryURL.path)) ?? []
+        var partitionDays = [Int64:[Int]]()
+
+        for macAddress in names.flatMap({ name in UInt64(name, radix: 16).map({ Int64(bitPattern: $0) }) })
+        {
+            let path = directoryURL(macAddress: macAddress).path
+            let names = (try? fileManager.contentsOfDirectory(atPath: path)) ?? []
+
+            partitionDays[macAddress] = names.flatMap({ name -> Int? in
+                let nsName = name as NSString
+                guard nsName.pathExtension == ColumnarStepsStore.partitionExtension else { return nil }
+                return Int(nsName.deletingPathExtension)
+            }).sorted()
+        }
+
+        self.partitionDays = partitionDays
+        return partitionDays
+    }
+
+    /// The MAC addresses of all sources with stored data.
+    fileprivate func macAddresses() -> [Int64]
+    {
+        return Array(indexedPartitionDays().keys)
+    }
+
+    /**
+     The days of all partitions stored for a source, in ascending order.
+
+     - parameter macAddress: The source MAC address.
+     */
+    fileprivate func days(macAddress: Int64) -> [Int]
+    {
+        return indexedPartitionDays()[macAddress] ?? []
+    }
+
+    /**
+     Adds a newly written partition to the partition index.
+
+     - parameter macAddress: The source MAC address.
+     - parameter day:        The day of the partition.
+     */
+    fileprivate func indexPartition(macAddress: Int64, day: Int)
+    {
+        var days = self.days(macAddress: macAddress)
+        guard !days.contains(day) else { return }
+
+        days.insert(day, at: days.index(where: { $0 > day }) ?? days.endIndex)
+        partitionDays?[macAddress] = days
+    }
+
+    /**
+     Memory-maps a partition, if it exists.
+
+     - parameter macAddress: The source MAC address.
+     - parameter day:        The day of the partition.
+     */
+    fileprivate func partition(macAddress: Int64, day: Int) -> Data?
+    {
+        let URL = partitionURL(macAddress: macAddress, day: day)
+
+        guard let data = try? Data(contentsOf: URL, options: .alwaysMapped) else { return nil }
+
+        guard data.count == ColumnarStepsStore.partitionSize else {
+            logFunction?("Ignoring partition with invalid size \(data.count) at “\(URL.path)”")
+            return nil
+        }
+
+        return data
+    }
+}
+
+/// Identifies a partition.
+struct PartitionKey: Hashable
+{
+    /// The source MAC address.
+    let macAddress: Int64
+
+    /// The day of the partition.
+    let day: Int
+
+    var hashValue: Int
+    {
+        // mix the day into the MAC address's hash, so that swapped or nearby values do not collide
+        let hash = macAddress.hashValue
+        return hash ^ (day.hashValue &+ 0x9e3779b9 &+ (hash << 6) &+ (hash >> 2))
+    }
+}
+
+func ==(lhs: PartitionKey, rhs: PartitionKey) -> Bool
+{
+    return lhs.macAddress == rhs.macAddress && lhs.day == rhs.day
+}
+
+extension ColumnarStepsStore
+{
+    // MARK: - Writing Updates
+
+    /**
+     Writes updates to the store, keeping the update with the most steps for each minute and source. This must be
+     called on `queue`.
+
+     - parameter sourcedUpdates: The updates to write.
+
+     - returns: The number of updates written and skipped.
+     */
+    func write(_ sourcedUpdates: [SourcedUpdate]) throws -> UpdatesWriteResult
+    {
+        let minutesPerPartition = ColumnarStepsStore.minutesPerPartition
+
+        var partitionUpdates = [PartitionKey:[SourcedUpdate]]()
+
+        for sourced in sourcedUpdates
+        {
+            let key = PartitionKey(
+                macAddress: sourced.macAddress,
+                day: Int(sourced.update.date.minute) / minutesPerPartition
+            )
+
+            if partitionUpdates[key] == nil
+            {
+                partitionUpdates[key] = [sourced]
+            }
+            else
+            {
+                partitionUpdates[key]?.append(sourced)
+            }
+        }
+
+        var written = 0
+
+        for (key, updates) in partitionUpdates
+        {
+            let existing = partition(macAddress: key.macAddress, day: key.day)
+
+            // the new walking and running steps for each changed minute of the partition
+            var changes = [Int:(RLYActivityTrackingSteps, RLYActivityTrackingSteps)]()
+
+            for sourced in updates
+            {
+                let offset = Int(sourced.update.date.minute) % minutesPerPartition
+                let current = changes[offset].map({ Int($0) + Int($1) })
+                    ?? existing.map({ Int($0[offset]) + Int($0[offset + minutesPerPartition]) })
+                    ?? 0
+
+                if sourced.update.steps > current
+                {
+                    changes[offset] = (sourced.update.walkingSteps, sourced.update.runningSteps)
+                    written += 1
+                }
+            }
+
+            if !changes.isEmpty
+            {
+                try writeChanges(changes, macAddress: key.macAddress, day: key.day, createPartition: existing == nil)
+            }
+        }
+
+        if written > 0
+        {
+            changesObserver.send(value: ())
+        }
+
+        return UpdatesWriteResult(written: written, skipped: sourcedUpdates.count - written)
+    }
+
+    /**
+     Writes changed minutes to a partition, seeking to each run of consecutive minutes rather than rewriting the whole
+     partition. This must be called on `queue`.
+
+     - parameter changes:         The new walking and running steps for each changed minute, relative to the start of
+                                  the day.
+     - parameter macAddress:      The source MAC address.
+     - parameter day:             The day of the partition.
+     - parameter createPartition: If `true`, the partition is created, or replaced if it has an invalid size.
+     */
+    fileprivate func writeChanges(_ changes: [Int:(RLYActivityTrackingSteps, RLYActivityTrackingSteps)],
+                                  macAddress: Int64,
+                                  day: Int,
+                                  createPartition: Bool) throws
+    {
+        let URL = partitionURL(macAddress: macAddress, day: day)
+        let fileManager = FileManager.default
+
+        if createPartition
+        {
+            try fileManager.createDirectory(
+                at: URL.deletingLastPathComponent(),
+                withIntermediateDirectories: true,
+                attributes: nil
+            )
+
+            guard fileManager.createFile(atPath: URL.path, contents: nil, attributes: nil) else {
+                throw NSError(domain: NSCocoaErrorDomain, code: NSFileWriteUnknownError, userInfo: [
+                    NSFilePathErrorKey: URL.path
+                ])
+            }
+        }
+
+        guard let handle = FileHandle(forWritingAtPath: URL.path) else {
+            throw NSError(domain: NSCocoaErrorDomain, code: NSFileWriteUnknownError, userInfo: [
+                NSFilePathErrorKey: URL.path
+            ])
+        }
+
+        defer { handle.closeFile() }
+
+        if createPartition
+        {
+            // a new partition is zero-filled, so only the changed minutes need to be written
+            handle.truncateFile(atOffset: UInt64(ColumnarStepsStore.partitionSize))
+        }
+
+        let minutesPerPartition = ColumnarStepsStore.minutesPerPartition
+        var offsets = ArraySlice(changes.keys.sorted())
+
+        while let first = offsets.first
+        {
+            // find the run of consecutive changed minutes starting at `first`
+            var count = 1
+
+            while offsets.count > count && offsets[offsets.startIndex + count] == first + count
+            {
+                count += 1
+            }
+
+            let run = offsets.prefix(count).map({ changes[$0]! })
+            offsets = offsets.dropFirst(count)
+
+            handle.seek(toFileOffset: UInt64(first))
+            handle.write(Data(bytes: run.map({ walking, _ in walking })))
+
+            handle.seek(toFileOffset: UInt64(minutesPerPartition + first))
+            handle.write(Data(bytes: run.map({ _, running in running })))
+        }
+
+        if createPartition
+        {
+            indexPartition(macAddress: macAddress, day: day)
+        }
+    }
+
+    /**
+     A producer that writes updates to the store.
+
+     - parameter sourcedUpdates: The updates to write.
+     */
+    func writeSourcedUpdates(_ sourcedUpdates: [SourcedUpdate]) -> SignalProducer<UpdatesWriteResult, NSError>
+    {
+        return queue.producer { [weak self] observer, _ in
+            guard let strong = self else { observer.sendInterrupted(); return }
+
+            do
+            {
+                observer.send(value: try strong.write(sourcedUpdates))
+                observer.sendCompleted()
+            }
+            catch let error as NSError
+            {
+                observer.send(error: error)
+            }
+        }
+    }
+
+    /// Deletes all data stored in the columnar store.
+    public func deleteAllData() -> SignalProducer<(), NSError>
+    {
+        return queue.producer { [weak self] observer, _ in
+            guard let strong = self else { observer.sendInterrupted(); return }
+
+            do
+            {
+                if FileManager.default.fileExists(atPath: strong.directoryURL.path)
+                {
+                    try FileManager.default.removeItem(at: strong.directoryURL)
+                }
+
+                strong.partitionDays = [:]
+
+                strong.changesObserver.send(value: ())
+                observer.sendCompleted()
+            }
+            catch let error as NSError
+            {
+                observer.send(error: error)
+            }
+        }
+    }
+}
+
+extension ColumnarStepsStore: SourcedUpdatesSink
+{
+    public func writeSourcedUpdatesProducer(_ updatesProducer: SignalProducer<SourcedUpdate, NoError>)
+        -> SignalProducer<(), NoError>
+    {
+        let logFunction = self.logFunction
+
+        return updatesProducer.bufferedForWriting()
+            .flatMap(.latest, transform: { [weak self] sourcedUpdates -> SignalProducer<(), NoError> in
+                guard let strong = self else { return SignalProducer.empty }
+
+                let count = sourcedUpdates.count
+
+                return strong.writeSourcedUpdates(sourcedUpdates)
+                    .on(failed: { error in
+                        logFunction?("Error writing \(count) updates to columnar store: \(error)")
+                    }, value: { result in
+                        logFunction?(
+                            "Wrote \(result.written) of \(count) updates to columnar store, skipped \(result.skipped)"
+                        )
+                    })
+                    .resultify()
+                    .ignoreValues()
+            })
+    }
+}
+
+extension ColumnarStepsStore
+{
+    // MARK: - Reading Steps
+
+    /**
+     Sums the steps in a range of minutes. This must be called on `queue`.
+
+     - parameter startMinute: The first minute to include.
+     - parameter endMinute:   The minute after the last minute to include.
+     - parameter macAddress:  The source to include. If `nil`, all sources are included.
+     */
+    func steps(startMinute: RLYActivityTrackingMinute, endMinute: RLYActivityTrackingMinute, macAddress: Int64?)
+        -> Steps
+    {
+        guard startMinute < endMinute else { return .zero }
+
+        let minutesPerPartition = ColumnarStepsStore.minutesPerPartition
+        let start = Int(startMinute), end = Int(endMinute)
+        let days = (start / minutesPerPartition)...((end - 1) / minutesPerPartition)
+
+        // find the sources with a partition for each day in the range
+        var dayMACAddresses = [Int:[Int64]]()
+
+        for macAddress in macAddress.map({ [$0] }) ?? macAddresses()
+        {
+            for day in self.days(macAddress: macAddress) where days.contains(day)
+            {
+                dayMACAddresses[day] = (dayMACAddresses[day] ?? []) + [macAddress]
+            }
+        }
+
+        return dayMACAddresses.reduce(Steps.zero, { steps, element in
+            let (day, macAddresses) = element
+            let dayStart = day * minutesPerPartition
+            let minutes = max(start - dayStart, 0)..<min(end - dayStart, minutesPerPartition)
+            let partitions = macAddresses.flatMap({ partition(macAddress: $0, day: day) })
+
+            return steps + ColumnarStepsStore.steps(in: partitions, minutes: minutes)
+        })
+    }
+
+    /**
+     Sums the steps in a range of minutes in a set of partitions for the same day. When multiple partitions have data
+     for the same minute, the data with the most steps is used.
+
+     - parameter partitions: The partitions.
+     - parameter minutes:    The range of minutes, relative to the start of the day.
+     */
+    static func steps(in partitions: [Data], minutes: Range<Int>) -> Steps
+    {
+        if partitions.count == 1
+        {
+            // with a single source, each column can be summed directly
+            return partitions[0].withUnsafeBytes({ (bytes: UnsafePointer<UInt8>) -> Steps in
+                var walkingStepCount = 0, runningStepCount = 0
+
+                for minute in minutes
+                {
+                    walkingStepCount += Int(bytes[minute])
+                    runningStepCount += Int(bytes[minutesPerPartition + minute])
+                }
+
+                return Steps(walkingStepCount: walkingStepCount, runningStepCount: runningStepCount)
+            })
+        }
+
+        var walkingStepCount = 0, runningStepCount = 0
+
+        for minute in minutes
+        {
+            var walking = 0, running = 0
+
+            for partition in partitions
+            {
+                let partitionWalking = Int(partition[minute])
+                let partitionRunning = Int(partition[minutesPerPartition + minute])
+
+                if partitionWalking + partitionRunning > walking + running
+                {
+                    walking = partitionWalking
+                    running = partitionRunning
+                }
+            }
+
+            walkingStepCount += walking
+            runningStepCount += running
+        }
+
+        return Steps(walkingStepCount: walkingStepCount, runningStepCount: runningStepCount)
+    }
+
+    /**
+     Finds the earliest or latest minute with steps. This must be called on `queue`.
+
+     - parameter ascending:  If `true`, finds the earliest minute. Otherwise, finds the latest minute.
+     - parameter minutes:    The range of minutes to search, inclusive. If `nil`, all minutes are searched.
+     - parameter macAddress: The source to include. If `nil`, all sources are included.
+     */
+    func boundaryMinute(ascending: Bool,
+                        minutes: ClosedRange<RLYActivityTrackingMinute>?,
+                        macAddress: Int64?)
+        -> RLYActivityTrackingMinute?
+    {
+        let minutesPerPartition = ColumnarStepsStore.minutesPerPartition
+        let lower = minutes.map({ Int($0.lowerBound) }) ?? 0
+        let upper = minutes.map({ Int($0.upperBound) }) ?? Int.max
+
+        let boundaries = (macAddress.map({ [$0] }) ?? macAddresses()).flatMap({ macAddress -> Int? in
+            let days = self.days(macAddress: macAddress).filter({ day in
+                (day + 1) * minutesPerPartition > lower && day * minutesPerPartition <= upper
+            })
+
+            // partitions are only written with steps, so the first partition with steps in range is the boundary
+            for day in ascending ? days : Array(days.reversed())
+            {
+                guard let partition = self.partition(macAddress: macAddress, day: day) else { continue }
+
+                let dayStart = day * minutesPerPartition
+                let offsets = max(lower - dayStart, 0)...min(upper - dayStart, minutesPerPartition - 1)
+
+                let offset = (ascending ? Array(offsets) : Array(offsets.reversed())).first(where: { offset in
+                    partition[offset] != 0 || partition[minutesPerPartition + offset] != 0
+                })
+
+                if let offset = offset
+                {
+                    return dayStart + offset
+                }
+            }
+
+            return nil
+        })
+
+        return (ascending ? boundaries.min() : boundaries.max()).map({ RLYActivityTrackingMinute($0) })
+    }
+
+    // MARK: - Producers
+
+    /**
+     A producer that reads a value from the store on `queue`, then reads it again after each write. Values are
+     delivered on the main queue, as with `RealmService`.
+
+     - parameter read: A function to read the value.
+     */
+    fileprivate func autoUpdatingProducer<Value>(_ read: @escaping (ColumnarStepsStore) -> Value)
+        -> SignalProducer<Value, NSError>
+    {
+        let reads = SignalProducer<(), NoError>(value: ()).concat(SignalProducer(changes))
+
+        return reads
+            .flatMap(.latest, transform: { [weak self] _ -> SignalProducer<Value, NoError> in
+                guard let strong = self else { return SignalProducer.empty }
+
+                return strong.queue.producer { observer, _ in
+                    observer.send(value: read(strong))
+                    observer.sendCompleted()
+                }
+            })
+            .observe(on: QueueScheduler.main)
+            .promoteErrors(NSError.self)
+    }
+
+    fileprivate func stepsDataProducer(startDate: Date, endDate: Date, macAddress: Int64?)
+        -> SignalProducer<StepsData, NSError>
+    {
+        do
+        {
+            let startMinute = try RLYActivityTrackingDate(date: startDate).minute
+            let endMinute = try RLYActivityTrackingDate(date: endDate).minute
+
+            return autoUpdatingProducer({ store -> StepsData in
+                store.steps(startMinute: startMinute, endMinute: endMinute, macAddress: macAddress)
+            })
+        }
+        catch let error as NSError
+        {
+            return SignalProducer(error: error)
+        }
+    }
+
+    fileprivate func stepsDataProducer(boundaryDates: [BoundaryDates], macAddress: Int64?)
+        -> SignalProducer<[StepsData], NSError>
+    {
+        do
+        {
+            let minutes = try boundaryDates.map({ dates -> (RLYActivityTrackingMinute, RLYActivityTrackingMinute) in
+                let startMinute = try RLYActivityTrackingDate(date: dates.start).minute
+                let endMinute = try RLYActivityTrackingDate(date: dates.end).minute
+                return (startMinute, endMinute)
+            })
+
+            // read every range in a single pass on the store's queue
+            return autoUpdatingProducer({ store -> [StepsData] in
+                minutes.map({ startMinute, endMinute in
+                    store.steps(startMinute: startMinute, endMinute: endMinute, macAddress: macAddress)
+                })
+            })
+        }
+        catch let error as NSError
+        {
+            return SignalProducer(error: error)
+        }
+    }
+
+    fileprivate func stepsBoundaryDateProducer(ascending: Bool,
+                                               minutes: ClosedRange<RLYActivityTrackingMinute>?,
+                                               macAddress: Int64?)
+        -> SignalProducer<Date?, NSError>
+    {
+        return autoUpdatingProducer({ store in
+            store.boundaryMinute(ascending: ascending, minutes: minutes, macAddress: macAddress)
+                .map(RLYActivityTrackingMinuteToNSDate)
+        })
+    }
+}
+
+extension ColumnarStepsStore: StepsDataSource
+{
+    // MARK: - Steps Data Source
+    public func stepsDataProducer(startDate: Date, endDate: Date) -> SignalProducer<StepsData, NSError>
+    {
+        return stepsDataProducer(startDate: startDate, endDate: endDate, macAddress: nil)
+    }
+
+    public func stepsDataProducer(boundaryDates: [BoundaryDates]) -> SignalProducer<[StepsData], NSError>
+    {
+        return stepsDataProducer(boundaryDates: boundaryDates, macAddress: nil)
+    }
+
+    public func stepsBoundaryDateProducer(ascending: Bool) -> SignalProducer<Date?, NSError>
+    {
+        return stepsBoundaryDateProducer(ascending: ascending, minutes: nil, macAddress: nil)
+    }
+
+    public func stepsBoundaryDateProducer(ascending: Bool, startDate: Date, endDate: Date)
+        -> SignalProducer<Date?, NSError>
+    {
+        guard let startMinute = try? RLYActivityTrackingDate(date: startDate).minute,
+              let endMinute = try? RLYActivityTrackingDate(date: endDate).minute,
+              startMinute <= endMinute
+        else { return SignalProducer(value: nil) }
+
+        return stepsBoundaryDateProducer(ascending: ascending, minutes: startMinute...endMinute, macAddress: nil)
+    }
+}
+
+extension ColumnarStepsStore: SourcedStepsDataSource
+{
+    // MARK: - Sourced Steps Data Source
+    public func stepsDataProducer(startDate: Date, endDate: Date, sourceMACAddress: Int64)
+        -> SignalProducer<StepsData, NSError>
+    {
+        return stepsDataProducer(startDate: startDate, endDate: endDate, macAddress: sourceMACAddress)
+    }
+
+    public func stepsBoundaryDateProducer(ascending: Bool, sourceMACAddress: Int64) -> SignalProducer<Date?, NSError>
+    {
+        return stepsBoundaryDateProducer(ascending: ascending, minutes: nil, macAddress: sourceMACAddress)
+    }
+}
@@ -128,6 +128,53 @@ extension HKHealthStore: HealthKitQuerySource
         }.deferUntilProtectedDataIsAvailable()
     }
 
+    /// A signal producer for a HealthKit statistics collection query. See Apple's documentation for
+    /// `HKStatisticsCollectionQuery` for argument information.
+    
+    public func statisticsCollectionQueryProducer(quantityType: HKQuantityType,
+                                                  predicate: NSPredicate,
+                                                  options: HKStatisticsOptions,
+                                                  anchorDate: Date,
+                                                  intervalComponents: DateComponents)
+                                                  -> SignalProducer<HKStatisticsCollection, NSError>
+    {
+        return SignalProducer { observer, disposable in
+            if !UIApplication.shared.isProtectedDataAvailable
+            {
+                HKHealthStoreDebugLogFunction?("Starting statistics collection query, predicate “\(predicate)”, protected data unavailable!")
+            }
+
+            let query = HKStatisticsCollectionQuery(
+                quantityType: quantityType,
+                quantitySamplePredicate: predicate,
+                options: options,
+                anchorDate: anchorDate,
+                intervalComponents: intervalComponents
+            )
+
+            query.initialResultsHandler = { _, maybeCollection, maybeError in
+                if let error = maybeError
+                {
+                    HKHealthStoreDebugLogFunction?("Statistics collection query failed, predicate “\(predicate)”, protected data \(UIApplication.shared.isProtectedDataAvailable), error “\(error)”")
+                    observer.send(error: HealthKitQueryError(underlyingHealthKitError: error as NSError) as NSError)
+                }
+                else
+                {
+                    if let collection = maybeCollection
+                    {
+                        observer.send(value: collection)
+                    }
+
+                    observer.sendCompleted()
+                }
+            }
+
+            disposable += ActionDisposable { self.stop(query) }
+
+            self.execute(query)
+        }.deferUntilProtectedDataIsAvailable()
+    }
+
     /// A signal producer for a HealthKit observer query. See Apple's documentation for `HKSampleQuery` for argument
     /// information.
     
@@ -183,11 +230,12 @@ extension HKHealthStore: HealthKitSaveSink
         }
     }
 
-    fileprivate func deleteObjectProducer(UUIDString: String, type: HKObjectType) -> SignalProducer<(), NSError>
+    public func deleteObjectsProducer(UUIDStrings: [String], type: HKObjectType) -> SignalProducer<(), NSError>
     {
         return SignalProducer { observer, _ in
-            let predicate = NSPredicate(
-                format: "%K.%K == %@", HKPredicateKeyPathMetadata, HKMetadataKeyExternalUUID, UUIDString
+            let predicate = HKQuery.predicateForObjects(
+                withMetadataKey: HKMetadataKeyExternalUUID,
+                allowedValues: UUIDStrings
             )
 
             self.deleteObjects(of: type, predicate: predicate, withCompletion: { success, count, error in
@@ -196,11 +244,6 @@ extension HKHealthStore: HealthKitSaveSink
         }
     }
 
-    public func deleteObjectsProducer(UUIDStrings: [String], type: HKObjectType) -> SignalProducer<(), NSError>
-    {
-        return SignalProducer.concat(UUIDStrings.map({ deleteObjectProducer(UUIDString: $0, type: type) }))
-    }
-
     public var stepsAuthorizationStatusProducer: SignalProducer<HKAuthorizationStatus, NoError>
     {
         let notifications = NotificationCenter.default.reactive
@@ -43,6 +43,24 @@ public protocol HealthKitQuerySource
                                  options: HKStatisticsOptions)
                                  -> SignalProducer<HKStatistics, NSError>
 
+    /**
+     A signal producer for a HealthKit statistics collection query, which calculates statistics for a series of
+     consecutive intervals with a single query.
+
+     - parameter quantityType:       The quantity type to query statistics for.
+     - parameter predicate:          The predicate for querying statistics.
+     - parameter options:            The statistics options to use for the query.
+     - parameter anchorDate:         The date that the intervals are aligned to.
+     - parameter intervalComponents: The length of each interval.
+     */
+    
+    func statisticsCollectionQueryProducer(quantityType: HKQuantityType,
+                                           predicate: NSPredicate,
+                                           options: HKStatisticsOptions,
+                                           anchorDate: Date,
+                                           intervalComponents: DateComponents)
+                                           -> SignalProducer<HKStatisticsCollection, NSError>
+
     /**
      A signal producer for a HealthKit observer query.
 
@@ -98,6 +116,37 @@ extension HealthKitQuerySource
         }
     }
 
+    /**
+     A signal producer for a statistics collection query that automatically updates when new data becomes available.
+
+     This will create an observer query, and execute a query every time new data becomes available. Additionally, it
+     will perform an initial query.
+
+     - parameter quantityType:       The quantity type to query statistics for.
+     - parameter predicate:          The predicate for querying statistics.
+     - parameter options:            The statistics options to use for the query.
+     - parameter anchorDate:         The date that the intervals are aligned to.
+     - parameter intervalComponents: The length of each interval.
+     */
+    
+    public func updatingStatisticsCollectionQueryProducer(quantityType: HKQuantityType,
+                                                          predicate: NSPredicate,
+                                                          options: HKStatisticsOptions,
+                                                          anchorDate: Date,
+                                                          intervalComponents: DateComponents)
+        -> SignalProducer<HKStatisticsCollection, NSError>
+    {
+        return updatingObserverQueryProducer(sampleType: quantityType, predicate: predicate) { completion in
+            self.statisticsCollectionQueryProducer(
+                quantityType: quantityType,
+                predicate: predicate,
+                options: options,
+                anchorDate: anchorDate,
+                intervalComponents: intervalComponents
+            ).on(terminated: completion)
+        }
+    }
+
     /**
      A signal producer for a query that automatically updates when new data becomes available.
      
@@ -71,10 +71,18 @@ extension HealthKitQueuedUpdatesDataSource where Self: StepsDataSource
      If this producer sends an error event, that indicates a failure of the underlying subscription to to queued updates
      data source, and the producer will terminate.
 
-     - parameter sink:        The write sink.
-     - parameter logFunction: A function to provide logging support.
+     Queued updates are debounced, so that a sync writing many updates in quick succession is exported once, after
+     it has finished.
+
+     - parameter sink:             The write sink.
+     - parameter debounceInterval: The time to wait after updates are queued before exporting them.
+     - parameter scheduler:        The scheduler to debounce on.
+     - parameter logFunction:      A function to provide logging support.
      */
-    public func writeProducer(to sink: HealthKitSaveSink, logFunction: @escaping (String) -> ())
+    public func writeProducer(to sink: HealthKitSaveSink,
+                              debounceInterval: TimeInterval = 5,
+                              on scheduler: DateSchedulerProtocol = QueueScheduler.main,
+                              logFunction: @escaping (String) -> ())
         -> SignalProducer<NSError, NSError>
     {
         // requirements for creating samples
@@ -89,7 +97,9 @@ extension HealthKitQueuedUpdatesDataSource where Self: StepsDataSource
                     type: type,
                     unit: unit,
                     sink: sink,
-                    queuedUpdatesProducer: strong.autoUpdatingQueuedUpdatesTimeValuesProducer(),
+                    queuedUpdatesProducer: strong.autoUpdatingQueuedUpdatesTimeValuesProducer()
+                        .filter({ $0.count > 0 })
+                        .debounce(debounceInterval, on: scheduler),
                     logFunction: logFunction
                 )
             })
@@ -99,9 +109,15 @@ extension HealthKitQueuedUpdatesDataSource where Self: StepsDataSource
     /**
      An implementation detail of `writeProducer(to:)`.
 
-     - parameter type:        The quantity type to use when writing.
-     - parameter unit:        The unit to use when writing.
-     - parameter logFunction: A function to provide logging support.
+     Each value of `queuedUpdatesProducer` starts an export, after any previous export has completed. Each export reads
+     the time values that are queued when it starts, so that time values fulfilled by a previous export are not
+     exported again.
+
+     - parameter type:                  The quantity type to use when writing.
+     - parameter unit:                  The unit to use when writing.
+     - parameter sink:                  The sink to write to.
+     - parameter queuedUpdatesProducer: A producer of queued time values, triggering exports.
+     - parameter logFunction:           A function to provide logging support.
      */
     fileprivate func innerWriteProducer(type: HKQuantityType,
                                     unit: HKUnit,
@@ -112,14 +128,21 @@ extension HealthKitQueuedUpdatesDataSource where Self: StepsDataSource
     {
         return queuedUpdatesProducer
             .filter({ $0.count > 0 })
-            .flatMap(.concat, transform: { [weak self] timeValues -> SignalProducer<NSError, NoError> in
+            .flatMap(.concat, transform: { [weak self] _ -> SignalProducer<NSError, NoError> in
                 guard let strong = self else { return SignalProducer.empty }
 
-                return strong.writeTimeValuesProducer(type: type,
-                                                      unit: unit,
-                                                      sink: sink,
-                                                      timeValues: timeValues,
-                                                      logFunction: logFunction)
+                return strong.queuedUpdatesTimeValuesProducer()
+                    .take(first: 1)
+                    .filter({ $0.count > 0 })
+                    .flatMap(.concat, transform: { timeValues in
+                        strong.writeTimeValuesProducer(
+                            type: type,
+                            unit: unit,
+                            sink: sink,
+                            timeValues: timeValues,
+                            logFunction: logFunction
+                        )
+                    })
                     // the producer yields `()`, so this is primarily for type conversion
                     .map({ _ in UnknownError() as NSError })
 
@@ -131,7 +154,11 @@ extension HealthKitQueuedUpdatesDataSource where Self: StepsDataSource
     
 
     /**
-     A producer that will write the time values to the sink and fulfill them in
+     A producer that will write the time values to the sink, then fulfill them in the data source.
+
+     The time values are grouped into `HealthKitExportBlock` values, and the steps for every time value in every block
+     are read with a single query. The samples replacing all of the blocks are then written with one delete request
+     and one save request.
 
      - parameter type:        The quantity type to use when writing.
      - parameter unit:        The unit to use when writing.
@@ -146,18 +173,31 @@ extension HealthKitQueuedUpdatesDataSource where Self: StepsDataSource
                                          logFunction: @escaping (String) -> ())
                                          -> SignalProducer<(), NSError>
     {
-        // create an array of sample producers, one for each time value
-        let sampleProducers = timeValues.map({ timeValue -> SignalProducer<HKQuantitySample, NSError> in
-            self.quantitySampleProducer(type: type, unit: unit, timeValue: timeValue)
-        })
+        let blocks = HealthKitExportBlock.blocks(containing: timeValues)
+        let boundaryDates = blocks.flatMap({ block in block.timeValues.map(Self.boundaryDatesForTimeValue) })
+
+        let save = stepsProducer(boundaryDates: boundaryDates)
+            .take(first: 1)
+            .flatMap(.concat, transform: { steps -> SignalProducer<(), NSError> in
+                let blockSteps = blocks.enumerated().map({ offset, block in
+                    Array(steps[(offset * block.timeValues.count)..<((offset + 1) * block.timeValues.count)])
+                })
+
+                let samples = zip(blocks, blockSteps).flatMap({ block, steps in
+                    Self.quantitySamples(type: type, unit: unit, block: block, steps: steps)
+                })
 
-        // combine the results of all samples, then save to the HealthKit sink
-        // it is not necessary to .take(first: 1) here, as that is already done in all individual producers
-        // we need to use flatten/collect here, because combineLatest and zip cause stack overflows
-        let save = SignalProducer.concat(sampleProducers)
-            .collect()
-            .flatMap(.concat, transform: { samples -> SignalProducer<(), NSError> in
-                sink.updateObjectsProducer(samples, type: type)
+                // replace the samples that could start at each time value of each block, and any samples written for
+                // its time values individually
+                let replacing = blocks.flatMap({ block in
+                    block.timeValues.flatMap({ [Self.UUIDForExportSample(startingAt: $0), Self.UUIDForTimeValue($0)] })
+                })
+
+                return sink.updateObjectsProducer(
+                    samples,
+                    replacingUUIDStrings: replacing.map({ $0.uuidString }),
+                    type: type
+                )
             })
             .on(completed: {
                 logFunction("Successfully wrote time values \(timeValues) to HealthKit")
@@ -168,33 +208,106 @@ extension HealthKitQueuedUpdatesDataSource where Self: StepsDataSource
     }
 
     /**
-     A producer that yields a quantity sample for the specified time value.
+     Returns quantity samples for an export block, one for each run of consecutive time values with steps. Time values
+     without steps are not covered by any sample, so that idle gaps do not appear as activity.
 
-     - parameter type:      The quantity type to use for the sample.
-     - parameter unit:      The unit to use for the sample.
-     - parameter timeValue: The time value.
+     - parameter type:  The quantity type to use for the samples.
+     - parameter unit:  The unit to use for the samples.
+     - parameter block: The export block.
+     - parameter steps: The steps for each of the block's time values.
+
+     - returns: The samples, which are empty if the block has no steps.
      */
-    fileprivate func quantitySampleProducer(type: HKQuantityType, unit: HKUnit, timeValue: Int32)
-        -> SignalProducer<HKQuantitySample, NSError>
+    fileprivate static func quantitySamples(type: HKQuantityType,
+                                            unit: HKUnit,
+                                            block: HealthKitExportBlock,
+                                            steps: [Steps])
+        -> [HKQuantitySample]
     {
-        // request the steps
-        let boundaryDates = Self.boundaryDatesForTimeValue(timeValue)
+        let timeValues = Array(block.timeValues)
 
-        return self.stepsProducer(startDate: boundaryDates.start, endDate: boundaryDates.end)
-            .take(first: 1)
-            .map({ steps in
-                HKQuantitySample(
-                    type: type,
-                    quantity: HKQuantity(unit: unit, doubleValue: Double(steps.stepCount)),
-                    start: boundaryDates.start,
-                    end: boundaryDates.end,
-                    device: nil,
-                    metadata: [
-                        HKMetadataKeyExternalUUID: Self.UUIDForTimeValue(timeValue).uuidString,
-                        HKQuantitySample.ringlyWalkingStepsUserInfoKey: steps.walkingStepCount,
-                        HKQuantitySample.ringlyRunningStepsUserInfoKey: steps.runningStepCount
-                    ]
-                )
-            })
+        // split the active time values into runs of consecutive indices
+        var runs = [CountableRange<Int>]()
+
+        for index in steps.indices where steps[index].stepCount > 0
+        {
+            if let last = runs.last, last.upperBound == index
+            {
+                runs[runs.count - 1] = last.lowerBound..<(index + 1)
+            }
+            else
+            {
+                runs.append(index..<(index + 1))
+            }
+        }
+
+        return runs.map({ run in
+            let total = steps[run].reduce(Steps.zero, +)
+
+            return HKQuantitySample(
+                type: type,
+                quantity: HKQuantity(unit: unit, doubleValue: Double(total.stepCount)),
+                start: boundaryDatesForTimeValue(timeValues[run.lowerBound]).start,
+                end: boundaryDatesForTimeValue(timeValues[run.upperBound - 1]).end,
+                device: nil,
+                metadata: [
+                    HKMetadataKeyExternalUUID: UUIDForExportSample(startingAt: timeValues[run.lowerBound]).uuidString,
+                    HKQuantitySample.ringlyWalkingStepsUserInfoKey: total.walkingStepCount,
+                    HKQuantitySample.ringlyRunningStepsUserInfoKey: total.runningStepCount
+                ]
+            )
+        })
+    }
+
+    /**
+     Yields a UUID for an exported sample, which is distinct from the UUID of the time value it starts at. Samples in an
+     export block never start at the same time value, so each sample's UUID is unique.
+
+     - parameter timeValue: The first time value of the sample.
+     */
+    fileprivate static func UUIDForExportSample(startingAt timeValue: Int32) -> UUID
+    {
+        var uuid = UUIDForTimeValue(timeValue).uuid
+        uuid.15 = uuid.15 ^ 0xff
+        return UUID(uuid: uuid)
+    }
+}
+
+// MARK: - Export Blocks
+
+/// An aligned range of HealthKit time values, which are exported together, as one sample for each run of consecutive
+/// time values with steps.
+///
+/// Because blocks are aligned, the samples that may contain any time value are always known, and can be replaced by
+/// their external UUIDs without querying HealthKit. Merging time values into fewer, larger samples reduces the number
+/// of objects that HealthKit must store and delete.
+struct HealthKitExportBlock
+{
+    /// The number of time values in each block - one hour, with the default ten minute time values.
+    static let timeValueCount: Int32 = 6
+
+    /// The block containing a time value.
+    ///
+    /// - parameter timeValue: The time value.
+    init(containing timeValue: Int32)
+    {
+        let count = HealthKitExportBlock.timeValueCount
+        let start = timeValue - ((timeValue % count) + count) % count
+
+        timeValues = start..<(start + count)
+    }
+
+    /// The time values in the block.
+    let timeValues: CountableRange<Int32>
+
+    /**
+     Returns the blocks containing any of a set of time values, sorted and without duplicates.
+
+     - parameter timeValues: The time values.
+     */
+    static func blocks(containing timeValues: [Int32]) -> [HealthKitExportBlock]
+    {
+        let starts = Set(timeValues.map({ HealthKitExportBlock(containing: $0).timeValues.lowerBound }))
+        return starts.sorted().map({ HealthKitExportBlock(containing: $0) })
     }
 }
@@ -24,7 +24,8 @@ public protocol HealthKitSaveSink
     func saveObjectsProducer(_ objects: [HKObject]) -> SignalProducer<(), NSError>
 
     /**
-     A producer that deletes objects with the specified UUIDs.
+     A producer that deletes objects with the specified UUIDs. Implementations should delete all of the objects with a
+     single request.
 
      - parameter UUIDStrings: The external UUID strings to delete.
      - parameter type:        The type of the objects to delete.
@@ -48,14 +49,41 @@ extension HealthKitSaveSink
                           operation.
      */
     func updateObjectsProducer(_ objects: [HKObject], type: HKObjectType) -> SignalProducer<(), NSError>
+    {
+        return updateObjectsProducer(objects, replacingUUIDStrings: [], type: type)
+    }
+
+    /**
+     Deletes any objects matching external UUIDs in `objects` or `replacingUUIDStrings`, then saves `objects`. This
+     allows objects to replace existing objects with different external UUIDs.
+
+     The deletion is performed with a single request, and the objects are saved with a single request. Empty requests
+     are skipped.
+
+     - parameter objects:              The objects to update.
+     - parameter replacingUUIDStrings: Additional external UUIDs to delete.
+     - parameter type:                 The type of objects to update.
+     */
+    func updateObjectsProducer(_ objects: [HKObject], replacingUUIDStrings: [String], type: HKObjectType)
+        -> SignalProducer<(), NSError>
     {
         let UUIDStrings = objects.flatMap({ object in
             object.metadata?[HKMetadataKeyExternalUUID] as? String
         })
 
-        return deleteObjectsProducer(UUIDStrings: UUIDStrings, type: type)
+        let allUUIDStrings = Array(Set(UUIDStrings + replacingUUIDStrings))
+
+        let delete = allUUIDStrings.isEmpty
+            ? SignalProducer<(), NSError>.empty
+            : deleteObjectsProducer(UUIDStrings: allUUIDStrings, type: type)
+
+        let save = objects.isEmpty
+            ? SignalProducer<(), NSError>.empty
+            : saveObjectsProducer(objects)
+
+        return delete
             .mapError(HealthKitExtraErrorContext.deletingObject.add)
-            .then(saveObjectsProducer(objects).mapError(HealthKitExtraErrorContext.savingObject.add))
+            .then(save.mapError(HealthKitExtraErrorContext.savingObject.add))
     }
 }
 
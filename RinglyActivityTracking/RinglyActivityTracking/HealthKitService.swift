@@ -215,6 +215,62 @@ extension HealthKitService
     }
 }
 
+extension HealthKitService
+{
+    // MARK: - Steps Queries
+
+    /**
+     Returns a predicate for the samples within another predicate that originate from the Ringly app and contain a
+     non-zero number of running steps.
+
+     - parameter predicate: The predicate to restrict.
+     */
+    fileprivate static func runningStepsPredicate(within predicate: NSPredicate) -> NSPredicate
+    {
+        return NSCompoundPredicate(andPredicateWithSubpredicates: [
+            predicate,
+            HKQuery.predicateForObjects(from: HKSource.default()),
+            HKQuery.predicateForObjects(
+                withMetadataKey: HKQuantitySample.ringlyRunningStepsUserInfoKey,
+                operatorType: .greaterThan,
+                value: 0
+            )
+        ])
+    }
+
+    /**
+     Returns the interval for a statistics collection query, such that each of a set of boundary dates is made up of
+     whole intervals: days, if every boundary date is a midnight, or hours, if every boundary date is a whole number of
+     hours from the anchor date.
+
+     - parameter boundaryDates: The boundary dates.
+     - parameter anchorDate:    The anchor date of the query.
+     - parameter calendar:      The calendar to use.
+
+     - returns: The interval, or `nil` if the boundary dates are not made up of whole days or hours.
+     */
+    fileprivate static func intervalComponents(dividing boundaryDates: [BoundaryDates],
+                                               anchorDate: Date,
+                                               calendar: Calendar)
+        -> DateComponents?
+    {
+        let dates = boundaryDates.flatMap({ [$0.start, $0.end] })
+
+        if dates.all({ calendar.startOfDay(for: $0) == $0 })
+        {
+            return DateComponents(day: 1)
+        }
+        else if dates.all({ $0.timeIntervalSince(anchorDate).truncatingRemainder(dividingBy: 3600) == 0 })
+        {
+            return DateComponents(hour: 1)
+        }
+        else
+        {
+            return nil
+        }
+    }
+}
+
 extension HealthKitService: MindfulMinuteDataSource
 {
     public func mindfulMinutesDataProducer(startDate: Date, endDate: Date) -> SignalProducer<MindfulMinuteData, NSError> {
@@ -285,21 +341,9 @@ extension HealthKitService: StepsDataSource
             .cumulativeSum
         )
 
-        // a predicate for the samples within the original predicate that originate from the Ringly app and contain
-        // a non-zero number of running steps.
-        let runningPredicate = NSCompoundPredicate(andPredicateWithSubpredicates: [
-            predicate,
-            HKQuery.predicateForObjects(from: HKSource.default()),
-            HKQuery.predicateForObjects(
-                withMetadataKey: HKQuantitySample.ringlyRunningStepsUserInfoKey,
-                operatorType: .greaterThan,
-                value: 0
-            )
-        ])
-
         let runningSamplesQuery = (updating ? querySource.updatingQueryProducer : querySource.queryProducer)(
             stepsType,
-            runningPredicate,
+            HealthKitService.runningStepsPredicate(within: predicate),
             HKObjectQueryNoLimit,
             nil
         )
@@ -316,6 +360,59 @@ extension HealthKitService: StepsDataSource
         })
     }
 
+    public func stepsDataProducer(boundaryDates: [BoundaryDates]) -> SignalProducer<[StepsData], NSError>
+    {
+        guard let startDate = boundaryDates.map({ $0.start }).min(),
+              let endDate = boundaryDates.map({ $0.end }).max(),
+              let intervalComponents = HealthKitService.intervalComponents(
+                  dividing: boundaryDates,
+                  anchorDate: startDate,
+                  calendar: Calendar.current
+              )
+        else { return individualStepsDataProducer(boundaryDates: boundaryDates) }
+
+        let predicate = HKQuery.predicateForSamples(withStart: startDate, end: endDate, options: [.strictStartDate])
+
+        // as with single queries, only observe recent data, to limit the number of observer queries
+        let updating = endDate.timeIntervalSinceNow > -86400 * 4
+
+        // bucket the total steps into intervals that evenly divide each boundary dates value, then add up the buckets
+        let makeCollectionQuery = updating
+            ? querySource.updatingStatisticsCollectionQueryProducer
+            : querySource.statisticsCollectionQueryProducer
+
+        let collectionQuery = makeCollectionQuery(stepsType, predicate, .cumulativeSum, startDate, intervalComponents)
+
+        let stepCountsQuery = collectionQuery.map({ collection in
+            boundaryDates.totals(of: collection.statistics().map({ statistics in
+                (date: statistics.startDate, value: statistics.sumQuantity()?.doubleValue(for: HKUnit.count()) ?? 0)
+            }))
+        })
+
+        // read all running samples at once, and add each to the boundary dates containing its start date
+        let runningSamplesQuery = (updating ? querySource.updatingQueryProducer : querySource.queryProducer)(
+            stepsType,
+            HealthKitService.runningStepsPredicate(within: predicate),
+            HKObjectQueryNoLimit,
+            nil
+        )
+
+        let runningStepsQuery = runningSamplesQuery
+            .map({ ($0 as? [HKQuantitySample]) ?? [] })
+            .map({ samples in
+                boundaryDates.totals(of: samples.map({ sample in
+                    (date: sample.startDate, value: Double(sample.runningStepCount))
+                }))
+            })
+
+        return stepCountsQuery.combineLatest(with: runningStepsQuery).map({ stepCounts, runningStepCounts in
+            zip(stepCounts, runningStepCounts).map({ stepCount, runningStepCount -> StepsData in
+                let runningSteps = Int(runningStepCount)
+                return Steps(walkingStepCount: max(Int(stepCount) - runningSteps, 0), runningStepCount: runningSteps)
+            })
+        })
+    }
+
     public func stepsBoundaryDateProducer(ascending: Bool) -> SignalProducer<Date?, NSError>
     {
         let calendar = Calendar.current
@@ -25,26 +25,17 @@ public final class MindfulDatesDataController
         let cacheCompleted = MutableProperty(false)
         self.cacheCompleted = cacheCompleted
         
-        let startDate = boundaryDates.first?.start
-        
-        if let start = startDate
-        {
-            disposable += cache.mindfulMinutesProducer(startDate: start, count: boundaryDates.count)
-                .on(value: { cached in
-                    if cached.any({ $0 != .zero })
-                    {
-                        mindfulMinute.value = cached.map({ .success($0) })
-                    }
-                })
-                .take(first: 1)
-                .startWithCompleted({
-                    cacheCompleted.value = true
-                })
-        }
-        else
-        {
-            cacheCompleted.value = true
-        }
+        disposable += cache.mindfulMinutesProducer(boundaryDates: boundaryDates)
+            .on(value: { cached in
+                if cached.any({ $0 != .zero })
+                {
+                    mindfulMinute.value = cached.map({ .success($0) })
+                }
+            })
+            .take(first: 1)
+            .startWithCompleted({
+                cacheCompleted.value = true
+            })
         
         // create producers between boundary dates
         queue = ProducerQueue(
@@ -56,9 +47,9 @@ public final class MindfulDatesDataController
                     .on(value: { result in
                         mindfulMinute.modify({ $0[item.offset] = result })
                         
-                        if let mindfulMinute = result.value, let start = startDate
+                        if let mindfulMinute = result.value
                         {
-                            cache.write(startDate: start, index: item.offset, mindfulMinutes: mindfulMinute)
+                            cache.write(boundaryDates: item.element, mindfulMinutes: mindfulMinute)
                         }
                     })
         }
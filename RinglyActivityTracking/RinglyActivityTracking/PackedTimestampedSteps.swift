@@ -0,0 +1,246 @@
+/// Timestamped steps data, packed into parallel arrays of timestamps, walking steps, and running steps.
+///
+/// This representation allows steps to be aggregated with `Steps.distinctMaxByMinuteSteps(packed:)`, which operates on
+/// contiguous buffers, rather than calling through `TimestampedStepsData` for each comparison.
+public struct PackedTimestampedSteps
+{
+    // MARK: - Initialization
+
+    /// Initializes an empty packed steps value.
+    ///
+    /// - parameter capacity: The number of elements to reserve capacity for.
+    public init(capacity: Int = 0)
+    {
+        timestamps.reserveCapacity(capacity)
+        walkingStepCounts.reserveCapacity(capacity)
+        runningStepCounts.reserveCapacity(capacity)
+    }
+
+    /// Initializes a packed steps value from a sequence of steps data, preserving its order.
+    ///
+    /// - parameter steps: The steps data.
+    public init<Data: TimestampedStepsData, S: Sequence>(_ steps: S) where S.Iterator.Element == Data
+    {
+        self.init(capacity: steps.underestimatedCount)
+
+        for data in steps
+        {
+            append(
+                timestamp: data.timestamp,
+                walkingStepCount: Int32(truncatingBitPattern: data.walkingStepCount),
+                runningStepCount: Int32(truncatingBitPattern: data.runningStepCount)
+            )
+        }
+    }
+
+    // MARK: - Columns
+
+    /// The timestamp of each element.
+    public fileprivate(set) var timestamps = [Int32]()
+
+    /// The walking step count of each element.
+    public fileprivate(set) var walkingStepCounts = [Int32]()
+
+    /// The running step count of each element.
+    public fileprivate(set) var runningStepCounts = [Int32]()
+
+    /// The number of elements.
+    public var count: Int
+    {
+        return timestamps.count
+    }
+
+    // MARK: - Appending
+
+    /**
+     Appends an element.
+
+     - parameter timestamp:        The timestamp.
+     - parameter walkingStepCount: The walking step count.
+     - parameter runningStepCount: The running step count.
+     */
+    public mutating func append(timestamp: Int32, walkingStepCount: Int32, runningStepCount: Int32)
+    {
+        timestamps.append(timestamp)
+        walkingStepCounts.append(walkingStepCount)
+        runningStepCounts.append(runningStepCount)
+    }
+}
+
+extension Steps
+{
+    // MARK: - Packed Aggregation
+
+    /**
+     Initializes a steps value by selecting the maximum for each timestamp from a sequence of timestamp-grouped steps.
+
+     - parameter timestampGroupedSteps: The steps data, with equal timestamps adjacent to each other.
+     */
+    init<Data: TimestampedStepsData, S: Sequence>(timestampGroupedSteps: S) where S.Iterator.Element == Data
+    {
+        self = Steps.distinctMaxByMinuteSteps(packed: PackedTimestampedSteps(timestampGroupedSteps))
+    }
+
+    /**
+     Sums packed steps data, selecting the element with the most steps for each timestamp. Elements with equal
+     timestamps must be adjacent - for example, sorted by timestamp. If multiple elements for a timestamp have the
+     same number of steps, the first is selected.
+
+     This has the same results as `distinctMaxByMinuteSteps(timestampGroupedSteps:)`. Runs of distinct timestamps,
+     which make up all data from a single source, are summed with a tight loop over each column that the compiler
+     can vectorize. Only timestamps with data from multiple sources are compared individually.
+
+     - parameter packed: The packed steps data.
+     */
+    public static func distinctMaxByMinuteSteps(packed: PackedTimestampedSteps) -> Steps
+    {
+        return distinctMaxByMinuteSteps(packed: packed, elements: 0..<packed.count)
+    }
+
+    /**
+     Sums the packed steps data with timestamps in a range, selecting the element with the most steps for each
+     timestamp. The elements must be sorted by timestamp.
+
+     This allows a single sorted read to be split into many ranges, without copying the elements of each range.
+
+     - parameter packed:     The packed steps data.
+     - parameter timestamps: The range of timestamps to include.
+     */
+    public static func distinctMaxByMinuteSteps(packed: PackedTimestampedSteps, timestamps: Range<Int32>) -> Steps
+    {
+        return distinctMaxByMinuteSteps(
+            packed: packed,
+            elements: packed.timestamps.lowerBoundIndex(of: timestamps.lowerBound)
+                ..< packed.timestamps.lowerBoundIndex(of: timestamps.upperBound)
+        )
+    }
+
+    /**
+     Sums a range of elements of packed steps data with `distinctMaxByMinuteSteps(timestamps:walking:running:)`.
+
+     - parameter packed:   The packed steps data.
+     - parameter elements: The range of elements to include.
+     */
+    fileprivate static func distinctMaxByMinuteSteps(packed: PackedTimestampedSteps, elements: Range<Int>) -> Steps
+    {
+        return packed.timestamps.withUnsafeBufferPointer({ timestamps in
+            packed.walkingStepCounts.withUnsafeBufferPointer({ walking in
+                packed.runningStepCounts.withUnsafeBufferPointer({ running in
+                    distinctMaxByMinuteSteps(
+                        timestamps: timestamps.slice(elements),
+                        walking: walking.slice(elements),
+                        running: running.slice(elements)
+                    )
+                })
+            })
+        })
+    }
+
+    /**
+     The aggregation kernel for `distinctMaxByMinuteSteps(packed:)`.
+
+     - parameter timestamps: The timestamp column.
+     - parameter walking:    The walking steps column.
+     - parameter running:    The running steps column.
+     */
+    fileprivate static func distinctMaxByMinuteSteps(timestamps: UnsafeBufferPointer<Int32>,
+                                                     walking: UnsafeBufferPointer<Int32>,
+                                                     running: UnsafeBufferPointer<Int32>)
+        -> Steps
+    {
+        let count = timestamps.count
+        var walkingStepCount = 0, runningStepCount = 0
+        var index = 0
+
+        while index < count
+        {
+            // find the run of elements whose timestamps differ from the next element's, and sum them directly
+            let runStart = index
+
+            while index + 1 < count && timestamps[index + 1] != timestamps[index]
+            {
+                index += 1
+            }
+
+            var runWalking: Int32 = 0, runRunning: Int32 = 0
+
+            for runIndex in runStart..<index
+            {
+                runWalking = runWalking &+ walking[runIndex]
+                runRunning = runRunning &+ running[runIndex]
+            }
+
+            walkingStepCount += Int(runWalking)
+            runningStepCount += Int(runRunning)
+
+            // the element at `index` either is the last element, or begins a group of equal timestamps
+            let timestamp = timestamps[index]
+            var maximum = index
+            var maximumStepCount = walking[index] + running[index]
+            index += 1
+
+            while index < count && timestamps[index] == timestamp
+            {
+                let stepCount = walking[index] + running[index]
+
+                if stepCount > maximumStepCount
+                {
+                    maximum = index
+                    maximumStepCount = stepCount
+                }
+
+                index += 1
+            }
+
+            walkingStepCount += Int(walking[maximum])
+            runningStepCount += Int(running[maximum])
+        }
+
+        return Steps(walkingStepCount: walkingStepCount, runningStepCount: runningStepCount)
+    }
+}
+
+extension UnsafeBufferPointer
+{
+    // MARK: - Slicing
+
+    /// Returns a buffer pointer to a range of the buffer's elements.
+    ///
+    /// - parameter range: The range of elements, which must be within the buffer.
+    fileprivate func slice(_ range: Range<Int>) -> UnsafeBufferPointer
+    {
+        return UnsafeBufferPointer(start: baseAddress.map({ $0 + range.lowerBound }), count: range.count)
+    }
+}
+
+extension RandomAccessCollection where Iterator.Element == Int32, Index == Int
+{
+    // MARK: - Binary Search
+
+    /**
+     Returns the index of the first element that is not less than `value`, or `endIndex` if there is no such
+     element. The collection must be sorted in ascending order.
+
+     - parameter value: The value to search for.
+     */
+    func lowerBoundIndex(of value: Int32) -> Int
+    {
+        var lower = startIndex, upper = endIndex
+
+        while lower < upper
+        {
+            let middle = lower + (upper - lower) / 2
+
+            if self[middle] < value
+            {
+                lower = middle + 1
+            }
+            else
+            {
+                upper = middle
+            }
+        }
+
+        return lower
+    }
+}
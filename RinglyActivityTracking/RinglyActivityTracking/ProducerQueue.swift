@@ -1,8 +1,11 @@
 import Foundation
 import ReactiveSwift
 
-/// A queue of signal producers, which starts the next producer after the previous producer sends its first value, or
-/// completes without sending a value.
+/// A queue of signal producers, which starts up to a maximum number of producers at once. A producer's slot is released
+/// after it sends its first value, or terminates without sending a value.
+///
+/// Producers are started in priority order, lowest first. Producers with the same priority are started in the order of
+/// the queue's content.
 internal final class ProducerQueue<Value, Error: Swift.Error>
 {
     // MARK: - Initialization
@@ -11,81 +14,238 @@ internal final class ProducerQueue<Value, Error: Swift.Error>
         self.init(content: producers, makeProducer: { $0 })
     }
 
-    init<Sequence: Swift.Sequence>(content: Sequence, makeProducer: (Sequence.Iterator.Element) -> SignalProducer<Value, Error>)
+    /**
+     Initializes a producer queue.
+
+     - parameter content:                 The content to create producers for.
+     - parameter maximumProducersStarted: The maximum number of producers that may be started at one time.
+     - parameter makeProducer:            A function to create a producer for an element of `content`. This is called
+                                          when the producer is started.
+     - parameter clock:                   A function returning the current time, used to measure metrics.
+     */
+    init<Sequence: Swift.Sequence>(content: Sequence,
+                                   maximumProducersStarted: Int = 1,
+                                   makeProducer: @escaping (Sequence.Iterator.Element) -> SignalProducer<Value, Error>,
+                                   clock: @escaping () -> TimeInterval = { ProcessInfo.processInfo.systemUptime })
     {
-        producerGenerator = AnyIterator(IteratorSequence(content.makeIterator()).lazy.map(makeProducer).makeIterator())
+        let now = clock()
+
+        self.clock = clock
+        self.maximumProducersStarted = max(maximumProducersStarted, 1)
+        self.pending = content.enumerated().map({ offset, element in
+            Entry(offset: offset, priority: offset, enqueueTime: now, makeProducer: { makeProducer(element) })
+        })
     }
 
-    // MARK: - Producers
+    // MARK: - Entries
 
-    /// If `true`, the queue will start producers.
-    var draining = false
+    /// A producer that has not yet been started.
+    fileprivate struct Entry
     {
-        didSet
-        {
-            if draining
-            {
-                drainLock.lock()
+        /// The offset of the entry in the queue's content.
+        let offset: Int
 
-                if producersStarted < maximumProducersStarted
-                {
-                    drainProducers()
-                }
+        /// The priority of the entry - lower priorities are started first.
+        var priority: Int
 
-                drainLock.unlock()
-            }
-        }
+        /// The time at which the entry became eligible to start, according to `clock`.
+        var enqueueTime: TimeInterval
+
+        /// Creates the entry's producer.
+        let makeProducer: () -> SignalProducer<Value, Error>
     }
 
-    /// A generator of the producers that this queue will start.
-    fileprivate var producerGenerator: AnyIterator<SignalProducer<Value, Error>>
+    /// The entries that have not yet been started. Only accessed while holding `lock`.
+    fileprivate var pending: [Entry]
 
-    /// The number of producers that have been started.
+    /// The number of producers that have been started, and have not yet released their slot. Only accessed while
+    /// holding `lock`.
     fileprivate var producersStarted = 0
 
     /// The maximum number of producers that may be started at one time.
-    fileprivate let maximumProducersStarted = 1
+    let maximumProducersStarted: Int
+
+    /// Protects the queue's state. Producers are never started while the lock is held, so synchronous producers do not
+    /// re-enter it.
+    fileprivate let lock = NSLock()
+
+    // MARK: - Draining
 
-    /// This lock needs to be recursive, in case a synchronous producer is started.
-    fileprivate let drainLock = NSRecursiveLock()
+    /// If `true`, the queue will start producers.
+    var draining: Bool
+    {
+        get
+        {
+            lock.lock()
+            defer { lock.unlock() }
+            return _draining
+        }
+        set
+        {
+            lock.lock()
+
+            if newValue && !_draining
+            {
+                // time spent with draining disabled is not counted as waiting in the queue
+                let now = clock()
+                pending = pending.map({ entry in
+                    var entry = entry
+                    entry.enqueueTime = max(entry.enqueueTime, now)
+                    return entry
+                })
+            }
 
-    /// Drains the next producer from the queue.
+            _draining = newValue
+            lock.unlock()
+
+            if newValue
+            {
+                drainProducers()
+            }
+        }
+    }
+
+    /// The backing value for `draining`. Only accessed while holding `lock`.
+    fileprivate var _draining = false
+
+    /// Starts producers until the maximum number is started, or no pending producers remain.
     fileprivate func drainProducers()
     {
-        drainLock.lock()
+        lock.lock()
 
-        while producersStarted < maximumProducersStarted && draining
+        var starting = [Entry]()
+
+        while _draining && producersStarted < maximumProducersStarted, let index = nextPendingIndex()
         {
-            if let producer = producerGenerator.next()
-            {
-                producersStarted += 1
+            starting.append(pending.remove(at: index))
+            producersStarted += 1
+        }
 
-                producer.startWithSignal({ signal, disposable in
-                    self.disposable += disposable
+        lock.unlock()
 
-                    let callback = { [weak self] in
-                        guard let strong = self else { return }
+        starting.forEach(start)
+    }
 
-                        strong.drainLock.lock()
-                        strong.producersStarted -= 1
-                        strong.drainProducers()
-                        strong.drainLock.unlock()
-                    }
+    /// The index in `pending` of the entry to start next. Must be called while holding `lock`.
+    fileprivate func nextPendingIndex() -> Int?
+    {
+        var next = Int?.none
 
-                    self.disposable += signal.take(first: 1).observeCompleted(callback)
-                    self.disposable += signal.take(first: 1).observeFailed({ _ in callback() })
-                })
-            }
-            else
+        for (index, entry) in pending.enumerated()
+        {
+            if let current = next, (pending[current].priority, pending[current].offset) <= (entry.priority, entry.offset)
             {
-                break
+                continue
             }
+
+            next = index
         }
 
-        drainLock.unlock()
+        return next
     }
 
+    /// Starts the producer for an entry. Must not be called while holding `lock`.
+    fileprivate func start(_ entry: Entry)
+    {
+        let startTime = clock()
+        let waitTime = startTime - entry.enqueueTime
+
+        entry.makeProducer().startWithSignal({ signal, disposable in
+            self.disposable += disposable
+
+            self.disposable += signal.take(first: 1).observe({ [weak self] event in
+                guard event.isTerminating, let strong = self else { return }
+
+                strong.metricsObserver?(ProducerQueueMetrics(
+                    offset: entry.offset,
+                    waitTime: waitTime,
+                    executionTime: strong.clock() - startTime
+                ))
+
+                strong.lock.lock()
+                strong.producersStarted -= 1
+                strong.lock.unlock()
+
+                strong.drainProducers()
+            })
+        })
+    }
+
+    // MARK: - Priority
+
+    /**
+     Changes the priorities of the producers that have not yet been started.
+
+     - parameter priority: A function returning the priority for an offset in the queue's content. Lower priorities are
+                           started first.
+     */
+    func prioritize(_ priority: (Int) -> Int)
+    {
+        lock.lock()
+
+        pending = pending.map({ entry in
+            var entry = entry
+            entry.priority = priority(entry.offset)
+            return entry
+        })
+
+        lock.unlock()
+    }
+
+    // MARK: - Cancellation
+
+    /**
+     Removes producers that have not yet been started from the queue. Producers that have already been started are not
+     affected.
+
+     - parameter predicate: A function returning `true` for offsets in the queue's content that should be cancelled.
+
+     - returns: The offsets that were cancelled.
+     */
+    @discardableResult
+    func cancelPending(where predicate: (Int) -> Bool) -> [Int]
+    {
+        lock.lock()
+
+        let cancelled = pending.filter({ predicate($0.offset) }).map({ $0.offset })
+        pending = pending.filter({ !predicate($0.offset) })
+
+        lock.unlock()
+
+        return cancelled
+    }
+
+    /// The number of producers that have not yet been started.
+    var pendingCount: Int
+    {
+        lock.lock()
+        defer { lock.unlock() }
+        return pending.count
+    }
+
+    // MARK: - Instrumentation
+
+    /// Returns the current time, used to measure metrics.
+    fileprivate let clock: () -> TimeInterval
+
+    /// A function to call with timing information after each producer releases its slot. This may be called on any
+    /// thread.
+    var metricsObserver: ((ProducerQueueMetrics) -> ())?
+
     // MARK: - Disposing of Producers
     fileprivate let disposable = CompositeDisposable()
     deinit { disposable.dispose() }
 }
+
+/// Timing information for a producer started by a producer queue.
+public struct ProducerQueueMetrics
+{
+    /// The offset of the producer in the queue's content.
+    public let offset: Int
+
+    /// The time that the producer waited in the queue before starting, while the queue was draining.
+    public let waitTime: TimeInterval
+
+    /// The time between starting the producer and it sending its first value or terminating.
+    public let executionTime: TimeInterval
+}
@@ -36,6 +36,13 @@ public final class RealmService
         self.configuration = configuration
         self.queue = DispatchQueue(label: queueName)
         self.logFunction = logFunction
+
+        (writtenStepsIntervals, writtenStepsIntervalsObserver) = Signal.pipe()
+    }
+
+    deinit
+    {
+        writtenStepsIntervalsObserver.sendCompleted()
     }
 
     // MARK: - Realm
@@ -47,7 +54,7 @@ public final class RealmService
     {
         return Realm.Configuration(
             fileURL: fileURL,
-            schemaVersion: 5,
+            schemaVersion: 7,
             migrationBlock: { (migration: RealmSwift.Migration, oldSchemaVersion: UInt64) in
                 // note that version 2 is the oldest version that was released to customers.
                 if oldSchemaVersion < 4
@@ -68,12 +75,72 @@ public final class RealmService
                         new?["identifier"] = UpdateModel.identifier(timestamp: timestamp, macAddress: macAddress)
                     })
                 }
+
+                if oldSchemaVersion < 6
+                {
+                    RealmService.createRollups(in: migration)
+                }
+
+                // version 7 indexes `UpdateModel.timestamp`, which Realm builds automatically
             },
-            objectTypes: [HealthKitQueuedUpdateModel.self, UpdateModel.self,
+            objectTypes: [HealthKitQueuedUpdateModel.self, UpdateModel.self, StepsRollupModel.self,
                           UpdateMindfulnessSession.self, MindfulnessSession.self]
         )
     }
 
+    /**
+     Creates hourly and daily rollups for all existing update models, when migrating from a schema version without
+     rollups.
+
+     - parameter migration: The migration.
+     */
+    fileprivate static func createRollups(in migration: RealmSwift.Migration)
+    {
+        var deltas = StepsRollupDeltas()
+        var maximums = [Int32:StepsRollupMinuteMaximum]()
+
+        migration.enumerateObjects(ofType: "UpdateModel", { _, new in
+            guard
+                let timestamp = new?["timestamp"] as? Int32,
+                let macAddress = new?["macAddress"] as? Int64,
+                let walkingBacking = new?["walkingBacking"] as? Int8,
+                let runningBacking = new?["runningBacking"] as? Int8
+            else { return }
+
+            let maximum = StepsRollupMinuteMaximum(
+                steps: Steps(
+                    walkingStepCount: Int(UInt8(bitPattern: walkingBacking)),
+                    runningStepCount: Int(UInt8(bitPattern: runningBacking))
+                ),
+                macAddress: macAddress
+            )
+
+            deltas.add(
+                walkingStepCount: maximum.steps.walkingStepCount,
+                runningStepCount: maximum.steps.runningStepCount,
+                timestamp: timestamp,
+                macAddress: macAddress
+            )
+
+            if maximums[timestamp].map(maximum.isPreferred) ?? true
+            {
+                maximums[timestamp] = maximum
+            }
+        })
+
+        for (timestamp, maximum) in maximums
+        {
+            deltas.add(
+                walkingStepCount: maximum.steps.walkingStepCount,
+                runningStepCount: maximum.steps.runningStepCount,
+                timestamp: timestamp,
+                macAddress: nil
+            )
+        }
+
+        deltas.create(in: migration)
+    }
+
     /// The Realm configuration.
     fileprivate let configuration: Realm.Configuration
 
@@ -88,6 +155,11 @@ public final class RealmService
 
     // MARK: - ReactiveCocoa
 
+    /// Sends the intervals containing the updates written by each write, after the write is committed. Consecutive
+    /// written minutes are combined into a single interval.
+    public let writtenStepsIntervals: Signal<[BoundaryDates], NoError>
+    fileprivate let writtenStepsIntervalsObserver: Observer<[BoundaryDates], NoError>
+
     // MARK: - Logging
     fileprivate let logFunction: ((String) -> ())?
 }
@@ -97,20 +169,7 @@ extension RealmService: SourcedUpdatesSink
     public func writeSourcedUpdatesProducer(_ updatesProducer: SignalProducer<SourcedUpdate, NoError>)
         -> SignalProducer<(), NoError>
     {
-        return updatesProducer
-            // only include updates that have non-zero steps and are within a reasonable time interval
-            .filter({ sourced in
-                guard sourced.update.steps > 0 else {
-                    return false
-                }
-
-                let date = sourced.update.date.date
-
-                return abs(date.timeIntervalSinceNow) < 86400 * 30
-            })
-
-            // buffer to group writes into transactions
-            .buffer(limit: 100, timeout: .seconds(5), on: QueueScheduler.main)
+        return updatesProducer.bufferedForWriting()
 
             // write the data to Realm, yielding the intervals that were written after completion
             .flatMap(.latest, transform: { [weak self] sourcedUpdates in
@@ -157,41 +216,176 @@ extension RealmService
 
      - parameter sourcedUpdates: The updates to write.
      */
-    fileprivate func writeSourcedUpdates(_ sourcedUpdates: [SourcedUpdate]) -> SignalProducer<(), NSError>
+    func writeSourcedUpdates(_ sourcedUpdates: [SourcedUpdate]) -> SignalProducer<UpdatesWriteResult, NSError>
     {
+        let writtenStepsIntervalsObserver = self.writtenStepsIntervalsObserver
+
         return realmProducer { realm, observer, disposable in
             let updateModels = sourcedUpdates.map(UpdateModel.init)
-            
-            //find all records between min and max updates
-            let minMaxTimestamp:(UpdateModel, UpdateModel) -> Bool = { (a,b) in a.timestamp < b.timestamp }
-            
-            
-            if let minTimestamp = updateModels.min(by: minMaxTimestamp)?.timestamp,
-                let maxTimestamp = updateModels.max(by: minMaxTimestamp)?.timestamp {
-                let predicate = NSPredicate(format: "timestamp >= %d AND timestamp <= %d", minTimestamp, maxTimestamp)
-                
-
-                let persistedUpdateModelsInRange = realm.objects(UpdateModel.self).filter(predicate)
-                let newUpdateModels = updateModels.filter({ updateModel in
-                    if let matchedUpdateModel = persistedUpdateModelsInRange.first(where: { $0.identifier == updateModel.identifier }) {
-                        return matchedUpdateModel.stepCount < updateModel.stepCount
-                    }
+            var result = UpdatesWriteResult(written: 0, skipped: 0)
+            var timestamps = Set<Int32>()
 
-                    return true
-                })
-                
-                let healthKitQueuedUpdates = newUpdateModels.healthKitTimestamps.map(HealthKitQueuedUpdateModel.init)
-                
-                try realm.write {
-                    realm.add(newUpdateModels, update: true)
-                    realm.add(healthKitQueuedUpdates, update: true)
-                }
+            try realm.write {
+                (result, timestamps) = RealmService.upsert(updateModels, in: realm)
+            }
+
+            if !timestamps.isEmpty
+            {
+                writtenStepsIntervalsObserver.send(value: RealmService.intervals(containing: timestamps))
             }
 
+            observer.send(value: result)
             observer.sendCompleted()
         }
     }
 
+    /**
+     Returns the intervals covering a set of minutes, combining consecutive minutes into a single interval.
+
+     - parameter timestamps: The minutes.
+     */
+    static func intervals(containing timestamps: Set<Int32>) -> [BoundaryDates]
+    {
+        var ranges = [Range<Int32>]()
+
+        for timestamp in timestamps.sorted()
+        {
+            if let last = ranges.last, last.upperBound == timestamp
+            {
+                ranges[ranges.count - 1] = last.lowerBound..<(timestamp + 1)
+            }
+            else
+            {
+                ranges.append(timestamp..<(timestamp + 1))
+            }
+        }
+
+        return ranges.map({ range in
+            BoundaryDates(
+                start: RLYActivityTrackingMinuteToNSDate(RLYActivityTrackingMinute(range.lowerBound)),
+                end: RLYActivityTrackingMinuteToNSDate(RLYActivityTrackingMinute(range.upperBound))
+            )
+        })
+    }
+
+    /**
+     Adds or updates update models, keeping the model with the most steps for each identifier, updates the hourly and
+     daily rollups containing the written models, and enqueues the written models for HealthKit. This must be called
+     within a write transaction.
+
+     Existing models are looked up by primary key, and the other models in the minutes they cover through the
+     `timestamp` index, so the cost of the write is proportional to the number of update models, and the number of
+     stored models in those minutes, rather than the total number of models already stored.
+
+     - parameter updateModels: The update models to write.
+     - parameter realm:        The Realm database to write to.
+
+     - returns: The number of models written and skipped, and the minutes of the written models.
+     */
+    static func upsert(_ updateModels: [UpdateModel], in realm: Realm)
+        -> (result: UpdatesWriteResult, timestamps: Set<Int32>)
+    {
+        // merge models with the same identifier, keeping the model with the most steps
+        var merged = [Int64:UpdateModel](minimumCapacity: updateModels.count)
+
+        for model in updateModels
+        {
+            if let current = merged[model.identifier], current.stepCount >= model.stepCount
+            {
+                continue
+            }
+
+            merged[model.identifier] = model
+        }
+
+        // only write models that have more steps than the persisted model with the same identifier, tracking the
+        // change in each source's steps for the rollups
+        var written = [UpdateModel]()
+        var deltas = StepsRollupDeltas()
+
+        for model in merged.values
+        {
+            let persisted = realm.object(ofType: UpdateModel.self, forPrimaryKey: model.identifier)
+            guard (persisted?.stepCount ?? -1) < model.stepCount else { continue }
+
+            written.append(model)
+
+            deltas.add(
+                walkingStepCount: model.walkingStepCount - (persisted?.walkingStepCount ?? 0),
+                runningStepCount: model.runningStepCount - (persisted?.runningStepCount ?? 0),
+                timestamp: model.timestamp,
+                macAddress: model.macAddress
+            )
+        }
+
+        // stored step counts only increase, so the combined maximum for each minute is the better of the previous
+        // maximum and the written models for that minute
+        let previousMaximums = minuteMaximums(in: realm, timestamps: written.lazy.map({ $0.timestamp }))
+        var maximums = previousMaximums
+
+        for model in written
+        {
+            let maximum = StepsRollupMinuteMaximum(steps: model.steps, macAddress: model.macAddress)
+
+            if maximums[model.timestamp].map(maximum.isPreferred) ?? true
+            {
+                maximums[model.timestamp] = maximum
+            }
+        }
+
+        for (timestamp, maximum) in maximums
+        {
+            let previous = previousMaximums[timestamp]?.steps ?? Steps.zero
+
+            deltas.add(
+                walkingStepCount: maximum.steps.walkingStepCount - previous.walkingStepCount,
+                runningStepCount: maximum.steps.runningStepCount - previous.runningStepCount,
+                timestamp: timestamp,
+                macAddress: nil
+            )
+        }
+
+        realm.add(written, update: true)
+        realm.add(written.healthKitTimestamps.map(HealthKitQueuedUpdateModel.init), update: true)
+        deltas.apply(to: realm)
+
+        return (
+            result: UpdatesWriteResult(written: written.count, skipped: updateModels.count - written.count),
+            timestamps: Set(written.lazy.map({ $0.timestamp }))
+        )
+    }
+
+    /**
+     Returns the update selected for each of the specified minutes when combining sources.
+
+     - parameter realm:      The Realm database to read from.
+     - parameter timestamps: The minutes.
+     */
+    fileprivate static func minuteMaximums<S: Sequence>(in realm: Realm, timestamps: S)
+        -> [Int32:StepsRollupMinuteMaximum] where S.Iterator.Element == Int32
+    {
+        let timestamps = Set(timestamps)
+
+        guard !timestamps.isEmpty else { return [:] }
+
+        var maximums = [Int32:StepsRollupMinuteMaximum](minimumCapacity: timestamps.count)
+
+        // an `IN` query is answered from the `timestamp` index, unlike a range query
+        let models = realm.objects(UpdateModel.self).filter("timestamp IN %@", timestamps.map({ Int($0) }))
+
+        for model in models
+        {
+            let maximum = StepsRollupMinuteMaximum(steps: model.steps, macAddress: model.macAddress)
+
+            if maximums[model.timestamp].map(maximum.isPreferred) ?? true
+            {
+                maximums[model.timestamp] = maximum
+            }
+        }
+
+        return maximums
+    }
+
     /**
      Writes updates to the Realm database, logging the result of the operation.
 
@@ -213,8 +407,11 @@ extension RealmService
         return writeSourcedUpdates(sourcedUpdates)
             .on(failed: { error in
                 logFunction?("Error writing \(count) updates from \(sources): \(error)")
-            }, completed: {
-                logFunction?("Wrote \(count) updates from \(sources), from minute \(first) to \(last)")
+            }, value: { result in
+                logFunction?(
+                    "Wrote \(result.written) of \(count) updates from \(sources), skipped \(result.skipped), " +
+                    "from minute \(first) to \(last)"
+                )
             })
             .resultify()
             .ignoreValues()
@@ -242,6 +439,7 @@ extension RealmService
         return realmProducer { realm, observer, disposable in
             try realm.write {
                 realm.delete(realm.objects(UpdateModel.self))
+                realm.delete(realm.objects(StepsRollupModel.self))
                 realm.delete(realm.objects(HealthKitQueuedUpdateModel.self))
                 realm.delete(realm.objects(UpdateMindfulnessSession.self))
                 realm.delete(realm.objects(MindfulnessSession.self))
@@ -398,13 +596,165 @@ extension RealmService
 
     func stepsDataProducer(startMinute: RLYActivityTrackingMinute,
                            endMinute: RLYActivityTrackingMinute,
-                           predicate: NSPredicate?)
+                           macAddress: Int64?)
         -> SignalProducer<StepsData, NSError>
+    {
+        // every write that changes steps also changes at least one rollup containing the changed minutes, so observing
+        // those rollups is sufficient to observe all changes to the range
+        let rollupsProducer = realmResultsProducer { realm -> Results<StepsRollupModel> in
+            realm.objects(StepsRollupModel.self).filter(StepsRollupModel.predicate(
+                containingMinutesIn: Int32(startMinute)..<max(Int32(startMinute), Int32(endMinute))
+            ))
+        }
+
+        return rollupsProducer.map({ rollups in
+            guard let realm = rollups.realm else { return Steps.zero }
+
+            return RealmService.steps(
+                in: realm,
+                startMinute: Int32(startMinute),
+                endMinute: Int32(endMinute),
+                macAddress: macAddress
+            )
+        })
+    }
+
+    /**
+     Returns the steps in a range of minutes, reading whole days and hours from rollups, and only the minutes at the
+     edges of the range from update models.
+
+     - parameter realm:       The Realm database to read from.
+     - parameter startMinute: The first minute to include.
+     - parameter endMinute:   The minute after the last minute to include.
+     - parameter macAddress:  The source MAC address to include, or `nil` to combine all sources.
+     */
+    static func steps(in realm: Realm, startMinute: Int32, endMinute: Int32, macAddress: Int64?) -> Steps
+    {
+        let plan = StepsRollupPlan(startMinute: startMinute, endMinute: endMinute)
+        var steps = Steps.zero
+
+        // read the edges from update models
+        let predicate = macAddress.map({ NSPredicate(format: "macAddress == %lld", $0) })
+
+        for range in plan.updateRanges
+        {
+            let models = updateModels(
+                in: realm,
+                startMinute: RLYActivityTrackingMinute(range.lowerBound),
+                endMinute: RLYActivityTrackingMinute(range.upperBound),
+                predicate: predicate
+            )
+
+            // a single range is reduced directly from the lazy results - packing them would be an extra pass
+            steps = steps + Steps.distinctMaxByMinuteSteps(timestampGroupedSteps: models)
+        }
+
+        // read everything else from rollups
+        let rollups = realm.objects(StepsRollupModel.self).filter(macAddress.map({ macAddress in
+            NSPredicate(format: "allSources == false AND macAddress == %lld", macAddress)
+        }) ?? NSPredicate(format: "allSources == true"))
+
+        let rollupRanges: [(Int32, Range<Int32>)] = plan.hourRanges.map({ (StepsRollupModel.hourMinuteCount, $0) })
+            + (plan.dayRange.map({ [(StepsRollupModel.dayMinuteCount, $0)] }) ?? [])
+
+        for (minuteCount, range) in rollupRanges
+        {
+            let results = rollups.filter(
+                "minuteCount == %d AND startMinute >= %d AND startMinute < %d",
+                minuteCount,
+                range.lowerBound,
+                range.upperBound
+            )
+
+            steps = steps + Steps(
+                walkingStepCount: results.sum(ofProperty: "walkingStepCount"),
+                runningStepCount: results.sum(ofProperty: "runningStepCount")
+            )
+        }
+
+        return steps
+    }
+
+    /**
+     Returns the steps in each of a set of ranges of minutes. Unlike calling
+     `steps(in:startMinute:endMinute:macAddress:)` for each range, this reads each size of rollup with one sorted query
+     over the union of the ranges, and the update models at the edges of every range with one more, then splits the
+     results between the ranges.
+
+     - parameter realm:        The Realm database to read from.
+     - parameter minuteRanges: The ranges of minutes. These may overlap, and do not need to be sorted.
+     - parameter macAddress:   The source MAC address to include, or `nil` to combine all sources.
+
+     - returns: The steps in each range, in the same order as `minuteRanges`.
+     */
+    static func steps(in realm: Realm, minuteRanges: [Range<Int32>], macAddress: Int64?) -> [Steps]
+    {
+        guard let startMinute = minuteRanges.map({ $0.lowerBound }).min(),
+              let endMinute = minuteRanges.map({ $0.upperBound }).max()
+        else { return [] }
+
+        let plans = minuteRanges.map({ StepsRollupPlan(startMinute: $0.lowerBound, endMinute: $0.upperBound) })
+
+        // read the edges of every range from update models
+        let updateRanges = plans.flatMap({ $0.updateRanges })
+        let predicate = macAddress.map({ NSPredicate(format: "macAddress == %lld", $0) })
+
+        // packed once, so that each range's models can be found by binary search rather than by another pass
+        let updates = updateRanges.isEmpty
+            ? PackedTimestampedSteps()
+            : PackedTimestampedSteps(updateModels(in: realm, minuteRanges: updateRanges, predicate: predicate))
+
+        // read each size of rollup over the union of the ranges
+        let rollups = realm.objects(StepsRollupModel.self).filter(macAddress.map({ macAddress in
+            NSPredicate(format: "allSources == false AND macAddress == %lld", macAddress)
+        }) ?? NSPredicate(format: "allSources == true"))
+
+        func cumulativeSums(minuteCount: Int32) -> StepsRollupCumulativeSums
+        {
+            return StepsRollupCumulativeSums(rollups
+                .filter(
+                    "minuteCount == %d AND startMinute >= %d AND startMinute < %d",
+                    minuteCount,
+                    startMinute,
+                    endMinute
+                )
+                .sorted(byKeyPath: "startMinute")
+            )
+        }
+
+        let hours = cumulativeSums(minuteCount: StepsRollupModel.hourMinuteCount)
+        let days = cumulativeSums(minuteCount: StepsRollupModel.dayMinuteCount)
+
+        return plans.map({ plan in
+            let updateSteps = plan.updateRanges.map({ range in
+                Steps.distinctMaxByMinuteSteps(packed: updates, timestamps: range)
+            })
+
+            let hourSteps = plan.hourRanges.map({ hours.steps(startingIn: $0) })
+            let daySteps = plan.dayRange.map({ days.steps(startingIn: $0) }) ?? Steps.zero
+
+            return (updateSteps + hourSteps).reduce(daySteps, +)
+        })
+    }
+
+    /**
+     Returns the update models in a range of minutes, sorted by timestamp, and then by MAC address, so that the first
+     of multiple updates with the same steps in a minute is the one selected by the rollups.
+
+     - parameter realm:       The Realm database to read from.
+     - parameter startMinute: The first minute to include.
+     - parameter endMinute:   The minute after the last minute to include.
+     - parameter predicate:   An additional predicate to filter with, if any.
+     */
+    static func updateModels(in realm: Realm,
+                             startMinute: RLYActivityTrackingMinute,
+                             endMinute: RLYActivityTrackingMinute,
+                             predicate: NSPredicate?)
+        -> Results<UpdateModel>
     {
         // create a predicate for the date range
         var predicates = [
-            NSPredicate(format: "timestamp >= %d", startMinute),
-            NSPredicate(format: "timestamp < %d", endMinute)
+            timestampPredicate(minuteRanges: [Int32(startMinute)..<max(Int32(startMinute), Int32(endMinute))])
         ]
 
         if let p = predicate
@@ -414,17 +764,104 @@ extension RealmService
 
         let fullPredicate = NSCompoundPredicate(andPredicateWithSubpredicates: predicates)
 
-        // perform the fetch request, reducing to a sum
-        let updatesProducer = realmResultsProducer { realm -> Results<UpdateModel> in
-            realm.objects(UpdateModel.self)
-                .filter(fullPredicate)
-                .sorted(byKeyPath: "timestamp", ascending: true)
+        return realm.objects(UpdateModel.self)
+            .filter(fullPredicate)
+            .sorted(by: [SortDescriptor(keyPath: "timestamp"), SortDescriptor(keyPath: "macAddress")])
+    }
+
+    /**
+     Returns the update models in any of a set of ranges of minutes, sorted as in
+     `updateModels(in:startMinute:endMinute:predicate:)`. Models in more than one range are only included once.
+
+     - parameter realm:        The Realm database to read from.
+     - parameter minuteRanges: The ranges of minutes to include.
+     - parameter predicate:    An additional predicate to filter with, if any.
+     */
+    static func updateModels(in realm: Realm, minuteRanges: [Range<Int32>], predicate: NSPredicate?)
+        -> Results<UpdateModel>
+    {
+        let rangesPredicate = timestampPredicate(minuteRanges: minuteRanges)
+
+        let fullPredicate = predicate.map({ predicate in
+            NSCompoundPredicate(andPredicateWithSubpredicates: [rangesPredicate, predicate])
+        }) ?? rangesPredicate
+
+        return realm.objects(UpdateModel.self)
+            .filter(fullPredicate)
+            .sorted(by: [SortDescriptor(keyPath: "timestamp"), SortDescriptor(keyPath: "macAddress")])
+    }
+
+    /// The maximum number of minutes that `timestampPredicate(minuteRanges:)` will list individually.
+    fileprivate static let maximumListedMinuteCount = Int(StepsRollupModel.dayMinuteCount)
+
+    /**
+     Returns a predicate matching update models in any of a set of ranges of minutes.
+
+     Realm only uses indexes for equality, so unless the ranges are very long, the predicate lists their minutes with
+     `IN`, which is answered from the `timestamp` index. Range queries scan every update model. The edges of ranges read
+     by `steps(in:minuteRanges:macAddress:)` are always shorter than two hours.
+
+     - parameter minuteRanges: The ranges of minutes.
+     */
+    static func timestampPredicate(minuteRanges: [Range<Int32>]) -> NSPredicate
+    {
+        let minuteCount = minuteRanges.reduce(0, { $0 + Int($1.upperBound - $1.lowerBound) })
+
+        if minuteCount <= maximumListedMinuteCount
+        {
+            let minutes = Set(minuteRanges.lazy.map({ CountableRange($0) }).joined())
+            return NSPredicate(format: "timestamp IN %@", minutes.map({ Int($0) }))
         }
 
-        return updatesProducer.map({ Steps.distinctMaxByMinuteSteps(timestampGroupedSteps: $0) })
+        return NSCompoundPredicate(orPredicateWithSubpredicates: minuteRanges.map({ range in
+            NSPredicate(format: "timestamp >= %d AND timestamp < %d", range.lowerBound, range.upperBound)
+        }))
     }
 
-    fileprivate func stepsDataProducer(startDate: Date, endDate: Date, predicate: NSPredicate?)
+    /**
+     A producer for the steps in each of a set of boundary dates, read with
+     `steps(in:minuteRanges:macAddress:)`.
+
+     - parameter boundaryDates: The boundary dates.
+     - parameter macAddress:    The source MAC address to include, or `nil` to combine all sources.
+     */
+    fileprivate func stepsDataProducer(boundaryDates: [BoundaryDates], macAddress: Int64?)
+        -> SignalProducer<[StepsData], NSError>
+    {
+        let minuteRanges: [Range<Int32>]
+
+        do
+        {
+            minuteRanges = try boundaryDates.map({ dates in
+                let startMinute = Int32(try RLYActivityTrackingDate(date: dates.start).minute)
+                let endMinute = Int32(try RLYActivityTrackingDate(date: dates.end).minute)
+
+                return startMinute..<max(startMinute, endMinute)
+            })
+        }
+        catch let error as NSError
+        {
+            return SignalProducer(error: error)
+        }
+
+        // as with single ranges, observing the rollups containing the ranges is sufficient to observe all changes
+        let observedStart = minuteRanges.map({ $0.lowerBound }).min() ?? 0
+        let observedRange = observedStart..<(minuteRanges.map({ $0.upperBound }).max() ?? observedStart)
+
+        let rollupsProducer = realmResultsProducer { realm -> Results<StepsRollupModel> in
+            realm.objects(StepsRollupModel.self).filter(StepsRollupModel.predicate(containingMinutesIn: observedRange))
+        }
+
+        return rollupsProducer.map({ rollups in
+            guard let realm = rollups.realm else {
+                return Array(repeating: Steps.zero, count: minuteRanges.count)
+            }
+
+            return RealmService.steps(in: realm, minuteRanges: minuteRanges, macAddress: macAddress)
+        })
+    }
+
+    fileprivate func stepsDataProducer(startDate: Date, endDate: Date, macAddress: Int64?)
         -> SignalProducer<StepsData, NSError>
     {
         do
@@ -432,7 +869,7 @@ extension RealmService
             return try stepsDataProducer(
                 startMinute: RLYActivityTrackingDate(date: startDate).minute,
                 endMinute: RLYActivityTrackingDate(date: endDate).minute,
-                predicate: predicate
+                macAddress: macAddress
             )
         }
         catch let error as NSError
@@ -449,7 +886,9 @@ extension RealmService: StepsDataSource
         do {
             let startMinute = try RLYActivityTrackingDate(date: startDate).minute
             let endMinute = try RLYActivityTrackingDate(date: endDate).minute
-            predicate = NSPredicate(format: "timestamp >= %d AND timestamp <= %d", startMinute, endMinute)
+            predicate = RealmService.timestampPredicate(
+                minuteRanges: [Int32(startMinute)..<(Int32(max(startMinute, endMinute)) + 1)]
+            )
         } catch let error as NSError {
             return SignalProducer(value: Date?.none)
         }
@@ -466,7 +905,12 @@ extension RealmService: StepsDataSource
     public func stepsDataProducer(startDate: Date, endDate: Date)
         -> SignalProducer<StepsData, NSError>
     {
-        return stepsDataProducer(startDate: startDate, endDate: endDate, predicate: nil)
+        return stepsDataProducer(startDate: startDate, endDate: endDate, macAddress: nil)
+    }
+
+    public func stepsDataProducer(boundaryDates: [BoundaryDates]) -> SignalProducer<[StepsData], NSError>
+    {
+        return stepsDataProducer(boundaryDates: boundaryDates, macAddress: nil)
     }
 }
 
@@ -482,11 +926,7 @@ extension RealmService: SourcedStepsDataSource
     public func stepsDataProducer(startDate: Date, endDate: Date, sourceMACAddress: Int64)
         -> SignalProducer<StepsData, NSError>
     {
-        return stepsDataProducer(
-            startDate: startDate,
-            endDate: endDate,
-            predicate: NSPredicate(format: "macAddress == %lld", sourceMACAddress)
-        )
+        return stepsDataProducer(startDate: startDate, endDate: endDate, macAddress: sourceMACAddress)
     }
 }
 
@@ -7,14 +7,47 @@ extension Sequence where Iterator.Element == SourcedUpdate
      */
     func bucketed(minutesDenominator: UInt32) -> [UInt32:Set<SourcedUpdate>]
     {
-        var buckets = [UInt32:Set<SourcedUpdate>]()
+        let updates = Array(self)
 
-        for update in self
+        // assign each key a dense index, counting the updates for each, so that every bucket can be sized up front
+        var keyIndices = [UInt32:Int]()
+        var updateIndices = [Int]()
+        var counts = [Int]()
+
+        updateIndices.reserveCapacity(updates.count)
+
+        for update in updates
+        {
+            let key = update.update.date.minute / minutesDenominator
+
+            if let index = keyIndices[key]
+            {
+                counts[index] += 1
+                updateIndices.append(index)
+            }
+            else
+            {
+                keyIndices[key] = counts.count
+                updateIndices.append(counts.count)
+                counts.append(1)
+            }
+        }
+
+        // insert into buckets in place - unlike dictionary values, array elements are mutated without being copied
+        var buckets = counts.map({ Set<SourcedUpdate>(minimumCapacity: $0) })
+
+        for (index, update) in zip(updateIndices, updates)
+        {
+            buckets[index].insert(update)
+        }
+
+        var bucketed = [UInt32:Set<SourcedUpdate>](minimumCapacity: keyIndices.count)
+
+        for (key, index) in keyIndices
         {
-            let healthKitInterval = update.update.date.minute / minutesDenominator
-            buckets[healthKitInterval] = buckets[healthKitInterval]?.union([update]) ?? [update]
+            bucketed[key] = buckets[index]
         }
 
-        return buckets
+        return bucketed
     }
 }
@@ -30,11 +30,35 @@ extension SourcedUpdate: Hashable
 {
     public var hashValue: Int
     {
-        return macAddress.hashValue ^ update.hashValue
+        // pack the update's fields into one word, then mix in the MAC address. combining the fields with XOR, as the
+        // update's own hash does, causes frequent collisions between nearby minutes and step counts.
+        let minute = UInt64(update.date.minute)
+        let fields = minute << 16 | UInt64(update.walkingSteps) << 8 | UInt64(update.runningSteps)
+        let mixed = SourcedUpdate.mix(SourcedUpdate.mix(fields) ^ UInt64(bitPattern: macAddress))
+
+        return Int(truncatingBitPattern: mixed)
+    }
+
+    /// The MurmurHash3 64-bit finalizer, which spreads each input bit across the entire output.
+    ///
+    /// - parameter value: The value to mix.
+    fileprivate static func mix(_ value: UInt64) -> UInt64
+    {
+        var value = value
+        value ^= value >> 33
+        value = value &* 0xff51afd7ed558ccd
+        value ^= value >> 33
+        value = value &* 0xc4ceb9fe1a85ec53
+        value ^= value >> 33
+        return value
     }
 }
 
 public func ==(lhs: SourcedUpdate, rhs: SourcedUpdate) -> Bool
 {
-    return lhs.macAddress == rhs.macAddress && lhs.update == rhs.update
+    // compare fields directly, rather than messaging the updates' dates for equality
+    return lhs.macAddress == rhs.macAddress
+        && lhs.update.date.minute == rhs.update.date.minute
+        && lhs.update.walkingSteps == rhs.update.walkingSteps
+        && lhs.update.runningSteps == rhs.update.runningSteps
 }
@@ -1,6 +1,7 @@
 import Foundation
 import ReactiveSwift
 import enum Result.NoError
+import RinglyExtensions
 
 /// A protocol for types that can write `SourcedUpdate` values to a store.
 public protocol SourcedUpdatesSink
@@ -14,3 +15,28 @@ public protocol SourcedUpdatesSink
     func writeSourcedUpdatesProducer(_ updatesProducer: SignalProducer<SourcedUpdate, NoError>)
         -> SignalProducer<(), NoError>
 }
+
+extension SignalProducerProtocol where Value == SourcedUpdate, Error == NoError
+{
+    // MARK: - Buffering Updates
+
+    /// Filters out updates without steps, or outside a reasonable time interval, then buffers the remaining updates to
+    /// group writes into transactions.
+    func bufferedForWriting() -> SignalProducer<[SourcedUpdate], NoError>
+    {
+        return self
+            // only include updates that have non-zero steps and are within a reasonable time interval
+            .filter({ sourced in
+                guard sourced.update.steps > 0 else {
+                    return false
+                }
+
+                let date = sourced.update.date.date
+
+                return abs(date.timeIntervalSinceNow) < 86400 * 30
+            })
+
+            // buffer to group writes into transactions
+            .buffer(limit: 100, timeout: .seconds(5), on: QueueScheduler.main)
+    }
+}
@@ -19,6 +19,19 @@ public protocol StepsDataSource
     func stepsDataProducer(startDate: Date, endDate: Date)
         -> SignalProducer<StepsData, NSError>
 
+    /**
+     A producer for the steps data between each of a set of boundary dates, such as the days of a week.
+
+     Data sources should answer all of the boundary dates with as few underlying queries as possible. A default
+     implementation, which combines a `stepsDataProducer(startDate:endDate:)` for each boundary dates value, is
+     provided.
+
+     - parameter boundaryDates: The boundary dates.
+
+     - returns: A producer yielding arrays with one element for each element of `boundaryDates`, in the same order.
+     */
+    func stepsDataProducer(boundaryDates: [BoundaryDates]) -> SignalProducer<[StepsData], NSError>
+
     // MARK: - Date Boundaries
 
     /**
@@ -31,6 +44,31 @@ public protocol StepsDataSource
     func stepsBoundaryDateProducer(ascending: Bool, startDate: Date, endDate: Date) -> SignalProducer<Date?, NSError>
 }
 
+extension StepsDataSource
+{
+    // MARK: - Multiple Boundary Dates
+    public func stepsDataProducer(boundaryDates: [BoundaryDates]) -> SignalProducer<[StepsData], NSError>
+    {
+        return individualStepsDataProducer(boundaryDates: boundaryDates)
+    }
+
+    /**
+     A producer for the steps data between each of a set of boundary dates, combining a
+     `stepsDataProducer(startDate:endDate:)` for each. Data sources can use this when they are unable to answer a
+     specific set of boundary dates with a single query.
+
+     - parameter boundaryDates: The boundary dates.
+     */
+    public func individualStepsDataProducer(boundaryDates: [BoundaryDates]) -> SignalProducer<[StepsData], NSError>
+    {
+        guard !boundaryDates.isEmpty else { return SignalProducer(value: []) }
+
+        return SignalProducer.combineLatest(boundaryDates.map({ dates in
+            stepsDataProducer(startDate: dates.start, endDate: dates.end)
+        }))
+    }
+}
+
 extension StepsDataSource
 {
     // MARK: - Counting Steps
@@ -47,4 +85,14 @@ extension StepsDataSource
     {
         return stepsDataProducer(startDate: startDate, endDate: endDate).map({ $0.steps })
     }
+
+    /**
+     A producer for the steps between each of a set of boundary dates.
+
+     - parameter boundaryDates: The boundary dates.
+     */
+    func stepsProducer(boundaryDates: [BoundaryDates]) -> SignalProducer<[Steps], NSError>
+    {
+        return stepsDataProducer(boundaryDates: boundaryDates).map({ data in data.map({ $0.steps }) })
+    }
 }
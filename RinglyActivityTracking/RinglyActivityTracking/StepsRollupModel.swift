@@ -0,0 +1,396 @@
+import RealmSwift
+
+/// A Realm model for the steps in an hour or a day, pre-aggregated from update models.
+///
+/// Rollups are maintained for each source, and for all sources combined. The combined rollups use the same per-minute
+/// semantics as `Steps.distinctMaxByMinuteSteps`: each minute contributes the update with the most steps, and if
+/// multiple updates for a minute have the same total, the update with the lowest MAC address.
+final class StepsRollupModel: Object
+{
+    // MARK: - Identifier
+
+    /**
+     Creates an identifier for a rollup model.
+
+     - parameter startMinute: The first minute of the rollup.
+     - parameter minuteCount: The number of minutes in the rollup.
+     - parameter macAddress:  The source MAC address, or `nil` for all sources.
+     */
+    @nonobjc static func identifier(startMinute: Int32, minuteCount: Int32, macAddress: Int64?) -> String
+    {
+        return "\(minuteCount):\(startMinute):\(macAddress.map({ String($0) }) ?? "*")"
+    }
+
+    /// The identifier (and primary key) for this model. This value should only be created with
+    /// `identifier(startMinute:minuteCount:macAddress:)`.
+    fileprivate(set) dynamic var identifier = ""
+
+    // MARK: - Metadata
+
+    /// The first minute of the rollup.
+    fileprivate(set) dynamic var startMinute: Int32 = 0
+
+    /// The number of minutes in the rollup - either `hourMinuteCount` or `dayMinuteCount`.
+    fileprivate(set) dynamic var minuteCount: Int32 = 0
+
+    /// The source MAC address for this rollup. If `allSources` is `true`, this value is ignored.
+    fileprivate(set) dynamic var macAddress: Int64 = 0
+
+    /// Whether or not this rollup combines all sources.
+    fileprivate(set) dynamic var allSources = false
+
+    // MARK: - Steps
+
+    /// The number of walking steps in the rollup.
+    dynamic var walkingStepCount = 0
+
+    /// The number of running steps in the rollup.
+    dynamic var runningStepCount = 0
+}
+
+extension StepsRollupModel
+{
+    // MARK: - Initialization
+
+    /**
+     Initializes an empty rollup model. The model's `identifier` is automatically determined.
+
+     - parameter startMinute: The first minute of the rollup.
+     - parameter minuteCount: The number of minutes in the rollup.
+     - parameter macAddress:  The source MAC address, or `nil` for all sources.
+     */
+    convenience init(startMinute: Int32, minuteCount: Int32, macAddress: Int64?)
+    {
+        self.init()
+
+        self.identifier = StepsRollupModel.identifier(
+            startMinute: startMinute,
+            minuteCount: minuteCount,
+            macAddress: macAddress
+        )
+
+        self.startMinute = startMinute
+        self.minuteCount = minuteCount
+        self.macAddress = macAddress ?? 0
+        self.allSources = macAddress == nil
+    }
+}
+
+extension StepsRollupModel
+{
+    // MARK: - Realm
+
+    /// The primary key for the rollup is `identifier`.
+    override static func primaryKey() -> String?
+    {
+        return "identifier"
+    }
+
+    /// Rollups are queried by ranges of start minutes.
+    override static func indexedProperties() -> [String]
+    {
+        return ["startMinute"]
+    }
+}
+
+extension StepsRollupModel
+{
+    // MARK: - Resolutions
+
+    /// The number of minutes in an hourly rollup.
+    @nonobjc static let hourMinuteCount: Int32 = 60
+
+    /// The number of minutes in a daily rollup.
+    @nonobjc static let dayMinuteCount: Int32 = 1440
+
+    /// The resolutions that rollups are maintained at.
+    @nonobjc static let minuteCounts = [hourMinuteCount, dayMinuteCount]
+}
+
+extension StepsRollupModel
+{
+    // MARK: - Querying
+
+    /**
+     Returns a predicate matching every rollup that contains a minute in a range. This may also match some hourly
+     rollups that do not, earlier on the day that the range starts.
+
+     - parameter minutes: The range of minutes.
+     */
+    @nonobjc static func predicate(containingMinutesIn minutes: Range<Int32>) -> NSPredicate
+    {
+        return NSPredicate(
+            format: "startMinute >= %d AND startMinute < %d",
+            minutes.lowerBound - minutes.lowerBound % dayMinuteCount,
+            minutes.upperBound
+        )
+    }
+}
+
+extension StepsRollupModel: StepsData {}
+
+// MARK: - Deltas
+
+/// Accumulates changes to rollups, so that each rollup is only looked up and written once per transaction.
+struct StepsRollupDeltas
+{
+    // MARK: - Deltas
+    fileprivate struct Key: Hashable
+    {
+        let startMinute: Int32
+        let minuteCount: Int32
+        let macAddress: Int64?
+
+        var hashValue: Int
+        {
+            return Int(startMinute) ^ Int(minuteCount) << 32 ^ (macAddress?.hashValue ?? 0)
+        }
+    }
+
+    fileprivate var deltas = [Key:Steps]()
+
+    /**
+     Adds a change in steps for a minute to each rollup containing that minute.
+
+     - parameter walkingStepCount: The change in walking steps.
+     - parameter runningStepCount: The change in running steps.
+     - parameter timestamp:        The minute.
+     - parameter macAddress:       The source MAC address, or `nil` for the combined rollups.
+     */
+    mutating func add(walkingStepCount: Int, runningStepCount: Int, timestamp: Int32, macAddress: Int64?)
+    {
+        guard walkingStepCount != 0 || runningStepCount != 0 else { return }
+
+        let delta = Steps(walkingStepCount: walkingStepCount, runningStepCount: runningStepCount)
+
+        for minuteCount in StepsRollupModel.minuteCounts
+        {
+            let key = Key(
+                startMinute: timestamp - timestamp % minuteCount,
+                minuteCount: minuteCount,
+                macAddress: macAddress
+            )
+
+            deltas[key] = (deltas[key] ?? Steps.zero) + delta
+        }
+    }
+
+    /**
+     Applies the accumulated changes to a Realm database. This must be called within a write transaction.
+
+     - parameter realm: The Realm database.
+     */
+    func apply(to realm: Realm)
+    {
+        for (key, delta) in deltas
+        {
+            let identifier = StepsRollupModel.identifier(
+                startMinute: key.startMinute,
+                minuteCount: key.minuteCount,
+                macAddress: key.macAddress
+            )
+
+            let model: StepsRollupModel
+
+            if let existing = realm.object(ofType: StepsRollupModel.self, forPrimaryKey: identifier)
+            {
+                model = existing
+            }
+            else
+            {
+                model = StepsRollupModel(
+                    startMinute: key.startMinute,
+                    minuteCount: key.minuteCount,
+                    macAddress: key.macAddress
+                )
+
+                realm.add(model)
+            }
+
+            model.walkingStepCount += delta.walkingStepCount
+            model.runningStepCount += delta.runningStepCount
+        }
+    }
+
+    /**
+     Creates rollups for the accumulated changes during a migration. This assumes that no rollups exist yet.
+
+     - parameter migration: The migration.
+     */
+    func create(in migration: RealmSwift.Migration)
+    {
+        for (key, delta) in deltas
+        {
+            let identifier = StepsRollupModel.identifier(
+                startMinute: key.startMinute,
+                minuteCount: key.minuteCount,
+                macAddress: key.macAddress
+            )
+
+            migration.create(StepsRollupModel.className(), value: [
+                "identifier": identifier,
+                "startMinute": key.startMinute,
+                "minuteCount": key.minuteCount,
+                "macAddress": key.macAddress ?? 0,
+                "allSources": key.macAddress == nil,
+                "walkingStepCount": delta.walkingStepCount,
+                "runningStepCount": delta.runningStepCount
+            ])
+        }
+    }
+}
+
+private func ==(lhs: StepsRollupDeltas.Key, rhs: StepsRollupDeltas.Key) -> Bool
+{
+    return lhs.startMinute == rhs.startMinute
+        && lhs.minuteCount == rhs.minuteCount
+        && lhs.macAddress == rhs.macAddress
+}
+
+// MARK: - Minute Maximums
+
+/// The update selected for a minute when combining sources.
+struct StepsRollupMinuteMaximum
+{
+    /// The steps of the selected update.
+    let steps: Steps
+
+    /// The source MAC address of the selected update.
+    let macAddress: Int64
+
+    /**
+     Returns `true` if the receiver should be selected over another update for the same minute.
+
+     - parameter other: The other update.
+     */
+    func isPreferred(to other: StepsRollupMinuteMaximum) -> Bool
+    {
+        return steps.stepCount > other.steps.stepCount
+            || (steps.stepCount == other.steps.stepCount && macAddress < other.macAddress)
+    }
+}
+
+// MARK: - Query Plan
+
+/// Splits a range of minutes into the segments that should be read from daily rollups, hourly rollups, and raw update
+/// models. At most two segments - one at each edge of the range - are read from update models.
+struct StepsRollupPlan
+{
+    // MARK: - Initialization
+
+    /**
+     Initializes a rollup plan.
+
+     - parameter startMinute: The first minute to include.
+     - parameter endMinute:   The minute after the last minute to include.
+     */
+    init(startMinute: Int32, endMinute: Int32)
+    {
+        let hour = StepsRollupModel.hourMinuteCount, day = StepsRollupModel.dayMinuteCount
+        let hourStart = StepsRollupPlan.ceil(startMinute, to: hour), hourEnd = StepsRollupPlan.floor(endMinute, to: hour)
+
+        guard hourStart < hourEnd else {
+            updateRanges = startMinute < endMinute ? [startMinute..<endMinute] : []
+            hourRanges = []
+            dayRange = nil
+            return
+        }
+
+        let updateRanges: [Range<Int32>] = [startMinute..<hourStart, hourEnd..<endMinute]
+        self.updateRanges = updateRanges.filter({ !$0.isEmpty })
+
+        let dayStart = StepsRollupPlan.ceil(hourStart, to: day), dayEnd = StepsRollupPlan.floor(hourEnd, to: day)
+
+        if dayStart < dayEnd
+        {
+            let hourRanges: [Range<Int32>] = [hourStart..<dayStart, dayEnd..<hourEnd]
+            self.hourRanges = hourRanges.filter({ !$0.isEmpty })
+            dayRange = dayStart..<dayEnd
+        }
+        else
+        {
+            hourRanges = [hourStart..<hourEnd]
+            dayRange = nil
+        }
+    }
+
+    // MARK: - Segments
+
+    /// The ranges of minutes to read from update models.
+    let updateRanges: [Range<Int32>]
+
+    /// The ranges of minutes to read from hourly rollups.
+    let hourRanges: [Range<Int32>]
+
+    /// The range of minutes to read from daily rollups, if any.
+    let dayRange: Range<Int32>?
+
+    // MARK: - Alignment
+    fileprivate static func floor(_ minute: Int32, to count: Int32) -> Int32
+    {
+        return minute - minute % count
+    }
+
+    fileprivate static func ceil(_ minute: Int32, to count: Int32) -> Int32
+    {
+        return floor(minute + count - 1, to: count)
+    }
+}
+
+// MARK: - Cumulative Rollups
+
+/// The rollups of a single size over a range of minutes, sorted by start minute, with cumulative step counts. The steps
+/// in any range of these rollups can be found with two binary searches, so a single read can answer many ranges.
+struct StepsRollupCumulativeSums
+{
+    // MARK: - Initialization
+
+    /**
+     Initializes cumulative sums.
+
+     - parameter rollups: The rollups, which must be sorted by start minute.
+     */
+    init<S: Sequence>(_ rollups: S) where S.Iterator.Element == StepsRollupModel
+    {
+        var walking = 0, running = 0
+
+        for rollup in rollups
+        {
+            walking += rollup.walkingStepCount
+            running += rollup.runningStepCount
+
+            startMinutes.append(rollup.startMinute)
+            walkingStepCounts.append(walking)
+            runningStepCounts.append(running)
+        }
+    }
+
+    // MARK: - Columns
+
+    /// The start minute of each rollup.
+    fileprivate var startMinutes = [Int32]()
+
+    /// The cumulative walking step count, up to and including each rollup, preceded by zero.
+    fileprivate var walkingStepCounts = [0]
+
+    /// The cumulative running step count, up to and including each rollup, preceded by zero.
+    fileprivate var runningStepCounts = [0]
+
+    // MARK: - Steps
+
+    /**
+     Returns the steps in the rollups starting within a range of minutes.
+
+     - parameter range: The range of start minutes.
+     */
+    func steps(startingIn range: Range<Int32>) -> Steps
+    {
+        let lower = startMinutes.lowerBoundIndex(of: range.lowerBound)
+        let upper = startMinutes.lowerBoundIndex(of: range.upperBound)
+
+        return Steps(
+            walkingStepCount: walkingStepCounts[upper] - walkingStepCounts[lower],
+            runningStepCount: runningStepCounts[upper] - runningStepCounts[lower]
+        )
+    }
+}
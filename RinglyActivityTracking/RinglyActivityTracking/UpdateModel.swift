@@ -93,6 +93,12 @@ extension UpdateModel
     {
         return "identifier"
     }
+
+    /// Updates are queried by minute, when writing, and when reading the edges of ranges not covered by rollups.
+    override static func indexedProperties() -> [String]
+    {
+        return ["timestamp"]
+    }
 }
 
 extension UpdateModel
@@ -0,0 +1,33 @@
+/// The result of writing activity tracking updates to a data store.
+public struct UpdatesWriteResult
+{
+    // MARK: - Initialization
+
+    /**
+     Initializes an `UpdatesWriteResult`.
+
+     - parameter written: The number of updates that were written.
+     - parameter skipped: The number of updates that were skipped.
+     */
+    public init(written: Int, skipped: Int)
+    {
+        self.written = written
+        self.skipped = skipped
+    }
+
+    // MARK: - Properties
+
+    /// The number of updates that were written, either as new records, or replacing records with fewer steps.
+    public let written: Int
+
+    /// The number of updates that were skipped, because an existing record or another update in the same write had at
+    /// least as many steps.
+    public let skipped: Int
+}
+
+extension UpdatesWriteResult: Equatable {}
+
+public func ==(lhs: UpdatesWriteResult, rhs: UpdatesWriteResult) -> Bool
+{
+    return lhs.written == rhs.written && lhs.skipped == rhs.skipped
+}
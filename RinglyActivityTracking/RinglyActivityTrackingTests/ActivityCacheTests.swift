@@ -0,0 +1,375 @@
+@testable import RinglyActivityTracking
+import Nimble
+import ReactiveSwift
+import Result
+import XCTest
+
+final class ActivityCacheTests: XCTestCase
+{
+    // MARK: - Setup
+    private var remove: [URL] = []
+
+    override func tearDown()
+    {
+        super.tearDown()
+        try! remove.forEach(FileManager.default.removeItem)
+        remove = []
+    }
+
+    private func makeCache(flushInterval: TimeInterval = 0.25) -> ActivityCache
+    {
+        return ActivityCache(fileURL: temporaryFileURL(), calendar: calendar, flushInterval: flushInterval)
+    }
+
+    private func temporaryFileURL() -> URL
+    {
+        let temporaryDirectory = URL(fileURLWithPath: NSTemporaryDirectory())
+            .appendingPathComponent("activitycachetests-\(arc4random())")
+
+        remove.append(temporaryDirectory)
+
+        try! FileManager.default.createDirectory(
+            at: temporaryDirectory,
+            withIntermediateDirectories: true,
+            attributes: nil
+        )
+
+        return temporaryDirectory.appendingPathComponent("cache.realm")
+    }
+
+    // MARK: - Dates
+    private let calendar: Calendar = {
+        var calendar = Calendar(identifier: .gregorian)
+        calendar.timeZone = TimeZone(identifier: "America/New_York")!
+        return calendar
+    }()
+
+    /// The boundary dates of consecutive days, starting on the day before daylight saving time ended in 2016.
+    private func days(from offset: Int = 0, count: Int) -> [BoundaryDates]
+    {
+        let start = calendar.date(from: DateComponents(year: 2016, month: 11, day: 5))!
+
+        return (offset..<(offset + count)).map({ index in
+            BoundaryDates(
+                start: calendar.date(byAdding: .day, value: index, to: start)!,
+                end: calendar.date(byAdding: .day, value: index + 1, to: start)!
+            )
+        })
+    }
+
+    /// Cache results are delivered on the main run loop, so they must be awaited rather than read synchronously.
+    private func expectCachedSteps(_ cache: ActivityCache,
+                                   boundaryDates: [BoundaryDates]? = nil,
+                                   toEventuallyEqual expected: [Steps])
+    {
+        var cached: [Steps]?
+
+        let disposable = cache.stepsProducer(boundaryDates: boundaryDates ?? days(count: expected.count))
+            .startWithValues({ cached = $0 })
+
+        expect(cached).toEventually(equal(expected))
+        disposable.dispose()
+    }
+
+    // MARK: - Writing
+    func testWritesAreCommitted()
+    {
+        let cache = makeCache()
+
+        cache.write(boundaryDates: days(count: 1)[0], steps: Steps(walkingStepCount: 5, runningStepCount: 1))
+        cache.write(boundaryDates: days(from: 2, count: 1)[0], steps: Steps(walkingStepCount: 7, runningStepCount: 0))
+        cache.waitForWrites()
+
+        expectCachedSteps(cache, toEventuallyEqual: [
+            Steps(walkingStepCount: 5, runningStepCount: 1),
+            Steps.zero,
+            Steps(walkingStepCount: 7, runningStepCount: 0)
+        ])
+    }
+
+    func testWritesToSameRecordAreCoalesced()
+    {
+        let cache = makeCache()
+
+        cache.write(boundaryDates: days(count: 1)[0], steps: Steps(walkingStepCount: 5, runningStepCount: 0))
+        cache.write(boundaryDates: days(count: 1)[0], steps: Steps(walkingStepCount: 9, runningStepCount: 0))
+        cache.waitForWrites()
+
+        expectCachedSteps(cache, toEventuallyEqual: [Steps(walkingStepCount: 9, runningStepCount: 0)])
+    }
+
+    func testWritesReplaceCommittedRecords()
+    {
+        let cache = makeCache()
+
+        cache.write(boundaryDates: days(count: 1)[0], steps: Steps(walkingStepCount: 5, runningStepCount: 0))
+        cache.waitForWrites()
+
+        cache.write(boundaryDates: days(count: 1)[0], steps: Steps(walkingStepCount: 3, runningStepCount: 0))
+        cache.waitForWrites()
+
+        expectCachedSteps(cache, toEventuallyEqual: [Steps(walkingStepCount: 3, runningStepCount: 0)])
+    }
+
+    func testWritesAreCommittedAfterFlushInterval()
+    {
+        let cache = makeCache(flushInterval: 0.05)
+
+        cache.write(boundaryDates: days(count: 1)[0], steps: Steps(walkingStepCount: 5, runningStepCount: 0))
+
+        expectCachedSteps(cache, toEventuallyEqual: [Steps(walkingStepCount: 5, runningStepCount: 0)])
+    }
+
+    // MARK: - Keys
+    func testRangesShareRecords()
+    {
+        let cache = makeCache()
+
+        days(count: 7).enumerated().forEach({ index, boundaryDates in
+            cache.write(boundaryDates: boundaryDates, steps: Steps(walkingStepCount: index + 1, runningStepCount: 0))
+        })
+
+        cache.waitForWrites()
+
+        // a different screen requesting an overlapping range
+        expectCachedSteps(cache, boundaryDates: days(from: 5, count: 3), toEventuallyEqual: [
+            Steps(walkingStepCount: 6, runningStepCount: 0),
+            Steps(walkingStepCount: 7, runningStepCount: 0),
+            Steps.zero
+        ])
+    }
+
+    func testAllStepsAreDatedAcrossDaylightSavingTime()
+    {
+        let cache = makeCache()
+        let days = self.days(count: 3)
+
+        days.forEach({ cache.write(boundaryDates: $0, steps: Steps(walkingStepCount: 1, runningStepCount: 0)) })
+        cache.waitForWrites()
+
+        expect(cache.stepsProducer().single()?.value?.map({ $0.0 })) == days.map({ $0.start })
+    }
+
+    func testHoursAreSeparateFromDays()
+    {
+        let cache = makeCache()
+        let day = days(count: 1)[0]
+        let hour = BoundaryDates(start: day.start, end: day.start.addingTimeInterval(3600))
+
+        cache.write(boundaryDates: day, steps: Steps(walkingStepCount: 100, runningStepCount: 0))
+        cache.write(boundaryDates: hour, steps: Steps(walkingStepCount: 10, runningStepCount: 0))
+        cache.waitForWrites()
+
+        expectCachedSteps(cache, boundaryDates: [day, hour], toEventuallyEqual: [
+            Steps(walkingStepCount: 100, runningStepCount: 0),
+            Steps(walkingStepCount: 10, runningStepCount: 0)
+        ])
+    }
+
+    func testRepeatedHourHasSeparateRecord()
+    {
+        let cache = makeCache()
+        let day = days(from: 1, count: 1)[0]
+
+        // clocks are set back at 2AM, so the second and third hours of the day are both 1AM
+        let hours = (1...2).map({ index in
+            BoundaryDates(
+                start: day.start.addingTimeInterval(Double(index) * 3600),
+                end: day.start.addingTimeInterval(Double(index + 1) * 3600)
+            )
+        })
+
+        cache.write(boundaryDates: hours[0], steps: Steps(walkingStepCount: 1, runningStepCount: 0))
+        cache.write(boundaryDates: hours[1], steps: Steps(walkingStepCount: 2, runningStepCount: 0))
+        cache.waitForWrites()
+
+        expectCachedSteps(cache, boundaryDates: hours, toEventuallyEqual: [
+            Steps(walkingStepCount: 1, runningStepCount: 0),
+            Steps(walkingStepCount: 2, runningStepCount: 0)
+        ])
+    }
+
+    func testRecordsFromAnotherTimeZoneAreNotRead()
+    {
+        let fileURL = temporaryFileURL()
+        let cache = ActivityCache(fileURL: fileURL, calendar: calendar)
+
+        cache.write(boundaryDates: days(count: 1)[0], steps: Steps(walkingStepCount: 5, runningStepCount: 0))
+        cache.waitForWrites()
+
+        // after relaunching in another time zone, the same calendar day has the same key, but a different interval
+        var relaunchedCalendar = calendar
+        relaunchedCalendar.timeZone = TimeZone(identifier: "America/Los_Angeles")!
+
+        let start = relaunchedCalendar.date(from: DateComponents(year: 2016, month: 11, day: 5))!
+        let day = BoundaryDates(start: start, end: relaunchedCalendar.date(byAdding: .day, value: 1, to: start)!)
+
+        let relaunched = ActivityCache(fileURL: fileURL, calendar: relaunchedCalendar)
+        expectCachedSteps(relaunched, boundaryDates: [day], toEventuallyEqual: [Steps.zero])
+
+        relaunched.write(boundaryDates: day, steps: Steps(walkingStepCount: 7, runningStepCount: 0))
+        relaunched.waitForWrites()
+        expectCachedSteps(relaunched, boundaryDates: [day], toEventuallyEqual: [
+            Steps(walkingStepCount: 7, runningStepCount: 0)
+        ])
+    }
+
+    func testOtherIntervalsAreNotCached()
+    {
+        let cache = makeCache()
+        let day = days(count: 1)[0]
+        let interval = BoundaryDates(start: day.start, end: day.start.addingTimeInterval(1800))
+
+        cache.write(boundaryDates: interval, steps: Steps(walkingStepCount: 1, runningStepCount: 0))
+        cache.waitForWrites()
+
+        expectCachedSteps(cache, boundaryDates: [interval], toEventuallyEqual: [Steps.zero])
+    }
+
+    // MARK: - Invalidation
+    func testInvalidateRemovesContainingDayAndHour()
+    {
+        let cache = makeCache()
+        let days = self.days(count: 2)
+        let hour = BoundaryDates(start: days[0].start, end: days[0].start.addingTimeInterval(3600))
+
+        days.forEach({ cache.write(boundaryDates: $0, steps: Steps(walkingStepCount: 5, runningStepCount: 0)) })
+        cache.write(boundaryDates: hour, steps: Steps(walkingStepCount: 1, runningStepCount: 0))
+        cache.waitForWrites()
+
+        cache.invalidate([
+            BoundaryDates(start: days[0].start.addingTimeInterval(600), end: days[0].start.addingTimeInterval(1200))
+        ])
+
+        cache.waitForWrites()
+
+        expectCachedSteps(cache, boundaryDates: days + [hour], toEventuallyEqual: [
+            Steps.zero,
+            Steps(walkingStepCount: 5, runningStepCount: 0),
+            Steps.zero
+        ])
+    }
+
+    func testInvalidateRemovesEveryOverlappedHour()
+    {
+        let cache = makeCache()
+        let day = days(count: 1)[0]
+
+        let hours = (0..<5).map({ index in
+            BoundaryDates(
+                start: day.start.addingTimeInterval(Double(index) * 3600),
+                end: day.start.addingTimeInterval(Double(index + 1) * 3600)
+            )
+        })
+
+        hours.forEach({ cache.write(boundaryDates: $0, steps: Steps(walkingStepCount: 5, runningStepCount: 0)) })
+        cache.waitForWrites()
+
+        // a single interval of three hours, as when consecutive written minutes are merged
+        cache.invalidate([BoundaryDates(start: hours[1].start, end: hours[3].end)])
+        cache.waitForWrites()
+
+        expectCachedSteps(cache, boundaryDates: hours, toEventuallyEqual: [
+            Steps(walkingStepCount: 5, runningStepCount: 0),
+            Steps.zero,
+            Steps.zero,
+            Steps.zero,
+            Steps(walkingStepCount: 5, runningStepCount: 0)
+        ])
+    }
+
+    func testInvalidateRemovesEveryOverlappedDay()
+    {
+        let cache = makeCache()
+        let days = self.days(count: 4)
+
+        days.forEach({ cache.write(boundaryDates: $0, steps: Steps(walkingStepCount: 5, runningStepCount: 0)) })
+        cache.waitForWrites()
+
+        cache.invalidate([BoundaryDates(start: days[0].start.addingTimeInterval(600), end: days[2].end)])
+        cache.waitForWrites()
+
+        expectCachedSteps(cache, boundaryDates: days, toEventuallyEqual: [
+            Steps.zero,
+            Steps.zero,
+            Steps.zero,
+            Steps(walkingStepCount: 5, runningStepCount: 0)
+        ])
+    }
+
+    func testInvalidateRemovesPendingWrites()
+    {
+        let cache = makeCache(flushInterval: 10)
+        let day = days(count: 1)[0]
+
+        cache.write(boundaryDates: day, steps: Steps(walkingStepCount: 5, runningStepCount: 0))
+        cache.invalidate([day])
+        cache.waitForWrites()
+
+        expectCachedSteps(cache, boundaryDates: [day], toEventuallyEqual: [Steps.zero])
+    }
+
+    func testInvalidatingStepsKeepsMindfulMinutes()
+    {
+        let cache = makeCache()
+        let day = days(count: 1)[0]
+
+        cache.write(boundaryDates: day, steps: Steps(walkingStepCount: 5, runningStepCount: 0))
+        cache.write(boundaryDates: day, mindfulMinutes: MindfulMinute(minuteCount: 3))
+        cache.waitForWrites()
+
+        cache.invalidate([day], kinds: .steps)
+        cache.waitForWrites()
+
+        expectCachedSteps(cache, boundaryDates: [day], toEventuallyEqual: [Steps.zero])
+
+        var minuteCounts: [Int]?
+
+        let disposable = cache.mindfulMinutesProducer(boundaryDates: [day])
+            .startWithValues({ minuteCounts = $0.map({ $0.minuteCount }) })
+
+        expect(minuteCounts).toEventually(equal([3]))
+        disposable.dispose()
+    }
+
+    func testEveryWriteToTheSameHourInvalidatesSteps()
+    {
+        let cache = makeCache()
+        let day = days(count: 1)[0]
+        let minute = BoundaryDates(start: day.start.addingTimeInterval(600), end: day.start.addingTimeInterval(660))
+        let (written, writtenObserver) = Signal<[BoundaryDates], NoError>.pipe()
+
+        cache.invalidateSteps(writtenIn: written)
+
+        for steps in 1...3
+        {
+            cache.write(boundaryDates: day, steps: Steps(walkingStepCount: steps, runningStepCount: 0))
+            cache.waitForWrites()
+            expectCachedSteps(cache, boundaryDates: [day], toEventuallyEqual: [
+                Steps(walkingStepCount: steps, runningStepCount: 0)
+            ])
+
+            // the same minute is written each time, as when a peripheral syncs more steps into a queued hour
+            writtenObserver.send(value: [minute])
+            cache.waitForWrites()
+            expectCachedSteps(cache, boundaryDates: [day], toEventuallyEqual: [Steps.zero])
+        }
+    }
+
+    // MARK: - Performance
+    func testWriteYearPerformance()
+    {
+        let cache = makeCache()
+
+        let year = days(count: 365)
+
+        measure {
+            for (index, boundaryDates) in year.enumerated()
+            {
+                cache.write(boundaryDates: boundaryDates, steps: Steps(walkingStepCount: index, runningStepCount: 0))
+            }
+
+            cache.waitForWrites()
+        }
+    }
+}
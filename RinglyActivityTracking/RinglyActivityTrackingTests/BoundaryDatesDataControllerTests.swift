@@ -0,0 +1,322 @@
+@testable import RinglyActivityTracking
+import Nimble
+import ReactiveSwift
+import Result
+import XCTest
+
+final class BoundaryDatesDataControllerTests: XCTestCase
+{
+    // MARK: - Setup
+    private var remove: [URL] = []
+
+    override func tearDown()
+    {
+        super.tearDown()
+        try! remove.forEach(FileManager.default.removeItem)
+        remove = []
+    }
+
+    private func makeCache() -> ActivityCache
+    {
+        let temporaryDirectory = URL(fileURLWithPath: NSTemporaryDirectory())
+            .appendingPathComponent("boundarydatesdatacontrollertests-\(arc4random())")
+
+        remove.append(temporaryDirectory)
+
+        try! FileManager.default.createDirectory(
+            at: temporaryDirectory,
+            withIntermediateDirectories: true,
+            attributes: nil
+        )
+
+        return ActivityCache(fileURL: temporaryDirectory.appendingPathComponent("cache.realm"))
+    }
+
+    /// Consecutive days, ending with today.
+    private func days(count: Int) -> [BoundaryDates]
+    {
+        let calendar = Calendar.current
+        let today = calendar.startOfDay(for: Date())
+
+        return (0..<count).map({ index in
+            let offset = index - count + 1
+
+            return BoundaryDates(
+                start: calendar.date(byAdding: .day, value: offset, to: today)!,
+                end: calendar.date(byAdding: .day, value: offset + 1, to: today)!
+            )
+        })
+    }
+
+    private func loadedController(dataSource: LatentStepsDataSource,
+                                  boundaryDates: [BoundaryDates],
+                                  maximumConcurrentQueries: Int,
+                                  maximumDatesPerQuery: Int = 1)
+        -> BoundaryDatesDataController
+    {
+        let controller = BoundaryDatesDataController(
+            dataSource: dataSource,
+            cache: makeCache(),
+            boundaryDates: boundaryDates,
+            maximumConcurrentQueries: maximumConcurrentQueries,
+            maximumDatesPerQuery: maximumDatesPerQuery
+        )
+
+        controller.queriesEnabled.value = true
+        return controller
+    }
+
+    private func allLoaded(_ controller: BoundaryDatesDataController) -> Bool
+    {
+        return !controller.steps.value.contains(where: { $0 == nil })
+    }
+
+    // MARK: - Concurrency
+    func testQueriesRunConcurrently()
+    {
+        let dataSource = LatentStepsDataSource(latency: 0.1)
+        let controller = loadedController(
+            dataSource: dataSource,
+            boundaryDates: days(count: 7),
+            maximumConcurrentQueries: 3
+        )
+
+        expect(self.allLoaded(controller)).toEventually(beTrue(), timeout: 2)
+        expect(dataSource.maximumConcurrentQueries) == 3
+    }
+
+    func testQueriesRunSeriallyWithMaximumOfOne()
+    {
+        let dataSource = LatentStepsDataSource(latency: 0.02)
+        let controller = loadedController(
+            dataSource: dataSource,
+            boundaryDates: days(count: 4),
+            maximumConcurrentQueries: 1
+        )
+
+        expect(self.allLoaded(controller)).toEventually(beTrue(), timeout: 2)
+        expect(dataSource.maximumConcurrentQueries) == 1
+    }
+
+    // MARK: - Batching
+    func testBatchesConsecutiveDates()
+    {
+        let dataSource = LatentStepsDataSource(latency: 0.02)
+        let days = self.days(count: 10)
+
+        let controller = loadedController(
+            dataSource: dataSource,
+            boundaryDates: days,
+            maximumConcurrentQueries: 1,
+            maximumDatesPerQuery: 4
+        )
+
+        expect(self.allLoaded(controller)).toEventually(beTrue(), timeout: 2)
+        expect(dataSource.batchSizes) == [2, 4, 4]
+        expect(dataSource.startDates) == [8, 9, 4, 5, 6, 7, 0, 1, 2, 3].map({ days[$0].start })
+    }
+
+    func testBatchesArePrioritizedByNearestIndex()
+    {
+        let dataSource = LatentStepsDataSource(latency: 0.02)
+        let days = self.days(count: 9)
+
+        let controller = BoundaryDatesDataController(
+            dataSource: dataSource,
+            cache: makeCache(),
+            boundaryDates: days,
+            maximumConcurrentQueries: 1,
+            maximumDatesPerQuery: 3
+        )
+
+        controller.prioritize(visibleIndices: 2..<3)
+        controller.queriesEnabled.value = true
+
+        expect(self.allLoaded(controller)).toEventually(beTrue(), timeout: 2)
+        expect(dataSource.batchSizes) == [3, 3, 3]
+        expect(dataSource.startDates) == days.map({ $0.start })
+    }
+
+    func testFailingDateOnlyFailsThatDate()
+    {
+        let days = self.days(count: 7)
+        let dataSource = LatentStepsDataSource(latency: 0.02, failingStartDates: [days[3].start])
+
+        let controller = loadedController(
+            dataSource: dataSource,
+            boundaryDates: days,
+            maximumConcurrentQueries: 1,
+            maximumDatesPerQuery: 7
+        )
+
+        expect(self.allLoaded(controller)).toEventually(beTrue(), timeout: 2)
+        expect(controller.steps.value.map({ $0?.error != nil })) == [false, false, false, true, false, false, false]
+    }
+
+    // MARK: - Priority
+    func testMostRecentDaysLoadFirstByDefault()
+    {
+        let dataSource = LatentStepsDataSource(latency: 0.02)
+        let days = self.days(count: 4)
+        let controller = loadedController(dataSource: dataSource, boundaryDates: days, maximumConcurrentQueries: 1)
+
+        expect(self.allLoaded(controller)).toEventually(beTrue(), timeout: 2)
+        expect(dataSource.startDates) == days.reversed().map({ $0.start })
+    }
+
+    func testVisibleDaysLoadFirst()
+    {
+        let dataSource = LatentStepsDataSource(latency: 0.02)
+        let days = self.days(count: 7)
+
+        let controller = BoundaryDatesDataController(
+            dataSource: dataSource,
+            cache: makeCache(),
+            boundaryDates: days,
+            maximumConcurrentQueries: 1,
+            maximumDatesPerQuery: 1
+        )
+
+        controller.prioritize(visibleIndices: 2..<3)
+        controller.queriesEnabled.value = true
+
+        expect(self.allLoaded(controller)).toEventually(beTrue(), timeout: 2)
+        expect(dataSource.startDates) == [2, 1, 3, 0, 4, 5, 6].map({ days[$0].start })
+    }
+
+    // MARK: - Cancellation
+    func testCancelledQueriesDoNotStart()
+    {
+        let dataSource = LatentStepsDataSource(latency: 0.02)
+        let days = self.days(count: 7)
+
+        let controller = BoundaryDatesDataController(
+            dataSource: dataSource,
+            cache: makeCache(),
+            boundaryDates: days,
+            maximumConcurrentQueries: 1,
+            maximumDatesPerQuery: 1
+        )
+
+        controller.cancelQueries(outside: 5..<7)
+        expect(controller.pendingQueryCount) == 2
+
+        controller.queriesEnabled.value = true
+
+        expect(controller.steps.value[5]).toEventuallyNot(beNil(), timeout: 2)
+        expect(controller.steps.value[6]).toNot(beNil())
+        expect(controller.pendingQueryCount) == 0
+        expect(dataSource.startDates) == [days[6].start, days[5].start]
+    }
+
+    // MARK: - Instrumentation
+    func testReportsQueryMetrics()
+    {
+        let dataSource = LatentStepsDataSource(latency: 0.05)
+
+        // metrics are sent on the data source's scheduler, so they are collected on a serial queue
+        let metricsQueue = DispatchQueue(label: "BoundaryDatesDataControllerTests")
+        var metrics = [ProducerQueueMetrics]()
+        let reportedMetrics = { metricsQueue.sync { metrics } }
+
+        let controller = BoundaryDatesDataController(
+            dataSource: dataSource,
+            cache: makeCache(),
+            boundaryDates: days(count: 2),
+            maximumConcurrentQueries: 1,
+            maximumDatesPerQuery: 1
+        )
+
+        controller.queryMetrics.observeValues({ value in metricsQueue.sync { metrics.append(value) } })
+        controller.queriesEnabled.value = true
+
+        expect(reportedMetrics().count).toEventually(equal(2), timeout: 2)
+
+        // the data source's latency is a lower bound on execution time, and the second query waits for the first
+        let reported = reportedMetrics()
+        expect(reported.map({ $0.offset })) == [1, 0]
+        expect(reported.contains(where: { $0.executionTime < 0.05 })) == false
+        expect(reported[1].waitTime) >= 0.05
+    }
+}
+
+/// A steps data source that yields zero steps for each query after a delay, recording the queries that it receives.
+/// Each query for multiple boundary dates is answered at once, and fails if any of its dates fails.
+private final class LatentStepsDataSource: StepsDataSource
+{
+    init(latency: TimeInterval, failingStartDates: Set<Date> = [])
+    {
+        self.latency = latency
+        self.failingStartDates = failingStartDates
+    }
+
+    let latency: TimeInterval
+
+    /// Queries including boundary dates with these start dates fail.
+    let failingStartDates: Set<Date>
+
+    private let lock = NSLock()
+    private var running = 0
+    private var _maximumConcurrentQueries = 0
+    private var _startDates = [Date]()
+    private var _batchSizes = [Int]()
+
+    /// Queries are started on background threads, so the recorded values are read while holding the lock.
+    private func locked<T>(_ value: () -> T) -> T
+    {
+        lock.lock()
+        defer { lock.unlock() }
+        return value()
+    }
+
+    var maximumConcurrentQueries: Int { return locked({ _maximumConcurrentQueries }) }
+    var startDates: [Date] { return locked({ _startDates }) }
+    var batchSizes: [Int] { return locked({ _batchSizes }) }
+
+    func stepsDataProducer(startDate: Date, endDate: Date) -> SignalProducer<StepsData, NSError>
+    {
+        return stepsDataProducer(boundaryDates: [BoundaryDates(start: startDate, end: endDate)]).map({ $0[0] })
+    }
+
+    func stepsDataProducer(boundaryDates: [BoundaryDates]) -> SignalProducer<[StepsData], NSError>
+    {
+        let steps: [StepsData] = boundaryDates.map({ _ in Steps.zero })
+        let fails = boundaryDates.contains(where: { failingStartDates.contains($0.start) })
+
+        let producer: SignalProducer<[StepsData], NSError> = fails
+            ? SignalProducer(error: NSError(domain: "LatentStepsDataSource", code: 0, userInfo: nil))
+            : SignalProducer(value: steps)
+
+        // the query is finished before its value is forwarded, which may start the next query
+        let finished: () -> () = { [weak self] in
+            guard let strong = self else { return }
+
+            strong.lock.lock()
+            strong.running -= 1
+            strong.lock.unlock()
+        }
+
+        return producer
+            .delay(latency, on: QueueScheduler())
+            .on(started: { [weak self] in
+                guard let strong = self else { return }
+
+                strong.lock.lock()
+                strong.running += 1
+                strong._maximumConcurrentQueries = max(strong._maximumConcurrentQueries, strong.running)
+                strong._startDates.append(contentsOf: boundaryDates.map({ $0.start }))
+                strong._batchSizes.append(boundaryDates.count)
+                strong.lock.unlock()
+            }, failed: { _ in finished() }, value: { _ in finished() })
+    }
+
+    func stepsBoundaryDateProducer(ascending: Bool) -> SignalProducer<Date?, NSError>
+    {
+        return SignalProducer(value: nil)
+    }
+
+    func stepsBoundaryDateProducer(ascending: Bool, startDate: Date, endDate: Date) -> SignalProducer<Date?, NSError>
+    {
+        return SignalProducer(value: nil)
+    }
+}
@@ -0,0 +1,333 @@
+@testable import RinglyActivityTracking
+import Nimble
+import RealmSwift
+import RinglyKit
+import XCTest
+
+final class ColumnarStepsStoreTests: XCTestCase
+{
+    // MARK: - Setup
+    private var remove: [URL] = []
+
+    override func tearDown()
+    {
+        super.tearDown()
+        try! remove.forEach(FileManager.default.removeItem)
+        remove = []
+    }
+
+    private func temporaryDirectory() -> URL
+    {
+        let temporaryDirectory = URL(fileURLWithPath: NSTemporaryDirectory())
+            .appendingPathComponent("columnarstepsstoretests-\(arc4random())")
+
+        remove.append(temporaryDirectory)
+
+        try! FileManager.default.createDirectory(
+            at: temporaryDirectory,
+            withIntermediateDirectories: true,
+            attributes: nil
+        )
+
+        return temporaryDirectory
+    }
+
+    private func makeStore() -> ColumnarStepsStore
+    {
+        return ColumnarStepsStore(directoryURL: temporaryDirectory().appendingPathComponent("steps"), logFunction: nil)
+    }
+
+    private func makeRealm() -> Realm
+    {
+        let realmFile = temporaryDirectory().appendingPathComponent("test.realm")
+        return try! Realm(configuration: RealmService.configuration(fileURL: realmFile, logFunction: nil))
+    }
+
+    // MARK: - Updates
+    private func update(minute: Int, walking: RLYActivityTrackingSteps, running: RLYActivityTrackingSteps = 0,
+                        macAddress: Int64 = 1)
+        -> SourcedUpdate
+    {
+        return SourcedUpdate(
+            macAddress: macAddress,
+            update: RLYActivityTrackingUpdate(
+                date: try! RLYActivityTrackingDate(minute: RLYActivityTrackingMinute(minute)),
+                walkingSteps: walking,
+                runningSteps: running
+            )
+        )
+    }
+
+    /// An arbitrary day-aligned minute to start test data at.
+    private let base = 1440 * 700
+
+    // MARK: - Writing
+    func testWriteResult()
+    {
+        let store = makeStore()
+
+        let first = [update(minute: base, walking: 5), update(minute: base + 1, walking: 6)]
+        expect(try! store.write(first)) == UpdatesWriteResult(written: 2, skipped: 0)
+
+        let second = [update(minute: base, walking: 3), update(minute: base + 1, walking: 8)]
+        expect(try! store.write(second)) == UpdatesWriteResult(written: 1, skipped: 1)
+    }
+
+    func testWritesOnlyChangedMinutes()
+    {
+        let store = makeStore()
+        let start = RLYActivityTrackingMinute(base)
+
+        _ = try! store.write([update(minute: base, walking: 5, running: 1), update(minute: base + 2, walking: 7)])
+        _ = try! store.write([
+            update(minute: base + 1, walking: 2),
+            update(minute: base + 2, walking: 8, running: 1),
+            update(minute: base + 1439, walking: 3)
+        ])
+
+        expect(store.steps(startMinute: start, endMinute: start + 1440, macAddress: nil))
+            == Steps(walkingStepCount: 18, runningStepCount: 2)
+        expect(store.steps(startMinute: start, endMinute: start + 1, macAddress: nil))
+            == Steps(walkingStepCount: 5, runningStepCount: 1)
+    }
+
+    func testPartitionsWrittenAfterQueryingAreIndexed()
+    {
+        let store = makeStore()
+        let start = RLYActivityTrackingMinute(base)
+
+        // loads the partition index while it is empty
+        expect(store.steps(startMinute: start, endMinute: start + 2880, macAddress: nil)) == Steps.zero
+
+        _ = try! store.write([update(minute: base + 1440, walking: 5, macAddress: 2)])
+
+        expect(store.steps(startMinute: start, endMinute: start + 2880, macAddress: nil))
+            == Steps(walkingStepCount: 5, runningStepCount: 0)
+        expect(store.boundaryMinute(ascending: true, minutes: nil, macAddress: 2)) == start + 1440
+    }
+
+    func testPartitionsAreIndexedAcrossStores()
+    {
+        let store = makeStore()
+        _ = try! store.write([update(minute: base, walking: 5)])
+
+        let reopened = ColumnarStepsStore(directoryURL: store.directoryURL, logFunction: nil)
+        let start = RLYActivityTrackingMinute(base)
+
+        expect(reopened.steps(startMinute: start, endMinute: start + 1, macAddress: nil))
+            == Steps(walkingStepCount: 5, runningStepCount: 0)
+    }
+
+    func testPartitionKeyHashMixesValues()
+    {
+        expect(PartitionKey(macAddress: 1, day: 2).hashValue) != PartitionKey(macAddress: 2, day: 1).hashValue
+        expect(PartitionKey(macAddress: 5, day: 5).hashValue) != PartitionKey(macAddress: 0, day: 0).hashValue
+    }
+
+    func testStepsInRange()
+    {
+        let store = makeStore()
+
+        _ = try! store.write([
+            update(minute: base, walking: 5, running: 1),
+            update(minute: base + 1, walking: 6),
+            update(minute: base + 1440 + 10, walking: 7, running: 2)
+        ])
+
+        let start = RLYActivityTrackingMinute(base)
+
+        expect(store.steps(startMinute: start, endMinute: start + 1, macAddress: nil))
+            == Steps(walkingStepCount: 5, runningStepCount: 1)
+
+        expect(store.steps(startMinute: start, endMinute: start + 2880, macAddress: nil))
+            == Steps(walkingStepCount: 18, runningStepCount: 3)
+
+        expect(store.steps(startMinute: start + 1, endMinute: start + 1450, macAddress: nil))
+            == Steps(walkingStepCount: 6, runningStepCount: 0)
+
+        expect(store.steps(startMinute: start + 5, endMinute: start + 5, macAddress: nil)) == Steps.zero
+    }
+
+    func testMaximumAcrossSources()
+    {
+        let store = makeStore()
+
+        _ = try! store.write([
+            update(minute: base, walking: 5, macAddress: 1),
+            update(minute: base, walking: 9, macAddress: 2),
+            update(minute: base + 1, walking: 4, macAddress: 2)
+        ])
+
+        let start = RLYActivityTrackingMinute(base)
+
+        expect(store.steps(startMinute: start, endMinute: start + 10, macAddress: nil))
+            == Steps(walkingStepCount: 13, runningStepCount: 0)
+
+        expect(store.steps(startMinute: start, endMinute: start + 10, macAddress: 1))
+            == Steps(walkingStepCount: 5, runningStepCount: 0)
+    }
+
+    func testBoundaryMinutes()
+    {
+        let store = makeStore()
+
+        _ = try! store.write([
+            update(minute: base + 30, walking: 5, macAddress: 1),
+            update(minute: base + 2000, walking: 5, macAddress: 2),
+            update(minute: base + 5000, walking: 5, macAddress: 1)
+        ])
+
+        let start = RLYActivityTrackingMinute(base)
+
+        expect(store.boundaryMinute(ascending: true, minutes: nil, macAddress: nil)) == start + 30
+        expect(store.boundaryMinute(ascending: false, minutes: nil, macAddress: nil)) == start + 5000
+        expect(store.boundaryMinute(ascending: true, minutes: nil, macAddress: 2)) == start + 2000
+        expect(store.boundaryMinute(ascending: true, minutes: (start + 31)...(start + 4999), macAddress: nil))
+            == start + 2000
+        expect(store.boundaryMinute(ascending: false, minutes: (start + 31)...(start + 1999), macAddress: nil))
+            .to(beNil())
+    }
+
+    func testAutoUpdatingProducer()
+    {
+        let store = makeStore()
+        let startDate = RLYActivityTrackingMinuteToNSDate(RLYActivityTrackingMinute(base))
+        let endDate = startDate.addingTimeInterval(86400)
+
+        var values = [Int]()
+        let disposable = store.stepsDataProducer(startDate: startDate, endDate: endDate)
+            .startWithResult({ values.append($0.value?.stepCount ?? -1) })
+
+        store.writeSourcedUpdates([update(minute: base, walking: 5)]).start()
+
+        expect(values).toEventually(equal([0, 5]))
+        disposable.dispose()
+    }
+
+    // MARK: - Realm Equivalence
+    func testMatchesRealm()
+    {
+        let store = makeStore()
+        let realm = makeRealm()
+
+        // overlapping sources, with varying step counts, across several days - running steps are derived from walking
+        // steps so that no two different updates have the same total, which would make the maximum ambiguous
+        let updates = (0..<5000).map({ index -> SourcedUpdate in
+            let walking = (index * 13) % 50
+
+            return update(
+                minute: base + (index * 7) % 2000,
+                walking: RLYActivityTrackingSteps(walking),
+                running: RLYActivityTrackingSteps(walking % 3),
+                macAddress: Int64(index % 3)
+            )
+        })
+
+        _ = try! store.write(updates)
+
+        try! realm.write {
+            _ = RealmService.upsert(updates.map(UpdateModel.init), in: realm)
+        }
+
+        let start = RLYActivityTrackingMinute(base)
+        let ranges = [(0, 2000), (0, 1440), (100, 200), (1439, 1441), (1500, 1999)]
+
+        for (lower, upper) in ranges
+        {
+            for macAddress in [nil, 0, 1] as [Int64?]
+            {
+                let predicate = macAddress.map({ NSPredicate(format: "macAddress == %lld", $0) })
+                let models = RealmService.updateModels(
+                    in: realm,
+                    startMinute: start + RLYActivityTrackingMinute(lower),
+                    endMinute: start + RLYActivityTrackingMinute(upper),
+                    predicate: predicate
+                )
+
+                let columnar = store.steps(
+                    startMinute: start + RLYActivityTrackingMinute(lower),
+                    endMinute: start + RLYActivityTrackingMinute(upper),
+                    macAddress: macAddress
+                )
+
+                expect(columnar) == Steps.distinctMaxByMinuteSteps(timestampGroupedSteps: models)
+            }
+        }
+    }
+
+    // MARK: - Performance
+    private static let yearMinutes = 365 * 1440
+
+    /// A year of updates from two sources, with steps in every fifth minute.
+    private func yearOfUpdates() -> [SourcedUpdate]
+    {
+        return stride(from: 0, to: ColumnarStepsStoreTests.yearMinutes, by: 5).map({ offset in
+            update(
+                minute: base + offset,
+                walking: RLYActivityTrackingSteps(offset % 40),
+                running: RLYActivityTrackingSteps(offset % 7),
+                macAddress: Int64(offset % 2)
+            )
+        })
+    }
+
+    private func measureColumnar(minutes: Int)
+    {
+        let store = makeStore()
+        _ = try! store.write(yearOfUpdates())
+
+        let start = RLYActivityTrackingMinute(base + ColumnarStepsStoreTests.yearMinutes - minutes)
+        let end = RLYActivityTrackingMinute(base + ColumnarStepsStoreTests.yearMinutes)
+
+        measure {
+            _ = store.steps(startMinute: start, endMinute: end, macAddress: nil)
+        }
+    }
+
+    private func measureRealm(minutes: Int)
+    {
+        let realm = makeRealm()
+
+        try! realm.write {
+            _ = RealmService.upsert(yearOfUpdates().map(UpdateModel.init), in: realm)
+        }
+
+        let start = RLYActivityTrackingMinute(base + ColumnarStepsStoreTests.yearMinutes - minutes)
+        let end = RLYActivityTrackingMinute(base + ColumnarStepsStoreTests.yearMinutes)
+
+        measure {
+            let models = RealmService.updateModels(in: realm, startMinute: start, endMinute: end, predicate: nil)
+            _ = Steps.distinctMaxByMinuteSteps(timestampGroupedSteps: models)
+        }
+    }
+
+    func testColumnarDayPerformance()
+    {
+        measureColumnar(minutes: 1440)
+    }
+
+    func testColumnarWeekPerformance()
+    {
+        measureColumnar(minutes: 1440 * 7)
+    }
+
+    func testColumnarYearPerformance()
+    {
+        measureColumnar(minutes: ColumnarStepsStoreTests.yearMinutes)
+    }
+
+    func testRealmDayPerformance()
+    {
+        measureRealm(minutes: 1440)
+    }
+
+    func testRealmWeekPerformance()
+    {
+        measureRealm(minutes: 1440 * 7)
+    }
+
+    func testRealmYearPerformance()
+    {
+        measureRealm(minutes: ColumnarStepsStoreTests.yearMinutes)
+    }
+}
@@ -0,0 +1,200 @@
+@testable import RinglyActivityTracking
+import HealthKit
+import Nimble
+import ReactiveSwift
+import RealmSwift
+import Result
+import RinglyKit
+import XCTest
+
+final class HealthKitExportTests: XCTestCase
+{
+    // MARK: - Setup
+    private var service: RealmService!
+    private var sink: RecordingHealthKitSaveSink!
+
+    /// Holds the in-memory Realm open, so that data persists between the service's producers.
+    private var realm: Realm!
+
+    override func setUp()
+    {
+        super.setUp()
+
+        let configuration = Realm.Configuration(
+            inMemoryIdentifier: "HealthKitExportTests-\(arc4random())",
+            objectTypes: [HealthKitQueuedUpdateModel.self, UpdateModel.self, StepsRollupModel.self,
+                          UpdateMindfulnessSession.self, MindfulnessSession.self]
+        )
+
+        realm = try! Realm(configuration: configuration)
+        service = RealmService(configuration: configuration, logFunction: nil)
+        sink = RecordingHealthKitSaveSink()
+    }
+
+    override func tearDown()
+    {
+        service = nil
+        sink = nil
+        realm = nil
+        super.tearDown()
+    }
+
+    // MARK: - Updates
+
+    /// An arbitrary hour-aligned minute to start test data at.
+    private let base: RLYActivityTrackingMinute = 1_000_020
+
+    /// Writes updates with one step every five minutes, for the specified minute offsets from `base`.
+    private func write(minutes: CountableRange<RLYActivityTrackingMinute>)
+    {
+        let updates = stride(from: minutes.lowerBound, to: minutes.upperBound, by: 5).map({ offset in
+            SourcedUpdate(
+                macAddress: 1,
+                update: RLYActivityTrackingUpdate(
+                    date: try! RLYActivityTrackingDate(minute: base + offset),
+                    walkingSteps: 1,
+                    runningSteps: 0
+                )
+            )
+        })
+
+        _ = service.writeSourcedUpdates(updates).single()
+    }
+
+    private var queuedCount: Int
+    {
+        realm.refresh()
+        return realm.objects(HealthKitQueuedUpdateModel.self).count
+    }
+
+    private var savedSamples: [HKQuantitySample]
+    {
+        return sink.saveRequests.joined().flatMap({ $0 as? HKQuantitySample })
+    }
+
+    // MARK: - Blocks
+    func testBlocksAreAlignedAndSorted()
+    {
+        let blocks = HealthKitExportBlock.blocks(containing: [13, 6, 11, 0, 5, 12])
+
+        expect(blocks.map({ $0.timeValues })) == [0..<6, 6..<12, 12..<18]
+    }
+
+    // MARK: - Exporting
+    func testExportsEachBlockAsOneSampleWithOneDeleteAndOneSave()
+    {
+        write(minutes: 0..<120)
+        expect(self.queuedCount) == 12
+
+        let disposable = service.clearHealthKitQueuedUpdates(to: sink, logFunction: { _ in }).start()
+        defer { disposable.dispose() }
+
+        expect(self.queuedCount).toEventually(equal(0), timeout: 2)
+        expect(self.sink.saveRequests.count) == 1
+        expect(self.sink.deleteRequests.count) == 1
+
+        // each block replaces the samples that could start at each of its six time values, and the samples for each
+        // of its time values written individually
+        expect(self.sink.deleteRequests.first?.count) == 24
+        expect(self.savedSamples.map({ $0.stepCount })) == [12, 12]
+        expect(self.savedSamples.map({ $0.startDate })) == [0, 60].map({ self.date(offset: $0) })
+        expect(self.savedSamples.map({ $0.endDate })) == [60, 120].map({ self.date(offset: $0) })
+    }
+
+    func testSampleSpansOnlyTimeValuesWithSteps()
+    {
+        write(minutes: 20..<40)
+
+        let disposable = service.clearHealthKitQueuedUpdates(to: sink, logFunction: { _ in }).start()
+        defer { disposable.dispose() }
+
+        expect(self.queuedCount).toEventually(equal(0), timeout: 2)
+        expect(self.savedSamples.map({ $0.startDate })) == [date(offset: 20)]
+        expect(self.savedSamples.map({ $0.endDate })) == [date(offset: 40)]
+    }
+
+    func testSamplesAreSplitAtIdleGaps()
+    {
+        write(minutes: 0..<20)
+        write(minutes: 40..<60)
+
+        let disposable = service.clearHealthKitQueuedUpdates(to: sink, logFunction: { _ in }).start()
+        defer { disposable.dispose() }
+
+        expect(self.queuedCount).toEventually(equal(0), timeout: 2)
+        expect(self.savedSamples.map({ $0.stepCount })) == [4, 4]
+        expect(self.savedSamples.map({ $0.startDate })) == [0, 40].map({ self.date(offset: $0) })
+        expect(self.savedSamples.map({ $0.endDate })) == [20, 60].map({ self.date(offset: $0) })
+        expect(Set(self.savedSamples.flatMap({ $0.metadata?[HKMetadataKeyExternalUUID] as? String })).count) == 2
+    }
+
+    func testDebouncesBusySync()
+    {
+        let disposable = service.writeProducer(
+            to: sink,
+            debounceInterval: 0.3,
+            on: QueueScheduler.main,
+            logFunction: { _ in }
+        ).start()
+
+        defer { disposable.dispose() }
+
+        write(minutes: 0..<20)
+        write(minutes: 20..<40)
+        write(minutes: 100..<120)
+
+        expect(self.sink.saveRequests.count).toEventually(equal(1), timeout: 2)
+        expect(self.queuedCount).toEventually(equal(0), timeout: 2)
+        expect(self.savedSamples.count) == 2
+
+        // give any repeated exports time to start
+        RunLoop.current.run(until: Date(timeIntervalSinceNow: 0.5))
+        expect(self.sink.roundTrips) == 2
+    }
+
+    private func date(offset: RLYActivityTrackingMinute) -> Date
+    {
+        return RLYActivityTrackingMinuteToNSDate(base + offset)
+    }
+}
+
+/// A HealthKit save sink that records the requests that it receives, without saving anything.
+private final class RecordingHealthKitSaveSink: HealthKitSaveSink
+{
+    // MARK: - Requests
+    private(set) var saveRequests = [[HKObject]]()
+    private(set) var deleteRequests = [[String]]()
+
+    /// The total number of requests made to the sink.
+    var roundTrips: Int
+    {
+        return saveRequests.count + deleteRequests.count
+    }
+
+    // MARK: - Health Kit Save Sink
+    var stepsAuthorizationStatusProducer: SignalProducer<HKAuthorizationStatus, NoError>
+    {
+        return SignalProducer(value: .sharingAuthorized)
+    }
+
+    var mindfulMinuteAuthorizationStatusProducer: SignalProducer<HKAuthorizationStatus, NoError>
+    {
+        return SignalProducer(value: .sharingAuthorized)
+    }
+
+    func saveObjectsProducer(_ objects: [HKObject]) -> SignalProducer<(), NSError>
+    {
+        return SignalProducer { observer, _ in
+            self.saveRequests.append(objects)
+            observer.sendCompleted()
+        }
+    }
+
+    func deleteObjectsProducer(UUIDStrings: [String], type: HKObjectType) -> SignalProducer<(), NSError>
+    {
+        return SignalProducer { observer, _ in
+            self.deleteRequests.append(UUIDStrings)
+            observer.sendCompleted()
+        }
+    }
+}
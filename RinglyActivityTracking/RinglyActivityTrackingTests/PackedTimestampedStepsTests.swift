@@ -0,0 +1,143 @@
+@testable import RinglyActivityTracking
+import Nimble
+import XCTest
+
+final class PackedTimestampedStepsTests: XCTestCase
+{
+    // MARK: - Data
+
+    /// A week of minutes, with data from the specified number of sources. Each source is missing some minutes, and
+    /// sources are interleaved in timestamp order, as they are in sorted fetch results.
+    private func steps(sources: Int, minutes: Int = 7 * 1440) -> [TimestampedSteps]
+    {
+        var steps = [TimestampedSteps]()
+        steps.reserveCapacity(sources * minutes)
+
+        for minute in 0..<minutes
+        {
+            for source in 0..<sources where (minute + source) % 11 != 0
+            {
+                let walking = (minute * 7 + source * 13) % 60
+
+                steps.append(TimestampedSteps(
+                    timestamp: Int32(minute),
+                    walkingStepCount: walking,
+                    runningStepCount: (minute + source) % 5
+                ))
+            }
+        }
+
+        return steps
+    }
+
+    // MARK: - Equivalence
+    func testEmptyStepsAreZero()
+    {
+        expect(Steps.distinctMaxByMinuteSteps(packed: PackedTimestampedSteps())) == Steps.zero
+    }
+
+    func testSingleElement()
+    {
+        var packed = PackedTimestampedSteps()
+        packed.append(timestamp: 4, walkingStepCount: 10, runningStepCount: 3)
+
+        expect(Steps.distinctMaxByMinuteSteps(packed: packed)) == Steps(walkingStepCount: 10, runningStepCount: 3)
+    }
+
+    func testMatchesSequentialMerge()
+    {
+        for sources in 1...4
+        {
+            let steps = self.steps(sources: sources, minutes: 1000)
+
+            expect(Steps.distinctMaxByMinuteSteps(packed: PackedTimestampedSteps(steps)))
+                == Steps.distinctMaxByMinuteSteps(timestampGroupedSteps: steps)
+        }
+    }
+
+    func testMatchesSequentialMergeWithTies()
+    {
+        let steps = [
+            TimestampedSteps(timestamp: 0, walkingStepCount: 5, runningStepCount: 5),
+            TimestampedSteps(timestamp: 0, walkingStepCount: 10, runningStepCount: 0),
+            TimestampedSteps(timestamp: 1, walkingStepCount: 1, runningStepCount: 0),
+            TimestampedSteps(timestamp: 2, walkingStepCount: 0, runningStepCount: 4),
+            TimestampedSteps(timestamp: 2, walkingStepCount: 4, runningStepCount: 0)
+        ]
+
+        expect(Steps.distinctMaxByMinuteSteps(packed: PackedTimestampedSteps(steps)))
+            == Steps(walkingStepCount: 6, runningStepCount: 9)
+
+        expect(Steps.distinctMaxByMinuteSteps(packed: PackedTimestampedSteps(steps)))
+            == Steps.distinctMaxByMinuteSteps(timestampGroupedSteps: steps)
+    }
+
+    func testTimestampRangesMatchFilteredSteps()
+    {
+        let steps = self.steps(sources: 3, minutes: 200)
+        let packed = PackedTimestampedSteps(steps)
+        let ranges: [Range<Int32>] = [0..<200, 0..<1, 10..<11, 17..<95, 150..<400, -5..<3, 300..<400, 40..<40]
+
+        for range in ranges
+        {
+            expect(Steps.distinctMaxByMinuteSteps(packed: packed, timestamps: range))
+                == Steps.distinctMaxByMinuteSteps(timestampGroupedSteps: steps.filter({ range.contains($0.timestamp) }))
+        }
+    }
+
+    // MARK: - Performance
+    private func measurePacked(sources: Int)
+    {
+        let packed = PackedTimestampedSteps(steps(sources: sources))
+
+        measure {
+            _ = Steps.distinctMaxByMinuteSteps(packed: packed)
+        }
+    }
+
+    private func measureSequential(sources: Int)
+    {
+        let steps = self.steps(sources: sources)
+
+        measure {
+            _ = Steps.distinctMaxByMinuteSteps(timestampGroupedSteps: steps)
+        }
+    }
+
+    func testPackedOneSourcePerformance()
+    {
+        measurePacked(sources: 1)
+    }
+
+    func testPackedTwoSourcesPerformance()
+    {
+        measurePacked(sources: 2)
+    }
+
+    func testPackedFourSourcesPerformance()
+    {
+        measurePacked(sources: 4)
+    }
+
+    func testSequentialOneSourcePerformance()
+    {
+        measureSequential(sources: 1)
+    }
+
+    func testSequentialTwoSourcesPerformance()
+    {
+        measureSequential(sources: 2)
+    }
+
+    func testSequentialFourSourcesPerformance()
+    {
+        measureSequential(sources: 4)
+    }
+}
+
+private struct TimestampedSteps: TimestampedStepsData
+{
+    let timestamp: Int32
+    let walkingStepCount: Int
+    let runningStepCount: Int
+}
@@ -0,0 +1,173 @@
+@testable import RinglyActivityTracking
+import Nimble
+import ReactiveSwift
+import Result
+import XCTest
+
+final class ProducerQueueTests: XCTestCase
+{
+    // MARK: - Setup
+
+    /// Creates a queue of producers that do not send values until their observers are sent values.
+    private func makeQueue(count: Int, maximumProducersStarted: Int)
+        -> (ProducerQueue<Int, NoError>, [Observer<Int, NoError>], () -> [Int])
+    {
+        let pipes = (0..<count).map({ _ in Signal<Int, NoError>.pipe() })
+        var started = [Int]()
+
+        let queue = ProducerQueue(
+            content: 0..<count,
+            maximumProducersStarted: maximumProducersStarted,
+            makeProducer: { index -> SignalProducer<Int, NoError> in
+                started.append(index)
+                return SignalProducer(signal: pipes[index].0)
+            }
+        )
+
+        return (queue, pipes.map({ $0.1 }), { started })
+    }
+
+    // MARK: - Concurrency
+    func testStartsOneProducerByDefault()
+    {
+        let (queue, observers, started) = makeQueue(count: 3, maximumProducersStarted: 1)
+        queue.draining = true
+
+        expect(started()) == [0]
+
+        observers[0].send(value: 0)
+        expect(started()) == [0, 1]
+
+        observers[1].sendCompleted()
+        expect(started()) == [0, 1, 2]
+    }
+
+    func testStartsUpToMaximumProducers()
+    {
+        let (queue, observers, started) = makeQueue(count: 5, maximumProducersStarted: 3)
+        queue.draining = true
+
+        expect(started()) == [0, 1, 2]
+
+        observers[1].send(value: 1)
+        expect(started()) == [0, 1, 2, 3]
+
+        observers[0].sendInterrupted()
+        expect(started()) == [0, 1, 2, 3, 4]
+    }
+
+    func testDoesNotStartProducersUntilDraining()
+    {
+        let (queue, _, started) = makeQueue(count: 3, maximumProducersStarted: 2)
+
+        expect(started()) == []
+
+        queue.draining = true
+        expect(started()) == [0, 1]
+    }
+
+    func testStopsStartingProducersWhenNotDraining()
+    {
+        let (queue, observers, started) = makeQueue(count: 3, maximumProducersStarted: 1)
+        queue.draining = true
+        queue.draining = false
+
+        observers[0].send(value: 0)
+        expect(started()) == [0]
+
+        queue.draining = true
+        expect(started()) == [0, 1]
+    }
+
+    func testSynchronousProducersDrainQueue()
+    {
+        var values = [Int]()
+
+        let queue = ProducerQueue(
+            content: 0..<100,
+            maximumProducersStarted: 2,
+            makeProducer: { index -> SignalProducer<Int, NoError> in
+                SignalProducer(value: index).on(value: { values.append($0) })
+            }
+        )
+
+        queue.draining = true
+        expect(values) == Array(0..<100)
+    }
+
+    // MARK: - Priority
+    func testStartsProducersInPriorityOrder()
+    {
+        let (queue, observers, started) = makeQueue(count: 5, maximumProducersStarted: 1)
+        queue.prioritize({ abs($0 - 3) })
+        queue.draining = true
+
+        observers[3].send(value: 3)
+        observers[2].send(value: 2)
+        observers[4].send(value: 4)
+        observers[1].send(value: 1)
+
+        expect(started()) == [3, 2, 4, 1, 0]
+    }
+
+    func testReprioritizingAffectsOnlyPendingProducers()
+    {
+        let (queue, observers, started) = makeQueue(count: 4, maximumProducersStarted: 1)
+        queue.draining = true
+        queue.prioritize({ -$0 })
+
+        observers[0].send(value: 0)
+        expect(started()) == [0, 3]
+    }
+
+    // MARK: - Cancellation
+    func testCancellingPendingProducers()
+    {
+        let (queue, observers, started) = makeQueue(count: 5, maximumProducersStarted: 1)
+        queue.draining = true
+
+        expect(queue.cancelPending(where: { $0 == 0 || $0 >= 3 })) == [3, 4]
+        expect(queue.pendingCount) == 2
+
+        observers[0].send(value: 0)
+        observers[1].send(value: 1)
+        observers[2].send(value: 2)
+
+        expect(started()) == [0, 1, 2]
+        expect(queue.pendingCount) == 0
+    }
+
+    // MARK: - Instrumentation
+    func testReportsMetrics()
+    {
+        let scheduler = TestScheduler()
+        let pipes = (0..<2).map({ _ in Signal<Int, NoError>.pipe() })
+
+        let queue = ProducerQueue(
+            content: 0..<2,
+            maximumProducersStarted: 1,
+            makeProducer: { index in SignalProducer(signal: pipes[index].0) },
+            clock: { scheduler.currentDate.timeIntervalSinceReferenceDate }
+        )
+
+        // metrics may be reported on any thread, so they are collected on a serial queue
+        let metricsQueue = DispatchQueue(label: "ProducerQueueTests")
+        var metrics = [ProducerQueueMetrics]()
+        queue.metricsObserver = { value in metricsQueue.sync { metrics.append(value) } }
+
+        // time spent before draining is not counted as waiting
+        scheduler.advance(by: .seconds(5))
+        queue.draining = true
+
+        scheduler.advance(by: .seconds(2))
+        pipes[0].1.send(value: 0)
+
+        scheduler.advance(by: .seconds(3))
+        pipes[1].1.send(value: 1)
+
+        let reported = metricsQueue.sync { metrics }
+        expect(reported.map({ $0.offset })) == [0, 1]
+        expect(reported.map({ $0.waitTime })) == [0, 2]
+        expect(reported.map({ $0.executionTime })) == [2, 3]
+    }
+}
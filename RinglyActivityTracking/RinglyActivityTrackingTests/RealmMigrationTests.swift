@@ -17,6 +17,11 @@ final class RealmMigrationTests: XCTestCase
 
     // MARK: - Initializing Unmigrated Databases
     private func migrationResults(fileName: String) -> Results<UpdateModel>
+    {
+        return migratedRealm(fileName: fileName).objects(UpdateModel.self)
+    }
+
+    private func migratedRealm(fileName: String) -> Realm
     {
         let temporaryDirectory = URL(fileURLWithPath: NSTemporaryDirectory())
             .appendingPathComponent("realmmigrationtests-\(arc4random())")
@@ -37,8 +42,7 @@ final class RealmMigrationTests: XCTestCase
         )
 
         let configuration = RealmService.configuration(fileURL: realmFile, logFunction: nil)
-        let realm = try! Realm(configuration: configuration)
-        return realm.objects(UpdateModel.self)
+        return try! Realm(configuration: configuration)
     }
 
     // MARK: - Test Cases
@@ -107,6 +111,30 @@ final class RealmMigrationTests: XCTestCase
 
         expect(version2).to(equal(version3))
     }
+
+    func testMigrationFromVersion3CreatesRollups()
+    {
+        let realm = migratedRealm(fileName: "Version3")
+
+        for macAddress in [nil, 10] as [Int64?]
+        {
+            expect(RealmService.steps(in: realm, startMinute: 0, endMinute: 1440, macAddress: macAddress))
+                == Steps(walkingStepCount: 33, runningStepCount: 33)
+
+            let identifier = StepsRollupModel.identifier(startMinute: 0, minuteCount: 60, macAddress: macAddress)
+            expect(realm.object(ofType: StepsRollupModel.self, forPrimaryKey: identifier)?.stepCount) == 66
+        }
+    }
+
+    func testMigrationFromVersion3IndexesTimestamps()
+    {
+        let realm = migratedRealm(fileName: "Version3")
+
+        expect(realm.schema["UpdateModel"]?["timestamp"]?.isIndexed) == true
+
+        let models = RealmService.updateModels(in: realm, startMinute: 10, endMinute: 12, predicate: nil)
+        expect(models.map({ $0.timestamp })) == [10, 11]
+    }
 }
 
 private func equal(_ expected: Results<UpdateModel>) -> NonNilMatcherFunc<Results<UpdateModel>>
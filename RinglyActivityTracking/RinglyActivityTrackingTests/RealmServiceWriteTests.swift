@@ -0,0 +1,151 @@
+@testable import RinglyActivityTracking
+import Nimble
+import RealmSwift
+import RinglyKit
+import XCTest
+
+final class RealmServiceWriteTests: XCTestCase
+{
+    // MARK: - Setup
+    private var service: RealmService!
+
+    /// Holds the in-memory Realm open, so that data persists between the service's producers.
+    private var realm: Realm!
+
+    override func setUp()
+    {
+        super.setUp()
+
+        let configuration = Realm.Configuration(
+            inMemoryIdentifier: "RealmServiceWriteTests-\(arc4random())",
+            objectTypes: [HealthKitQueuedUpdateModel.self, UpdateModel.self, StepsRollupModel.self,
+                          UpdateMindfulnessSession.self, MindfulnessSession.self]
+        )
+
+        realm = try! Realm(configuration: configuration)
+        service = RealmService(configuration: configuration, logFunction: nil)
+    }
+
+    override func tearDown()
+    {
+        service = nil
+        realm = nil
+        super.tearDown()
+    }
+
+    // MARK: - Updates
+    private func update(minute: RLYActivityTrackingMinute, steps: RLYActivityTrackingSteps, macAddress: Int64 = 1)
+        -> SourcedUpdate
+    {
+        return SourcedUpdate(
+            macAddress: macAddress,
+            update: RLYActivityTrackingUpdate(
+                date: try! RLYActivityTrackingDate(minute: minute),
+                walkingSteps: steps,
+                runningSteps: 0
+            )
+        )
+    }
+
+    /// Thirty days of minute updates, starting from an arbitrary minute.
+    private func monthOfUpdates(steps: (Int) -> RLYActivityTrackingSteps) -> [SourcedUpdate]
+    {
+        return (0..<(30 * 24 * 60)).map({ offset in
+            update(minute: 1_000_000 + RLYActivityTrackingMinute(offset), steps: steps(offset))
+        })
+    }
+
+    private func write(_ updates: [SourcedUpdate]) -> UpdatesWriteResult?
+    {
+        return service.writeSourcedUpdates(updates).single()?.value
+    }
+
+    private func persistedSteps() -> [Int32:Int]
+    {
+        realm.refresh()
+
+        var steps = [Int32:Int]()
+        realm.objects(UpdateModel.self).forEach({ steps[$0.timestamp] = $0.stepCount })
+        return steps
+    }
+
+    // MARK: - Writing
+    func testWritesNewUpdates()
+    {
+        expect(self.write([self.update(minute: 10, steps: 5), self.update(minute: 11, steps: 6)]))
+            == UpdatesWriteResult(written: 2, skipped: 0)
+
+        expect(self.persistedSteps()) == [10: 5, 11: 6]
+        expect(self.realm.objects(HealthKitQueuedUpdateModel.self).count) == 1
+    }
+
+    func testKeepsMaximumSteps()
+    {
+        _ = write([update(minute: 10, steps: 5), update(minute: 11, steps: 6)])
+
+        expect(self.write([self.update(minute: 10, steps: 3), self.update(minute: 11, steps: 8)]))
+            == UpdatesWriteResult(written: 1, skipped: 1)
+
+        expect(self.persistedSteps()) == [10: 5, 11: 8]
+    }
+
+    func testMergesDuplicatesInWrite()
+    {
+        let updates = [update(minute: 10, steps: 5), update(minute: 10, steps: 9), update(minute: 10, steps: 7)]
+
+        expect(self.write(updates)) == UpdatesWriteResult(written: 1, skipped: 2)
+        expect(self.persistedSteps()) == [10: 9]
+    }
+
+    func testSeparatesSources()
+    {
+        _ = write([update(minute: 10, steps: 5, macAddress: 1)])
+
+        expect(self.write([self.update(minute: 10, steps: 3, macAddress: 2)]))
+            == UpdatesWriteResult(written: 1, skipped: 0)
+
+        realm.refresh()
+        expect(self.realm.objects(UpdateModel.self).count) == 2
+    }
+
+    // MARK: - Written Intervals
+    func testSendsWrittenIntervals()
+    {
+        var intervals = [[BoundaryDates]]()
+        service.writtenStepsIntervals.observeValues({ intervals.append($0) })
+
+        _ = write([update(minute: 10, steps: 5), update(minute: 11, steps: 6), update(minute: 13, steps: 1)])
+        _ = write([update(minute: 10, steps: 3), update(minute: 11, steps: 8)])
+        _ = write([update(minute: 10, steps: 3)])
+
+        let minutes = intervals.map({ writeIntervals in
+            writeIntervals.map({ interval in
+                [interval.start, interval.end].map({ Int(try! RLYActivityTrackingDate(date: $0).minute) })
+            })
+        })
+
+        // the last write changes nothing, so it sends nothing
+        expect(minutes) == [[[10, 12], [13, 14]], [[11, 12]]]
+    }
+
+    // MARK: - Performance
+    func testSyncMonthIntoPopulatedStorePerformance()
+    {
+        let existing = monthOfUpdates(steps: { _ in 5 })
+        let synced = monthOfUpdates(steps: { offset in offset % 2 == 0 ? 10 : 5 })
+
+        measureMetrics(type(of: self).defaultPerformanceMetrics(), automaticallyStartMeasuring: false, for: {
+            try! self.realm.write {
+                self.realm.deleteAll()
+            }
+
+            _ = self.write(existing)
+
+            self.startMeasuring()
+            let result = self.write(synced)
+            self.stopMeasuring()
+
+            XCTAssertEqual(result, UpdatesWriteResult(written: synced.count / 2, skipped: synced.count / 2))
+        })
+    }
+}
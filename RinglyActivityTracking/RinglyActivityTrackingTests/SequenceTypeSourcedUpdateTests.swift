@@ -58,4 +58,65 @@ final class SequenceTypeSourcedUpdateTests: XCTestCase
         XCTAssertEqual(bucketed[5], [updates[0], updates[1]])
         XCTAssertEqual(bucketed[6], [updates[2], updates[3]])
     }
+
+    func testBucketDeduplicatesEqualUpdates()
+    {
+        let bucketed = (updates + updates).bucketed(minutesDenominator: 2)
+
+        XCTAssertEqual(bucketed.count, 2)
+        XCTAssertEqual(bucketed[5], [updates[0], updates[1]])
+        XCTAssertEqual(bucketed[6], [updates[2], updates[3]])
+    }
+
+    // MARK: - Hashing
+
+    /// A month of updates from three sources, with step counts that repeat frequently.
+    fileprivate func monthOfUpdates() -> [SourcedUpdate]
+    {
+        return (0..<(30 * 1440)).flatMap({ minute -> [SourcedUpdate] in
+            (0..<3).map({ source in
+                SourcedUpdate(
+                    macAddress: 0x001122334400 + Int64(source),
+                    update: RLYActivityTrackingUpdate(
+                        date: try! RLYActivityTrackingDate(minute: RLYActivityTrackingMinute(minute)),
+                        walkingSteps: RLYActivityTrackingSteps((minute + source) % 8),
+                        runningSteps: RLYActivityTrackingSteps(minute % 3)
+                    )
+                )
+            })
+        })
+    }
+
+    func testEqualUpdatesHaveEqualHashes()
+    {
+        let copies = updates.map({ sourced -> SourcedUpdate in
+            let update = RLYActivityTrackingUpdate(
+                date: try! RLYActivityTrackingDate(minute: sourced.update.date.minute),
+                walkingSteps: sourced.update.walkingSteps,
+                runningSteps: sourced.update.runningSteps
+            )
+
+            return SourcedUpdate(macAddress: sourced.macAddress, update: update)
+        })
+
+        XCTAssertEqual(copies, updates)
+        XCTAssertEqual(copies.map({ $0.hashValue }), updates.map({ $0.hashValue }))
+    }
+
+    func testHashesDoNotCollide()
+    {
+        let updates = monthOfUpdates()
+
+        XCTAssertEqual(Set(updates.map({ $0.hashValue })).count, updates.count)
+    }
+
+    // MARK: - Performance
+    func testBucketMonthPerformance()
+    {
+        let updates = monthOfUpdates()
+
+        measure {
+            _ = updates.bucketed(minutesDenominator: 10)
+        }
+    }
 }
@@ -0,0 +1,359 @@
+@testable import RinglyActivityTracking
+import Nimble
+import RealmSwift
+import RinglyKit
+import XCTest
+
+final class StepsRollupTests: XCTestCase
+{
+    // MARK: - Setup
+    private var realm: Realm!
+
+    override func setUp()
+    {
+        super.setUp()
+
+        realm = try! Realm(configuration: Realm.Configuration(
+            inMemoryIdentifier: "StepsRollupTests-\(arc4random())",
+            objectTypes: [HealthKitQueuedUpdateModel.self, UpdateModel.self, StepsRollupModel.self,
+                          UpdateMindfulnessSession.self, MindfulnessSession.self]
+        ))
+    }
+
+    override func tearDown()
+    {
+        realm = nil
+        super.tearDown()
+    }
+
+    // MARK: - Updates
+
+    /// An arbitrary day-aligned minute to start test data at.
+    private let base: Int32 = 1440 * 700
+
+    private func update(minute: Int32, walking: UInt8, running: UInt8 = 0, macAddress: Int64 = 1) -> UpdateModel
+    {
+        return UpdateModel(timestamp: minute, macAddress: macAddress, walkingSteps: walking, runningSteps: running)
+    }
+
+    private func write(_ updates: [UpdateModel])
+    {
+        try! realm.write {
+            _ = RealmService.upsert(updates, in: realm)
+        }
+    }
+
+    private func rawSteps(startMinute: Int32, endMinute: Int32, macAddress: Int64?) -> Steps
+    {
+        let models = RealmService.updateModels(
+            in: realm,
+            startMinute: RLYActivityTrackingMinute(startMinute),
+            endMinute: RLYActivityTrackingMinute(endMinute),
+            predicate: macAddress.map({ NSPredicate(format: "macAddress == %lld", $0) })
+        )
+
+        return Steps.distinctMaxByMinuteSteps(timestampGroupedSteps: models)
+    }
+
+    private func rollup(startMinute: Int32, minuteCount: Int32, macAddress: Int64?) -> StepsRollupModel?
+    {
+        let identifier = StepsRollupModel.identifier(
+            startMinute: startMinute,
+            minuteCount: minuteCount,
+            macAddress: macAddress
+        )
+
+        return realm.object(ofType: StepsRollupModel.self, forPrimaryKey: identifier)
+    }
+
+    // MARK: - Plan
+    func testPlanWithinHourReadsOnlyUpdates()
+    {
+        let plan = StepsRollupPlan(startMinute: base + 5, endMinute: base + 50)
+
+        expect(plan.updateRanges) == [(base + 5)..<(base + 50)]
+        expect(plan.hourRanges.isEmpty) == true
+        expect(plan.dayRange).to(beNil())
+    }
+
+    func testPlanWithinDayReadsHours()
+    {
+        let plan = StepsRollupPlan(startMinute: base + 30, endMinute: base + 200)
+
+        expect(plan.updateRanges) == [(base + 30)..<(base + 60), (base + 180)..<(base + 200)]
+        expect(plan.hourRanges) == [(base + 60)..<(base + 180)]
+        expect(plan.dayRange).to(beNil())
+    }
+
+    func testPlanAcrossDaysReadsDays()
+    {
+        let plan = StepsRollupPlan(startMinute: base - 300, endMinute: base + 1440 * 7 + 120)
+
+        expect(plan.updateRanges.isEmpty) == true
+        expect(plan.hourRanges) == [(base - 300)..<base, (base + 1440 * 7)..<(base + 1440 * 7 + 120)]
+        expect(plan.dayRange) == base..<(base + 1440 * 7)
+    }
+
+    func testPlanWithEmptyRange()
+    {
+        let plan = StepsRollupPlan(startMinute: base, endMinute: base)
+
+        expect(plan.updateRanges.isEmpty) == true
+        expect(plan.hourRanges.isEmpty) == true
+        expect(plan.dayRange).to(beNil())
+    }
+
+    // MARK: - Maintenance
+    func testRollupsForSingleSource()
+    {
+        write([update(minute: base, walking: 5, running: 1), update(minute: base + 61, walking: 6)])
+
+        expect(self.rollup(startMinute: self.base, minuteCount: 60, macAddress: 1)?.steps)
+            == Steps(walkingStepCount: 5, runningStepCount: 1)
+
+        expect(self.rollup(startMinute: self.base + 60, minuteCount: 60, macAddress: 1)?.steps)
+            == Steps(walkingStepCount: 6, runningStepCount: 0)
+
+        expect(self.rollup(startMinute: self.base, minuteCount: 1440, macAddress: nil)?.steps)
+            == Steps(walkingStepCount: 11, runningStepCount: 1)
+    }
+
+    func testRollupsUseMaximumAcrossSources()
+    {
+        write([update(minute: base, walking: 5, macAddress: 1)])
+        write([update(minute: base, walking: 9, macAddress: 2)])
+        write([update(minute: base, walking: 7, macAddress: 1)])
+
+        expect(self.rollup(startMinute: self.base, minuteCount: 1440, macAddress: nil)?.stepCount) == 9
+        expect(self.rollup(startMinute: self.base, minuteCount: 1440, macAddress: 1)?.stepCount) == 7
+        expect(self.rollup(startMinute: self.base, minuteCount: 1440, macAddress: 2)?.stepCount) == 9
+
+        write([update(minute: base, walking: 12, macAddress: 1)])
+
+        expect(self.rollup(startMinute: self.base, minuteCount: 1440, macAddress: nil)?.stepCount) == 12
+    }
+
+    func testSkippedUpdatesDoNotChangeRollups()
+    {
+        write([update(minute: base, walking: 5)])
+        write([update(minute: base, walking: 3)])
+
+        expect(self.rollup(startMinute: self.base, minuteCount: 60, macAddress: nil)?.stepCount) == 5
+    }
+
+    // MARK: - Observation
+    func testObservedRollupsIncludeOnlyRollupsContainingRange()
+    {
+        // a range in the middle of the second day
+        let range = (base + 1440 + 600)..<(base + 1440 + 630)
+
+        write([
+            update(minute: base + 1440 + 610, walking: 5),
+            update(minute: base + 1440 + 700, walking: 5),
+            update(minute: base + 600, walking: 5),
+            update(minute: base + 2880 + 600, walking: 5)
+        ])
+
+        let observed = realm.objects(StepsRollupModel.self)
+            .filter(StepsRollupModel.predicate(containingMinutesIn: range))
+
+        let containing = observed.filter({ rollup in
+            rollup.startMinute <= range.lowerBound && range.lowerBound < rollup.startMinute + rollup.minuteCount
+        })
+
+        // the hour and day containing the range, for the source and for all sources
+        expect(containing.count) == 4
+
+        // the rollups on other days are not observed, so writes to them do not reload the range
+        expect(observed.filter({ $0.startMinute < self.base + 1440 || $0.startMinute >= range.upperBound }).count)
+            == 0
+    }
+
+    // MARK: - Equivalence
+    func testMatchesRawUpdates()
+    {
+        // overlapping sources with tied totals, written in several batches, across several days
+        for batch in 0..<4
+        {
+            write((0..<3000).map({ index in
+                let offset = Int32((index * 7 + batch * 31) % 5000)
+                let walking = UInt8((index * 13 + batch) % 50)
+
+                return update(
+                    minute: base + offset,
+                    walking: walking,
+                    running: UInt8((index + batch) % 4),
+                    macAddress: Int64((index + batch) % 3)
+                )
+            }))
+        }
+
+        let ranges: [(Int32, Int32)] = [(0, 5000), (0, 1440), (100, 200), (59, 61), (1439, 2881), (30, 4321), (7, 7)]
+
+        for (lower, upper) in ranges
+        {
+            for macAddress in [nil, 0, 2] as [Int64?]
+            {
+                let startMinute = base + lower, endMinute = base + upper
+
+                expect(RealmService.steps(
+                    in: self.realm,
+                    startMinute: startMinute,
+                    endMinute: endMinute,
+                    macAddress: macAddress
+                )) == rawSteps(startMinute: startMinute, endMinute: endMinute, macAddress: macAddress)
+            }
+        }
+    }
+
+    func testMultipleRangesMatchSingleRanges()
+    {
+        for batch in 0..<2
+        {
+            write((0..<3000).map({ index in
+                update(
+                    minute: base + Int32((index * 11 + batch * 17) % 4500),
+                    walking: UInt8((index * 3 + batch) % 40),
+                    running: UInt8(index % 3),
+                    macAddress: Int64((index + batch) % 2)
+                )
+            }))
+        }
+
+        // consecutive days offset from UTC, overlapping ranges, and ranges within a single hour
+        let days: [Range<Int32>] = (Int32(0)..<3).map({ day in
+            (base + 300 + day * 1440)..<(base + 300 + (day + 1) * 1440)
+        })
+        let others: [Range<Int32>] = [(base + 60)..<(base + 4000), (base + 5)..<(base + 50), base..<base]
+        let ranges = days + others
+
+        for macAddress in [nil, 1] as [Int64?]
+        {
+            expect(RealmService.steps(in: self.realm, minuteRanges: ranges, macAddress: macAddress)) == ranges.map({
+                RealmService.steps(
+                    in: self.realm,
+                    startMinute: $0.lowerBound,
+                    endMinute: $0.upperBound,
+                    macAddress: macAddress
+                )
+            })
+        }
+    }
+
+    func testMultipleRangesWithNoRanges()
+    {
+        expect(RealmService.steps(in: self.realm, minuteRanges: [], macAddress: nil).isEmpty) == true
+    }
+
+    // MARK: - Performance
+
+    /// Thirty days of updates from two sources.
+    private func writeMonth()
+    {
+        write((0..<(30 * 1440)).flatMap({ offset -> [UpdateModel] in
+            let minute = base + Int32(offset)
+
+            return [
+                update(minute: minute, walking: UInt8(offset % 40), macAddress: 1),
+                update(minute: minute, walking: UInt8(offset % 37), macAddress: 2)
+            ]
+        }))
+    }
+
+    func testRollupWeekQueryPerformance()
+    {
+        writeMonth()
+
+        measure {
+            _ = RealmService.steps(
+                in: self.realm,
+                startMinute: self.base + 300,
+                endMinute: self.base + 300 + 1440 * 7,
+                macAddress: nil
+            )
+        }
+    }
+
+    func testRollupDaysQueryPerformance()
+    {
+        writeMonth()
+
+        let days: [Range<Int32>] = (Int32(0)..<28).map({ day in
+            (self.base + 300 + day * 1440)..<(self.base + 300 + (day + 1) * 1440)
+        })
+
+        measure {
+            _ = RealmService.steps(in: self.realm, minuteRanges: days, macAddress: nil)
+        }
+    }
+
+    func testRollupIndividualDaysQueryPerformance()
+    {
+        writeMonth()
+
+        let days: [Range<Int32>] = (Int32(0)..<28).map({ day in
+            (self.base + 300 + day * 1440)..<(self.base + 300 + (day + 1) * 1440)
+        })
+
+        measure {
+            _ = days.map({ day in
+                RealmService.steps(
+                    in: self.realm,
+                    startMinute: day.lowerBound,
+                    endMinute: day.upperBound,
+                    macAddress: nil
+                )
+            })
+        }
+    }
+
+    /// The update ranges at the edges of 28 consecutive days, which start and end mid-hour.
+    private var dayEdgeRanges: [Range<Int32>]
+    {
+        return (Int32(0)..<28).flatMap({ day in
+            StepsRollupPlan(
+                startMinute: self.base + 330 + day * 1440,
+                endMinute: self.base + 330 + (day + 1) * 1440
+            ).updateRanges
+        })
+    }
+
+    func testPackedEdgesQueryPerformance()
+    {
+        writeMonth()
+        let ranges = dayEdgeRanges
+
+        measure {
+            let models = RealmService.updateModels(in: self.realm, minuteRanges: ranges, predicate: nil)
+            let packed = PackedTimestampedSteps(models)
+
+            _ = ranges.map({ Steps.distinctMaxByMinuteSteps(packed: packed, timestamps: $0) })
+        }
+    }
+
+    func testSequentialEdgesQueryPerformance()
+    {
+        // reducing the lazy results for each range, for comparison
+        writeMonth()
+        let ranges = dayEdgeRanges
+
+        measure {
+            let models = RealmService.updateModels(in: self.realm, minuteRanges: ranges, predicate: nil)
+
+            _ = ranges.map({ range in
+                Steps.distinctMaxByMinuteSteps(
+                    timestampGroupedSteps: models.lazy.filter({ range.contains($0.timestamp) })
+                )
+            })
+        }
+    }
+
+    func testRawWeekQueryPerformance()
+    {
+        writeMonth()
+
+        measure {
+            _ = self.rawSteps(startMinute: self.base + 300, endMinute: self.base + 300 + 1440 * 7, macAddress: nil)
+        }
+    }
+}
@@ -0,0 +1,130 @@
+#import <Foundation/Foundation.h>
+#import "RLYDefines.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+#pragma mark - Components
+
+/**
+ *  The calendar components of a date sent by a peripheral in an ANCS notification.
+ */
+typedef struct
+{
+    /**
+     *  The Gregorian year.
+     */
+    int32_t year;
+
+    /**
+     *  The month, from `1` to `12`.
+     */
+    int32_t month;
+
+    /**
+     *  The day of the month, starting at `1`.
+     */
+    int32_t day;
+
+    /**
+     *  The hour, from `0` to `23`.
+     */
+    int32_t hour;
+
+    /**
+     *  The minute, from `0` to `59`.
+     */
+    int32_t minute;
+
+    /**
+     *  The second, from `0` to `59`.
+     */
+    int32_t second;
+} RLYANCSDateComponents;
+
+#pragma mark - Parsing
+
+/**
+ *  Parses an ANCS version 2 date, which is in the fixed format `yyyyMMdd'T'HHmmss`, directly from a byte buffer.
+ *
+ *  @param bytes      The date bytes.
+ *  @param length     The number of date bytes, which must be `15`.
+ *  @param components A pointer to a components structure, which will be set if parsing succeeds.
+ *
+ *  @return `YES` if the bytes were a valid date, otherwise `NO`.
+ */
+RINGLYKIT_EXTERN BOOL RLYANCSV2ParseDateComponents(const uint8_t *bytes,
+                                                   size_t length,
+                                                   RLYANCSDateComponents *components);
+
+/**
+ *  Parses an ANCS version 1 date, which is in the fixed format `ddHHmmss`, directly from a byte buffer. Version 1
+ *  peripherals do not send a year or month, so these must be provided.
+ *
+ *  @param bytes      The date bytes.
+ *  @param length     The number of date bytes. Only the first 8 bytes are read.
+ *  @param year       The year to use.
+ *  @param month      The month to use.
+ *  @param components A pointer to a components structure, which will be set if parsing succeeds.
+ *
+ *  @return `YES` if the bytes were a valid date, otherwise `NO`.
+ */
+RINGLYKIT_EXTERN BOOL RLYANCSV1ParseDateComponents(const uint8_t *bytes,
+                                                   size_t length,
+                                                   int32_t year,
+                                                   int32_t month,
+                                                   RLYANCSDateComponents *components);
+
+#pragma mark - Conversion
+
+/**
+ *  Converts date components to an absolute time, interpreting them as a wall clock time in `timeZone`.
+ *
+ *  This function does not allocate, and is safe to call from any thread.
+ *
+ *  @param components The date components.
+ *  @param timeZone   The time zone to interpret the components in.
+ */
+RINGLYKIT_EXTERN CFAbsoluteTime RLYANCSDateComponentsToAbsoluteTime(RLYANCSDateComponents components,
+                                                                    NSTimeZone *timeZone);
+
+#pragma mark - Year and Month
+
+/**
+ *  Caches the current year and month for version 1 dates, so that they only need to be calculated once per day.
+ */
+typedef struct
+{
+    /**
+     *  The cached year.
+     */
+    int32_t year;
+
+    /**
+     *  The cached month.
+     */
+    int32_t month;
+
+    /**
+     *  The absolute time at which the cached values became valid.
+     */
+    CFAbsoluteTime start;
+
+    /**
+     *  The absolute time at which the cached values are no longer valid.
+     */
+    CFAbsoluteTime expiration;
+} RLYANCSYearMonthCache;
+
+/**
+ *  Updates `cache` for the absolute time `time`, if it is outside of the cached period. If the cache is still valid,
+ *  this function only performs two comparisons.
+ *
+ *  @param cache    The cache. A zeroed cache is always expired.
+ *  @param time     The absolute time.
+ *  @param timeZone The time zone to determine the year and month in.
+ */
+RINGLYKIT_EXTERN void RLYANCSYearMonthCacheUpdate(RLYANCSYearMonthCache *cache,
+                                                  CFAbsoluteTime time,
+                                                  NSTimeZone *timeZone);
+
+NS_ASSUME_NONNULL_END
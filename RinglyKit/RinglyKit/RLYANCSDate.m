@@ -0,0 +1,192 @@
+#import "RLYANCSDate.h"
+
+#pragma mark - Digits
+
+/**
+ *  Parses `count` ASCII decimal digits from `bytes`.
+ *
+ *  @param bytes The bytes to parse.
+ *  @param count The number of digits.
+ *  @param value A pointer to the parsed value, which is set if parsing succeeds.
+ *
+ *  @return `YES` if all bytes were digits.
+ */
+static BOOL RLYANCSParseDigits(const uint8_t *bytes, size_t count, int32_t *value)
+{
+    int32_t result = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        uint8_t digit = bytes[i] - '0';
+
+        if (digit > 9)
+        {
+            return NO;
+        }
+
+        result = result * 10 + digit;
+    }
+
+    *value = result;
+    return YES;
+}
+
+#pragma mark - Calendar Arithmetic
+
+/**
+ *  Returns `YES` if `year` is a Gregorian leap year.
+ *
+ *  @param year The year.
+ */
+static BOOL RLYANCSIsLeapYear(int32_t year)
+{
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+/**
+ *  Returns the number of days in the given month.
+ *
+ *  @param year  The year.
+ *  @param month The month, from `1` to `12`.
+ */
+static int32_t RLYANCSDaysInMonth(int32_t year, int32_t month)
+{
+    static const int32_t days[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    return month == 2 && RLYANCSIsLeapYear(year) ? 29 : days[month - 1];
+}
+
+/**
+ *  Returns the number of days between 2001-01-01 (the Core Foundation reference date) and the given Gregorian date.
+ *
+ *  @param year  The year.
+ *  @param month The month, from `1` to `12`.
+ *  @param day   The day of the month.
+ */
+static int64_t RLYANCSDaysSinceReferenceDate(int32_t year, int32_t month, int32_t day)
+{
+    // shift the year to start in March, so that the leap day is the last day of the year
+    int64_t y = month <= 2 ? year - 1 : year;
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    int64_t yearOfEra = y - era * 400;
+    int64_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+
+    // days since 1970-01-01, minus the days between 1970-01-01 and 2001-01-01
+    return era * 146097 + dayOfEra - 719468 - 11323;
+}
+
+/**
+ *  Returns `YES` if the components describe a valid date and time.
+ *
+ *  @param components The components.
+ */
+static BOOL RLYANCSDateComponentsAreValid(RLYANCSDateComponents components)
+{
+    return components.month >= 1 && components.month <= 12
+        && components.day >= 1 && components.day <= RLYANCSDaysInMonth(components.year, components.month)
+        && components.hour <= 23
+        && components.minute <= 59
+        && components.second <= 59;
+}
+
+#pragma mark - Parsing
+BOOL RLYANCSV2ParseDateComponents(const uint8_t *bytes, size_t length, RLYANCSDateComponents *components)
+{
+    if (length != 15 || bytes[8] != 'T')
+    {
+        return NO;
+    }
+
+    RLYANCSDateComponents parsed;
+
+    if (!RLYANCSParseDigits(bytes, 4, &parsed.year)
+        || !RLYANCSParseDigits(bytes + 4, 2, &parsed.month)
+        || !RLYANCSParseDigits(bytes + 6, 2, &parsed.day)
+        || !RLYANCSParseDigits(bytes + 9, 2, &parsed.hour)
+        || !RLYANCSParseDigits(bytes + 11, 2, &parsed.minute)
+        || !RLYANCSParseDigits(bytes + 13, 2, &parsed.second)
+        || !RLYANCSDateComponentsAreValid(parsed))
+    {
+        return NO;
+    }
+
+    *components = parsed;
+    return YES;
+}
+
+BOOL RLYANCSV1ParseDateComponents(const uint8_t *bytes,
+                                  size_t length,
+                                  int32_t year,
+                                  int32_t month,
+                                  RLYANCSDateComponents *components)
+{
+    if (length < 8)
+    {
+        return NO;
+    }
+
+    RLYANCSDateComponents parsed = { .year = year, .month = month };
+
+    if (!RLYANCSParseDigits(bytes, 2, &parsed.day)
+        || !RLYANCSParseDigits(bytes + 2, 2, &parsed.hour)
+        || !RLYANCSParseDigits(bytes + 4, 2, &parsed.minute)
+        || !RLYANCSParseDigits(bytes + 6, 2, &parsed.second)
+        || !RLYANCSDateComponentsAreValid(parsed))
+    {
+        return NO;
+    }
+
+    *components = parsed;
+    return YES;
+}
+
+#pragma mark - Conversion
+CFAbsoluteTime RLYANCSDateComponentsToAbsoluteTime(RLYANCSDateComponents components, NSTimeZone *timeZone)
+{
+    CFAbsoluteTime wallClock = (CFAbsoluteTime)(RLYANCSDaysSinceReferenceDate(components.year,
+                                                                              components.month,
+                                                                              components.day) * 86400
+                                                + components.hour * 3600
+                                                + components.minute * 60
+                                                + components.second);
+
+    // the offset depends on the absolute time, which we don't know yet - guess with the offset at the wall clock time,
+    // then correct with the offset at the guess, which resolves daylight saving time transitions
+    CFTimeZoneRef zone = (__bridge CFTimeZoneRef)timeZone;
+    CFTimeInterval guessOffset = CFTimeZoneGetSecondsFromGMT(zone, wallClock);
+    CFTimeInterval offset = CFTimeZoneGetSecondsFromGMT(zone, wallClock - guessOffset);
+
+    return wallClock - offset;
+}
+
+#pragma mark - Year and Month
+void RLYANCSYearMonthCacheUpdate(RLYANCSYearMonthCache *cache, CFAbsoluteTime time, NSTimeZone *timeZone)
+{
+    // the clock can move backwards, so the time must be checked against both ends of the cached day
+    if (cache->start <= time && time < cache->expiration && cache->year != 0)
+    {
+        return;
+    }
+
+    // convert to a local day number, then walk forward from the start of the era to find the year and month
+    CFTimeInterval offset = CFTimeZoneGetSecondsFromGMT((__bridge CFTimeZoneRef)timeZone, time);
+    int64_t days = (int64_t)floor((time + offset) / 86400);
+
+    // inverse of `RLYANCSDaysSinceReferenceDate`
+    int64_t z = days + 719468 + 11323;
+    int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    int64_t dayOfEra = z - era * 146097;
+    int64_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    int64_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    int64_t shiftedMonth = (5 * dayOfYear + 2) / 153;
+    int32_t month = (int32_t)(shiftedMonth < 10 ? shiftedMonth + 3 : shiftedMonth - 9);
+    int32_t year = (int32_t)(yearOfEra + era * 400 + (month <= 2 ? 1 : 0));
+
+    cache->year = year;
+    cache->month = month;
+
+    // the cache is valid for the current local day - recalculating daily handles both month changes and time zone
+    // changes, without needing to track either
+    cache->start = (CFAbsoluteTime)(days * 86400) - offset;
+    cache->expiration = (CFAbsoluteTime)((days + 1) * 86400) - offset;
+}
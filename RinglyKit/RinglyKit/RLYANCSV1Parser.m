@@ -1,17 +1,82 @@
+#import "RLYANCSDate.h"
 #import "RLYANCSV1Parser.h"
 #import "RLYErrorFunctions.h"
 #import "RLYFunctions.h"
 
+/**
+ *  The number of parts in an ANCS version 1 notification.
+ */
+#define RLY_ANCS_V1_PART_COUNT 5
+
+/**
+ *  The maximum length of a single ANCS version 1 part. This is the maximum length of a Bluetooth attribute value, so
+ *  no valid characteristic update can exceed it.
+ */
+#define RLY_ANCS_V1_MAXIMUM_PART_LENGTH 512
+
+/**
+ *  The index of each part in an ANCS version 1 notification.
+ */
+typedef NS_ENUM(NSUInteger, RLYANCSV1Part)
+{
+    RLYANCSV1PartCategory = 0,
+    RLYANCSV1PartApplicationIdentifierPrefix = 1,
+    RLYANCSV1PartApplicationIdentifierSuffix = 2,
+    RLYANCSV1PartTitle = 3,
+    RLYANCSV1PartMessage = 4
+};
+
+/**
+ *  Parses the category part of an ANCS version 1 notification, with the same semantics as
+ *  `RLYANCSCategoryFromNumericalString`, but without creating a string.
+ *
+ *  @param bytes  The category bytes.
+ *  @param length The number of category bytes.
+ */
+static RLYANCSCategory RLYANCSV1CategoryFromBytes(const uint8_t *bytes, size_t length)
+{
+    size_t offset = 0;
+
+    while (offset < length && (bytes[offset] == ' ' || bytes[offset] == '\t' || bytes[offset] == '\n'))
+    {
+        offset++;
+    }
+
+    BOOL negative = NO;
+
+    if (offset < length && (bytes[offset] == '-' || bytes[offset] == '+'))
+    {
+        negative = bytes[offset] == '-';
+        offset++;
+    }
+
+    NSInteger value = 0;
+
+    while (offset < length && bytes[offset] >= '0' && bytes[offset] <= '9' && value < 12)
+    {
+        value = value * 10 + (bytes[offset] - '0');
+        offset++;
+    }
+
+    return !negative && value < 12 ? (RLYANCSCategory)value : RLYANCSCategoryOther;
+}
+
 @interface RLYANCSV1Parser ()
 {
 @private
     // date handling
     NSDate *_yearMonthDate;
-    NSDateFormatter *_yearMonthFormatter;
-    NSDateFormatter *_dateFormatter;
-    
-    // ANCS data
-    NSArray<NSData*> *_appends;
+    RLYANCSYearMonthCache _yearMonthCache;
+
+    // ANCS data - parts are stored in a ring of fixed slots, so that restarting a notification with the most recently
+    // received part only requires moving the first slot index, not copying the part
+    uint8_t _slots[RLY_ANCS_V1_PART_COUNT][RLY_ANCS_V1_MAXIMUM_PART_LENGTH];
+    size_t _slotLengths[RLY_ANCS_V1_PART_COUNT];
+    NSUInteger _firstSlot;
+    NSUInteger _partCount;
+
+    // the header length of the first part, or `0` if the first part did not include a header
+    size_t _headerLength;
 }
 
 @end
@@ -27,121 +92,169 @@
 -(instancetype)initWithYearMonthDate:(NSDate *)yearMonthDate
 {
     self = [super init];
-    
+
     if (self)
     {
         _yearMonthDate = yearMonthDate;
-        
-        _yearMonthFormatter = [NSDateFormatter new];
-        _yearMonthFormatter.dateFormat = @"YYYYMM";
-        
-        _dateFormatter = [NSDateFormatter new];
-        _dateFormatter.dateFormat = @"YYYYMMddHHmmss";
     }
-    
+
     return self;
 }
 
+#pragma mark - Slots
+-(uint8_t*)bytesForPart:(NSUInteger)part
+{
+    return _slots[(_firstSlot + part) % RLY_ANCS_V1_PART_COUNT];
+}
+
+-(size_t)lengthForPart:(NSUInteger)part
+{
+    return _slotLengths[(_firstSlot + part) % RLY_ANCS_V1_PART_COUNT];
+}
+
 #pragma mark - ANCS Data
 -(void)appendData:(NSData*)data
 {
-    // add the new data
-    _appends = [_appends ?: @[] arrayByAddingObject:data];
-    
+    // copy the new data into the next free slot
+    NSUInteger slot = (_firstSlot + _partCount) % RLY_ANCS_V1_PART_COUNT;
+    size_t length = MIN(data.length, (size_t)RLY_ANCS_V1_MAXIMUM_PART_LENGTH);
+
+    memcpy(_slots[slot], data.bytes, length);
+    _slotLengths[slot] = length;
+
+    size_t headerLength = RLYScanANCSV1HeaderLength(_slots[slot], length);
+
     // check data headers
-    if (_appends.count > 1)
+    if (_partCount == 0)
+    {
+        _headerLength = headerLength;
+    }
+    else
     {
         // make sure we actually have a data header
-        NSData *lastHeader = RLYScanANCSV1Header(_appends.lastObject);
-        
-        if (!lastHeader)
+        if (headerLength == 0)
         {
+            // restart the process on the next append
+            _partCount = 0;
+
             // send an error to the delegate
             NSError *error = RLYANCSV1Error(RLYANCSV1ErrorCodeInvalidHeader);
             [_delegate ANCSV1Parser:self failedToParseNotificationWithError:error];
-            
-            // restart the process on the next append
-            _appends = @[];
-            
+
             return;
         }
-        
-        // compare with the headers we're already tracking to make sure this is the same notification
-        NSData *firstHeader = RLYScanANCSV1Header(_appends.firstObject);
-        
-        if (![firstHeader isEqualToData:lastHeader])
+
+        // compare with the header we're already tracking to make sure this is the same notification
+        if (headerLength != _headerLength || memcmp(_slots[slot], [self bytesForPart:0], headerLength) != 0)
         {
+            // restart the process, with the new notification as the first value
+            _firstSlot = slot;
+            _partCount = 1;
+            _headerLength = headerLength;
+
             // send an error to the delegate
             NSError *error = RLYANCSV1Error(RLYANCSV1ErrorCodeDifferentHeader);
             [_delegate ANCSV1Parser:self failedToParseNotificationWithError:error];
-            
-            // restart the process, with the new notification as the first value
-            _appends = @[data];
-            
+
             return;
         }
     }
-    
-    // once we've collected 5 appends, parse them into a notification
-    if (_appends.count == 5)
-    {
-        // convert from data to strings, dropping the initial header
-        NSMutableArray<NSString*> *strings = [NSMutableArray arrayWithCapacity:5];
-        NSMutableArray<NSData*> *subdatas = [NSMutableArray arrayWithCapacity:5];
-        
-        for (NSUInteger i = 0; i < 5; i++)
-        {
-            NSData *data = _appends[i];
-            
-            // find the header for the part
-            NSData *header = RLYScanANCSV1Header(data);
-            
-            // take all data after the header as the message body
-            NSData *subdata = [data subdataWithRange:NSMakeRange(header.length, data.length - header.length)];
-            [subdatas addObject:subdata];
-            
-            // convert to a UTF-8 string
-            [strings addObject:RLYFindValidUTF8Prefix(RLYSubdataToFirstNull(subdata))];
-        }
-        
-        // parse ANCS date if available
-        NSDate *date = nil;
 
-        if (strings[4].length >= 8)
-        {
-            // trim excess length, where the flags are stored
-            NSString *trimmed = [strings[4] substringToIndex:8];
-            
-            // add the year and month to the reported date
-            NSString *yearMonth = [_yearMonthFormatter stringFromDate:_yearMonthDate ?: [NSDate date]];
-            NSString *dateString = [yearMonth stringByAppendingString:trimmed];
-            
-            date = [_dateFormatter dateFromString:dateString];;
-        }
-        
-        // include flags data if requested
-        RLYANCSNotificationFlagsValue *flagsValue = nil;
+    _partCount++;
 
-        if (_includeFlags && subdatas[4].length > 8)
-        {
-            RLYANCSNotificationFlags flags = ((uint8_t*)subdatas[4].bytes)[8];
-            flagsValue = [[RLYANCSNotificationFlagsValue alloc] initWithFlags:flags];
-        }
+    // once we've collected all parts, parse them into a notification
+    if (_partCount == RLY_ANCS_V1_PART_COUNT)
+    {
+        // clear for the next parse operation before notifying the delegate, in case it appends more data
+        RLYANCSNotification *notification = [self parseNotification];
+        _firstSlot = 0;
+        _partCount = 0;
 
-        // create ANCS notification
-        RLYANCSNotification *notification =
-            [[RLYANCSNotification alloc] initWithVersion:RLYANCSNotificationVersion1
-                                                category:RLYANCSCategoryFromNumericalString(strings[0])
-                                   applicationIdentifier:[strings[1] stringByAppendingString:strings[2]]
-                                                   title:strings[3]
-                                                    date:date
-                                                 message:strings[4]
-                                              flagsValue:flagsValue];
-        
-        // send the notification to the delegate and clear for the next parse operation
         [_delegate ANCSV1Parser:self parsedNotification:notification];
-        _appends = @[];
     }
 }
 
+#pragma mark - Parsing
+-(RLYANCSNotification*)parseNotification
+{
+    // find the valid UTF-8 body of each part, dropping the header, without copying any data
+    const uint8_t *bodies[RLY_ANCS_V1_PART_COUNT];
+    size_t bodyLengths[RLY_ANCS_V1_PART_COUNT];
+    size_t stringLengths[RLY_ANCS_V1_PART_COUNT];
+
+    for (NSUInteger i = 0; i < RLY_ANCS_V1_PART_COUNT; i++)
+    {
+        size_t length = [self lengthForPart:i];
+        size_t headerLength = MIN(_headerLength, length);
+
+        bodies[i] = [self bytesForPart:i] + headerLength;
+        bodyLengths[i] = length - headerLength;
+
+        // crop to the first null character, then to a valid UTF-8 prefix
+        const uint8_t *null = memchr(bodies[i], '\0', bodyLengths[i]);
+        size_t nullLength = null ? (size_t)(null - bodies[i]) : bodyLengths[i];
+        stringLengths[i] = RLYValidUTF8PrefixLength(bodies[i], nullLength);
+    }
+
+    // the application identifier is split across two parts, join them before creating a string
+    size_t prefixLength = stringLengths[RLYANCSV1PartApplicationIdentifierPrefix];
+    size_t suffixLength = stringLengths[RLYANCSV1PartApplicationIdentifierSuffix];
+    uint8_t applicationIdentifierBytes[RLY_ANCS_V1_MAXIMUM_PART_LENGTH * 2];
+
+    memcpy(applicationIdentifierBytes, bodies[RLYANCSV1PartApplicationIdentifierPrefix], prefixLength);
+    memcpy(applicationIdentifierBytes + prefixLength, bodies[RLYANCSV1PartApplicationIdentifierSuffix], suffixLength);
+
+    NSString *applicationIdentifier = [[NSString alloc] initWithBytes:applicationIdentifierBytes
+                                                               length:prefixLength + suffixLength
+                                                             encoding:NSUTF8StringEncoding];
+
+    NSString *title = [[NSString alloc] initWithBytes:bodies[RLYANCSV1PartTitle]
+                                               length:stringLengths[RLYANCSV1PartTitle]
+                                             encoding:NSUTF8StringEncoding];
+
+    NSString *message = [[NSString alloc] initWithBytes:bodies[RLYANCSV1PartMessage]
+                                                 length:stringLengths[RLYANCSV1PartMessage]
+                                               encoding:NSUTF8StringEncoding];
+
+    // parse ANCS date if available, adding the current year and month, which are only recalculated once per day
+    NSDate *date = nil;
+    NSTimeZone *timeZone = [NSTimeZone defaultTimeZone];
+    CFAbsoluteTime yearMonthTime = _yearMonthDate
+        ? _yearMonthDate.timeIntervalSinceReferenceDate
+        : CFAbsoluteTimeGetCurrent();
+
+    RLYANCSYearMonthCacheUpdate(&_yearMonthCache, yearMonthTime, timeZone);
+
+    RLYANCSDateComponents dateComponents;
+
+    if (RLYANCSV1ParseDateComponents(bodies[RLYANCSV1PartMessage],
+                                     stringLengths[RLYANCSV1PartMessage],
+                                     _yearMonthCache.year,
+                                     _yearMonthCache.month,
+                                     &dateComponents))
+    {
+        date = [NSDate dateWithTimeIntervalSinceReferenceDate:RLYANCSDateComponentsToAbsoluteTime(dateComponents,
+                                                                                                  timeZone)];
+    }
+
+    // include flags data if requested
+    RLYANCSNotificationFlagsValue *flagsValue = nil;
+
+    if (_includeFlags && bodyLengths[RLYANCSV1PartMessage] > 8)
+    {
+        RLYANCSNotificationFlags flags = bodies[RLYANCSV1PartMessage][8];
+        flagsValue = [[RLYANCSNotificationFlagsValue alloc] initWithFlags:flags];
+    }
+
+    // create ANCS notification
+    return [[RLYANCSNotification alloc] initWithVersion:RLYANCSNotificationVersion1
+                                               category:RLYANCSV1CategoryFromBytes(bodies[RLYANCSV1PartCategory],
+                                                                                   stringLengths[RLYANCSV1PartCategory])
+                                  applicationIdentifier:applicationIdentifier ?: @""
+                                                  title:title ?: @""
+                                                   date:date
+                                                message:message
+                                             flagsValue:flagsValue];
+}
+
 @end
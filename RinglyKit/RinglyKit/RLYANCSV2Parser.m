@@ -1,3 +1,4 @@
+#import "RLYANCSDate.h"
 #import "RLYANCSV2Parser.h"
 #import "RLYDefines+Internal.h"
 #import "RLYErrorFunctions.h"
@@ -19,27 +20,69 @@ typedef NS_ENUM(uint8_t, RLYANCSV2ApplicationAttribute)
     RLYANCSV2NotificationAttributeDisplayName = 0
 };
 
+/**
+ *  The number of known notification attributes, used to size attribute slot arrays.
+ */
+#define RLY_ANCS_V2_NOTIFICATION_ATTRIBUTE_COUNT (RLYANCSV2NotificationAttributeNegativeAction + 1)
+
+/**
+ *  The location of an attribute's value within the original data. Values are only decoded once they are needed.
+ */
+typedef struct
+{
+    /**
+     *  The offset of the attribute's value.
+     */
+    size_t offset;
+    
+    /**
+     *  The length of the attribute's value.
+     */
+    size_t length;
+    
+    /**
+     *  `YES` if the attribute was included in the data.
+     */
+    BOOL present;
+} RLYANCSV2AttributeSlot;
+
+/**
+ *  Decodes the attribute in `slot` to a string.
+ *
+ *  @param bytes The original bytes.
+ *  @param slot  The attribute slot.
+ */
+static NSString * _Nullable RLYANCSV2DecodeAttribute(const uint8_t *bytes, RLYANCSV2AttributeSlot slot)
+{
+    return slot.present
+        ? [[NSString alloc] initWithBytes:bytes + slot.offset length:slot.length encoding:NSUTF8StringEncoding]
+        : nil;
+}
+
 @implementation RLYANCSV2Parser
 
 #define ANCSV2_SET_ERROR_AND_RETURN_NIL(errorCode, data) \
     RLY_SET_ERROR_AND_RETURN(RLYANCSV2Error(errorCode, data), nil)
 
+#define ANCSV2_SET_ERROR_AND_RETURN_NO(errorCode, data) \
+    RLY_SET_ERROR_AND_RETURN(RLYANCSV2Error(errorCode, data), NO)
+
 #pragma mark - Parsing
-+(nullable NSDictionary<NSNumber*, NSString*>*)consumeAttributeDictionaryFromBytes:(const uint8_t*)bytes
-                                                                            offset:(size_t*)offset
-                                                                        dataLength:(size_t)dataLength
-                                                                    attributeCount:(NSUInteger)count
-                                                                      originalData:(NSData*)originalData
-                                                                             error:(NSError**)error
++(BOOL)consumeAttributesFromBytes:(const uint8_t*)bytes
+                           offset:(size_t*)offset
+                       dataLength:(size_t)dataLength
+                   attributeCount:(NSUInteger)count
+                            slots:(RLYANCSV2AttributeSlot*)slots
+                        slotCount:(size_t)slotCount
+                     originalData:(NSData*)originalData
+                            error:(NSError**)error
 {
-    NSMutableDictionary<NSNumber*, NSString*> *attributes = [NSMutableDictionary dictionaryWithCapacity:count];
-    
     for (NSUInteger i = 0; i < count; i++)
     {
         // read the attribute id
         if (dataLength <= *offset + 1)
         {
-            ANCSV2_SET_ERROR_AND_RETURN_NIL(RLYANCSV2ErrorCodeIncorrectDataSize, originalData);
+            ANCSV2_SET_ERROR_AND_RETURN_NO(RLYANCSV2ErrorCodeIncorrectDataSize, originalData);
         }
         
         uint8_t attributeIdentifier = bytes[*offset];
@@ -48,28 +91,31 @@ typedef NS_ENUM(uint8_t, RLYANCSV2ApplicationAttribute)
         // read the attribute length
         if (dataLength <= *offset + 2)
         {
-            ANCSV2_SET_ERROR_AND_RETURN_NIL(RLYANCSV2ErrorCodeIncorrectDataSize, originalData);
+            ANCSV2_SET_ERROR_AND_RETURN_NO(RLYANCSV2ErrorCodeIncorrectDataSize, originalData);
         }
         
-        uint16_t attributeLength = *(uint16_t*)(bytes + *offset);
+        uint16_t attributeLength = (uint16_t)bytes[*offset] | (uint16_t)(bytes[*offset + 1] << 8);
         *offset += 2;
         
-        // read the attribute
+        // skip over the attribute, recording its location if it's one that we track
         if (dataLength <= *offset + attributeLength)
         {
-            ANCSV2_SET_ERROR_AND_RETURN_NIL(RLYANCSV2ErrorCodeIncorrectDataSize, originalData);
+            ANCSV2_SET_ERROR_AND_RETURN_NO(RLYANCSV2ErrorCodeIncorrectDataSize, originalData);
         }
         
-        NSString *attributeValue = [[NSString alloc] initWithBytes:bytes + *offset
-                                                            length:attributeLength
-                                                          encoding:NSUTF8StringEncoding];
-        *offset += attributeLength;
+        if (attributeIdentifier < slotCount)
+        {
+            slots[attributeIdentifier] = (RLYANCSV2AttributeSlot){
+                .offset = *offset,
+                .length = attributeLength,
+                .present = YES
+            };
+        }
         
-        // update dictionary
-        attributes[@(attributeIdentifier)] = attributeValue;
+        *offset += attributeLength;
     }
     
-    return attributes;
+    return YES;
 }
 
 +(nullable RLYANCSNotification*)parseData:(NSData*)data
@@ -104,19 +150,19 @@ typedef NS_ENUM(uint8_t, RLYANCSV2ApplicationAttribute)
         ANCSV2_SET_ERROR_AND_RETURN_NIL(RLYANCSV2ErrorCodeIncorrectDataSize, data);
     }
     
-    __unused uint32_t notificationIdentifier = *(uint32_t*)(bytes + offset);
     offset += 4;
     
-    // read the notification attributes
-    NSDictionary<NSNumber*, NSString*> *notificationAttributes =
-        [RLYANCSV2Parser consumeAttributeDictionaryFromBytes:bytes
-                                                      offset:&offset
-                                                  dataLength:length
-                                              attributeCount:notificationAttributeCount
-                                                originalData:data
-                                                       error:error];
-    
-    if (!notificationAttributes)
+    // locate the notification attributes
+    RLYANCSV2AttributeSlot notificationAttributes[RLY_ANCS_V2_NOTIFICATION_ATTRIBUTE_COUNT] = { 0 };
+    
+    if (![RLYANCSV2Parser consumeAttributesFromBytes:bytes
+                                              offset:&offset
+                                          dataLength:length
+                                      attributeCount:notificationAttributeCount
+                                               slots:notificationAttributes
+                                           slotCount:RLY_ANCS_V2_NOTIFICATION_ATTRIBUTE_COUNT
+                                        originalData:data
+                                               error:error])
     {
         return nil;
     }
@@ -135,77 +181,70 @@ typedef NS_ENUM(uint8_t, RLYANCSV2ApplicationAttribute)
     offset++;
     
     // read the application identifier
-    size_t applicationIdentifierLength = 0;
-    
-    while (bytes[offset + applicationIdentifierLength] != '\0' && offset + applicationIdentifierLength < length)
-    {
-        applicationIdentifierLength++;
-    }
+    const uint8_t *terminator = memchr(bytes + offset, '\0', length - offset);
     
-    if (length <= offset + applicationIdentifierLength)
+    if (!terminator)
     {
         ANCSV2_SET_ERROR_AND_RETURN_NIL(RLYANCSV2ErrorCodeIncorrectDataSize, data);
     }
     
-    NSString *applicationIdentifier = [[NSString alloc] initWithBytes:bytes + offset
-                                                               length:applicationIdentifierLength
-                                                             encoding:NSUTF8StringEncoding];
-    
+    size_t applicationIdentifierOffset = offset;
+    size_t applicationIdentifierLength = (size_t)(terminator - (bytes + offset));
     offset += applicationIdentifierLength + 1;
     
-    // read the application attributes
-    NSDictionary<NSNumber*, NSString*> *applicationAttributes =
-        [RLYANCSV2Parser consumeAttributeDictionaryFromBytes:bytes
-                                                      offset:&offset
-                                                  dataLength:length
-                                              attributeCount:applicationAttributeCount
-                                                originalData:data
-                                                       error:error];
-    
-    if (!applicationAttributes)
+    // validate the application attributes - none of these are currently used, so we don't track any of them
+    if (![RLYANCSV2Parser consumeAttributesFromBytes:bytes
+                                              offset:&offset
+                                          dataLength:length
+                                      attributeCount:applicationAttributeCount
+                                               slots:NULL
+                                           slotCount:0
+                                        originalData:data
+                                               error:error])
     {
         return nil;
     }
     
-    // unpack required notification attributes
-    NSString *title = notificationAttributes[@(RLYANCSV2NotificationAttributeTitle)];
+    // decode required notification attributes
+    NSString *title = RLYANCSV2DecodeAttribute(bytes, notificationAttributes[RLYANCSV2NotificationAttributeTitle]);
     
     if (!title)
     {
         ANCSV2_SET_ERROR_AND_RETURN_NIL(RLYANCSV2ErrorCodeMissingTitle, data);
     }
     
-    NSString *dateString = notificationAttributes[@(RLYANCSV2NotificationAttributeDate)];
+    RLYANCSV2AttributeSlot dateSlot = notificationAttributes[RLYANCSV2NotificationAttributeDate];
     
-    if (!dateString)
+    if (!dateSlot.present)
     {
         ANCSV2_SET_ERROR_AND_RETURN_NIL(RLYANCSV2ErrorCodeMissingDate, data);
     }
     
-    // unpack nullable notification attribute message
-    NSString *message = notificationAttributes[@(RLYANCSV2NotificationAttributeMessage)];
+    // parse the date directly from the data, an invalid date is not an error
+    NSDate *date = nil;
+    RLYANCSDateComponents dateComponents;
+    
+    if (RLYANCSV2ParseDateComponents(bytes + dateSlot.offset, dateSlot.length, &dateComponents))
+    {
+        CFAbsoluteTime time = RLYANCSDateComponentsToAbsoluteTime(dateComponents, [NSTimeZone defaultTimeZone]);
+        date = [NSDate dateWithTimeIntervalSinceReferenceDate:time];
+    }
+    
+    // decode nullable notification attribute message
+    NSString *message = RLYANCSV2DecodeAttribute(bytes, notificationAttributes[RLYANCSV2NotificationAttributeMessage]);
+    
+    NSString *applicationIdentifier = [[NSString alloc] initWithBytes:bytes + applicationIdentifierOffset
+                                                               length:applicationIdentifierLength
+                                                             encoding:NSUTF8StringEncoding];
     
     // create ANCS notification
     return [[RLYANCSNotification alloc] initWithVersion:RLYANCSNotificationVersion2
                                                category:RLYANCSCategoryOther // TODO
                                   applicationIdentifier:applicationIdentifier
                                                   title:title
-                                                   date:[[self ANCSV2DateFormatter] dateFromString:dateString]
+                                                   date:date
                                                 message:message
                                              flagsValue:nil];
 }
 
-#pragma mark - Date Formatter
-+(NSDateFormatter*)ANCSV2DateFormatter
-{
-    static NSDateFormatter *formatter;
-    static dispatch_once_t onceToken;
-    dispatch_once(&onceToken, ^{
-        formatter = [NSDateFormatter new];
-        formatter.dateFormat = @"yyyyMMdd'T'HHmmSS";
-    });
-    
-    return formatter;
-}
-
 @end
@@ -1,5 +1,6 @@
 #import "RLYActivityTrackingUpdate.h"
 #import "RLYActivityTrackingUpdate+Internal.h"
+#import "RLYActivityTrackingUpdateBatch+Internal.h"
 #import "RLYErrorFunctions.h"
 
 @implementation RLYActivityTrackingUpdate
@@ -58,44 +59,13 @@
                                  errorCallback:(nonnull void (^)(NSError * _Nonnull))errorCallback
                             completionCallback:(nonnull void (^)())completionCallback
 {
-    // if the data is empty, this indicates the termination of data updates
-    if (data.length == 0)
-    {
-        completionCallback();
-        return;
-    }
-
-    // the data size must be a multiple of 5
-    size_t const packetSize = 5;
-
-    if (data.length % packetSize != 0)
-    {
-        errorCallback(RLYActivityTrackingUpdateError(RLYActivityTrackingUpdateErrorCodeIncorrectDataLength, @{
-            RLYActivityTrackingUpdateInvalidDataErrorKey: data
-        }));
-
-        return;
-    }
-
-    // parse data packets
-    size_t dataCount = data.length / packetSize;
-    uint8_t *bytes = (uint8_t*)data.bytes;
-
-    for (size_t i = 0; i < dataCount; i++)
-    {
-        size_t offset = i * packetSize;
-        NSError *error = nil;
-        RLYActivityTrackingUpdate *activityTrackingUpdate = [self updateAtOffset:offset ofBytes:bytes withError:&error];
-
-        if (activityTrackingUpdate)
+    // parse as a batch, then adapt to individual updates
+    [RLYActivityTrackingUpdateBatch parseActivityTrackingCharacteristicData:data withBatchCallback:^(RLYActivityTrackingUpdateBatch *batch) {
+        for (RLYActivityTrackingUpdate *update in batch.updates)
         {
-            updateCallback(activityTrackingUpdate);
+            updateCallback(update);
         }
-        else if (error)
-        {
-            errorCallback(error);
-        }
-    }
+    } errorCallback:errorCallback completionCallback:completionCallback];
 }
 
 +(RLYActivityTrackingUpdate*)updateAtOffset:(size_t)offset
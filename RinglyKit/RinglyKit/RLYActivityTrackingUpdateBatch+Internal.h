@@ -0,0 +1,25 @@
+#import "RLYActivityTrackingUpdateBatch.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface RLYActivityTrackingUpdateBatch ()
+
+#pragma mark - Parsing Data
+
+/**
+ *  Synchronously parses data from the activity tracking data characteristic into a single batch.
+ *
+ *  @param data               The data to parse.
+ *  @param batchCallback      A callback to call with the parsed batch. This will not be called if the data contained
+ *                            no updates.
+ *  @param errorCallback      A callback to call if the data could not be parsed.
+ *  @param completionCallback A callback to call if the data indicates that all available data has been read.
+ */
++(void)parseActivityTrackingCharacteristicData:(NSData*)data
+                             withBatchCallback:(__attribute__((noescape)) void(^)(RLYActivityTrackingUpdateBatch *batch))batchCallback
+                                 errorCallback:(__attribute__((noescape)) void(^)(NSError *error))errorCallback
+                            completionCallback:(__attribute__((noescape)) void(^)())completionCallback;
+
+@end
+
+NS_ASSUME_NONNULL_END
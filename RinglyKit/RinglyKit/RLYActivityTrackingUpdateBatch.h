@@ -0,0 +1,59 @@
+#import "RLYActivityTrackingUpdate.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ *  All of the activity tracking data sent by a peripheral in a single characteristic notification, stored as contiguous
+ *  arrays of minutes, walking steps, and running steps (a "struct of arrays"), instead of as individual objects.
+ *
+ *  Reset records (those with a minute of `0`) are not included.
+ */
+RINGLYKIT_FINAL @interface RLYActivityTrackingUpdateBatch : NSObject
+
+#pragma mark - Initialization
+
+/**
+ *  `+new` is unavailable, batches are created by `RLYPeripheral`.
+ */
++(instancetype)new NS_UNAVAILABLE;
+
+/**
+ *  `-init` is unavailable, batches are created by `RLYPeripheral`.
+ */
+-(instancetype)init NS_UNAVAILABLE;
+
+#pragma mark - Count
+
+/**
+ *  The number of updates in the batch. Each of the array properties contains this many elements.
+ */
+@property (nonatomic, readonly) NSUInteger count;
+
+#pragma mark - Arrays
+
+/**
+ *  The minute of each update. This array is owned by the batch, and is valid for the lifetime of the batch.
+ */
+@property (nonatomic, readonly) const RLYActivityTrackingMinute *minutes;
+
+/**
+ *  The walking steps of each update. This array is owned by the batch, and is valid for the lifetime of the batch.
+ */
+@property (nonatomic, readonly) const RLYActivityTrackingSteps *walkingSteps;
+
+/**
+ *  The running steps of each update. This array is owned by the batch, and is valid for the lifetime of the batch.
+ */
+@property (nonatomic, readonly) const RLYActivityTrackingSteps *runningSteps;
+
+#pragma mark - Updates
+
+/**
+ *  The batch's contents, as update objects. These objects are created the first time this property is accessed, so
+ *  clients that only need the arrays do not pay for them.
+ */
+@property (nonatomic, readonly, strong) NSArray<RLYActivityTrackingUpdate*> *updates;
+
+@end
+
+NS_ASSUME_NONNULL_END
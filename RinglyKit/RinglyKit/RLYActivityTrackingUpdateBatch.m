@@ -0,0 +1,140 @@
+#import "RLYActivityTrackingUpdateBatch.h"
+#import "RLYActivityTrackingUpdateBatch+Internal.h"
+#import "RLYErrorFunctions.h"
+
+/**
+ *  The size of a single record in the activity tracking data characteristic.
+ */
+#define RLY_ACTIVITY_TRACKING_RECORD_SIZE 5
+
+@interface RLYActivityTrackingUpdateBatch ()
+{
+@private
+    // a single allocation, containing the minutes array followed by the walking and running steps arrays
+    uint8_t *_storage;
+    NSArray<RLYActivityTrackingUpdate*> *_updates;
+}
+
+@end
+
+@implementation RLYActivityTrackingUpdateBatch
+
+#pragma mark - Initialization
+-(instancetype)initWithStorage:(uint8_t*)storage capacity:(NSUInteger)capacity count:(NSUInteger)count
+{
+    self = [super init];
+
+    if (self)
+    {
+        _storage = storage;
+        _count = count;
+        _minutes = (const RLYActivityTrackingMinute*)storage;
+        _walkingSteps = storage + capacity * sizeof(RLYActivityTrackingMinute);
+        _runningSteps = _walkingSteps + capacity;
+    }
+
+    return self;
+}
+
+-(void)dealloc
+{
+    free(_storage);
+}
+
+#pragma mark - Updates
+-(NSArray<RLYActivityTrackingUpdate*>*)updates
+{
+    @synchronized (self)
+    {
+        if (!_updates)
+        {
+            NSMutableArray *updates = [NSMutableArray arrayWithCapacity:_count];
+
+            for (NSUInteger i = 0; i < _count; i++)
+            {
+                RLYActivityTrackingDate *date = [RLYActivityTrackingDate dateWithMinute:_minutes[i] error:nil];
+
+                [updates addObject:[[RLYActivityTrackingUpdate alloc] initWithDate:date
+                                                                      walkingSteps:_walkingSteps[i]
+                                                                      runningSteps:_runningSteps[i]]];
+            }
+
+            _updates = updates;
+        }
+
+        return _updates;
+    }
+}
+
+#pragma mark - Description
+-(NSString*)description
+{
+    return [NSString stringWithFormat:@"(count = %lu, first = %d, last = %d)",
+                                      (unsigned long)_count,
+                                      _count > 0 ? _minutes[0] : 0,
+                                      _count > 0 ? _minutes[_count - 1] : 0];
+}
+
+#pragma mark - Parsing Data
++(void)parseActivityTrackingCharacteristicData:(NSData*)data
+                             withBatchCallback:(void (^)(RLYActivityTrackingUpdateBatch * _Nonnull))batchCallback
+                                 errorCallback:(void (^)(NSError * _Nonnull))errorCallback
+                            completionCallback:(void (^)())completionCallback
+{
+    // if the data is empty, this indicates the termination of data updates
+    if (data.length == 0)
+    {
+        completionCallback();
+        return;
+    }
+
+    // the data size must be a multiple of the record size
+    if (data.length % RLY_ACTIVITY_TRACKING_RECORD_SIZE != 0)
+    {
+        errorCallback(RLYActivityTrackingUpdateError(RLYActivityTrackingUpdateErrorCodeIncorrectDataLength, @{
+            RLYActivityTrackingUpdateInvalidDataErrorKey: data
+        }));
+
+        return;
+    }
+
+    NSUInteger capacity = data.length / RLY_ACTIVITY_TRACKING_RECORD_SIZE;
+    const uint8_t *bytes = (const uint8_t*)data.bytes;
+
+    uint8_t *storage = malloc(capacity * (sizeof(RLYActivityTrackingMinute) + 2 * sizeof(RLYActivityTrackingSteps)));
+    RLYActivityTrackingMinute *minutes = (RLYActivityTrackingMinute*)storage;
+    RLYActivityTrackingSteps *walkingSteps = storage + capacity * sizeof(RLYActivityTrackingMinute);
+    RLYActivityTrackingSteps *runningSteps = walkingSteps + capacity;
+
+    // unpack each record - this loop has no branches, so that the compiler is free to vectorize it. reset records,
+    // which have a minute of `0`, are written and then overwritten by the next record, by not advancing the count.
+    //
+    // the minute is 23 bits, so it can never exceed `RLYActivityTrackingMinuteMax`, and once reset records are dropped
+    // it can never be less than `RLYActivityTrackingMinuteMin` - no per-record validation is necessary
+    NSUInteger count = 0;
+
+    for (NSUInteger i = 0; i < capacity; i++)
+    {
+        const uint8_t *record = bytes + i * RLY_ACTIVITY_TRACKING_RECORD_SIZE;
+
+        RLYActivityTrackingMinute minute = (RLYActivityTrackingMinute)record[0]
+                                         | ((RLYActivityTrackingMinute)record[1] << 8)
+                                         | ((RLYActivityTrackingMinute)(record[2] & 0b01111111) << 16);
+
+        minutes[count] = minute;
+        walkingSteps[count] = record[3];
+        runningSteps[count] = record[4];
+        count += minute != 0;
+    }
+
+    if (count > 0)
+    {
+        batchCallback([[self alloc] initWithStorage:storage capacity:capacity count:count]);
+    }
+    else
+    {
+        free(storage);
+    }
+}
+
+@end
@@ -86,6 +86,15 @@ RINGLYKIT_EXTERN NSComparisonResult RLYCompareVersionNumbers(NSString *first, NS
  */
 RINGLYKIT_EXTERN NSData *RLYScanANCSV1Header(NSData *data);
 
+/**
+ *  Returns the length of the ANCS v1 header at the start of `bytes`, including the terminating comma, or `0` if no
+ *  header is present. This is the allocation-free equivalent of `RLYScanANCSV1Header`.
+ *
+ *  @param bytes  The bytes to scan.
+ *  @param length The number of bytes available.
+ */
+RINGLYKIT_EXTERN size_t RLYScanANCSV1HeaderLength(const uint8_t *bytes, size_t length);
+
 #pragma mark - Data String Parsing
 
 /**
@@ -103,6 +112,15 @@ RINGLYKIT_EXTERN NSData *RLYSubdataToFirstNull(NSData *data);
  */
 RINGLYKIT_EXTERN NSString *RLYFindValidUTF8Prefix(NSData *data);
 
+/**
+ *  Returns the length of the longest prefix of `bytes` that is valid UTF-8, without dropping into a partial multi-byte
+ *  sequence. This is the allocation-free equivalent of `RLYFindValidUTF8Prefix`.
+ *
+ *  @param bytes  The bytes to validate.
+ *  @param length The number of bytes available.
+ */
+RINGLYKIT_EXTERN size_t RLYValidUTF8PrefixLength(const uint8_t *bytes, size_t length);
+
 /**
  *  Drops bytes from the start of `data` until it parses as a valid UTF-8 string. This function cannot return `nil`, as
  *  a data of length `0` will always correctly parse to the empty string.
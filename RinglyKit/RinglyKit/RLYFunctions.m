@@ -122,15 +122,14 @@ NSComparisonResult RLYCompareVersionNumbers(NSString *first, NSString *second)
 #pragma mark - ANCS Version 1
 NSData *RLYScanANCSV1Header(NSData *data)
 {
-    for (NSUInteger i = 0; i < data.length; i++)
-    {
-        if (((uint8_t*)data.bytes)[i] == ',')
-        {
-            return [data subdataWithRange:NSMakeRange(0, i + 1)];
-        }
-    }
-    
-    return nil;
+    size_t length = RLYScanANCSV1HeaderLength((const uint8_t*)data.bytes, data.length);
+    return length > 0 ? [data subdataWithRange:NSMakeRange(0, length)] : nil;
+}
+
+size_t RLYScanANCSV1HeaderLength(const uint8_t *bytes, size_t length)
+{
+    const uint8_t *comma = memchr(bytes, ',', length);
+    return comma ? (size_t)(comma - bytes) + 1 : 0;
 }
 
 #pragma mark - Data String Parsing
@@ -149,17 +148,75 @@ NSData *RLYSubdataToFirstNull(NSData *data)
 
 NSString *RLYFindValidUTF8Prefix(NSData *data)
 {
-    NSString *string = [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+    const uint8_t *bytes = (const uint8_t*)data.bytes;
+    size_t length = RLYValidUTF8PrefixLength(bytes, data.length);
     
-    if (string)
-    {
-        return string;
-    }
-    else
+    return [[NSString alloc] initWithBytes:bytes length:length encoding:NSUTF8StringEncoding] ?: @"";
+}
+
+size_t RLYValidUTF8PrefixLength(const uint8_t *bytes, size_t length)
+{
+    size_t offset = 0;
+    
+    while (offset < length)
     {
-        NSData *subdata = [data subdataWithRange:NSMakeRange(0, data.length - 1)];
-        return RLYFindValidUTF8Prefix(subdata);
+        uint8_t lead = bytes[offset];
+        
+        // fast path for ASCII
+        if (lead < 0x80)
+        {
+            offset++;
+            continue;
+        }
+        
+        // determine the sequence length and the valid range for the second byte (excluding overlong encodings,
+        // surrogates, and values above U+10FFFF)
+        size_t sequenceLength;
+        uint8_t secondMinimum = 0x80, secondMaximum = 0xbf;
+        
+        if (lead >= 0xc2 && lead <= 0xdf)
+        {
+            sequenceLength = 2;
+        }
+        else if (lead >= 0xe0 && lead <= 0xef)
+        {
+            sequenceLength = 3;
+            if (lead == 0xe0) { secondMinimum = 0xa0; }
+            if (lead == 0xed) { secondMaximum = 0x9f; }
+        }
+        else if (lead >= 0xf0 && lead <= 0xf4)
+        {
+            sequenceLength = 4;
+            if (lead == 0xf0) { secondMinimum = 0x90; }
+            if (lead == 0xf4) { secondMaximum = 0x8f; }
+        }
+        else
+        {
+            return offset;
+        }
+        
+        if (offset + sequenceLength > length)
+        {
+            return offset;
+        }
+        
+        if (bytes[offset + 1] < secondMinimum || bytes[offset + 1] > secondMaximum)
+        {
+            return offset;
+        }
+        
+        for (size_t i = 2; i < sequenceLength; i++)
+        {
+            if ((bytes[offset + i] & 0xc0) != 0x80)
+            {
+                return offset;
+            }
+        }
+        
+        offset += sequenceLength;
     }
+    
+    return offset;
 }
 
 NSString *RLYFindValidUTF8Suffix(NSData *data)
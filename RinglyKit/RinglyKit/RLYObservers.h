@@ -6,6 +6,9 @@
  *
  *  This can be considered a form of delegation, with an arbitrary number of subscribers. Observers are weakly
  *  referenced, so they will be removed automatically if deallocated.
+ *
+ *  Observers may be added and removed from any thread. Enumeration reads an immutable snapshot of the observers, so
+ *  observers may be added or removed, and events may be sent, from within an enumeration block.
  */
 @interface RLYObservers : NSObject
 
@@ -29,7 +32,7 @@ NS_ASSUME_NONNULL_BEGIN
 -(void)removeObserver:(id)observer;
 
 /**
- *  Enumerates the observers.
+ *  Enumerates the observers. Observers added or removed during enumeration will not affect the current enumeration.
  *
  *  @param block A block, which will recieve each observer.
  */
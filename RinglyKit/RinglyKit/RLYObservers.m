@@ -1,28 +1,27 @@
 #import "RLYObservers.h"
+#import <pthread.h>
+#import <stdatomic.h>
 
 @interface RLYObservableWrapper : NSObject
 
-@property (nonatomic, weak) id observer;
+-(instancetype)initWithObserver:(id)observer;
+
+@property (nonatomic, readonly, weak) id observer;
 
 @end
 
 @implementation RLYObservableWrapper
 
--(NSUInteger)hash
+-(instancetype)initWithObserver:(id)observer
 {
-    return [_observer hash];
-}
+    self = [super init];
 
--(BOOL)isEqual:(id)object
-{
-    if ([object isKindOfClass:[RLYObservableWrapper class]])
-    {
-        return [_observer isEqual:[object observer]];
-    }
-    else
+    if (self)
     {
-        return NO;
+        _observer = observer;
     }
+
+    return self;
 }
 
 @end
@@ -30,7 +29,14 @@
 @interface RLYObservers ()
 {
 @private
-    NSMutableSet *_observers;
+    // an immutable array of wrappers, which is replaced (never mutated) when observers are added or removed
+    NSArray<RLYObservableWrapper*> *_snapshot;
+
+    // serializes replacement of the snapshot, and guards reading it
+    pthread_mutex_t _mutex;
+
+    // set when enumeration finds a deallocated observer, so that the snapshot is compacted
+    atomic_bool _needsCompaction;
 }
 
 @end
@@ -44,38 +50,100 @@
     
     if (self)
     {
-        _observers = [NSMutableSet set];
+        _snapshot = @[];
+        pthread_mutex_init(&_mutex, NULL);
+        atomic_init(&_needsCompaction, false);
     }
     
     return self;
 }
 
+-(void)dealloc
+{
+    pthread_mutex_destroy(&_mutex);
+}
+
+#pragma mark - Snapshots
+-(NSArray<RLYObservableWrapper*>*)snapshot
+{
+    // the lock is only held to retain the current snapshot - enumeration happens outside of it, so observers can add
+    // or remove observers, or send further events, without deadlocking
+    pthread_mutex_lock(&_mutex);
+    NSArray *snapshot = _snapshot;
+    pthread_mutex_unlock(&_mutex);
+
+    return snapshot;
+}
+
+/**
+ *  Replaces the snapshot with a new snapshot, excluding deallocated observers. The mutex must be held.
+ *
+ *  @param excluded An observer to exclude, or `nil`.
+ *  @param included An observer to include, or `nil`. If this observer is already included, it will not be added again.
+ */
+-(void)lockedReplaceSnapshotExcluding:(id)excluded including:(id)included
+{
+    NSMutableArray *snapshot = [NSMutableArray arrayWithCapacity:_snapshot.count + 1];
+    BOOL alreadyIncluded = NO;
+
+    for (RLYObservableWrapper *wrapper in _snapshot)
+    {
+        id observer = wrapper.observer;
+
+        if (observer && observer != excluded)
+        {
+            [snapshot addObject:wrapper];
+            alreadyIncluded = alreadyIncluded || observer == included;
+        }
+    }
+
+    if (included && !alreadyIncluded)
+    {
+        [snapshot addObject:[[RLYObservableWrapper alloc] initWithObserver:included]];
+    }
+
+    atomic_store(&_needsCompaction, false);
+    _snapshot = [snapshot copy];
+}
+
 #pragma mark - Observers
 -(void)addObserver:(id)observer
 {
-    RLYObservableWrapper *wrapper = [RLYObservableWrapper new];
-    wrapper.observer = observer;
-    
-    [_observers addObject:wrapper];
+    pthread_mutex_lock(&_mutex);
+    [self lockedReplaceSnapshotExcluding:nil including:observer];
+    pthread_mutex_unlock(&_mutex);
 }
 
 -(void)removeObserver:(id)observer
 {
-    [_observers filterUsingPredicate:[NSPredicate predicateWithBlock:^BOOL(RLYObservableWrapper *wrapper, NSDictionary *bindings) {
-        return wrapper.observer && wrapper.observer != observer;
-    }]];
+    pthread_mutex_lock(&_mutex);
+    [self lockedReplaceSnapshotExcluding:observer including:nil];
+    pthread_mutex_unlock(&_mutex);
 }
 
 -(void)enumerateObservers:(void(^)(id observer))block
 {
-    [_observers filterUsingPredicate:[NSPredicate predicateWithBlock:^BOOL(RLYObservableWrapper *wrapper, NSDictionary *bindings) {
-        if (wrapper.observer)
+    for (RLYObservableWrapper *wrapper in [self snapshot])
+    {
+        id observer = wrapper.observer;
+
+        if (observer)
+        {
+            block(observer);
+        }
+        else
         {
-            block(wrapper.observer);
+            atomic_store(&_needsCompaction, true);
         }
-        
-        return wrapper.observer != nil;
-    }]];
+    }
+
+    // deallocated observers are removed after enumeration, so that the common case never allocates
+    if (atomic_exchange(&_needsCompaction, false))
+    {
+        pthread_mutex_lock(&_mutex);
+        [self lockedReplaceSnapshotExcluding:nil including:nil];
+        pthread_mutex_unlock(&_mutex);
+    }
 }
 
 @end
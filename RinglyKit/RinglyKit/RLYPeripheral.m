@@ -2,6 +2,7 @@
 #import "RLYANCSV1Parser.h"
 #import "RLYANCSV2Parser.h"
 #import "RLYActivityTrackingUpdate+Internal.h"
+#import "RLYActivityTrackingUpdateBatch+Internal.h"
 #import "RLYClearBondsCommand.h"
 #import "RLYCommand+Internal.h"
 #import "RLYDateTimeCommand.h"
@@ -21,6 +22,21 @@
 #import "RLYPeripheralEnumerations+Internal.h"
 #import "RLYPeripheralServices.h"
 #import "RLYUUID.h"
+#import "RLYWritePipeline.h"
+
+/**
+ *  The maximum number of writes awaiting a response from a peripheral at once.
+ */
+#define RLY_PERIPHERAL_WRITE_WINDOW_SIZE 4
+
+/**
+ *  The maximum number of commands written in a single burst, when writing without a response is allowed.
+ */
+#define RLY_PERIPHERAL_WRITE_BURST_SIZE 8
+
+@interface CBPeripheral (RLYWritePipelineTarget) <RLYWritePipelineTarget>
+
+@end
 
 @interface RLYPeripheral () <RLYANCSV1ParserDelegate, CBPeripheralDelegate>
 {
@@ -33,6 +49,9 @@
     
     // configuration hash completion blocks
     NSMutableArray *_configurationHashBlocks;
+
+    // writes
+    RLYWritePipeline *_writePipeline;
 }
 
 // ANCS v2
@@ -165,6 +184,10 @@ static NSMapTable *RLYPeripheralUniqueTable = nil;
         
         _CBPeripheral = CBPeripheral;
         _CBPeripheral.delegate = self;
+
+        _writePipeline = [[RLYWritePipeline alloc] initWithTarget:_CBPeripheral
+                                                       windowSize:RLY_PERIPHERAL_WRITE_WINDOW_SIZE
+                                                        burstSize:RLY_PERIPHERAL_WRITE_BURST_SIZE];
         
         _name = _CBPeripheral.name;
         _identifier = _CBPeripheral.identifier;
@@ -340,6 +363,9 @@ static NSMapTable *RLYPeripheralUniqueTable = nil;
             break;
             
         case CBPeripheralStateDisconnected: {
+            // responses will never arrive for pending writes
+            [_writePipeline failAllWritesWithError:RLYPeripheralError(RLYPeripheralErrorCodePeripheralDisconnected)];
+
             [self clearServicesAndCharacteristics];
 
             // reset properties that are now unknowable
@@ -458,6 +484,11 @@ static NSMapTable *RLYPeripheralUniqueTable = nil;
 
 #pragma mark - Commands
 -(void)writeCommand:(id<RLYCommand>)command
+{
+    [self writeCommand:command completion:nil];
+}
+
+-(void)writeCommand:(id<RLYCommand>)command completion:(nullable void(^)(NSError *_Nullable error))completion
 {
     RLYBreakpointIf(_centralManagerState != CBCentralManagerStatePoweredOn);
     
@@ -470,25 +501,55 @@ static NSMapTable *RLYPeripheralUniqueTable = nil;
     
     if (self.canWriteCommands)
     {
-        [_CBPeripheral writeValue:RLYCommandDataRepresentation(command)
-                forCharacteristic:_ringlyCharacteristics.command
-                             type:CBCharacteristicWriteWithResponse];
-        
+        __weak typeof(self) weakSelf = self;
+
+        [_writePipeline enqueueData:RLYCommandDataRepresentation(command)
+                  forCharacteristic:_ringlyCharacteristics.command
+         allowsWriteWithoutResponse:YES
+                         completion:^(NSError *error) {
+                             [weakSelf completeWriteOfCommand:command withError:error];
+
+                             if (completion)
+                             {
+                                 completion(error);
+                             }
+                         }];
+    }
+    else
+    {
+        NSError *error = RLYPeripheralError(RLYPeripheralErrorCodePeripheralDisconnected);
+        [self completeWriteOfCommand:command withError:error];
+
+        if (completion)
+        {
+            completion(error);
+        }
+    }
+}
+
+/**
+ *  Notifies observers that a command was written, or failed to write.
+ *
+ *  @param command The command.
+ *  @param error   The error, if the command failed to write.
+ */
+-(void)completeWriteOfCommand:(id<RLYCommand>)command withError:(nullable NSError*)error
+{
+    if (error)
+    {
         [_observers enumerateObservers:^void(id<RLYPeripheralObserver> observer) {
-            if ([observer respondsToSelector:@selector(peripheral:didWriteCommand:)])
+            if ([observer respondsToSelector:@selector(peripheral:failedToWriteCommand:withError:)])
             {
-                [observer peripheral:self didWriteCommand:command];
+                [observer peripheral:self failedToWriteCommand:command withError:error];
             }
         }];
     }
     else
     {
-        NSError *error = RLYPeripheralError(RLYPeripheralErrorCodePeripheralDisconnected);
-        
         [_observers enumerateObservers:^void(id<RLYPeripheralObserver> observer) {
-            if ([observer respondsToSelector:@selector(peripheral:failedToWriteCommand:withError:)])
+            if ([observer respondsToSelector:@selector(peripheral:didWriteCommand:)])
             {
-                [observer peripheral:self failedToWriteCommand:command withError:error];
+                [observer peripheral:self didWriteCommand:command];
             }
         }];
     }
@@ -526,6 +587,21 @@ static NSMapTable *RLYPeripheralUniqueTable = nil;
     return _state == CBPeripheralStateConnected && _ringlyCharacteristics.command;
 }
 
+-(BOOL)allowsCommandWritesWithoutResponse
+{
+    return _writePipeline.allowsWritesWithoutResponse;
+}
+
+-(void)setAllowsCommandWritesWithoutResponse:(BOOL)allowsCommandWritesWithoutResponse
+{
+    _writePipeline.allowsWritesWithoutResponse = allowsCommandWritesWithoutResponse;
+}
+
+-(RLYPeripheralWriteStatistics*)writeStatistics
+{
+    return _writePipeline.statistics;
+}
+
 #pragma mark - Reading Information
 +(NSSet*)keyPathsForValuesAffectingReadBondCharacteristicSupport
 {
@@ -670,10 +746,12 @@ static NSMapTable *RLYPeripheralUniqueTable = nil;
     {
         NSData *data = [NSData dataWithBytes:&hash length:sizeof(hash)];
         
+        // the hash is written through the pipeline, so that it is not written before preceding commands
         RLYBreakpointIf(_centralManagerState != CBCentralManagerStatePoweredOn);
-        [_CBPeripheral writeValue:data
-                forCharacteristic:_ringlyCharacteristics.configurationHash
-                             type:CBCharacteristicWriteWithResponse];
+        [_writePipeline enqueueData:data
+                  forCharacteristic:_ringlyCharacteristics.configurationHash
+         allowsWriteWithoutResponse:NO
+                         completion:nil];
         
         return YES;
     }
@@ -1697,11 +1775,20 @@ static NSMapTable *RLYPeripheralUniqueTable = nil;
 
         if (data)
         {
-            [RLYActivityTrackingUpdate parseActivityTrackingCharacteristicData:data withUpdateCallback:^(RLYActivityTrackingUpdate* update) {
+            [RLYActivityTrackingUpdateBatch parseActivityTrackingCharacteristicData:data withBatchCallback:^(RLYActivityTrackingUpdateBatch* batch) {
+                // deliver each packet to observers once - observers that only implement the per-update message share
+                // the batch's lazily created update objects
                 [_observers enumerateObservers:^(id  _Nonnull observer) {
-                    if ([observer respondsToSelector:@selector(peripheral:readActivityTrackingUpdate:)])
+                    if ([observer respondsToSelector:@selector(peripheral:readActivityTrackingBatch:)])
+                    {
+                        [observer peripheral:self readActivityTrackingBatch:batch];
+                    }
+                    else if ([observer respondsToSelector:@selector(peripheral:readActivityTrackingUpdate:)])
                     {
-                        [observer peripheral:self readActivityTrackingUpdate:update];
+                        for (RLYActivityTrackingUpdate *update in batch.updates)
+                        {
+                            [observer peripheral:self readActivityTrackingUpdate:update];
+                        }
                     }
                 }];
             } errorCallback:^(NSError* error) {
@@ -1777,6 +1864,9 @@ static NSMapTable *RLYPeripheralUniqueTable = nil;
 
 -(void)peripheral:(CBPeripheral *)peripheral didWriteValueForCharacteristic:(CBCharacteristic *)characteristic error:(NSError *)error
 {
+    // writes that were not sent through the pipeline will not be matched, which is fine
+    [_writePipeline didWriteValueForCharacteristic:characteristic error:error];
+
     if (error)
     {
         RLYLogFunction(@"Error writing to characteristic %@ on “%@”: %@", characteristic.UUID, self.lastFourMAC, error);
@@ -1,5 +1,6 @@
 #import "RLYANCSNotification.h"
 #import "RLYActivityTrackingUpdate.h"
+#import "RLYActivityTrackingUpdateBatch.h"
 #import "RLYColor.h"
 #import "RLYCommand.h"
 #import "RLYVibration.h"
@@ -143,7 +144,7 @@ NS_ASSUME_NONNULL_BEGIN
 -(void)peripheral:(RLYPeripheral*)peripheral willWriteCommand:(id<RLYCommand>)command;
 
 /**
- *  Notifies the observer that a `RLYCommand` was written to the peripheral.
+ *  Notifies the observer that a `RLYCommand` was written to the peripheral, and acknowledged by the peripheral.
  *
  *  @param peripheral The peripheral.
  *  @param command    The command that was written to the peripheral.
@@ -169,6 +170,17 @@ NS_ASSUME_NONNULL_BEGIN
  */
 -(void)peripheral:(RLYPeripheral*)peripheral readActivityTrackingUpdate:(RLYActivityTrackingUpdate*)activityTrackingUpdate;
 
+/**
+ *  Notifies the observer that a batch of activity tracking data was read from the peripheral. This message is sent
+ *  once for each packet of data that the peripheral sends.
+ *
+ *  If an observer implements this message, it will not receive `-peripheral:readActivityTrackingUpdate:`.
+ *
+ *  @param peripheral The peripheral.
+ *  @param batch      The batch of activity tracking updates that was read.
+ */
+-(void)peripheral:(RLYPeripheral*)peripheral readActivityTrackingBatch:(RLYActivityTrackingUpdateBatch*)batch;
+
 /**
  *  Notifies the observer that an error was encountered while reading activity tracking updates from the peripheral.
  *
@@ -0,0 +1,32 @@
+#import "RLYPeripheralWriteStatistics.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface RLYPeripheralWriteStatistics ()
+
+#pragma mark - Initialization
+
+/**
+ *  Initializes a write statistics snapshot.
+ *
+ *  @param completedWriteCount        The number of completed writes.
+ *  @param failedWriteCount           The number of failed writes.
+ *  @param writeWithoutResponseCount  The number of completed writes sent without a response.
+ *  @param pendingWriteCount          The number of pending writes.
+ *  @param completedByteCount         The number of bytes in completed writes.
+ *  @param totalLatency               The total latency of all completed writes.
+ *  @param maximumLatency             The maximum latency of a completed write.
+ *  @param activeDuration             The total time during which writes were pending.
+ */
+-(instancetype)initWithCompletedWriteCount:(NSUInteger)completedWriteCount
+                          failedWriteCount:(NSUInteger)failedWriteCount
+                 writeWithoutResponseCount:(NSUInteger)writeWithoutResponseCount
+                         pendingWriteCount:(NSUInteger)pendingWriteCount
+                        completedByteCount:(uint64_t)completedByteCount
+                              totalLatency:(NSTimeInterval)totalLatency
+                            maximumLatency:(NSTimeInterval)maximumLatency
+                            activeDuration:(NSTimeInterval)activeDuration NS_DESIGNATED_INITIALIZER;
+
+@end
+
+NS_ASSUME_NONNULL_END
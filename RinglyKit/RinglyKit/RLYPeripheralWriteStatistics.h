@@ -0,0 +1,79 @@
+#import <Foundation/Foundation.h>
+#import "RLYDefines.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ *  A snapshot of the latency and throughput of a peripheral's write pipeline.
+ *
+ *  Latency is measured from when a write is requested (i.e. `-writeCommand:` is called) until the peripheral
+ *  acknowledges it, so it includes time spent waiting in the pipeline.
+ */
+RINGLYKIT_FINAL @interface RLYPeripheralWriteStatistics : NSObject
+
+#pragma mark - Initialization
+
+/**
+ *  `+new` is unavailable, statistics are created by `RLYPeripheral`.
+ */
++(instancetype)new NS_UNAVAILABLE;
+
+/**
+ *  `-init` is unavailable, statistics are created by `RLYPeripheral`.
+ */
+-(instancetype)init NS_UNAVAILABLE;
+
+#pragma mark - Counts
+
+/**
+ *  The number of writes that have been acknowledged by the peripheral.
+ */
+@property (nonatomic, readonly) NSUInteger completedWriteCount;
+
+/**
+ *  The number of writes that failed, either with an error from the peripheral, or due to disconnection.
+ */
+@property (nonatomic, readonly) NSUInteger failedWriteCount;
+
+/**
+ *  The number of completed writes that were sent without a response, as part of a burst.
+ */
+@property (nonatomic, readonly) NSUInteger writeWithoutResponseCount;
+
+/**
+ *  The number of writes that are queued or awaiting acknowledgement.
+ */
+@property (nonatomic, readonly) NSUInteger pendingWriteCount;
+
+/**
+ *  The total number of bytes in completed writes.
+ */
+@property (nonatomic, readonly) uint64_t completedByteCount;
+
+#pragma mark - Latency
+
+/**
+ *  The mean latency of completed writes, or `0` if no writes have completed.
+ */
+@property (nonatomic, readonly) NSTimeInterval averageLatency;
+
+/**
+ *  The maximum latency of a completed write, or `0` if no writes have completed.
+ */
+@property (nonatomic, readonly) NSTimeInterval maximumLatency;
+
+#pragma mark - Throughput
+
+/**
+ *  The total time during which the pipeline had pending writes.
+ */
+@property (nonatomic, readonly) NSTimeInterval activeDuration;
+
+/**
+ *  The number of completed writes per second of `activeDuration`, or `0` if the pipeline has not been active.
+ */
+@property (nonatomic, readonly) double writesPerSecond;
+
+@end
+
+NS_ASSUME_NONNULL_END
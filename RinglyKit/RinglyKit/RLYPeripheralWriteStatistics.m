@@ -0,0 +1,44 @@
+#import "RLYPeripheralWriteStatistics+Internal.h"
+
+@implementation RLYPeripheralWriteStatistics
+
+#pragma mark - Initialization
+-(instancetype)initWithCompletedWriteCount:(NSUInteger)completedWriteCount
+                          failedWriteCount:(NSUInteger)failedWriteCount
+                 writeWithoutResponseCount:(NSUInteger)writeWithoutResponseCount
+                         pendingWriteCount:(NSUInteger)pendingWriteCount
+                        completedByteCount:(uint64_t)completedByteCount
+                              totalLatency:(NSTimeInterval)totalLatency
+                            maximumLatency:(NSTimeInterval)maximumLatency
+                            activeDuration:(NSTimeInterval)activeDuration
+{
+    self = [super init];
+
+    if (self)
+    {
+        _completedWriteCount = completedWriteCount;
+        _failedWriteCount = failedWriteCount;
+        _writeWithoutResponseCount = writeWithoutResponseCount;
+        _pendingWriteCount = pendingWriteCount;
+        _completedByteCount = completedByteCount;
+        _averageLatency = completedWriteCount > 0 ? totalLatency / completedWriteCount : 0;
+        _maximumLatency = maximumLatency;
+        _activeDuration = activeDuration;
+        _writesPerSecond = activeDuration > 0 ? completedWriteCount / activeDuration : 0;
+    }
+
+    return self;
+}
+
+#pragma mark - Description
+-(NSString*)description
+{
+    return [NSString stringWithFormat:@"(completed = %lu, failed = %lu, pending = %lu, average latency = %.3fs, writes/s = %.1f)",
+                                      (unsigned long)_completedWriteCount,
+                                      (unsigned long)_failedWriteCount,
+                                      (unsigned long)_pendingWriteCount,
+                                      _averageLatency,
+                                      _writesPerSecond];
+}
+
+@end
@@ -1,4 +1,5 @@
 #import "RLYCommand.h"
+#import "RLYPeripheralWriteStatistics.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -18,11 +19,39 @@ NS_ASSUME_NONNULL_BEGIN
  */
 -(void)writeCommand:(id<RLYCommand>)command NS_SWIFT_NAME(write(command:));
 
+/**
+ *  Writes a `Command` to the peripheral.
+ *
+ *  Commands are queued, and a limited number are sent to the peripheral at once. They are written in order.
+ *
+ *  @param command    The command to write to the peripheral. This parameter may not be `nil`.
+ *  @param completion A completion block, which will be called with `nil` once the peripheral acknowledges the command,
+ *                    or with an error if the command could not be written.
+ */
+-(void)writeCommand:(id<RLYCommand>)command
+         completion:(nullable void(^)(NSError *_Nullable error))completion
+    NS_SWIFT_NAME(write(command:completion:));
+
 /**
  *  Returns `YES` if commands can be written to the peripheral.
  */
 @property (nonatomic, readonly) BOOL canWriteCommands;
 
+/**
+ *  If `YES`, and the peripheral's firmware supports it, consecutive commands will be written without a response, in
+ *  bursts. The final command in each burst is written with a response, which acknowledges the entire burst.
+ *
+ *  The default value of this property is `NO`.
+ */
+@property (nonatomic) BOOL allowsCommandWritesWithoutResponse;
+
+#pragma mark - Statistics
+
+/**
+ *  A snapshot of the latency and throughput of writes to the peripheral, including commands and configuration hashes.
+ */
+@property (nonatomic, readonly, strong) RLYPeripheralWriteStatistics *writeStatistics;
+
 #pragma mark - Clear Bond
 
 /**
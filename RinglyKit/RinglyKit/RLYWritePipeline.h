@@ -0,0 +1,126 @@
+#import <CoreBluetooth/CoreBluetooth.h>
+#import "RLYPeripheralWriteStatistics.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ *  The object that a `RLYWritePipeline` writes to. `CBPeripheral` conforms to this protocol without additions.
+ */
+@protocol RLYWritePipelineTarget <NSObject>
+
+/**
+ *  Writes a value to a characteristic.
+ *
+ *  @param data           The data to write.
+ *  @param characteristic The characteristic to write to.
+ *  @param type           The write type.
+ */
+-(void)writeValue:(NSData*)data forCharacteristic:(CBCharacteristic*)characteristic type:(CBCharacteristicWriteType)type;
+
+@end
+
+/**
+ *  A completion block for a write in a `RLYWritePipeline`.
+ *
+ *  @param error An error, if the write failed, or `nil` if it was acknowledged.
+ */
+typedef void(^RLYWritePipelineCompletion)(NSError *_Nullable error);
+
+/**
+ *  Queues writes to a peripheral, limiting the number of writes awaiting a response, and matching responses from
+ *  `-peripheral:didWriteValueForCharacteristic:error:` to their writes.
+ *
+ *  Writes are sent in the order that they are enqueued. When enabled, consecutive writes to characteristics that
+ *  support it are sent without a response, in bursts. The last write of each burst is always sent with a response, so
+ *  that its acknowledgement also acknowledges the rest of the burst - ATT writes are handled in order.
+ *
+ *  Write pipelines are not thread-safe, and should be used on the peripheral's delegate queue.
+ */
+RINGLYKIT_FINAL @interface RLYWritePipeline : NSObject
+
+#pragma mark - Initialization
+
+/**
+ *  `+new` is unavailable, use the designated initializer instead.
+ */
++(instancetype)new NS_UNAVAILABLE;
+
+/**
+ *  `-init` is unavailable, use the designated initializer instead.
+ */
+-(instancetype)init NS_UNAVAILABLE;
+
+/**
+ *  Initializes a write pipeline.
+ *
+ *  @param target     The target to write to. This object is weakly referenced.
+ *  @param windowSize The maximum number of writes that may be awaiting a response at once. This must be at least `1`.
+ *  @param burstSize  The maximum number of writes in a burst, including the final write that is sent with a response.
+ */
+-(instancetype)initWithTarget:(id<RLYWritePipelineTarget>)target
+                   windowSize:(NSUInteger)windowSize
+                    burstSize:(NSUInteger)burstSize NS_DESIGNATED_INITIALIZER;
+
+#pragma mark - Configuration
+
+/**
+ *  The maximum number of writes that may be awaiting a response at once.
+ */
+@property (nonatomic, readonly) NSUInteger windowSize;
+
+/**
+ *  The maximum number of writes in a burst.
+ */
+@property (nonatomic, readonly) NSUInteger burstSize;
+
+/**
+ *  If `YES`, writes that allow it will be sent without a response, in bursts. The default value is `NO`.
+ */
+@property (nonatomic) BOOL allowsWritesWithoutResponse;
+
+#pragma mark - Writing
+
+/**
+ *  Enqueues a write, sending it immediately if the window is not full.
+ *
+ *  @param data                       The data to write.
+ *  @param characteristic             The characteristic to write to.
+ *  @param allowsWriteWithoutResponse Whether or not the write may be sent without a response. It will only be sent
+ *                                    without a response if `allowsWritesWithoutResponse` is also `YES`, and if the
+ *                                    characteristic supports it.
+ *  @param completion                 A completion block, called once the write is acknowledged or fails.
+ */
+-(void)enqueueData:(NSData*)data
+ forCharacteristic:(CBCharacteristic*)characteristic
+allowsWriteWithoutResponse:(BOOL)allowsWriteWithoutResponse
+        completion:(nullable RLYWritePipelineCompletion)completion;
+
+/**
+ *  Matches a write response to the oldest write to the characteristic that is awaiting a response, completes it, and
+ *  sends further writes.
+ *
+ *  @param characteristic The characteristic that was written to.
+ *  @param error          The error, if any.
+ *
+ *  @returns `YES` if the response was matched to a write, otherwise `NO` - for example, if the write was not sent
+ *           through the pipeline.
+ */
+-(BOOL)didWriteValueForCharacteristic:(CBCharacteristic*)characteristic error:(nullable NSError*)error;
+
+/**
+ *  Fails all queued writes, and all writes awaiting a response. This should be called when the peripheral disconnects.
+ *
+ *  @param error The error to pass to each completion block.
+ */
+-(void)failAllWritesWithError:(NSError*)error;
+
+#pragma mark - Statistics
+
+/**
+ *  A snapshot of the pipeline's latency and throughput counters.
+ */
+@property (nonatomic, readonly) RLYPeripheralWriteStatistics *statistics;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,260 @@
+#import "RLYPeripheralWriteStatistics+Internal.h"
+#import "RLYWritePipeline.h"
+
+#pragma mark - Entries
+
+/**
+ *  A single write in a `RLYWritePipeline`.
+ */
+@interface RLYWritePipelineEntry : NSObject
+
+@property (nonatomic, strong) NSData *data;
+@property (nonatomic, strong) CBCharacteristic *characteristic;
+@property (nonatomic) BOOL allowsWriteWithoutResponse;
+@property (nonatomic, copy) RLYWritePipelineCompletion completion;
+@property (nonatomic) CFAbsoluteTime enqueuedTime;
+@property (nonatomic) BOOL sentWithoutResponse;
+
+@end
+
+@implementation RLYWritePipelineEntry
+
+@end
+
+#pragma mark - Pipeline
+
+@interface RLYWritePipeline ()
+{
+@private
+    __weak id<RLYWritePipelineTarget> _target;
+
+    // entries that have not been sent yet, and entries that have been sent, but not acknowledged, in order
+    NSMutableArray<RLYWritePipelineEntry*> *_queued;
+    NSMutableArray<RLYWritePipelineEntry*> *_sent;
+
+    // the number of sent entries that will receive a response, which is limited by the window size
+    NSUInteger _awaitingResponseCount;
+
+    // the number of consecutive writes that have been sent without a response
+    NSUInteger _burstLength;
+
+    // prevents re-entrant sends if the target responds synchronously, or a completion block enqueues a write
+    BOOL _sending;
+
+    // statistics
+    NSUInteger _completedWriteCount;
+    NSUInteger _failedWriteCount;
+    NSUInteger _writeWithoutResponseCount;
+    uint64_t _completedByteCount;
+    NSTimeInterval _totalLatency;
+    NSTimeInterval _maximumLatency;
+    NSTimeInterval _activeDuration;
+    CFAbsoluteTime _activeSince;
+}
+
+@end
+
+@implementation RLYWritePipeline
+
+#pragma mark - Initialization
+-(instancetype)initWithTarget:(id<RLYWritePipelineTarget>)target
+                   windowSize:(NSUInteger)windowSize
+                    burstSize:(NSUInteger)burstSize
+{
+    self = [super init];
+
+    if (self)
+    {
+        _target = target;
+        _windowSize = MAX(windowSize, (NSUInteger)1);
+        _burstSize = MAX(burstSize, (NSUInteger)1);
+        _queued = [NSMutableArray array];
+        _sent = [NSMutableArray array];
+    }
+
+    return self;
+}
+
+#pragma mark - Writing
+-(void)enqueueData:(NSData*)data
+ forCharacteristic:(CBCharacteristic*)characteristic
+allowsWriteWithoutResponse:(BOOL)allowsWriteWithoutResponse
+        completion:(RLYWritePipelineCompletion)completion
+{
+    CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+
+    if (_queued.count == 0 && _sent.count == 0)
+    {
+        _activeSince = now;
+    }
+
+    RLYWritePipelineEntry *entry = [RLYWritePipelineEntry new];
+    entry.data = data;
+    entry.characteristic = characteristic;
+    entry.allowsWriteWithoutResponse = allowsWriteWithoutResponse;
+    entry.completion = completion;
+    entry.enqueuedTime = now;
+
+    [_queued addObject:entry];
+    [self sendQueuedEntries];
+}
+
+-(void)sendQueuedEntries
+{
+    if (_sending)
+    {
+        return;
+    }
+
+    _sending = YES;
+
+    while (_queued.count > 0 && _awaitingResponseCount < _windowSize)
+    {
+        RLYWritePipelineEntry *entry = _queued.firstObject;
+        [_queued removeObjectAtIndex:0];
+
+        // a write can only be sent without a response if a later write will be sent with one, to acknowledge it
+        BOOL withoutResponse = _allowsWritesWithoutResponse
+                            && entry.allowsWriteWithoutResponse
+                            && (entry.characteristic.properties & CBCharacteristicPropertyWriteWithoutResponse) != 0
+                            && _queued.count > 0
+                            && _burstLength + 1 < _burstSize;
+
+        entry.sentWithoutResponse = withoutResponse;
+        _burstLength = withoutResponse ? _burstLength + 1 : 0;
+        _awaitingResponseCount += withoutResponse ? 0 : 1;
+
+        [_sent addObject:entry];
+
+        [_target writeValue:entry.data
+          forCharacteristic:entry.characteristic
+                       type:withoutResponse ? CBCharacteristicWriteWithoutResponse : CBCharacteristicWriteWithResponse];
+    }
+
+    _sending = NO;
+}
+
+-(BOOL)didWriteValueForCharacteristic:(CBCharacteristic*)characteristic error:(NSError*)error
+{
+    // find the oldest write to this characteristic that is awaiting a response
+    NSUInteger index = [_sent indexOfObjectPassingTest:^BOOL(RLYWritePipelineEntry *entry, NSUInteger i, BOOL *stop) {
+        return !entry.sentWithoutResponse && entry.characteristic == characteristic;
+    }];
+
+    if (index == NSNotFound)
+    {
+        return NO;
+    }
+
+    // the response also acknowledges the burst of writes sent without a response immediately before it
+    NSUInteger start = index;
+
+    while (start > 0 && _sent[start - 1].sentWithoutResponse)
+    {
+        start--;
+    }
+
+    NSRange range = NSMakeRange(start, index - start + 1);
+    NSArray<RLYWritePipelineEntry*> *completed = [_sent subarrayWithRange:range];
+    [_sent removeObjectsInRange:range];
+    _awaitingResponseCount--;
+
+    CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+
+    for (RLYWritePipelineEntry *entry in completed)
+    {
+        // writes sent without a response can't fail individually
+        NSError *entryError = entry.sentWithoutResponse ? nil : error;
+
+        [self recordCompletionOfEntry:entry withError:entryError atTime:now];
+    }
+
+    [self recordIdleIfEmptyAtTime:now];
+
+    for (RLYWritePipelineEntry *entry in completed)
+    {
+        if (entry.completion)
+        {
+            entry.completion(entry.sentWithoutResponse ? nil : error);
+        }
+    }
+
+    [self sendQueuedEntries];
+
+    return YES;
+}
+
+-(void)failAllWritesWithError:(NSError*)error
+{
+    NSArray<RLYWritePipelineEntry*> *failed = [_sent arrayByAddingObjectsFromArray:_queued];
+    [_sent removeAllObjects];
+    [_queued removeAllObjects];
+    _awaitingResponseCount = 0;
+    _burstLength = 0;
+
+    CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+
+    for (RLYWritePipelineEntry *entry in failed)
+    {
+        [self recordCompletionOfEntry:entry withError:error atTime:now];
+    }
+
+    [self recordIdleIfEmptyAtTime:now];
+
+    for (RLYWritePipelineEntry *entry in failed)
+    {
+        if (entry.completion)
+        {
+            entry.completion(error);
+        }
+    }
+}
+
+#pragma mark - Statistics
+-(void)recordCompletionOfEntry:(RLYWritePipelineEntry*)entry withError:(NSError*)error atTime:(CFAbsoluteTime)time
+{
+    if (error)
+    {
+        _failedWriteCount++;
+    }
+    else
+    {
+        NSTimeInterval latency = time - entry.enqueuedTime;
+
+        _completedWriteCount++;
+        _writeWithoutResponseCount += entry.sentWithoutResponse ? 1 : 0;
+        _completedByteCount += entry.data.length;
+        _totalLatency += latency;
+        _maximumLatency = MAX(_maximumLatency, latency);
+    }
+}
+
+-(void)recordIdleIfEmptyAtTime:(CFAbsoluteTime)time
+{
+    if (_queued.count == 0 && _sent.count == 0 && _activeSince != 0)
+    {
+        _activeDuration += time - _activeSince;
+        _activeSince = 0;
+    }
+}
+
+-(RLYPeripheralWriteStatistics*)statistics
+{
+    NSTimeInterval activeDuration = _activeDuration;
+
+    if (_activeSince != 0)
+    {
+        activeDuration += CFAbsoluteTimeGetCurrent() - _activeSince;
+    }
+
+    return [[RLYPeripheralWriteStatistics alloc] initWithCompletedWriteCount:_completedWriteCount
+                                                            failedWriteCount:_failedWriteCount
+                                                   writeWithoutResponseCount:_writeWithoutResponseCount
+                                                           pendingWriteCount:_queued.count + _sent.count
+                                                          completedByteCount:_completedByteCount
+                                                                totalLatency:_totalLatency
+                                                              maximumLatency:_maximumLatency
+                                                              activeDuration:activeDuration];
+}
+
+@end
@@ -5,6 +5,7 @@
 #import <RinglyKit/RLYActivityTrackingDate.h>
 #import <RinglyKit/RLYActivityTrackingDateError.h>
 #import <RinglyKit/RLYActivityTrackingUpdate.h>
+#import <RinglyKit/RLYActivityTrackingUpdateBatch.h>
 #import <RinglyKit/RLYActivityTrackingUpdateError.h>
 #import <RinglyKit/RLYAdvertisingNameCommand.h>
 #import <RinglyKit/RLYApplicationSettingsCommand.h>
@@ -0,0 +1,209 @@
+#import <RinglyKit/RLYANCSDate.h>
+#import <XCTest/XCTest.h>
+
+/**
+ *  The number of timestamps to parse in each performance test.
+ */
+static const NSUInteger RLYANCSDateTestsPerformanceCount = 1000000;
+
+@interface RLYANCSDateTests : XCTestCase
+
+@end
+
+@implementation RLYANCSDateTests
+
+#pragma mark - Version 2
+-(void)testV2ParseComponents
+{
+    const char *string = "20151028T120021";
+    RLYANCSDateComponents components;
+
+    XCTAssertTrue(RLYANCSV2ParseDateComponents((const uint8_t*)string, strlen(string), &components));
+    XCTAssertEqual(components.year, 2015);
+    XCTAssertEqual(components.month, 10);
+    XCTAssertEqual(components.day, 28);
+    XCTAssertEqual(components.hour, 12);
+    XCTAssertEqual(components.minute, 0);
+    XCTAssertEqual(components.second, 21);
+}
+
+-(void)testV2RejectsInvalidDates
+{
+    const char *strings[] = {
+        "2015102812002",    // too short
+        "20151028T1200210", // too long
+        "20151028 120021",  // missing separator
+        "2015102xT120021",  // not a digit
+        "20151328T120021",  // invalid month
+        "20150229T120021",  // not a leap year
+        "20151028T240021"   // invalid hour
+    };
+
+    for (size_t i = 0; i < sizeof(strings) / sizeof(strings[0]); i++)
+    {
+        RLYANCSDateComponents components;
+        XCTAssertFalse(RLYANCSV2ParseDateComponents((const uint8_t*)strings[i], strlen(strings[i]), &components),
+                       @"%s", strings[i]);
+    }
+}
+
+-(void)testV2LeapDay
+{
+    const char *string = "20160229T000000";
+    RLYANCSDateComponents components;
+
+    XCTAssertTrue(RLYANCSV2ParseDateComponents((const uint8_t*)string, strlen(string), &components));
+}
+
+#pragma mark - Version 1
+-(void)testV1ParseComponents
+{
+    // version 1 dates may be followed by flags data, which is ignored
+    const char *string = "28120021\x01";
+    RLYANCSDateComponents components;
+
+    XCTAssertTrue(RLYANCSV1ParseDateComponents((const uint8_t*)string, strlen(string), 2015, 10, &components));
+    XCTAssertEqual(components.year, 2015);
+    XCTAssertEqual(components.month, 10);
+    XCTAssertEqual(components.day, 28);
+    XCTAssertEqual(components.hour, 12);
+    XCTAssertEqual(components.minute, 0);
+    XCTAssertEqual(components.second, 21);
+}
+
+-(void)testV1RejectsDayOutsideMonth
+{
+    const char *string = "31120021";
+    RLYANCSDateComponents components;
+
+    XCTAssertFalse(RLYANCSV1ParseDateComponents((const uint8_t*)string, strlen(string), 2015, 11, &components));
+}
+
+#pragma mark - Conversion
+-(void)testConversionMatchesCalendar
+{
+    NSTimeZone *timeZone = [NSTimeZone timeZoneWithName:@"America/New_York"];
+
+    NSCalendar *calendar = [[NSCalendar alloc] initWithCalendarIdentifier:NSCalendarIdentifierGregorian];
+    calendar.timeZone = timeZone;
+
+    // include times on either side of daylight saving time transitions
+    RLYANCSDateComponents dates[] = {
+        { 2015, 10, 28, 12, 0, 21 },
+        { 2016, 3, 13, 1, 59, 59 },
+        { 2016, 3, 13, 3, 0, 0 },
+        { 2016, 11, 6, 0, 30, 0 },
+        { 2016, 11, 6, 2, 30, 0 },
+        { 2000, 2, 29, 23, 59, 59 },
+        { 1999, 12, 31, 0, 0, 0 }
+    };
+
+    for (size_t i = 0; i < sizeof(dates) / sizeof(dates[0]); i++)
+    {
+        NSDateComponents *components = [NSDateComponents new];
+        components.year = dates[i].year;
+        components.month = dates[i].month;
+        components.day = dates[i].day;
+        components.hour = dates[i].hour;
+        components.minute = dates[i].minute;
+        components.second = dates[i].second;
+
+        NSDate *expected = [calendar dateFromComponents:components];
+        CFAbsoluteTime time = RLYANCSDateComponentsToAbsoluteTime(dates[i], timeZone);
+
+        XCTAssertEqualWithAccuracy(time, expected.timeIntervalSinceReferenceDate, 0.001, @"%@", components);
+    }
+}
+
+#pragma mark - Year and Month Cache
+-(void)testYearMonthCache
+{
+    NSTimeZone *timeZone = [NSTimeZone timeZoneWithName:@"America/New_York"];
+
+    // 2015-12-31 23:00 in New York
+    CFAbsoluteTime time = RLYANCSDateComponentsToAbsoluteTime((RLYANCSDateComponents){ 2015, 12, 31, 23, 0, 0 },
+                                                              timeZone);
+
+    RLYANCSYearMonthCache cache = { 0 };
+    RLYANCSYearMonthCacheUpdate(&cache, time, timeZone);
+
+    XCTAssertEqual(cache.year, 2015);
+    XCTAssertEqual(cache.month, 12);
+
+    // the cache should be valid from the previous midnight until the next
+    XCTAssertEqualWithAccuracy(cache.start, time - 23 * 3600, 0.001);
+    XCTAssertEqualWithAccuracy(cache.expiration, time + 3600, 0.001);
+
+    RLYANCSYearMonthCacheUpdate(&cache, time + 3600, timeZone);
+
+    XCTAssertEqual(cache.year, 2016);
+    XCTAssertEqual(cache.month, 1);
+}
+
+-(void)testYearMonthCacheWhenTimeMovesBackwards
+{
+    NSTimeZone *timeZone = [NSTimeZone timeZoneWithName:@"America/New_York"];
+
+    // 2016-03-01 01:00 in New York
+    CFAbsoluteTime time = RLYANCSDateComponentsToAbsoluteTime((RLYANCSDateComponents){ 2016, 3, 1, 1, 0, 0 },
+                                                              timeZone);
+
+    RLYANCSYearMonthCache cache = { 0 };
+    RLYANCSYearMonthCacheUpdate(&cache, time, timeZone);
+
+    XCTAssertEqual(cache.year, 2016);
+    XCTAssertEqual(cache.month, 3);
+
+    // the clock is set back two hours, to 2016-02-29 23:00, which is before the cached day, but not its expiration
+    RLYANCSYearMonthCacheUpdate(&cache, time - 7200, timeZone);
+
+    XCTAssertEqual(cache.year, 2016);
+    XCTAssertEqual(cache.month, 2);
+    XCTAssertEqualWithAccuracy(cache.expiration, time - 3600, 0.001);
+}
+
+#pragma mark - Performance
+-(void)testV2ParsePerformance
+{
+    const char *string = "20151028T120021";
+    size_t length = strlen(string);
+    NSTimeZone *timeZone = [NSTimeZone defaultTimeZone];
+
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < RLYANCSDateTestsPerformanceCount; i++)
+        {
+            RLYANCSDateComponents components;
+
+            if (RLYANCSV2ParseDateComponents((const uint8_t*)string, length, &components))
+            {
+                RLYANCSDateComponentsToAbsoluteTime(components, timeZone);
+            }
+        }
+    }];
+}
+
+-(void)testV2FormatterPerformance
+{
+    // the previous implementation, for comparison
+    NSDateFormatter *formatter = [NSDateFormatter new];
+    formatter.dateFormat = @"yyyyMMdd'T'HHmmss";
+
+    const char *string = "20151028T120021";
+    size_t length = strlen(string);
+
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < RLYANCSDateTestsPerformanceCount; i++)
+        {
+            @autoreleasepool
+            {
+                NSString *dateString = [[NSString alloc] initWithBytes:string
+                                                                length:length
+                                                              encoding:NSUTF8StringEncoding];
+
+                [formatter dateFromString:dateString];
+            }
+        }
+    }];
+}
+
+@end
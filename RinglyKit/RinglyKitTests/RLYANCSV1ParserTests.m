@@ -2,6 +2,66 @@
 #import <RinglyKit/RLYANCSV1Parser.h>
 #import <RinglyKit/RLYFunctions.h>
 #import <XCTest/XCTest.h>
+#import <pthread.h>
+
+#pragma mark - Counting Allocations
+
+/**
+ *  The signature of the malloc logging hook, which libmalloc calls for every allocation and deallocation when set.
+ */
+typedef void (RLYMallocLogger)(uint32_t type,
+                               uintptr_t arg1,
+                               uintptr_t arg2,
+                               uintptr_t arg3,
+                               uintptr_t result,
+                               uint32_t skippedFrames);
+
+extern RLYMallocLogger *malloc_logger;
+
+/// The `type` flag passed to the malloc logger for allocations, including reallocations.
+static const uint32_t RLYMallocLogTypeAllocate = 2;
+
+static RLYMallocLogger *RLYPreviousMallocLogger = NULL;
+static pthread_t RLYCountedThread;
+static uint64_t RLYAllocationCount = 0;
+
+static void RLYCountAllocation(uint32_t type,
+                               uintptr_t arg1,
+                               uintptr_t arg2,
+                               uintptr_t arg3,
+                               uintptr_t result,
+                               uint32_t skippedFrames)
+{
+    if ((type & RLYMallocLogTypeAllocate) && pthread_equal(pthread_self(), RLYCountedThread))
+    {
+        RLYAllocationCount++;
+    }
+
+    if (RLYPreviousMallocLogger)
+    {
+        RLYPreviousMallocLogger(type, arg1, arg2, arg3, result, skippedFrames);
+    }
+}
+
+/**
+ *  Counts the heap allocations made by the current thread while a block runs.
+ *
+ *  @param block The block.
+ *
+ *  @returns The number of allocations.
+ */
+static uint64_t RLYCountAllocations(void(^block)(void))
+{
+    RLYCountedThread = pthread_self();
+    RLYAllocationCount = 0;
+    RLYPreviousMallocLogger = malloc_logger;
+    malloc_logger = RLYCountAllocation;
+
+    block();
+
+    malloc_logger = RLYPreviousMallocLogger;
+    return RLYAllocationCount;
+}
 
 NSData *NullTerminate(NSData *input)
 {
@@ -18,6 +78,7 @@ NSData *NullTerminate(NSData *input)
 @property (nonatomic, strong) RLYANCSV1Parser *parser;
 @property (nonatomic, strong) RLYANCSNotification *notification;
 @property (nonatomic, strong) NSError *error;
+@property (nonatomic) NSUInteger parsedCount;
 
 @end
 
@@ -186,10 +247,118 @@ NSData *NullTerminate(NSData *input)
     XCTAssertEqual(self.error.code, RLYANCSV1ErrorCodeInvalidHeader);
 }
 
+-(void)testConsecutiveNotifications
+{
+    for (NSUInteger i = 0; i < 3; i++)
+    {
+        NSString *header = [NSString stringWithFormat:@"%lu,", (unsigned long)i];
+        NSString *title = [NSString stringWithFormat:@"Testing %lu", (unsigned long)i];
+        
+        self.notification = nil;
+        
+        [self.parser appendData:NullTerminate([[header stringByAppendingString:@"6"] dataUsingEncoding:NSUTF8StringEncoding])];
+        [self.parser appendData:[[header stringByAppendingString:@"com.ringly."] dataUsingEncoding:NSUTF8StringEncoding]];
+        [self.parser appendData:NullTerminate([[header stringByAppendingString:@"Ringly"] dataUsingEncoding:NSUTF8StringEncoding])];
+        [self.parser appendData:NullTerminate([[header stringByAppendingString:title] dataUsingEncoding:NSUTF8StringEncoding])];
+        [self.parser appendData:NullTerminate([[header stringByAppendingString:@"011200000"] dataUsingEncoding:NSUTF8StringEncoding])];
+        
+        XCTAssertNotNil(self.notification);
+        XCTAssertNil(self.error);
+        
+        XCTAssertEqualObjects(self.notification.applicationIdentifier, @"com.ringly.Ringly");
+        XCTAssertEqualObjects(self.notification.title, title);
+        XCTAssertEqual(self.notification.category, RLYANCSCategoryEmail);
+    }
+}
+
+-(void)testRestartAfterDifferentHeaderWrapsSlots
+{
+    // fill four slots, then restart from the last one, so that the next notification wraps around the slot buffer
+    [self.parser appendData:NullTerminate([@"0,4" dataUsingEncoding:NSUTF8StringEncoding])];
+    [self.parser appendData:[@"0,com.ringly." dataUsingEncoding:NSUTF8StringEncoding]];
+    [self.parser appendData:NullTerminate([@"0,Ringly" dataUsingEncoding:NSUTF8StringEncoding])];
+    [self.parser appendData:NullTerminate([@"1,4" dataUsingEncoding:NSUTF8StringEncoding])];
+    
+    XCTAssertEqual(self.error.code, RLYANCSV1ErrorCodeDifferentHeader);
+    self.error = nil;
+    
+    [self.parser appendData:[@"1,com.ringly." dataUsingEncoding:NSUTF8StringEncoding]];
+    [self.parser appendData:NullTerminate([@"1,Ringly" dataUsingEncoding:NSUTF8StringEncoding])];
+    [self.parser appendData:NullTerminate([@"1,Testing" dataUsingEncoding:NSUTF8StringEncoding])];
+    [self.parser appendData:NullTerminate([@"1,011200000" dataUsingEncoding:NSUTF8StringEncoding])];
+    
+    XCTAssertNotNil(self.notification);
+    XCTAssertNil(self.error);
+    
+    XCTAssertEqualObjects(self.notification.applicationIdentifier, @"com.ringly.Ringly");
+    XCTAssertEqualObjects(self.notification.title, @"Testing");
+    XCTAssertEqualObjects(self.notification.message, @"011200000");
+}
+
+-(void)testSplitCharacterIsDropped
+{
+    NSData *emoji = [@"Test😐" dataUsingEncoding:NSUTF8StringEncoding];
+    NSMutableData *title = [[@"0," dataUsingEncoding:NSUTF8StringEncoding] mutableCopy];
+    [title appendData:[emoji subdataWithRange:NSMakeRange(0, emoji.length - 1)]];
+    
+    [self.parser appendData:NullTerminate([@"0,4" dataUsingEncoding:NSUTF8StringEncoding])];
+    [self.parser appendData:[@"0,com.ringly." dataUsingEncoding:NSUTF8StringEncoding]];
+    [self.parser appendData:NullTerminate([@"0,Ringly" dataUsingEncoding:NSUTF8StringEncoding])];
+    [self.parser appendData:title];
+    [self.parser appendData:NullTerminate([@"0,011200000" dataUsingEncoding:NSUTF8StringEncoding])];
+    
+    XCTAssertEqualObjects(self.notification.title, @"Test");
+}
+
+#pragma mark - Performance
+-(void)testNotificationStreamPerformance
+{
+    // a recorded five-part stream, as received from a version 1 peripheral during a group chat
+    NSArray<NSData*> *parts = @[
+        NullTerminate([@"12,4" dataUsingEncoding:NSUTF8StringEncoding]),
+        [@"12,com.tinyspeck" dataUsingEncoding:NSUTF8StringEncoding],
+        NullTerminate([@"12,.chatlyio" dataUsingEncoding:NSUTF8StringEncoding]),
+        NullTerminate([@"12,#general: lunch?" dataUsingEncoding:NSUTF8StringEncoding]),
+        NullTerminate([@"12,281200150" dataUsingEncoding:NSUTF8StringEncoding])
+    ];
+    
+    // the measured wall clock time is for a fixed number of notifications, so it tracks throughput directly
+    NSUInteger notificationCount = 10000;
+    
+    [self measureMetrics:@[XCTPerformanceMetric_WallClockTime] automaticallyStartMeasuring:NO forBlock:^{
+        self.parsedCount = 0;
+        
+        uint64_t allocations = RLYCountAllocations(^{
+            @autoreleasepool {
+                [self startMeasuring];
+                
+                for (NSUInteger i = 0; i < notificationCount; i++)
+                {
+                    for (NSData *part in parts)
+                    {
+                        [self.parser appendData:part];
+                    }
+                }
+                
+                [self stopMeasuring];
+            }
+        });
+        
+        XCTAssertEqual(self.parsedCount, notificationCount);
+        
+        // a notification and its strings, not a copy of every part for every notification
+        XCTAssertLessThan((double)allocations / (double)self.parsedCount, 64);
+    }];
+    
+    XCTAssertNil(self.error);
+    XCTAssertEqualObjects(self.notification.applicationIdentifier, @"com.tinyspeck.chatlyio");
+}
+
 #pragma mark - ANCS Version 1 Parser Delegate
 -(void)ANCSV1Parser:(RLYANCSV1Parser *)parser parsedNotification:(RLYANCSNotification *)notification
 {
     self.notification = notification;
+    self.parsedCount += 1;
 }
 
 -(void)ANCSV1Parser:(RLYANCSV1Parser *)parser failedToParseNotificationWithError:(NSError *)error
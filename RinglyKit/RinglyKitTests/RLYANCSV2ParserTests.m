@@ -2,18 +2,25 @@
 #import <RinglyKit/RLYANCSV2Parser.h>
 #import <XCTest/XCTest.h>
 
+/**
+ *  A captured version 2 payload for a Messages notification, with eight notification attributes and one application
+ *  attribute.
+ */
+static NSString *const RLYANCSV2ParserTestsMessagesPayload = @"ABQAAAAAEwBjb20uYXBwbGUuTW9iaWxlU01TAQwATmF0ZSBTdGVkbWFuAgAAAw4AaGFzbGhrZmpkYXNoZmEEAgAxNAUPADIwMTUxMDI4VDEyMDAyMQYAAAcFAENsZWFyAWNvbS5hcHBsZS5Nb2JpbGVTTVMAAAgATWVzc2FnZXMAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA";
+
 @interface RLYANCSV2ParserTests : XCTestCase
 @end
 
 @implementation RLYANCSV2ParserTests
 
+#pragma mark - Parsing
+
 -(void)testSuccessfulParse
 {
     NSUInteger notificationAttributeCount = 8;
     NSUInteger applicationAttributeCount = 1;
     
-    NSString *base64 = @"ABQAAAAAEwBjb20uYXBwbGUuTW9iaWxlU01TAQwATmF0ZSBTdGVkbWFuAgAAAw4AaGFzbGhrZmpkYXNoZmEEAgAxNAUPADIwMTUxMDI4VDEyMDAyMQYAAAcFAENsZWFyAWNvbS5hcHBsZS5Nb2JpbGVTTVMAAAgATWVzc2FnZXMAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA";
-    NSData *data = [[NSData alloc] initWithBase64EncodedString:base64 options:0];
+    NSData *data = [[NSData alloc] initWithBase64EncodedString:RLYANCSV2ParserTestsMessagesPayload options:0];
     
     XCTAssertNotNil(data);
     
@@ -28,6 +35,45 @@
 
     XCTAssertEqualObjects(notification.applicationIdentifier, @"com.apple.MobileSMS");
     XCTAssertEqualObjects(notification.title, @"Nate Stedman");
+    XCTAssertEqualObjects(notification.message, @"haslhkfjdashfa");
+    XCTAssertNotNil(notification.date);
+}
+
+-(void)testMissingTitle
+{
+    // command, uid, a date attribute, then the application attributes command and identifier
+    const uint8_t bytes[] = {
+        0, 0, 0, 0, 0,
+        5, 15, 0, '2', '0', '1', '5', '1', '0', '2', '8', 'T', '1', '2', '0', '0', '2', '1',
+        1, 'a', 0,
+        0, 0
+    };
+    
+    NSData *data = [NSData dataWithBytes:bytes length:sizeof(bytes)];
+    
+    NSError *error = nil;
+    RLYANCSNotification *notification = [RLYANCSV2Parser parseData:data
+                                    withNotificationAttributeCount:1
+                                         applicationAttributeCount:0
+                                                             error:&error];
+    
+    XCTAssertNil(notification);
+    XCTAssertEqual(error.code, RLYANCSV2ErrorCodeMissingTitle);
+}
+
+-(void)testMissingApplicationIdentifierTerminator
+{
+    const uint8_t bytes[] = { 0, 0, 0, 0, 0, 1, 'a', 'b', 'c' };
+    NSData *data = [NSData dataWithBytes:bytes length:sizeof(bytes)];
+    
+    NSError *error = nil;
+    RLYANCSNotification *notification = [RLYANCSV2Parser parseData:data
+                                    withNotificationAttributeCount:0
+                                         applicationAttributeCount:0
+                                                             error:&error];
+    
+    XCTAssertNil(notification);
+    XCTAssertEqual(error.code, RLYANCSV2ErrorCodeIncorrectDataSize);
 }
 
 -(void)testErrorData
@@ -47,4 +93,87 @@
     XCTAssertEqualObjects(error.userInfo[RLYANCSV2DataErrorKey], [data description]);
 }
 
+#pragma mark - Fuzzing
+
+/**
+ *  Parses `data`, asserting that the parser either returns a notification or an error, but not both.
+ *
+ *  @param data The data to parse.
+ */
+-(void)assertParsesOrFails:(NSData*)data
+{
+    NSError *error = nil;
+    RLYANCSNotification *notification = [RLYANCSV2Parser parseData:data
+                                    withNotificationAttributeCount:8
+                                         applicationAttributeCount:1
+                                                             error:&error];
+    
+    XCTAssertTrue((notification == nil) != (error == nil), @"%@", data);
+}
+
+-(void)testFuzzTruncations
+{
+    NSData *data = [[NSData alloc] initWithBase64EncodedString:RLYANCSV2ParserTestsMessagesPayload options:0];
+    
+    for (NSUInteger length = 0; length <= data.length; length++)
+    {
+        [self assertParsesOrFails:[data subdataWithRange:NSMakeRange(0, length)]];
+    }
+}
+
+-(void)testFuzzByteReplacements
+{
+    NSData *data = [[NSData alloc] initWithBase64EncodedString:RLYANCSV2ParserTestsMessagesPayload options:0];
+    const uint8_t replacements[] = { 0x00, 0x01, 0x7f, 0x80, 0xff };
+    
+    // only mutate the meaningful prefix of the payload, the remainder is zero padding
+    for (NSUInteger offset = 0; offset < 128; offset++)
+    {
+        for (size_t i = 0; i < sizeof(replacements); i++)
+        {
+            NSMutableData *mutated = [data mutableCopy];
+            ((uint8_t*)mutated.mutableBytes)[offset] = replacements[i];
+            [self assertParsesOrFails:mutated];
+        }
+    }
+}
+
+-(void)testFuzzRandomPayloads
+{
+    NSData *data = [[NSData alloc] initWithBase64EncodedString:RLYANCSV2ParserTestsMessagesPayload options:0];
+    
+    // use a fixed seed, so that failures are reproducible
+    srand48(2015);
+    
+    for (NSUInteger iteration = 0; iteration < 2000; iteration++)
+    {
+        NSMutableData *mutated = [[data subdataWithRange:NSMakeRange(0, (NSUInteger)(drand48() * data.length))]
+                                  mutableCopy];
+        
+        for (NSUInteger flip = 0; flip < 4 && mutated.length > 0; flip++)
+        {
+            NSUInteger offset = (NSUInteger)(drand48() * mutated.length);
+            ((uint8_t*)mutated.mutableBytes)[offset] = (uint8_t)(drand48() * 256);
+        }
+        
+        [self assertParsesOrFails:mutated];
+    }
+}
+
+#pragma mark - Performance
+-(void)testParsePerformance
+{
+    NSData *data = [[NSData alloc] initWithBase64EncodedString:RLYANCSV2ParserTestsMessagesPayload options:0];
+    
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < 10000; i++)
+        {
+            [RLYANCSV2Parser parseData:data
+                withNotificationAttributeCount:8
+                     applicationAttributeCount:1
+                                         error:nil];
+        }
+    }];
+}
+
 @end
@@ -0,0 +1,167 @@
+#import <RinglyKit/RinglyKit.h>
+#import <RinglyKit/RLYActivityTrackingUpdate+Internal.h>
+#import <RinglyKit/RLYActivityTrackingUpdateBatch+Internal.h>
+#import <XCTest/XCTest.h>
+
+@interface RLYActivityTrackingUpdateBatchTests : XCTestCase
+
+@end
+
+@implementation RLYActivityTrackingUpdateBatchTests
+
+#pragma mark - Parsing
+-(void)testBatchParsing
+{
+    uint8_t bytes[] = {
+        6, 235, 77, 100, 200,
+        0, 0, 0, 1, 1,
+        6, 235, 78, 50, 150,
+        255, 255, 255, 234, 134
+    };
+
+    NSData *data = [NSData dataWithBytes:bytes length:sizeof(bytes)];
+
+    __block RLYActivityTrackingUpdateBatch *batch = nil;
+
+    [RLYActivityTrackingUpdateBatch parseActivityTrackingCharacteristicData:data withBatchCallback:^(RLYActivityTrackingUpdateBatch * _Nonnull parsed) {
+        XCTAssertNil(batch);
+        batch = parsed;
+    } errorCallback:^(NSError * _Nonnull error) {
+        XCTFail();
+    } completionCallback:^{
+        XCTFail();
+    }];
+
+    // the reset record is dropped
+    XCTAssertEqual(batch.count, (NSUInteger)3);
+
+    XCTAssertEqual(batch.minutes[0], (RLYActivityTrackingMinute)5106438);
+    XCTAssertEqual(batch.walkingSteps[0], 100);
+    XCTAssertEqual(batch.runningSteps[0], 200);
+
+    XCTAssertEqual(batch.minutes[1], (RLYActivityTrackingMinute)5171974);
+    XCTAssertEqual(batch.walkingSteps[1], 50);
+    XCTAssertEqual(batch.runningSteps[1], 150);
+
+    XCTAssertEqual(batch.minutes[2], (RLYActivityTrackingMinute)8388607);
+    XCTAssertEqual(batch.walkingSteps[2], 234);
+    XCTAssertEqual(batch.runningSteps[2], 134);
+}
+
+-(void)testBatchUpdatesMatchArrays
+{
+    uint8_t bytes[] = {
+        6, 235, 77, 100, 200,
+        6, 235, 78, 50, 150
+    };
+
+    NSData *data = [NSData dataWithBytes:bytes length:sizeof(bytes)];
+
+    [RLYActivityTrackingUpdateBatch parseActivityTrackingCharacteristicData:data withBatchCallback:^(RLYActivityTrackingUpdateBatch * _Nonnull batch) {
+        NSArray<RLYActivityTrackingUpdate*> *updates = batch.updates;
+
+        XCTAssertEqual(updates.count, batch.count);
+
+        for (NSUInteger i = 0; i < batch.count; i++)
+        {
+            XCTAssertEqual(updates[i].date.minute, batch.minutes[i]);
+            XCTAssertEqual(updates[i].walkingSteps, batch.walkingSteps[i]);
+            XCTAssertEqual(updates[i].runningSteps, batch.runningSteps[i]);
+        }
+
+        // the update objects are only created once
+        XCTAssertTrue(batch.updates == updates);
+    } errorCallback:^(NSError * _Nonnull error) {
+        XCTFail();
+    } completionCallback:^{
+        XCTFail();
+    }];
+}
+
+-(void)testOnlyResetRecords
+{
+    uint8_t bytes[] = {
+        0, 0, 0, 1, 1,
+        0, 0, 128, 1, 1
+    };
+
+    NSData *data = [NSData dataWithBytes:bytes length:sizeof(bytes)];
+
+    [RLYActivityTrackingUpdateBatch parseActivityTrackingCharacteristicData:data withBatchCallback:^(RLYActivityTrackingUpdateBatch * _Nonnull batch) {
+        XCTFail();
+    } errorCallback:^(NSError * _Nonnull error) {
+        XCTFail();
+    } completionCallback:^{
+        XCTFail();
+    }];
+}
+
+#pragma mark - Performance
+
+/**
+ *  Returns a packet of activity tracking data with `count` records, for consecutive minutes.
+ *
+ *  @param count The number of records.
+ */
+-(NSData*)performanceDataWithCount:(NSUInteger)count
+{
+    NSMutableData *data = [NSMutableData dataWithLength:count * 5];
+    uint8_t *bytes = data.mutableBytes;
+
+    for (NSUInteger i = 0; i < count; i++)
+    {
+        RLYActivityTrackingMinuteBytes minute = RLYActivityTrackingMinuteBytesFromMinute(5106438 + (uint32_t)i);
+        bytes[i * 5] = minute.first;
+        bytes[i * 5 + 1] = minute.second;
+        bytes[i * 5 + 2] = minute.third;
+        bytes[i * 5 + 3] = (uint8_t)i;
+        bytes[i * 5 + 4] = (uint8_t)(i * 3);
+    }
+
+    return data;
+}
+
+-(void)testBatchParsingPerformance
+{
+    // a week of history, in packets of the maximum size that fits in a default MTU
+    NSData *data = [self performanceDataWithCount:4];
+    NSUInteger packets = 7 * 24 * 60 / 4;
+
+    [self measureBlock:^{
+        __block NSUInteger steps = 0;
+
+        for (NSUInteger i = 0; i < packets; i++)
+        {
+            [RLYActivityTrackingUpdateBatch parseActivityTrackingCharacteristicData:data withBatchCallback:^(RLYActivityTrackingUpdateBatch *batch) {
+                for (NSUInteger j = 0; j < batch.count; j++)
+                {
+                    steps += batch.walkingSteps[j] + batch.runningSteps[j];
+                }
+            } errorCallback:^(NSError *error) {} completionCallback:^{}];
+        }
+
+        XCTAssertGreaterThan(steps, 0);
+    }];
+}
+
+-(void)testUpdateParsingPerformance
+{
+    // the per-update adapter, for comparison
+    NSData *data = [self performanceDataWithCount:4];
+    NSUInteger packets = 7 * 24 * 60 / 4;
+
+    [self measureBlock:^{
+        __block NSUInteger steps = 0;
+
+        for (NSUInteger i = 0; i < packets; i++)
+        {
+            [RLYActivityTrackingUpdate parseActivityTrackingCharacteristicData:data withUpdateCallback:^(RLYActivityTrackingUpdate *update) {
+                steps += update.steps;
+            } errorCallback:^(NSError *error) {} completionCallback:^{}];
+        }
+
+        XCTAssertGreaterThan(steps, 0);
+    }];
+}
+
+@end
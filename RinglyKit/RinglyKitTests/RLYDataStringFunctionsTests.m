@@ -61,6 +61,27 @@
     XCTAssertEqualObjects(RLYFindValidUTF8Prefix([data subdataWithRange:NSMakeRange(0, data.length - 4)]), @"");
 }
 
+-(void)testValidUTF8PrefixLength
+{
+    const uint8_t ascii[] = { 't', 'e', 's', 't' };
+    XCTAssertEqual(RLYValidUTF8PrefixLength(ascii, sizeof(ascii)), 4);
+    
+    // a truncated four-byte sequence is dropped
+    const uint8_t truncated[] = { 't', 0xf0, 0x9f, 0x98 };
+    XCTAssertEqual(RLYValidUTF8PrefixLength(truncated, sizeof(truncated)), 1);
+    
+    // overlong encodings and surrogates are invalid
+    const uint8_t overlong[] = { 't', 0xc0, 0xaf };
+    XCTAssertEqual(RLYValidUTF8PrefixLength(overlong, sizeof(overlong)), 1);
+    
+    const uint8_t surrogate[] = { 't', 't', 0xed, 0xa0, 0x80 };
+    XCTAssertEqual(RLYValidUTF8PrefixLength(surrogate, sizeof(surrogate)), 2);
+    
+    // an invalid byte in the middle crops everything after it
+    const uint8_t middle[] = { 't', 0xff, 't' };
+    XCTAssertEqual(RLYValidUTF8PrefixLength(middle, sizeof(middle)), 1);
+}
+
 #pragma mark - UTF-8 Suffix
 -(void)testFindValidUTF8Suffix
 {
@@ -68,4 +68,131 @@
     XCTAssertEqual(count, (NSUInteger)1);
 }
 
+-(void)testRemovalDuringEnumeration
+{
+    RLYObservers *observers = [RLYObservers new];
+    
+    NSObject *first = [NSObject new];
+    NSObject *second = [NSObject new];
+    [observers addObserver:first];
+    [observers addObserver:second];
+    
+    // the current enumeration should not be affected
+    __block NSUInteger count = 0;
+    [observers enumerateObservers:^(id observer) {
+        [observers removeObserver:first];
+        [observers removeObserver:second];
+        count++;
+    }];
+    
+    XCTAssertEqual(count, (NSUInteger)2);
+    
+    count = 0;
+    [observers enumerateObservers:^(id observer) {
+        count++;
+    }];
+    
+    XCTAssertEqual(count, (NSUInteger)0);
+}
+
+-(void)testAdditionDuringEnumeration
+{
+    RLYObservers *observers = [RLYObservers new];
+    
+    NSObject *first = [NSObject new];
+    NSObject *second = [NSObject new];
+    [observers addObserver:first];
+    
+    __block NSUInteger count = 0;
+    [observers enumerateObservers:^(id observer) {
+        [observers addObserver:second];
+        count++;
+    }];
+    
+    XCTAssertEqual(count, (NSUInteger)1);
+    
+    count = 0;
+    [observers enumerateObservers:^(id observer) {
+        count++;
+    }];
+    
+    XCTAssertEqual(count, (NSUInteger)2);
+}
+
+-(void)testConcurrentAdditionAndRemoval
+{
+    RLYObservers *observers = [RLYObservers new];
+    
+    NSMutableArray *retained = [NSMutableArray array];
+    
+    for (NSUInteger i = 0; i < 100; i++)
+    {
+        [retained addObject:[NSObject new]];
+    }
+    
+    dispatch_apply(retained.count, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+        [observers addObserver:retained[i]];
+        [observers enumerateObservers:^(id observer) {}];
+        
+        if (i % 2 == 0)
+        {
+            [observers removeObserver:retained[i]];
+        }
+    });
+    
+    __block NSUInteger count = 0;
+    [observers enumerateObservers:^(id observer) {
+        count++;
+    }];
+    
+    XCTAssertEqual(count, retained.count / 2);
+}
+
+#pragma mark - Performance
+/**
+ *  Measures the cost of dispatching events to the specified number of observers.
+ *
+ *  @param observerCount The number of observers.
+ */
+-(void)measureDispatchWithObserverCount:(NSUInteger)observerCount
+{
+    RLYObservers *observers = [RLYObservers new];
+    NSMutableArray *retained = [NSMutableArray arrayWithCapacity:observerCount];
+    
+    for (NSUInteger i = 0; i < observerCount; i++)
+    {
+        NSObject *observer = [NSObject new];
+        [retained addObject:observer];
+        [observers addObserver:observer];
+    }
+    
+    [self measureBlock:^{
+        __block NSUInteger count = 0;
+        
+        for (NSUInteger i = 0; i < 100000; i++)
+        {
+            [observers enumerateObservers:^(id observer) {
+                count++;
+            }];
+        }
+        
+        XCTAssertEqual(count, observerCount * 100000);
+    }];
+}
+
+-(void)testDispatchPerformanceWithOneObserver
+{
+    [self measureDispatchWithObserverCount:1];
+}
+
+-(void)testDispatchPerformanceWithTenObservers
+{
+    [self measureDispatchWithObserverCount:10];
+}
+
+-(void)testDispatchPerformanceWithOneHundredObservers
+{
+    [self measureDispatchWithObserverCount:100];
+}
+
 @end
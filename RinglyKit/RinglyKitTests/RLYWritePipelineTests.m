@@ -0,0 +1,308 @@
+#import <RinglyKit/RinglyKit.h>
+#import <RinglyKit/RLYWritePipeline.h>
+#import <XCTest/XCTest.h>
+
+#pragma mark - Simulated Peripheral
+
+/**
+ *  Stands in for a `CBPeripheral`, recording writes so that tests can acknowledge them.
+ */
+@interface RLYWritePipelineTestsTarget : NSObject <RLYWritePipelineTarget>
+
+/**
+ *  The characteristics of writes sent with a response, which have not been acknowledged.
+ */
+@property (nonatomic, readonly) NSMutableArray<CBCharacteristic*> *awaitingResponse;
+
+/**
+ *  The type of each write, in order.
+ */
+@property (nonatomic, readonly) NSMutableArray<NSNumber*> *types;
+
+@end
+
+@implementation RLYWritePipelineTestsTarget
+
+-(instancetype)init
+{
+    self = [super init];
+
+    if (self)
+    {
+        _awaitingResponse = [NSMutableArray array];
+        _types = [NSMutableArray array];
+    }
+
+    return self;
+}
+
+-(void)writeValue:(NSData*)data forCharacteristic:(CBCharacteristic*)characteristic type:(CBCharacteristicWriteType)type
+{
+    [_types addObject:@(type)];
+
+    if (type == CBCharacteristicWriteWithResponse)
+    {
+        [_awaitingResponse addObject:characteristic];
+    }
+}
+
+-(NSUInteger)acknowledgeAllWithPipeline:(RLYWritePipeline*)pipeline
+{
+    NSUInteger roundTrips = 0;
+
+    while (_awaitingResponse.count > 0)
+    {
+        CBCharacteristic *characteristic = _awaitingResponse.firstObject;
+        [_awaitingResponse removeObjectAtIndex:0];
+        [pipeline didWriteValueForCharacteristic:characteristic error:nil];
+        roundTrips++;
+    }
+
+    return roundTrips;
+}
+
+@end
+
+#pragma mark - Tests
+
+@interface RLYWritePipelineTests : XCTestCase
+
+@property (nonatomic, strong) RLYWritePipelineTestsTarget *target;
+@property (nonatomic, strong) CBMutableCharacteristic *command;
+@property (nonatomic, strong) CBMutableCharacteristic *configurationHash;
+
+@end
+
+@implementation RLYWritePipelineTests
+
+-(void)setUp
+{
+    [super setUp];
+
+    _target = [RLYWritePipelineTestsTarget new];
+
+    _command = [[CBMutableCharacteristic alloc] initWithType:[CBUUID UUIDWithString:@"757ED3E4-1828-4A0C-8362-C229C3A6DA72"]
+                                                  properties:CBCharacteristicPropertyWrite | CBCharacteristicPropertyWriteWithoutResponse
+                                                       value:nil
+                                                 permissions:CBAttributePermissionsWriteable];
+
+    _configurationHash = [[CBMutableCharacteristic alloc] initWithType:[CBUUID UUIDWithString:@"394F9D1A-8D3C-4C3A-9F3E-1B1F3A9C0A6B"]
+                                                            properties:CBCharacteristicPropertyWrite
+                                                                 value:nil
+                                                           permissions:CBAttributePermissionsWriteable];
+}
+
+-(void)tearDown
+{
+    _target = nil;
+    _command = nil;
+    _configurationHash = nil;
+
+    [super tearDown];
+}
+
+-(NSData*)commandData
+{
+    static const uint8_t bytes[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20 };
+    return [NSData dataWithBytes:bytes length:sizeof(bytes)];
+}
+
+#pragma mark - Window
+-(void)testWindowLimitsWritesAwaitingResponse
+{
+    RLYWritePipeline *pipeline = [[RLYWritePipeline alloc] initWithTarget:_target windowSize:2 burstSize:1];
+    NSMutableArray *completed = [NSMutableArray array];
+
+    for (NSUInteger i = 0; i < 5; i++)
+    {
+        [pipeline enqueueData:[self commandData] forCharacteristic:_command allowsWriteWithoutResponse:YES completion:^(NSError *error) {
+            XCTAssertNil(error);
+            [completed addObject:@(i)];
+        }];
+    }
+
+    XCTAssertEqual(_target.types.count, (NSUInteger)2);
+    XCTAssertEqual(pipeline.statistics.pendingWriteCount, (NSUInteger)5);
+
+    XCTAssertTrue([pipeline didWriteValueForCharacteristic:_command error:nil]);
+    XCTAssertEqualObjects(completed, @[@0]);
+    XCTAssertEqual(_target.types.count, (NSUInteger)3);
+
+    [_target.awaitingResponse removeObjectAtIndex:0];
+    [_target acknowledgeAllWithPipeline:pipeline];
+
+    XCTAssertEqualObjects(completed, (@[@0, @1, @2, @3, @4]));
+    XCTAssertEqual(pipeline.statistics.completedWriteCount, (NSUInteger)5);
+    XCTAssertEqual(pipeline.statistics.pendingWriteCount, (NSUInteger)0);
+    XCTAssertEqual(pipeline.statistics.completedByteCount, (uint64_t)100);
+}
+
+-(void)testErrorsAreMatchedToWrites
+{
+    RLYWritePipeline *pipeline = [[RLYWritePipeline alloc] initWithTarget:_target windowSize:4 burstSize:1];
+    NSError *error = [NSError errorWithDomain:@"test" code:0 userInfo:nil];
+
+    __block NSError *commandError = nil;
+    __block NSError *hashError = error;
+
+    [pipeline enqueueData:[self commandData] forCharacteristic:_command allowsWriteWithoutResponse:NO completion:^(NSError *error) {
+        commandError = error;
+    }];
+
+    [pipeline enqueueData:[self commandData] forCharacteristic:_configurationHash allowsWriteWithoutResponse:NO completion:^(NSError *error) {
+        hashError = error;
+    }];
+
+    XCTAssertTrue([pipeline didWriteValueForCharacteristic:_command error:error]);
+    XCTAssertTrue([pipeline didWriteValueForCharacteristic:_configurationHash error:nil]);
+
+    XCTAssertEqualObjects(commandError, error);
+    XCTAssertNil(hashError);
+    XCTAssertEqual(pipeline.statistics.failedWriteCount, (NSUInteger)1);
+    XCTAssertEqual(pipeline.statistics.completedWriteCount, (NSUInteger)1);
+}
+
+-(void)testUnmatchedResponse
+{
+    RLYWritePipeline *pipeline = [[RLYWritePipeline alloc] initWithTarget:_target windowSize:4 burstSize:1];
+
+    [pipeline enqueueData:[self commandData] forCharacteristic:_command allowsWriteWithoutResponse:NO completion:nil];
+
+    XCTAssertFalse([pipeline didWriteValueForCharacteristic:_configurationHash error:nil]);
+    XCTAssertEqual(pipeline.statistics.pendingWriteCount, (NSUInteger)1);
+}
+
+-(void)testFailAllWrites
+{
+    RLYWritePipeline *pipeline = [[RLYWritePipeline alloc] initWithTarget:_target windowSize:1 burstSize:1];
+    NSError *error = [NSError errorWithDomain:@"test" code:0 userInfo:nil];
+    __block NSUInteger failed = 0;
+
+    for (NSUInteger i = 0; i < 3; i++)
+    {
+        [pipeline enqueueData:[self commandData] forCharacteristic:_command allowsWriteWithoutResponse:NO completion:^(NSError *completionError) {
+            XCTAssertEqualObjects(completionError, error);
+            failed++;
+        }];
+    }
+
+    [pipeline failAllWritesWithError:error];
+
+    XCTAssertEqual(failed, (NSUInteger)3);
+    XCTAssertEqual(pipeline.statistics.failedWriteCount, (NSUInteger)3);
+    XCTAssertEqual(pipeline.statistics.pendingWriteCount, (NSUInteger)0);
+
+    // responses for the failed writes should be ignored
+    XCTAssertFalse([pipeline didWriteValueForCharacteristic:_command error:nil]);
+}
+
+#pragma mark - Bursts
+-(void)testBurstsEndWithResponse
+{
+    RLYWritePipeline *pipeline = [[RLYWritePipeline alloc] initWithTarget:_target windowSize:1 burstSize:4];
+    pipeline.allowsWritesWithoutResponse = YES;
+
+    __block NSUInteger completed = 0;
+
+    for (NSUInteger i = 0; i < 6; i++)
+    {
+        [pipeline enqueueData:[self commandData] forCharacteristic:_command allowsWriteWithoutResponse:YES completion:^(NSError *error) {
+            completed++;
+        }];
+    }
+
+    // the first write has nothing queued behind it when it is sent, so it can't be sent without a response
+    XCTAssertEqualObjects(_target.types, @[@(CBCharacteristicWriteWithResponse)]);
+
+    [pipeline didWriteValueForCharacteristic:_command error:nil];
+    [_target.awaitingResponse removeObjectAtIndex:0];
+
+    NSArray *burst = @[
+        @(CBCharacteristicWriteWithoutResponse),
+        @(CBCharacteristicWriteWithoutResponse),
+        @(CBCharacteristicWriteWithoutResponse),
+        @(CBCharacteristicWriteWithResponse)
+    ];
+
+    XCTAssertEqual(completed, (NSUInteger)1);
+    XCTAssertEqualObjects([_target.types subarrayWithRange:NSMakeRange(1, 4)], burst);
+
+    // the response acknowledges the entire burst
+    [pipeline didWriteValueForCharacteristic:_command error:nil];
+    [_target.awaitingResponse removeObjectAtIndex:0];
+
+    XCTAssertEqual(completed, (NSUInteger)5);
+
+    // the final write must be sent with a response
+    XCTAssertEqualObjects(_target.types.lastObject, @(CBCharacteristicWriteWithResponse));
+
+    [_target acknowledgeAllWithPipeline:pipeline];
+
+    XCTAssertEqual(completed, (NSUInteger)6);
+    XCTAssertEqual(_target.types.count, (NSUInteger)6);
+    XCTAssertEqual(pipeline.statistics.writeWithoutResponseCount, (NSUInteger)3);
+}
+
+-(void)testBurstsRequireCharacteristicSupport
+{
+    RLYWritePipeline *pipeline = [[RLYWritePipeline alloc] initWithTarget:_target windowSize:4 burstSize:4];
+    pipeline.allowsWritesWithoutResponse = YES;
+
+    for (NSUInteger i = 0; i < 3; i++)
+    {
+        [pipeline enqueueData:[self commandData] forCharacteristic:_configurationHash allowsWriteWithoutResponse:YES completion:nil];
+    }
+
+    for (NSNumber *type in _target.types)
+    {
+        XCTAssertEqual(type.integerValue, CBCharacteristicWriteWithResponse);
+    }
+}
+
+#pragma mark - Performance
+/**
+ *  Simulates a full settings resync (a clear, application and contact settings, and a configuration hash), returning
+ *  the number of round trips required.
+ *
+ *  @param pipeline The pipeline to write to.
+ */
+-(NSUInteger)resyncWithPipeline:(RLYWritePipeline*)pipeline
+{
+    // all commands are written at once, before any responses arrive
+    for (NSUInteger i = 0; i < 1 + 60 + 40; i++)
+    {
+        [pipeline enqueueData:[self commandData] forCharacteristic:_command allowsWriteWithoutResponse:YES completion:nil];
+    }
+
+    uint64_t hash = 0;
+    [pipeline enqueueData:[NSData dataWithBytes:&hash length:sizeof(hash)]
+        forCharacteristic:_configurationHash
+allowsWriteWithoutResponse:NO
+               completion:nil];
+
+    return [_target acknowledgeAllWithPipeline:pipeline];
+}
+
+-(void)testBurstsReduceRoundTrips
+{
+    RLYWritePipeline *pipeline = [[RLYWritePipeline alloc] initWithTarget:_target windowSize:4 burstSize:8];
+    XCTAssertEqual([self resyncWithPipeline:pipeline], (NSUInteger)102);
+
+    pipeline.allowsWritesWithoutResponse = YES;
+    XCTAssertLessThan([self resyncWithPipeline:pipeline], (NSUInteger)20);
+    XCTAssertEqual(pipeline.statistics.completedWriteCount, (NSUInteger)204);
+}
+
+-(void)testResyncPerformance
+{
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < 1000; i++)
+        {
+            RLYWritePipeline *pipeline = [[RLYWritePipeline alloc] initWithTarget:_target windowSize:4 burstSize:8];
+            pipeline.allowsWritesWithoutResponse = YES;
+            [self resyncWithPipeline:pipeline];
+        }
+    }];
+}
+
+@end